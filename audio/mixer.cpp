@@ -22,6 +22,7 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -41,10 +42,14 @@ namespace Audio {
 
 /**
  * Channel used by the default Mixer implementation.
+ *
+ * Channels are owned by the mixer callback: apart from their construction,
+ * all methods are only called with MixerImpl::_mutex held. The engine side
+ * bookkeeping (id, pause level, ...) lives in MixerImpl::ChannelState.
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, RateConverterQuality quality);
 	~Channel();
 
 	/**
@@ -64,29 +69,18 @@ public:
 	bool isFinished() const { return _stream->endOfStream(); }
 
 	/**
-	 * Queries whether the channel is a permanent channel.
-	 * A permanent channel is not affected by a Mixer::stopAll
-	 * call.
-	 */
-	bool isPermanent() const { return _permanent; }
-
-	/**
-	 * Returns the id of the channel.
-	 */
-	int getId() const { return _id; }
-
-	/**
-	 * Pauses or unpaused the channel in a recursive fashion.
+	 * Pauses or unpauses the channel. Nesting of pause requests is
+	 * handled by the mixer.
 	 *
 	 * @param paused true, when the channel should be paused.
 	 *               false when it should be unpaused.
 	 */
-	void pause(bool paused);
+	void setPaused(bool paused) { _paused = paused; }
 
 	/**
 	 * Queries whether the channel is currently paused.
 	 */
-	bool isPaused() const { return (_pauseLevel != 0); }
+	bool isPaused() const { return _paused; }
 
 	/**
 	 * Sets the channel's own volume.
@@ -95,13 +89,6 @@ public:
 	 */
 	void setVolume(const byte volume);
 
-	/**
-	 * Gets the channel's own volume.
-	 *
-	 * @return volume
-	 */
-	byte getVolume();
-
 	/**
 	 * Sets the channel's balance setting.
 	 *
@@ -109,13 +96,6 @@ public:
 	 */
 	void setBalance(const int8 balance);
 
-	/**
-	 * Gets the channel's balance setting.
-	 *
-	 * @return balance
-	 */
-	int8 getBalance();
-
 	/**
 	 * Notifies the channel that the global sound type
 	 * volume settings changed.
@@ -123,9 +103,19 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Queries the number of sample frames played before the last mix call.
+	 */
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
+
+	/**
+	 * Queries the time of the last mix call, or 0 if there was none yet.
+	 */
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
+
+	/**
+	 * Queries the number of mix calls which consumed data.
 	 */
-	Timestamp getElapsedTime();
+	uint32 getMixCount() const { return _mixCount; }
 
 	/**
 	 * Queries the channel's sound type.
@@ -147,9 +137,7 @@ public:
 private:
 	const Mixer::SoundType _type;
 	SoundHandle _handle;
-	bool _permanent;
-	int _pauseLevel;
-	int _id;
+	bool _paused;
 
 	byte _volume;
 	int8 _balance;
@@ -162,8 +150,7 @@ private:
 	uint32 _samplesConsumed;
 	uint32 _samplesDecoded;
 	uint32 _mixerTimeStamp;
-	uint32 _pauseStartTime;
-	uint32 _pauseTime;
+	uint32 _mixCount;
 
 	RateConverter *_converter;
 	Common::DisposablePtr<AudioStream> _stream;
@@ -173,19 +160,89 @@ private:
 #pragma mark --- Mixer ---
 #pragma mark -
 
+/*
+ * Threading model
+ *
+ * The mixer callback runs on the audio thread and must not wait for the
+ * engine, while engines poll the state of their sounds every frame and
+ * must not wait for the mixer callback. Hence the two sides only share
+ * a queue of commands and a snapshot of the playback progress per slot:
+ *
+ * - All public methods except mixCallback() are serialized by
+ *   _controlMutex, which the mixer callback never takes. They keep their
+ *   own copy of the channel settings in _states, which answers queries,
+ *   and pass changes on to the channels through the command queue.
+ * - mixCallback() holds _mutex, executes the queued commands in order,
+ *   mixes and publishes the progress of each channel in _snapshots.
+ *
+ * The lock order is _mutex before _controlMutex: streams may call back
+ * into the mixer from the audio thread, so the engine side must never
+ * take _mutex while holding _controlMutex. It only takes _mutex (and
+ * then _controlMutex again) once _controlMutex is released:
+ *
+ * - to flush the command queue after stopping sounds, since callers
+ *   expect the streams to be gone (or at least no longer read from)
+ *   once they return,
+ * - to flush the command queue after commands did not fit into it, e.g.
+ *   because the backend did not start the mixer callback yet. These are
+ *   kept aside in _overflowCommands until then,
+ * - to grow the channel tables when playStream() runs out of slots.
+ */
+
 // TODO: parameter "system" is unused
-MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+MixerImpl::MixerImpl(OSystem *system, uint sampleRate, uint maxChannels)
+	: _mutex(), _controlMutex(), _sampleRate(sampleRate), _mixerReady(false), _soundTypeSettings(),
+	  _numChannels(0), _maxChannels(getChannelLimit(maxChannels)), _channels(0), _states(0), _snapshots(0),
+	  _finished(0), _finishedMask(0), _finishedHead(0), _finishedTail(0),
+	  _commandHead(0), _commandTail(0), _controlDepth(0), _flushRequested(false),
+	  _rateConverterQuality(kRateConverterLinear) {
 
 	assert(sampleRate > 0);
+	assert(_maxChannels > 0 && _maxChannels < HANDLE_INDEX_MASK);
+
+	if (ConfMan.get("resampler") == "sinc")
+		_rateConverterQuality = kRateConverterSinc;
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		_channels[i] = 0;
+	uint32 finishedSize = 1;
+	while (finishedSize < 2 * _maxChannels)
+		finishedSize <<= 1;
+	_finished = new uint32[finishedSize];
+	_finishedMask = finishedSize - 1;
+
+	growChannels();
+}
+
+// The last slot index is left out, so that no handle equals the invalid one
+uint MixerImpl::getChannelLimit(uint maxChannels) {
+	if (maxChannels >= HANDLE_INDEX_MASK) {
+		warning("Limiting the mixer to %d channels instead of %u", HANDLE_INDEX_MASK - 1, maxChannels);
+		return HANDLE_INDEX_MASK - 1;
+	}
+
+	if (maxChannels)
+		return maxChannels;
+
+	if (ConfMan.hasKey("mixer_channels")) {
+		const int channels = ConfMan.getInt("mixer_channels");
+		if (channels > 0 && channels < HANDLE_INDEX_MASK)
+			return channels;
+		warning("Ignoring mixer_channels setting %d, it must be between 1 and %d", channels, HANDLE_INDEX_MASK - 1);
+	}
+
+	return kDefaultMaxChannels;
 }
 
 MixerImpl::~MixerImpl() {
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	// Channels which were never inserted are still owned by the queue
+	flushCommands();
+
+	for (uint i = 0; i != _numChannels; i++)
 		delete _channels[i];
+
+	delete[] _channels;
+	delete[] _states;
+	delete[] _snapshots;
+	delete[] _finished;
 }
 
 void MixerImpl::setReady(bool ready) {
@@ -196,29 +253,270 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
-void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
-	int index = -1;
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == 0) {
-			index = i;
+void MixerImpl::growChannels() {
+	// The tables are swapped under both mutexes, in the documented order
+	Common::StackLock lock(_mutex);
+	Common::StackLock controlLock(_controlMutex);
+
+	// Another thread may have grown them in the meantime
+	reclaimFinishedChannels();
+	if (!_freeSlots.empty() || _numChannels == _maxChannels)
+		return;
+
+	const uint oldNumChannels = _numChannels;
+	const uint numChannels = MIN<uint>(MAX<uint>(oldNumChannels * 2, INITIAL_CHANNELS), _maxChannels);
+
+	Channel **channels = new Channel *[numChannels];
+	ChannelState *states = new ChannelState[numChannels];
+	ChannelSnapshot *snapshots = new ChannelSnapshot[numChannels];
+
+	for (uint i = oldNumChannels; i != numChannels; i++) {
+		channels[i] = 0;
+		states[i].used = false;
+		states[i].generation = 0;
+
+		snapshots[i].sequence = 0;
+		snapshots[i].handle = 0;
+		snapshots[i].samplesConsumed = 0;
+		snapshots[i].mixerTimeStamp = 0;
+		snapshots[i].mixCount = 0;
+		snapshots[i].finishedHandle = 0xFFFFFFFF;
+	}
+
+	for (uint i = 0; i != oldNumChannels; i++)
+		states[i] = _states[i];
+
+	for (uint i = 0; i != oldNumChannels; i++) {
+		channels[i] = _channels[i];
+		snapshots[i] = _snapshots[i];
+	}
+
+	delete[] _channels;
+	delete[] _snapshots;
+	delete[] _states;
+	_channels = channels;
+	_snapshots = snapshots;
+	_states = states;
+	_numChannels = numChannels;
+
+	// Hand out the lower slots first
+	for (uint i = numChannels; i-- != oldNumChannels;)
+		_freeSlots.push_back(i);
+}
+
+MixerImpl::ControlLock::ControlLock(MixerImpl *mixer) : _mixer(mixer) {
+	_mixer->_controlMutex.lock();
+	_mixer->_controlDepth++;
+}
+
+MixerImpl::ControlLock::~ControlLock() {
+	const bool flush = --_mixer->_controlDepth == 0 && (_mixer->_flushRequested || !_mixer->_overflowCommands.empty());
+	if (flush)
+		_mixer->_flushRequested = false;
+	_mixer->_controlMutex.unlock();
+
+	if (flush)
+		_mixer->flushCommands();
+}
+
+void MixerImpl::pushCommand(CommandType type, int index, uint32 handle, int value, Channel *channel) {
+	Command cmd;
+	cmd.type = type;
+	cmd.index = index;
+	cmd.handle = handle;
+	cmd.value = value;
+	cmd.channel = channel;
+
+	// Taking _mutex here could deadlock, so when the mixer callback does
+	// not keep up, the command waits for the ControlLock to be released
+	const uint32 head = _commandHead;
+	if (!_overflowCommands.empty() || head - Common::atomicLoad(_commandTail) == COMMAND_QUEUE_SIZE) {
+		_overflowCommands.push_back(cmd);
+		return;
+	}
+
+	_commands[head & (COMMAND_QUEUE_SIZE - 1)] = cmd;
+	Common::atomicStore(_commandHead, head + 1);
+}
+
+void MixerImpl::processCommands() {
+	// Stopping a sound deletes its stream, which may call back into the
+	// mixer and process the following commands itself. So each command is
+	// taken off the queue before it is executed.
+	for (;;) {
+		const uint32 tail = _commandTail;
+		if (tail == Common::atomicLoad(_commandHead))
 			break;
+
+		const Command cmd = _commands[tail & (COMMAND_QUEUE_SIZE - 1)];
+		Common::atomicStore(_commandTail, tail + 1);
+		executeCommand(cmd);
+	}
+}
+
+void MixerImpl::executeCommand(const Command &cmd) {
+	if (cmd.type == kCommandInsert) {
+		// The engine side only reuses slots it stopped before or which
+		// we reported finished, so this is merely a safety net
+		Channel *oldChan = _channels[cmd.index];
+		_channels[cmd.index] = cmd.channel;
+		delete oldChan;
+		return;
+	} else if (cmd.type == kCommandUpdateVolumes) {
+		for (uint i = 0; i != _numChannels; ++i) {
+			if (_channels[i] && _channels[i]->getType() == cmd.index)
+				_channels[i]->notifyGlobalVolChange();
 		}
+		return;
 	}
-	if (index == -1) {
-		warning("MixerImpl::out of mixer slots");
-		delete chan;
+
+	// Ignore requests for channels which terminated in the meantime
+	Channel *chan = _channels[cmd.index];
+	if (!chan || chan->getHandle()._val != cmd.handle)
 		return;
+
+	switch (cmd.type) {
+	case kCommandStop:
+		_channels[cmd.index] = 0;
+		delete chan;
+		break;
+	case kCommandPause:
+		chan->setPaused(cmd.value != 0);
+		break;
+	case kCommandSetVolume:
+		chan->setVolume((byte)cmd.value);
+		break;
+	case kCommandSetBalance:
+		chan->setBalance((int8)cmd.value);
+		break;
+	default:
+		break;
 	}
+}
 
-	_channels[index] = chan;
+void MixerImpl::flushCommands() {
+	Common::StackLock lock(_mutex);
+	Common::StackLock controlLock(_controlMutex);
+
+	// While there are overflowing commands, no new ones are queued, so
+	// the queued ones come first
+	processCommands();
+
+	// Commands may stop sounds, whose streams could call back into the
+	// mixer, so like above, each command is taken off the list first
+	while (!_overflowCommands.empty()) {
+		const Command cmd = _overflowCommands.front();
+		_overflowCommands.remove_at(0);
+		executeCommand(cmd);
+	}
+}
 
-	SoundHandle chanHandle;
-	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
+void MixerImpl::publishSnapshot(int index) {
+	ChannelSnapshot &snapshot = _snapshots[index];
+	const Channel *chan = _channels[index];
 
-	chan->setHandle(chanHandle);
-	_handleSeed++;
-	if (handle)
-		*handle = chanHandle;
+	// An odd sequence number tells readers that an update is in progress
+	const uint32 sequence = snapshot.sequence;
+	Common::atomicStore(snapshot.sequence, sequence + 1);
+	Common::memoryBarrier();
+
+	snapshot.handle = chan->getHandle()._val;
+	snapshot.samplesConsumed = chan->getSamplesConsumed();
+	snapshot.mixerTimeStamp = chan->getMixerTimeStamp();
+	snapshot.mixCount = chan->getMixCount();
+
+	Common::atomicStore(snapshot.sequence, sequence + 2);
+}
+
+/*
+ * Free the slots of the channels the mixer callback reported finished.
+ *
+ * This is called before allocating a slot, so in between two calls each
+ * slot can be reported at most twice: once for the channel it held at the
+ * time of the last call, and once for a channel inserted after stopping
+ * that one. The queue is sized accordingly.
+ */
+void MixerImpl::reclaimFinishedChannels() {
+	const uint32 head = Common::atomicLoad(_finishedHead);
+	uint32 tail = _finishedTail;
+
+	for (; tail != head; ++tail) {
+		const uint32 handle = _finished[tail & _finishedMask];
+		const int index = handle & HANDLE_INDEX_MASK;
+
+		// The slot may have been stopped and reused in the meantime
+		if (_states[index].used && _states[index].handle == handle)
+			releaseChannel(index);
+	}
+
+	Common::atomicStore(_finishedTail, tail);
+}
+
+void MixerImpl::releaseChannel(int index) {
+	_states[index].used = false;
+	_freeSlots.push_back(index);
+}
+
+bool MixerImpl::isChannelActive(int index) {
+	ChannelState &state = _states[index];
+	if (!state.used)
+		return false;
+
+	// Free the slot as soon as the mixer callback reports the end of the
+	// sound, it already deleted the channel then
+	if (Common::atomicLoad(_snapshots[index].finishedHandle) == state.handle) {
+		releaseChannel(index);
+		return false;
+	}
+
+	return true;
+}
+
+int MixerImpl::findChannel(SoundHandle handle) {
+	const uint index = handle._val & HANDLE_INDEX_MASK;
+	if (index >= _numChannels || !isChannelActive(index) || _states[index].handle != handle._val)
+		return -1;
+	return index;
+}
+
+void MixerImpl::pauseChannel(int index, bool paused) {
+	ChannelState &state = _states[index];
+
+	//assert((paused && state.pauseLevel >= 0) || (!paused && state.pauseLevel));
+
+	if (paused) {
+		state.pauseLevel++;
+
+		if (state.pauseLevel == 1) {
+			state.pauseStartTime = g_system->getMillis(true);
+			pushCommand(kCommandPause, index, state.handle, 1);
+		}
+	} else if (state.pauseLevel > 0) {
+		state.pauseLevel--;
+
+		if (!state.pauseLevel) {
+			state.pauseTime = (g_system->getMillis(true) - state.pauseStartTime);
+			state.pauseStartTime = 0;
+			// The snapshot may still belong to the previous sound in this slot
+			if (Common::atomicLoad(_snapshots[index].handle) == state.handle)
+				state.unpauseMixCount = Common::atomicLoad(_snapshots[index].mixCount);
+			else
+				state.unpauseMixCount = 0;
+			pushCommand(kCommandPause, index, state.handle, 0);
+		}
+	}
+}
+
+void MixerImpl::stopChannel(int index) {
+	releaseChannel(index);
+	pushCommand(kCommandStop, index, _states[index].handle);
+
+	// Callers expect the stream to be gone once they return
+	_flushRequested = true;
+}
+
+void MixerImpl::updateVolumes(SoundType type) {
+	pushCommand(kCommandUpdateVolumes, type, 0);
 }
 
 void MixerImpl::playStream(
@@ -229,11 +527,24 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
+	// The channel tables can't grow while _controlMutex is held
+	while (!startChannel(type, handle, stream, id, volume, balance, autofreeStream, permanent, reverseStereo))
+		growChannels();
+}
+
+bool MixerImpl::startChannel(
+			SoundType type,
+			SoundHandle *handle,
+			AudioStream *stream,
+			int id, byte volume, int8 balance,
+			DisposeAfterUse::Flag autofreeStream,
+			bool permanent,
+			bool reverseStereo) {
+	ControlLock lock(this);
 
 	if (stream == 0) {
 		warning("stream is 0");
-		return;
+		return true;
 	}
 
 
@@ -241,8 +552,8 @@ void MixerImpl::playStream(
 
 	// Prevent duplicate sounds
 	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+		for (uint i = 0; i != _numChannels; i++)
+			if (isChannelActive(i) && _states[i].id == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -251,19 +562,59 @@ void MixerImpl::playStream(
 				// try to play QueuingAudioStreams with a sound id.
 				if (autofreeStream == DisposeAfterUse::YES)
 					delete stream;
-				return;
+				return true;
 			}
 	}
 
+	reclaimFinishedChannels();
+	if (_freeSlots.empty()) {
+		// Let the caller grow the tables, and try again
+		if (_numChannels != _maxChannels)
+			return false;
+
+		warning("MixerImpl::out of mixer slots");
+		if (autofreeStream == DisposeAfterUse::YES)
+			delete stream;
+		return true;
+	}
+
+	const int index = _freeSlots.back();
+	_freeSlots.pop_back();
+
 #ifdef AUDIO_REVERSE_STEREO
 	reverseStereo = !reverseStereo;
 #endif
 
-	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	// Create the channel. This happens on our side, so that the mixer
+	// callback does not have to set up rate converters.
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, _rateConverterQuality);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
-	insertChannel(handle, chan);
+
+	ChannelState &state = _states[index];
+	state.generation++;
+
+	SoundHandle chanHandle;
+	chanHandle._val = index | (state.generation << HANDLE_INDEX_BITS);
+	chan->setHandle(chanHandle);
+
+	state.used = true;
+	state.handle = chanHandle._val;
+	state.id = id;
+	state.type = type;
+	state.permanent = permanent;
+	state.volume = volume;
+	state.balance = balance;
+	state.pauseLevel = 0;
+	state.pauseStartTime = 0;
+	state.pauseTime = 0;
+	state.unpauseMixCount = 0;
+
+	pushCommand(kCommandInsert, index, chanHandle._val, 0, chan);
+
+	if (handle)
+		*handle = chanHandle;
+	return true;
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
@@ -279,18 +630,29 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	processCommands();
+
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (uint i = 0; i != _numChannels; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
+				const uint32 finishedHandle = _channels[i]->getHandle()._val;
 				delete _channels[i];
 				_channels[i] = 0;
+				Common::atomicStore(_snapshots[i].finishedHandle, finishedHandle);
+
+				const uint32 head = _finishedHead;
+				if (head - Common::atomicLoad(_finishedTail) <= _finishedMask) {
+					_finished[head & _finishedMask] = finishedHandle;
+					Common::atomicStore(_finishedHead, head + 1);
+				}
 			} else if (!_channels[i]->isPaused()) {
 				tmp = _channels[i]->mix(buf, len);
+				publishSnapshot(i);
 
 				if (tmp > res)
 					res = tmp;
@@ -301,45 +663,38 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+	ControlLock lock(this);
+	for (uint i = 0; i != _numChannels; i++) {
+		if (isChannelActive(i) && !_states[i].permanent)
+			stopChannel(i);
 	}
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+	ControlLock lock(this);
+	for (uint i = 0; i != _numChannels; i++) {
+		if (isChannelActive(i) && _states[i].id == id)
+			stopChannel(i);
 	}
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	ControlLock lock(this);
 
 	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	stopChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	ControlLock lock(this);
+	_soundTypeSettings[type].mute = mute;
+	updateVolumes(type);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -348,39 +703,45 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	ControlLock lock(this);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setVolume(volume);
+	_states[index].volume = volume;
+	pushCommand(kCommandSetVolume, index, handle._val, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_controlMutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return _states[index].volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	ControlLock lock(this);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setBalance(balance);
+	_states[index].balance = balance;
+	pushCommand(kCommandSetBalance, index, handle._val, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_controlMutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return _states[index].balance;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -388,81 +749,120 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
+
+	Audio::Timestamp ts(0, _sampleRate);
+
+	const int index = findChannel(handle);
+	if (index == -1)
+		return ts;
+
+	// Read a consistent snapshot of the playback progress, retrying while
+	// the mixer callback updates it
+	const ChannelSnapshot &snapshot = _snapshots[index];
+	uint32 sequence, snapshotHandle, samplesConsumed, mixerTimeStamp, mixCount;
+	do {
+		sequence = Common::atomicLoad(snapshot.sequence);
+		snapshotHandle = snapshot.handle;
+		samplesConsumed = snapshot.samplesConsumed;
+		mixerTimeStamp = snapshot.mixerTimeStamp;
+		mixCount = snapshot.mixCount;
+		Common::memoryBarrier();
+	} while ((sequence & 1) || snapshot.sequence != sequence);
+
+	// Not mixed yet
+	if (snapshotHandle != handle._val || mixerTimeStamp == 0)
+		return ts;
+
+	const ChannelState &state = _states[index];
+	uint32 delta = 0;
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	if (state.pauseLevel)
+		delta = state.pauseStartTime - mixerTimeStamp;
+	else if (mixCount == state.unpauseMixCount)
+		delta = g_system->getMillis(true) - mixerTimeStamp - state.pauseTime;
+	else
+		delta = g_system->getMillis(true) - mixerTimeStamp;
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::pauseAll(bool paused) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0) {
-			_channels[i]->pause(paused);
+	ControlLock lock(this);
+	for (uint i = 0; i != _numChannels; i++) {
+		if (isChannelActive(i)) {
+			pauseChannel(i, paused);
 		}
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
+	ControlLock lock(this);
+	for (uint i = 0; i != _numChannels; i++) {
+		if (isChannelActive(i) && _states[i].id == id) {
+			pauseChannel(i, paused);
 			return;
 		}
 	}
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
-	Common::StackLock lock(_mutex);
+	ControlLock lock(this);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->pause(paused);
+	pauseChannel(index, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+	for (uint i = 0; i != _numChannels; i++)
+		if (isChannelActive(i) && _states[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	Common::StackLock lock(_controlMutex);
+	const int index = findChannel(handle);
+	if (index != -1)
+		return _states[index].id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_controlMutex);
 
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != -1;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+	Common::StackLock lock(_controlMutex);
+	for (uint i = 0; i != _numChannels; i++)
+		if (isChannelActive(i) && _states[i].type == type)
 			return true;
 	return false;
 }
@@ -479,13 +879,9 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
+	ControlLock lock(this);
 	_soundTypeSettings[type].volume = volume;
-
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	updateVolumes(type);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -500,16 +896,16 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
-    : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
-      _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0), _volL(0), _volR(0),
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, RateConverterQuality quality)
+    : _type(type), _mixer(mixer), _paused(false), _volume(Mixer::kMaxChannelVolume),
+      _balance(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
+      _mixCount(0), _converter(0), _volL(0), _volR(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, quality);
 }
 
 Channel::~Channel() {
@@ -521,19 +917,11 @@ void Channel::setVolume(const byte volume) {
 	updateChannelVolumes();
 }
 
-byte Channel::getVolume() {
-	return _volume;
-}
-
 void Channel::setBalance(const int8 balance) {
 	_balance = balance;
 	updateChannelVolumes();
 }
 
-int8 Channel::getBalance() {
-	return _balance;
-}
-
 void Channel::updateChannelVolumes() {
 	// From the channel balance/volume and the global volume, we compute
 	// the effective volume for the left and right channel. Note the
@@ -561,52 +949,6 @@ void Channel::updateChannelVolumes() {
 	}
 }
 
-void Channel::pause(bool paused) {
-	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
-
-	if (paused) {
-		_pauseLevel++;
-
-		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis(true);
-	} else if (_pauseLevel > 0) {
-		_pauseLevel--;
-
-		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis(true) - _pauseStartTime);
-			_pauseStartTime = 0;
-		}
-	}
-}
-
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
-}
-
 int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
@@ -617,7 +959,7 @@ int Channel::mix(int16 *data, uint len) {
 		assert(_converter);
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
-		_pauseTime = 0;
+		_mixCount++;
 		res = _converter->flow(*_stream, data, len, _volL, _volR);
 		_samplesDecoded += res;
 	}
@@ -24,8 +24,11 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/atomic.h"
+#include "common/array.h"
 #include "common/mutex.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -51,14 +54,97 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		/** number of channel slots allocated up front */
+		INITIAL_CHANNELS = 16,
+		/** bits of a sound handle holding the slot index, the rest is the slot's generation */
+		HANDLE_INDEX_BITS = 12,
+		HANDLE_INDEX_MASK = (1 << HANDLE_INDEX_BITS) - 1,
+		/** capacity of the command queue, must be a power of two */
+		COMMAND_QUEUE_SIZE = 256
 	};
 
+	/**
+	 * Requests queued by the engine side, executed by the mixer callback.
+	 */
+	enum CommandType {
+		kCommandInsert,
+		kCommandStop,
+		kCommandPause,
+		kCommandSetVolume,
+		kCommandSetBalance,
+		kCommandUpdateVolumes
+	};
+
+	struct Command {
+		CommandType type;
+		/** the channel slot, or the sound type for kCommandUpdateVolumes */
+		int index;
+		/** the handle of the channel the command is meant for */
+		uint32 handle;
+		int value;
+		/** the new channel, for kCommandInsert */
+		Channel *channel;
+	};
+
+	/**
+	 * The engine side view of a channel slot, protected by _controlMutex.
+	 * The slot is in use until the sound is stopped, or until the mixer
+	 * callback reports it finished through its snapshot.
+	 */
+	struct ChannelState {
+		bool used;
+		/** incremented whenever the slot is reused, so that stale handles do not match */
+		uint32 generation;
+		uint32 handle;
+		int id;
+		SoundType type;
+		bool permanent;
+		byte volume;
+		int8 balance;
+
+		int pauseLevel;
+		uint32 pauseStartTime;
+		uint32 pauseTime;
+		/** the snapshot's mixCount when the channel was last unpaused */
+		uint32 unpauseMixCount;
+	};
+
+	/**
+	 * Playback progress of a channel slot, published by the mixer callback
+	 * and read by the engine side without locking. The fields are guarded
+	 * by a sequence counter, which is odd while they are being updated.
+	 */
+	struct ChannelSnapshot {
+		volatile uint32 sequence;
+		volatile uint32 handle;
+		volatile uint32 samplesConsumed;
+		volatile uint32 mixerTimeStamp;
+		volatile uint32 mixCount;
+		/** the handle of the last channel in this slot which played until its end */
+		volatile uint32 finishedHandle;
+	};
+
+	/** held by the mixer callback, and by the engine side only to flush the command queue */
 	Common::Mutex _mutex;
+	/** serializes the engine side, i.e. all public methods except mixCallback; never held when taking _mutex */
+	Common::Mutex _controlMutex;
+
+	/**
+	 * Locks _controlMutex for an engine side call which queues commands.
+	 * Once the outermost lock is released, the command queue is flushed if
+	 * sounds were stopped or if commands did not fit into it.
+	 */
+	class ControlLock {
+	public:
+		explicit ControlLock(MixerImpl *mixer);
+		~ControlLock();
+
+	private:
+		MixerImpl *_mixer;
+	};
 
 	const uint _sampleRate;
 	bool _mixerReady;
-	uint32 _handleSeed;
 
 	struct SoundTypeSettings {
 		SoundTypeSettings() : mute(false), volume(kMaxMixerVolume) {}
@@ -68,12 +154,90 @@ private:
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
-	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * The channel slots. The tables grow on demand, up to _maxChannels
+	 * entries; resizing them requires both mutexes, see growChannels().
+	 */
+	uint _numChannels;
+	const uint _maxChannels;
+	/** the channels, owned by the mixer callback */
+	Channel **_channels;
+	ChannelState *_states;
+	ChannelSnapshot *_snapshots;
+
+	/** slots which are not in use on the engine side, protected by _controlMutex */
+	Common::Array<uint> _freeSlots;
+
+	/**
+	 * Single producer, single consumer queue of the handles of channels
+	 * which played until their end, so that the engine side can reclaim
+	 * their slots without scanning. The producer is the mixer callback.
+	 * Its capacity is a power of two, and large enough that it never
+	 * overflows, see reclaimFinishedChannels().
+	 */
+	uint32 *_finished;
+	uint32 _finishedMask;
+	volatile uint32 _finishedHead;
+	volatile uint32 _finishedTail;
+
+	/**
+	 * Single producer, single consumer queue of commands. The producer is
+	 * whoever holds _controlMutex, the consumer whoever holds _mutex.
+	 */
+	Command _commands[COMMAND_QUEUE_SIZE];
+	volatile uint32 _commandHead;
+	volatile uint32 _commandTail;
+
+	/**
+	 * Commands which did not fit into the queue, e.g. because the backend did
+	 * not start the mixer callback yet. They follow the ones in the queue and
+	 * are executed by flushCommands(). Protected by _controlMutex.
+	 */
+	Common::Array<Command> _overflowCommands;
+	/** how often the current thread holds a ControlLock, protected by _controlMutex */
+	uint _controlDepth;
+	/** set when sounds were stopped, protected by _controlMutex */
+	bool _flushRequested;
+
+	/** the resampling algorithm used for new channels, from the "resampler" config key */
+	RateConverterQuality _rateConverterQuality;
+
+	void pushCommand(CommandType type, int index, uint32 handle, int value = 0, Channel *channel = 0);
+	void processCommands();
+	void executeCommand(const Command &cmd);
+	void flushCommands();
+	void publishSnapshot(int index);
+
+	void growChannels();
+	bool startChannel(SoundType type, SoundHandle *handle, AudioStream *stream,
+	                  int id, byte volume, int8 balance,
+	                  DisposeAfterUse::Flag autofreeStream, bool permanent, bool reverseStereo);
+	void reclaimFinishedChannels();
+	void releaseChannel(int index);
+
+	bool isChannelActive(int index);
+	static uint getChannelLimit(uint maxChannels);
+	int findChannel(SoundHandle handle);
+	void pauseChannel(int index, bool paused);
+	void stopChannel(int index);
+	void updateVolumes(SoundType type);
 
 public:
 
-	MixerImpl(OSystem *system, uint sampleRate);
+	enum {
+		/** default upper bound of the number of simultaneous channels */
+		kDefaultMaxChannels = 256
+	};
+
+	/**
+	 * @param maxChannels upper bound of the number of simultaneous sounds,
+	 *                    less than 4095, larger values are clamped. Slots
+	 *                    are allocated on demand.
+	 *                    0 to take it from the "mixer_channels" config key,
+	 *                    or kDefaultMaxChannels if that isn't set.
+	 */
+	MixerImpl(OSystem *system, uint sampleRate, uint maxChannels = 0);
 	~MixerImpl();
 
 	virtual bool isReady() const { return _mixerReady; }
@@ -118,9 +282,6 @@ public:
 
 	virtual uint getOutputRate() const;
 
-protected:
-	void insertChannel(SoundHandle *handle, Channel *chan);
-
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
@@ -30,6 +30,8 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_sinc.h"
+#include "audio/rate_kernels.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
@@ -47,6 +49,16 @@ namespace Audio {
 #define INTERMEDIATE_BUFFER_SIZE 512
 
 
+/**
+ * Picks the kernel which mixes frames of the given layout into the output.
+ */
+template<bool stereo, bool reverseStereo>
+static MixFramesProc getMixFramesProc(const RateKernels &kernels) {
+	if (!stereo)
+		return kernels.mixMono;
+	return reverseStereo ? kernels.mixStereoReverse : kernels.mixStereo;
+}
+
 /**
  * Audio rate converter based on simple resampling. Used when no
  * interpolation is required.
@@ -60,6 +72,9 @@ protected:
 	const st_sample_t *inPtr;
 	int inLen;
 
+	/** the picked input frames, waiting to be mixed */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
 	/** position of how far output is ahead of input */
 	/** Holds what would have been opos-ipos */
 	long opos;
@@ -67,6 +82,8 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	MixFramesProc mixFrames;
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -95,6 +112,8 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 	opos_inc = inrate / outrate;
 
 	inLen = 0;
+
+	mixFrames = getMixFramesProc<stereo, reverseStereo>(getRateKernels());
 }
 
 /*
@@ -108,38 +127,46 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	ostart = obuf;
 	oend = obuf + osamp * 2;
 
-	while (obuf < oend) {
-
-		// read enough input samples so that opos >= 0
-		do {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			opos--;
-			if (opos >= 0) {
-				inPtr += (stereo ? 2 : 1);
-			}
-		} while (opos >= 0);
-
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
-
-		// Increment output position
-		opos += opos_inc;
-
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	bool endOfInput = false;
+	while (obuf < oend && !endOfInput) {
+		const st_size_t maxFrames = MIN<st_size_t>((oend - obuf) / 2, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		st_sample_t *outPtr = outBuf;
+		st_size_t frames = 0;
+
+		while (frames < maxFrames) {
+			// read enough input samples so that opos >= 0
+			do {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						inLen = 0;
+						endOfInput = true;
+						break;
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				opos--;
+				if (opos >= 0) {
+					inPtr += (stereo ? 2 : 1);
+				}
+			} while (opos >= 0);
+
+			if (endOfInput)
+				break;
+
+			*outPtr++ = *inPtr++;
+			if (stereo)
+				*outPtr++ = *inPtr++;
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+			// Increment output position
+			opos += opos_inc;
+			frames++;
+		}
 
-		obuf += 2;
+		mixFrames(obuf, outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -152,26 +179,34 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
  * method which stored a possibly big buffer of size
  * lcm(in_rate,out_rate).
  *
+ * Input frames are kept in a window, which always starts with the last
+ * frame still needed for interpolation. This lets us compute whole runs
+ * of output frames at once with the interpolation kernel.
+ *
  * Limited to sampling frequency <= 65535 Hz.
  */
 
 template<bool stereo, bool reverseStereo>
 class LinearRateConverter : public RateConverter {
 protected:
-	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
-	const st_sample_t *inPtr;
-	int inLen;
+	/** input frames, with room for one frame carried over from the last refill */
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE + 2];
+	/** number of valid frames in inBuf */
+	int inFrames;
 
-	/** fractional position of the output stream in input stream unit */
+	/** the interpolated frames, waiting to be mixed */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	/** fractional position of the output stream in input stream unit, relative to inBuf */
 	frac_t opos;
 
 	/** fractional position increment in the output stream */
 	frac_t opos_inc;
 
-	/** last sample(s) in the input stream (left/right channel) */
-	st_sample_t ilast0, ilast1;
-	/** current sample(s) in the input stream (left/right channel) */
-	st_sample_t icur0, icur1;
+	InterpolateProc interpolate;
+	MixFramesProc mixFrames;
+
+	bool refill(AudioStream &input);
 
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
@@ -191,7 +226,10 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 		error("rate effect can only handle rates < 65536");
 	}
 
-	opos = FRAC_ONE;
+	// We start interpolating from a silent frame
+	inBuf[0] = inBuf[1] = 0;
+	inFrames = 1;
+	opos = 0;
 
 	// Compute the linear interpolation increment.
 	// This will overflow if inrate >= 2^16, and underflow if outrate >= 2^16.
@@ -200,10 +238,30 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 	// versa, I think we can live with that limitation ;-).
 	opos_inc = (inrate << FRAC_BITS) / outrate;
 
-	ilast0 = ilast1 = 0;
-	icur0 = icur1 = 0;
+	const RateKernels &kernels = getRateKernels();
+	interpolate = stereo ? kernels.interpolateStereo : kernels.interpolateMono;
+	mixFrames = getMixFramesProc<stereo, reverseStereo>(kernels);
+}
 
-	inLen = 0;
+/*
+ * Drop the input frames we are done with and append new ones.
+ * Return false if the input stream has no more data.
+ */
+template<bool stereo, bool reverseStereo>
+bool LinearRateConverter<stereo, reverseStereo>::refill(AudioStream &input) {
+	const int channels = stereo ? 2 : 1;
+
+	const int consumed = MIN<int>(opos >> FRAC_BITS, inFrames);
+	inFrames -= consumed;
+	opos -= consumed << FRAC_BITS;
+	memmove(inBuf, inBuf + consumed * channels, inFrames * channels * sizeof(st_sample_t));
+
+	const int len = input.readBuffer(inBuf + inFrames * channels, ARRAYSIZE(inBuf) - inFrames * channels);
+	if (len <= 0)
+		return false;
+
+	inFrames += len / channels;
+	return true;
 }
 
 /*
@@ -218,47 +276,28 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	oend = obuf + osamp * 2;
 
 	while (obuf < oend) {
-
-		// read enough input samples so that opos < 0
-		while ((frac_t)FRAC_ONE <= opos) {
-			// Check if we have to refill the buffer
-			if (inLen == 0) {
-				inPtr = inBuf;
-				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
-				if (inLen <= 0)
-					return (obuf - ostart) / 2;
-			}
-			inLen -= (stereo ? 2 : 1);
-			ilast0 = icur0;
-			icur0 = *inPtr++;
-			if (stereo) {
-				ilast1 = icur1;
-				icur1 = *inPtr++;
-			}
-			opos -= FRAC_ONE;
+		// read enough input samples so that the next output frame has both
+		// of its neighbours available
+		if ((opos >> FRAC_BITS) + 1 >= inFrames) {
+			if (!refill(input))
+				break;
+			continue;
 		}
 
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
+		// Compute all the output frames the buffered input allows, as long
+		// as there is still space in the output buffer.
+		const frac_t limit = (inFrames - 1) << FRAC_BITS;
+		st_size_t frames = (limit - opos + opos_inc - 1) / opos_inc;
+		frames = MIN<st_size_t>(frames, (oend - obuf) / 2);
+		frames = MIN<st_size_t>(frames, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+		interpolate(outBuf, inBuf, opos, opos_inc, frames);
+		mixFrames(obuf, outBuf, frames, vol_l, vol_r);
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		obuf += frames * 2;
 
-			obuf += 2;
-
-			// Increment output position
-			opos += opos_inc;
-		}
+		// Increment output position
+		opos += frames * opos_inc;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -274,8 +313,11 @@ template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
+	MixFramesProc _mixFrames;
 public:
-	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
+	CopyRateConverter() : _buffer(0), _bufferSize(0) {
+		_mixFrames = getMixFramesProc<stereo, reverseStereo>(getRateKernels());
+	}
 	~CopyRateConverter() {
 		free(_buffer);
 	}
@@ -283,11 +325,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -303,23 +342,13 @@ public:
 
 		// Read up to 'osamp' samples into our temporary buffer
 		len = input.readBuffer(_buffer, osamp);
+		if ((int)len <= 0)
+			return 0;
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const st_size_t frames = (stereo ? len / 2 : len);
+		_mixFrames(obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -346,7 +375,10 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
+	if (quality == kRateConverterSinc && inrate != outrate)
+		return makeSincRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (stereo) {
 		if (reverseStereo)
 			return makeRateConverter<true, true>(inrate, outrate);
@@ -78,7 +78,21 @@ public:
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/**
+ * The resampling algorithms a RateConverter can use.
+ */
+enum RateConverterQuality {
+	/** Nearest neighbour for integer ratios, linear interpolation otherwise */
+	kRateConverterLinear = 0,
+	/** Polyphase windowed-sinc filtering, for fewer aliasing artifacts */
+	kRateConverterSinc = 1
+};
+
+/**
+ * Create and return a RateConverter object for the specified input and output rates.
+ * When both rates are equal, the samples are copied regardless of @p quality.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, RateConverterQuality quality = kRateConverterLinear);
 
 } // End of namespace Audio
 
@@ -0,0 +1,338 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/rate_kernels.h"
+#include "audio/mixer.h"
+#include "common/cpudetect.h"
+#include "common/endian.h"
+
+// The vector kernels rely on the signed output representation
+#ifdef OUTPUT_UNSIGNED_AUDIO
+#undef SCUMMVM_SSE2
+#undef SCUMMVM_NEON
+#endif
+
+#if defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#elif defined(SCUMMVM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+#pragma mark --- Plain C kernels ---
+
+template<bool stereo, bool reverseStereo>
+static void mixFramesC(st_sample_t *dst, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; numFrames > 0; --numFrames) {
+		st_sample_t out0, out1;
+		out0 = *src++;
+		out1 = (stereo ? *src++ : out0);
+
+		// output left channel
+		clampedAdd(dst[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(dst[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		dst += 2;
+	}
+}
+
+template<bool stereo>
+static void interpolateC(st_sample_t *dst, const st_sample_t *src, frac_t pos, frac_t inc, st_size_t numFrames) {
+	for (; numFrames > 0; --numFrames) {
+		const st_sample_t *frame = src + (pos >> FRAC_BITS) * (stereo ? 2 : 1);
+		const frac_t frac = pos & FRAC_LO_MASK;
+
+		*dst++ = (st_sample_t)(frame[0] + (((frame[stereo ? 2 : 1] - frame[0]) * frac + FRAC_HALF) >> FRAC_BITS));
+		if (stereo)
+			*dst++ = (st_sample_t)(frame[1] + (((frame[3] - frame[1]) * frac + FRAC_HALF) >> FRAC_BITS));
+
+		pos += inc;
+	}
+}
+
+static const RateKernels s_kernelsC = {
+	"C",
+	mixFramesC<false, false>,
+	mixFramesC<true, false>,
+	mixFramesC<true, true>,
+	interpolateC<false>,
+	interpolateC<true>
+};
+
+#pragma mark -
+#pragma mark --- SSE2 kernels ---
+
+#if defined(SCUMMVM_SSE2)
+
+/**
+ * Scales eight samples by the per-lane volumes in vol (0 - kMaxMixerVolume),
+ * dividing with truncation towards zero like the C code does, and adds the
+ * result to dst with saturation.
+ */
+static inline void mixVectorSSE2(st_sample_t *dst, __m128i samples, __m128i vol) {
+	const __m128i lo = _mm_mullo_epi16(samples, vol);
+	const __m128i hi = _mm_mulhi_epi16(samples, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	const __m128i bias = _mm_set1_epi32(Audio::Mixer::kMaxMixerVolume - 1);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), 8);
+
+	__m128i *out = (__m128i *)dst;
+	_mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), _mm_packs_epi32(p0, p1)));
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixFramesSSE2(st_sample_t *dst, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	// The vector code divides by shifting, which needs the volumes to fit
+	if (vol_l > Audio::Mixer::kMaxMixerVolume || vol_r > Audio::Mixer::kMaxMixerVolume) {
+		mixFramesC<stereo, reverseStereo>(dst, src, numFrames, vol_l, vol_r);
+		return;
+	}
+
+	// With reversed stereo, the swapped right sample ends up in the even lane
+	const __m128i vol = reverseStereo ? _mm_set_epi16(vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r)
+	                                  : _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	if (stereo) {
+		for (; numFrames >= 4; numFrames -= 4) {
+			__m128i s = _mm_loadu_si128((const __m128i *)src);
+			if (reverseStereo)
+				s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			mixVectorSSE2(dst, s, vol);
+			src += 8;
+			dst += 8;
+		}
+	} else {
+		for (; numFrames >= 8; numFrames -= 8) {
+			const __m128i s = _mm_loadu_si128((const __m128i *)src);
+			mixVectorSSE2(dst, _mm_unpacklo_epi16(s, s), vol);
+			mixVectorSSE2(dst + 8, _mm_unpackhi_epi16(s, s), vol);
+			src += 8;
+			dst += 16;
+		}
+	}
+
+	mixFramesC<stereo, reverseStereo>(dst, src, numFrames, vol_l, vol_r);
+}
+
+/**
+ * Multiplies the 32 bit lanes of a and b, keeping the low 32 bits of each
+ * product (SSE2 lacks pmulld).
+ */
+static inline __m128i mulLo32SSE2(__m128i a, __m128i b) {
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/**
+ * Interpolates four samples: a + (((b - a) * frac + FRAC_HALF) >> FRAC_BITS),
+ * truncated to 16 bits and sign extended again.
+ */
+static inline __m128i interpolateVectorSSE2(__m128i a, __m128i b, __m128i frac) {
+	__m128i r = mulLo32SSE2(_mm_sub_epi32(b, a), frac);
+	r = _mm_srai_epi32(_mm_add_epi32(r, _mm_set1_epi32(FRAC_HALF)), FRAC_BITS);
+	r = _mm_add_epi32(r, a);
+	return _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+}
+
+template<bool stereo>
+static void interpolateSSE2(st_sample_t *dst, const st_sample_t *src, frac_t pos, frac_t inc, st_size_t numFrames) {
+	// Lane k holds the position of the frame its sample belongs to
+	__m128i posVector = stereo ? _mm_set_epi32(pos + inc, pos + inc, pos, pos)
+	                           : _mm_set_epi32(pos + 3 * inc, pos + 2 * inc, pos + inc, pos);
+	const __m128i posStep = _mm_set1_epi32(stereo ? 2 * inc : 4 * inc);
+	const __m128i fracMask = _mm_set1_epi32(FRAC_LO_MASK);
+
+	for (; numFrames >= (stereo ? 4 : 8); numFrames -= (stereo ? 4 : 8)) {
+		__m128i result[2];
+
+		for (int half = 0; half < 2; ++half) {
+			__m128i a, b;
+
+			if (stereo) {
+				// Both neighbouring frames are four consecutive samples:
+				// gather them and split into left/right of a and b
+				const __m128i f0 = _mm_loadl_epi64((const __m128i *)(src + (pos >> FRAC_BITS) * 2));
+				pos += inc;
+				const __m128i f1 = _mm_loadl_epi64((const __m128i *)(src + (pos >> FRAC_BITS) * 2));
+				pos += inc;
+				const __m128i x = _mm_shuffle_epi32(_mm_unpacklo_epi64(f0, f1), _MM_SHUFFLE(3, 1, 2, 0));
+				a = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+				b = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+			} else {
+				// Each lane gets the pair of neighbouring samples (a, b)
+				__m128i p[4];
+				for (int i = 0; i < 4; ++i) {
+					p[i] = _mm_cvtsi32_si128(READ_UINT32(src + (pos >> FRAC_BITS)));
+					pos += inc;
+				}
+				const __m128i x = _mm_unpacklo_epi64(_mm_unpacklo_epi32(p[0], p[1]), _mm_unpacklo_epi32(p[2], p[3]));
+#ifdef SCUMM_BIG_ENDIAN
+				a = _mm_srai_epi32(x, 16);
+				b = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+#else
+				a = _mm_srai_epi32(_mm_slli_epi32(x, 16), 16);
+				b = _mm_srai_epi32(x, 16);
+#endif
+			}
+
+			result[half] = interpolateVectorSSE2(a, b, _mm_and_si128(posVector, fracMask));
+			posVector = _mm_add_epi32(posVector, posStep);
+		}
+
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(result[0], result[1]));
+		dst += 8;
+	}
+
+	interpolateC<stereo>(dst, src, pos, inc, numFrames);
+}
+
+static const RateKernels s_kernelsSSE2 = {
+	"SSE2",
+	mixFramesSSE2<false, false>,
+	mixFramesSSE2<true, false>,
+	mixFramesSSE2<true, true>,
+	interpolateSSE2<false>,
+	interpolateSSE2<true>
+};
+
+#endif
+
+#pragma mark -
+#pragma mark --- NEON kernels ---
+
+#if defined(SCUMMVM_NEON)
+
+static inline int32x4_t scaleVectorNEON(int16x4_t samples, int16x4_t vol) {
+	const int32x4_t p = vmull_s16(samples, vol);
+	// Truncate towards zero: add kMaxMixerVolume - 1 to negative products
+	const int32x4_t bias = vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(p, 31)), 24));
+	return vshrq_n_s32(vaddq_s32(p, bias), 8);
+}
+
+static inline void mixVectorNEON(st_sample_t *dst, int16x8_t samples, int16x4_t vol) {
+	const int32x4_t p0 = scaleVectorNEON(vget_low_s16(samples), vol);
+	const int32x4_t p1 = scaleVectorNEON(vget_high_s16(samples), vol);
+	const int16x8_t v = vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+	vst1q_s16(dst, vqaddq_s16(vld1q_s16(dst), v));
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixFramesNEON(st_sample_t *dst, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r) {
+	if (vol_l > Audio::Mixer::kMaxMixerVolume || vol_r > Audio::Mixer::kMaxMixerVolume) {
+		mixFramesC<stereo, reverseStereo>(dst, src, numFrames, vol_l, vol_r);
+		return;
+	}
+
+	const int16 volPattern[4] = {
+		(int16)(reverseStereo ? vol_r : vol_l), (int16)(reverseStereo ? vol_l : vol_r),
+		(int16)(reverseStereo ? vol_r : vol_l), (int16)(reverseStereo ? vol_l : vol_r)
+	};
+	const int16x4_t vol = vld1_s16(volPattern);
+
+	if (stereo) {
+		for (; numFrames >= 4; numFrames -= 4) {
+			int16x8_t s = vld1q_s16(src);
+			if (reverseStereo)
+				s = vrev32q_s16(s);
+			mixVectorNEON(dst, s, vol);
+			src += 8;
+			dst += 8;
+		}
+	} else {
+		for (; numFrames >= 8; numFrames -= 8) {
+			const int16x8_t s = vld1q_s16(src);
+			const int16x8x2_t z = vzipq_s16(s, s);
+			mixVectorNEON(dst, z.val[0], vol);
+			mixVectorNEON(dst + 8, z.val[1], vol);
+			src += 8;
+			dst += 16;
+		}
+	}
+
+	mixFramesC<stereo, reverseStereo>(dst, src, numFrames, vol_l, vol_r);
+}
+
+static inline int16x4_t interpolateVectorNEON(int32x4_t a, int32x4_t b, int32x4_t frac) {
+	int32x4_t r = vmulq_s32(vsubq_s32(b, a), frac);
+	r = vshrq_n_s32(vaddq_s32(r, vdupq_n_s32(FRAC_HALF)), FRAC_BITS);
+	return vmovn_s32(vaddq_s32(r, a));
+}
+
+template<bool stereo>
+static void interpolateNEON(st_sample_t *dst, const st_sample_t *src, frac_t pos, frac_t inc, st_size_t numFrames) {
+	const int framesPerVector = stereo ? 4 : 8;
+	const int channels = stereo ? 2 : 1;
+
+	for (; numFrames >= (st_size_t)framesPerVector; numFrames -= framesPerVector) {
+		int32 a[8], b[8], f[8];
+
+		for (int i = 0; i < framesPerVector; ++i) {
+			const st_sample_t *frame = src + (pos >> FRAC_BITS) * channels;
+			for (int c = 0; c < channels; ++c) {
+				a[i * channels + c] = frame[c];
+				b[i * channels + c] = frame[c + channels];
+				f[i * channels + c] = pos & FRAC_LO_MASK;
+			}
+			pos += inc;
+		}
+
+		const int16x4_t r0 = interpolateVectorNEON(vld1q_s32(a), vld1q_s32(b), vld1q_s32(f));
+		const int16x4_t r1 = interpolateVectorNEON(vld1q_s32(a + 4), vld1q_s32(b + 4), vld1q_s32(f + 4));
+		vst1q_s16(dst, vcombine_s16(r0, r1));
+		dst += 8;
+	}
+
+	interpolateC<stereo>(dst, src, pos, inc, numFrames);
+}
+
+static const RateKernels s_kernelsNEON = {
+	"NEON",
+	mixFramesNEON<false, false>,
+	mixFramesNEON<true, false>,
+	mixFramesNEON<true, true>,
+	interpolateNEON<false>,
+	interpolateNEON<true>
+};
+
+#endif
+
+#pragma mark -
+
+const RateKernels &getRateKernels() {
+#if defined(SCUMMVM_SSE2)
+	if (Common::hasCpuFeature(Common::kCpuFeatureSSE2))
+		return s_kernelsSSE2;
+#elif defined(SCUMMVM_NEON)
+	if (Common::hasCpuFeature(Common::kCpuFeatureNEON))
+		return s_kernelsNEON;
+#endif
+	return s_kernelsC;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,78 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_KERNELS_H
+#define AUDIO_RATE_KERNELS_H
+
+#include "common/scummsys.h"
+#include "common/frac.h"
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Mixes frames into an interleaved stereo output buffer.
+ *
+ * Each source frame is scaled by vol_l / vol_r (in the range
+ * 0 - Mixer::kMaxMixerVolume) and added to the output with clamping,
+ * exactly like clampedAdd() does.
+ *
+ * @param dst       interleaved stereo output buffer
+ * @param src       source frames (mono or interleaved stereo)
+ * @param numFrames number of frames to mix
+ */
+typedef void (*MixFramesProc)(st_sample_t *dst, const st_sample_t *src, st_size_t numFrames, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Produces linearly interpolated frames.
+ *
+ * Output frame k is interpolated between the source frames
+ * (pos_k >> FRAC_BITS) and (pos_k >> FRAC_BITS) + 1, where
+ * pos_k = pos + k * inc. The caller has to make sure that all these
+ * source frames are available.
+ */
+typedef void (*InterpolateProc)(st_sample_t *dst, const st_sample_t *src, frac_t pos, frac_t inc, st_size_t numFrames);
+
+/**
+ * A set of sample processing kernels used by the rate converters.
+ */
+struct RateKernels {
+	const char *name;
+
+	MixFramesProc mixMono;
+	MixFramesProc mixStereo;
+	MixFramesProc mixStereoReverse;
+
+	InterpolateProc interpolateMono;
+	InterpolateProc interpolateStereo;
+};
+
+/**
+ * Returns the fastest kernel set supported by the CPU we are running on.
+ * The decision honors Common::setCpuFeatureMask(), so a mask of 0 yields
+ * the plain C kernels.
+ */
+const RateKernels &getRateKernels();
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,269 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate_sinc.h"
+#include "audio/rate_kernels.h"
+#include "common/math.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Audio {
+
+enum {
+	/** Number of zero crossings of the sinc on each side of its center, when upsampling */
+	kZeroCrossings = 8,
+	/** Upper bound for the filter length, which limits the cost per output frame */
+	kMaxTaps = 64,
+	/** Upper bound for the size of a filter bank, to keep it cache resident */
+	kMaxCoefficients = 16384,
+	/** Precision of the filter coefficients */
+	kCoefficientBits = 14,
+	/** Number of input samples read at once */
+	kInputBufferSize = 512
+};
+
+/** Passband edge, relative to the lower of the two Nyquist frequencies */
+static const double kCutoff = 0.9;
+
+static uint32 greatestCommonDivisor(uint32 a, uint32 b) {
+	while (b) {
+		const uint32 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * Audio rate converter based on a polyphase windowed-sinc filter.
+ *
+ * Each output frame is the dot product of kMaxTaps or less input frames
+ * with one of a bank of filters, precomputed for the fractional offsets
+ * between input and output frames the conversion ratio produces. When the
+ * ratio has more distinct offsets than fit into the bank, the nearest
+ * lower one is used.
+ *
+ * Input frames are kept in a window starting at the first frame the next
+ * output frame depends on, so output frames are computed in blocks which
+ * are then mixed with the regular mixing kernels.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	/** input frames, with room for the filter history */
+	st_sample_t _inBuf[(kMaxTaps + kInputBufferSize) * 2];
+	/** number of valid frames in _inBuf */
+	int _inFrames;
+	/** first input frame of the filter for the next output frame */
+	int _index;
+
+	/** the filtered frames, waiting to be mixed */
+	st_sample_t _outBuf[kInputBufferSize];
+
+	/** the filter bank, _numPhases filters of _taps coefficients each */
+	int16 *_coefficients;
+	int _taps;
+	uint32 _numPhases;
+
+	/** fractional input position of the next output frame, in units of 1 / _phaseDenominator */
+	uint32 _phase;
+	uint32 _phaseDenominator;
+	/** input position increment per output frame, split into whole frames and remainder */
+	int _indexStep;
+	uint32 _phaseStep;
+
+	MixFramesProc _mixFrames;
+
+	void computeFilterBank(double cutoff);
+	bool refill(AudioStream &input);
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~SincRateConverter();
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	const uint32 gcd = greatestCommonDivisor(inrate, outrate);
+	_phaseDenominator = outrate / gcd;
+	_indexStep = (inrate / gcd) / _phaseDenominator;
+	_phaseStep = (inrate / gcd) % _phaseDenominator;
+	_phase = 0;
+
+	// When downsampling, the cutoff moves down to the output Nyquist
+	// frequency, which needs proportionally longer filters
+	const double ratio = MIN(1.0, (double)outrate / inrate);
+	_taps = (int)ceil(2 * kZeroCrossings / ratio);
+	_taps = MIN<int>((_taps + 1) & ~1, kMaxTaps);
+	_numPhases = MIN<uint32>(_phaseDenominator, kMaxCoefficients / _taps);
+
+	_coefficients = new int16[_numPhases * _taps];
+	computeFilterBank(ratio * kCutoff);
+
+	// Start with silence, so that the first output frame is centered on
+	// the first input frame
+	_inFrames = _taps / 2 - 1;
+	_index = 0;
+	memset(_inBuf, 0, sizeof(_inBuf));
+
+	const RateKernels &kernels = getRateKernels();
+	_mixFrames = !stereo ? kernels.mixMono : (reverseStereo ? kernels.mixStereoReverse : kernels.mixStereo);
+}
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::~SincRateConverter() {
+	delete[] _coefficients;
+}
+
+/*
+ * Compute Blackman windowed sinc filters for all phases, normalized to
+ * unity gain.
+ */
+template<bool stereo, bool reverseStereo>
+void SincRateConverter<stereo, reverseStereo>::computeFilterBank(double cutoff) {
+	const int center = _taps / 2 - 1;
+	const double halfWidth = _taps / 2;
+
+	for (uint32 p = 0; p < _numPhases; ++p) {
+		const double offset = (double)p / _numPhases;
+		int16 *filter = _coefficients + p * _taps;
+
+		double h[kMaxTaps];
+		double sum = 0;
+		for (int t = 0; t < _taps; ++t) {
+			const double x = t - center - offset;
+			const double sinc = (x == 0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			const double u = x / halfWidth;
+			const double window = (fabs(u) >= 1.0) ? 0.0 : 0.42 + 0.5 * cos(M_PI * u) + 0.08 * cos(2 * M_PI * u);
+			h[t] = sinc * window;
+			sum += h[t];
+		}
+
+		// Quantize and put the rounding error into the largest tap, so each
+		// filter sums up to exactly 1.0
+		int total = 0, largest = 0;
+		for (int t = 0; t < _taps; ++t) {
+			filter[t] = (int16)floor(h[t] / sum * (1 << kCoefficientBits) + 0.5);
+			total += filter[t];
+			if (filter[t] > filter[largest])
+				largest = t;
+		}
+		filter[largest] += (1 << kCoefficientBits) - total;
+	}
+}
+
+/*
+ * Drop the input frames we are done with and append new ones.
+ * Return false if the input stream has no more data.
+ */
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::refill(AudioStream &input) {
+	const int channels = stereo ? 2 : 1;
+
+	const int consumed = MIN(_index, _inFrames);
+	_inFrames -= consumed;
+	_index -= consumed;
+	memmove(_inBuf, _inBuf + consumed * channels, _inFrames * channels * sizeof(st_sample_t));
+
+	const int len = input.readBuffer(_inBuf + _inFrames * channels, ARRAYSIZE(_inBuf) - _inFrames * channels);
+	if (len <= 0)
+		return false;
+
+	_inFrames += len / channels;
+	return true;
+}
+
+template<bool stereo, bool reverseStereo>
+int SincRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	const int channels = stereo ? 2 : 1;
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+		// read enough input samples for the whole filter
+		if (_index + _taps > _inFrames) {
+			if (!refill(input))
+				break;
+			continue;
+		}
+
+		const st_size_t maxFrames = MIN<st_size_t>((oend - obuf) / 2, ARRAYSIZE(_outBuf) / channels);
+		st_sample_t *outPtr = _outBuf;
+		st_size_t frames = 0;
+
+		while (frames < maxFrames && _index + _taps <= _inFrames) {
+			const uint32 phase = (_numPhases == _phaseDenominator) ? _phase : (uint32)((uint64)_phase * _numPhases / _phaseDenominator);
+			const int16 *filter = _coefficients + phase * _taps;
+			const st_sample_t *in = _inBuf + _index * channels;
+
+			int32 sum0 = 1 << (kCoefficientBits - 1);
+			int32 sum1 = 1 << (kCoefficientBits - 1);
+			for (int t = 0; t < _taps; ++t) {
+				sum0 += filter[t] * in[t * channels];
+				if (stereo)
+					sum1 += filter[t] * in[t * channels + 1];
+			}
+
+			*outPtr++ = (st_sample_t)CLIP<int32>(sum0 >> kCoefficientBits, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+			if (stereo)
+				*outPtr++ = (st_sample_t)CLIP<int32>(sum1 >> kCoefficientBits, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+			// Increment input position
+			_index += _indexStep;
+			_phase += _phaseStep;
+			if (_phase >= _phaseDenominator) {
+				_phase -= _phaseDenominator;
+				_index++;
+			}
+
+			frames++;
+		}
+
+		_mixFrames(obuf, _outBuf, frames, vol_l, vol_r);
+		obuf += frames * 2;
+	}
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	if (stereo) {
+		if (reverseStereo)
+			return new SincRateConverter<true, true>(inrate, outrate);
+		else
+			return new SincRateConverter<true, false>(inrate, outrate);
+	} else
+		return new SincRateConverter<false, false>(inrate, outrate);
+}
+
+} // End of namespace Audio
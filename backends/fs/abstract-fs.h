@@ -62,6 +62,18 @@ protected:
 	 */
 	virtual AbstractFSNode *getChild(const Common::String &name) const = 0;
 
+	/**
+	 * Returns the child node with the given name, whose type the caller
+	 * already knows (e.g. from an earlier directory listing). Backends
+	 * should avoid accessing the filesystem here, if they can.
+	 *
+	 * The default implementation simply calls getChild().
+	 *
+	 * @param name String containing the name of the child to create a new node.
+	 * @param isDirectory Whether the child is a directory.
+	 */
+	virtual AbstractFSNode *makeChild(const Common::String &name, bool isDirectory) const { return getChild(name); }
+
 	/**
 	 * The parent node of this directory.
 	 * The parent of the root is the root itself.
@@ -158,6 +170,27 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the time of the last modification of the object in seconds,
+	 * or 0 if it is unknown. For directories, it has to change whenever
+	 * entries are added, removed or renamed. The values are only meant to
+	 * be compared for equality.
+	 *
+	 * The default implementation always returns 0.
+	 *
+	 * @param microseconds	set to the fraction of the second, or 0 if the
+	 *						backend doesn't know it
+	 */
+	virtual uint32 getModificationTime(uint32 &microseconds) const { microseconds = 0; return 0; }
+
+	/**
+	 * Returns the size of the file in bytes, without opening it, or -1 if
+	 * it is unknown.
+	 *
+	 * The default implementation always returns -1.
+	 */
+	virtual int32 getFileSize() const { return -1; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -114,6 +114,53 @@ AbstractFSNode *POSIXFilesystemNode::getChild(const Common::String &n) const {
 	return makeNode(newPath);
 }
 
+AbstractFSNode *POSIXFilesystemNode::makeChild(const Common::String &n, bool isDirectory) const {
+	assert(!_path.empty());
+	assert(_isDirectory);
+
+	// Make sure the string contains no slashes
+	assert(!n.contains('/'));
+
+	// Like getChildren(), start with a clone of this node, so that we do
+	// not need to stat() the child
+	POSIXFilesystemNode *entry = new POSIXFilesystemNode(*this);
+	entry->_displayName = n;
+	if (_path.lastChar() != '/')
+		entry->_path += '/';
+	entry->_path += n;
+	entry->_isValid = true;
+	entry->_isDirectory = isDirectory;
+
+	return entry;
+}
+
+uint32 POSIXFilesystemNode::getModificationTime(uint32 &microseconds) const {
+	struct stat st;
+
+	microseconds = 0;
+	if (stat(_path.c_str(), &st) != 0)
+		return 0;
+
+	// Add the sub-second part where we know how to get it, since whole
+	// seconds miss changes in quick succession
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+	microseconds = (uint32)(st.st_mtim.tv_nsec / 1000);
+#elif defined(MACOSX)
+	microseconds = (uint32)(st.st_mtimespec.tv_nsec / 1000);
+#endif
+
+	return (uint32)st.st_mtime;
+}
+
+int32 POSIXFilesystemNode::getFileSize() const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return -1;
+
+	return (int32)st.st_size;
+}
+
 bool POSIXFilesystemNode::getChildren(AbstractFSList &myList, ListMode mode, bool hidden) const {
 	assert(_isDirectory);
 
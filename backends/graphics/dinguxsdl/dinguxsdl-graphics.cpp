@@ -290,14 +290,8 @@ void DINGUXSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
-	// Force a full redraw if requested
-	if (_forceFull) {
-		_numDirtyRects = 1;
-		_dirtyRectList[0].x = 0;
-		_dirtyRectList[0].y = 0;
-		_dirtyRectList[0].w = width;
-		_dirtyRectList[0].h = height;
-	}
+	// Merge the dirty rects, or redraw everything if requested
+	collectDirtyRects(width, height);
 
 	// Only draw anything if necessary
 	if (_numDirtyRects > 0 || _mouseNeedsRedraw) {
@@ -319,14 +319,10 @@ void GPHGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
-	// Force a full redraw if requested
-	if (_forceFull) {
-		_numDirtyRects = 1;
-		_dirtyRectList[0].x = 0;
-		_dirtyRectList[0].y = 0;
-		_dirtyRectList[0].w = width;
-		_dirtyRectList[0].h = height;
+	// Merge the dirty rects, or redraw everything if requested
+	collectDirtyRects(width, height);
 
+	if (_forceFull) {
 		// HACK: Make sure the full hardware screen is wiped clean.
 		SDL_FillRect(_hwscreen, NULL, 0);
 	}
@@ -28,8 +28,10 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/platform/sdl/sdl.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
+#include "common/thread.h"
 #include "common/translation.h"
 #include "common/util.h"
 #ifdef USE_RGB_COLOR
@@ -130,6 +132,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_overlayVisible(false),
 	_overlayscreen(0), _tmpscreen2(0),
 	_scalerProc(0), _screenChangeCount(0),
+	_scalerPool(0), _bandScalerProc(0), _bandSrcPitch(0), _bandDstPitch(0), _bandScaleFactor(1),
 	_mouseVisible(false), _mouseNeedsRedraw(false), _mouseData(0), _mouseSurface(0),
 	_mouseOrigSurface(0), _cursorDontScale(false), _cursorPaletteDisabled(true),
 	_currentShakePos(0), _newShakePos(0),
@@ -158,8 +161,22 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 
 	memset(&_mouseCurState, 0, sizeof(_mouseCurState));
 
+	_numDirtyRects = 0;
+	memset(&_scaleStats, 0, sizeof(_scaleStats));
+
 	_graphicsMutex = g_system->createMutex();
 
+	if (ConfMan.hasKey("scaler_threads")) {
+		const int threads = ConfMan.getInt("scaler_threads");
+		if (threads != 1) {
+			_scalerPool = new Common::ThreadPool(MAX(threads, 0));
+			if (_scalerPool->getNumThreads() == 1) {
+				delete _scalerPool;
+				_scalerPool = 0;
+			}
+		}
+	}
+
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	if (ConfMan.hasKey("use_sdl_debug_focusrect"))
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
@@ -205,6 +222,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 		SDL_FreeSurface(_mouseOrigSurface);
 	_mouseOrigSurface = 0;
 	g_system->deleteMutex(_graphicsMutex);
+	delete _scalerPool;
 
 	free(_currentPalette);
 	free(_cursorPalette);
@@ -1047,14 +1065,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 	if (_mouseNeedsRedraw)
 		undrawMouse();
 
-	// Force a full redraw if requested
-	if (_forceFull) {
-		_numDirtyRects = 1;
-		_dirtyRectList[0].x = 0;
-		_dirtyRectList[0].y = 0;
-		_dirtyRectList[0].w = width;
-		_dirtyRectList[0].h = height;
-	}
+	// Merge the dirty rects, or redraw everything if requested
+	collectDirtyRects(width, height);
 
 	// Only draw anything if necessary
 	if (_numDirtyRects > 0 || _mouseNeedsRedraw) {
@@ -1062,6 +1074,7 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_Rect dst;
 		uint32 srcPitch, dstPitch;
 		SDL_Rect *lastRect = _dirtyRectList + _numDirtyRects;
+		uint32 scaledPixels = 0;
 
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			dst = *r;
@@ -1078,6 +1091,37 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwscreen->pitch;
 
+		const uint32 scaleStart = SDL_GetTicks();
+		const bool stretch = _videoMode.aspectRatioCorrection && !_overlayVisible;
+
+		// Hand the scaling to the scaler threads, unless there is too little
+		// of it to be worth the trouble
+		bool banded = false;
+		if (_scalerPool) {
+			uint32 pixels = 0;
+			for (r = _dirtyRectList; r != lastRect; ++r) {
+				const int dst_y = r->y + _currentShakePos;
+				if (dst_y < height)
+					pixels += r->w * MIN<int>(r->h, height - dst_y);
+			}
+			banded = pixels >= (uint32)kMinBandedPixels;
+		}
+
+		int bandRows = 0;
+		if (banded) {
+			_scaleBands.clear();
+			_bandScalerProc = scalerProc;
+			_bandSrcPitch = srcPitch;
+			_bandDstPitch = dstPitch;
+			_bandScaleFactor = scale1;
+
+			// Bands of an even number of rows, enough of them for all
+			// threads when the whole screen is scaled
+			const uint numBands = _scalerPool->getNumThreads() * kScaleBandsPerThread;
+			bandRows = MAX<int>(kMinScaleBandRows, (height + numBands - 1) / numBands);
+			bandRows = (bandRows + 1) & ~1;
+		}
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			register int dst_y = r->y + _currentShakePos;
 			register int dst_h = 0;
@@ -1092,12 +1136,18 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 				orig_dst_y = dst_y;
 				dst_y = dst_y * scale1;
 
-				if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+				if (stretch)
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				if (banded) {
+					addScaleBands((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch,
+						(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, rx1, r->w, dst_h, orig_dst_y * scale1, stretch, bandRows);
+				} else {
+					scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+						(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				}
+				scaledPixels += r->w * dst_h;
 			}
 
 			r->x = rx1;
@@ -1106,13 +1156,30 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 			r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
-				r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			if (stretch && orig_dst_y < height) {
+				// The bands are stretched by the scaler threads
+				if (banded)
+					r->h = 1 + real2Aspect(orig_dst_y * scale1 + r->h - 1) - r->y;
+				else
+					r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			}
 #endif
 		}
+
+		if (banded) {
+			// The scratch space is kept for the next frames
+			const uint32 scratchSize = getBandScratchSize();
+			if (_bandScratch.size() < scratchSize)
+				_bandScratch.resize(scratchSize);
+
+			_scalerPool->run(_scaleBands.size(), Common::Functor1Mem<uint, void, SurfaceSdlGraphicsManager>(this, &SurfaceSdlGraphicsManager::scaleBand));
+		}
+
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
+		updateScaleStats(scaledPixels, SDL_GetTicks() - scaleStart);
+
 		// Readjust the dirty rect list in case we are doing a full update.
 		// This is necessary if shaking is active.
 		if (_forceFull) {
@@ -1347,11 +1414,6 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceFull = true;
-		return;
-	}
-
 	int height, width;
 
 	if (!_overlayVisible && !realCoordinates) {
@@ -1401,16 +1463,167 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		return;
 	}
 
-	if (w > 0 && h > 0) {
+	if (w <= 0 || h <= 0)
+		return;
+
+	// Rects in real coordinates are added while the screen is updated,
+	// when the list is already converted to them
+	if (realCoordinates) {
+		if (_numDirtyRects == NUM_DIRTY_RECT) {
+			_forceFull = true;
+			return;
+		}
+
 		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 
 		r->x = x;
 		r->y = y;
 		r->w = w;
 		r->h = h;
+		return;
+	}
+
+	// The region covers both the game screen and the overlay, and is only
+	// resized when the graphics mode changes, which forces a full redraw
+	const int regionWidth = MAX(_videoMode.screenWidth, _videoMode.overlayWidth);
+	const int regionHeight = MAX(_videoMode.screenHeight, _videoMode.overlayHeight);
+	if (_dirtyRegion.getWidth() != regionWidth || _dirtyRegion.getHeight() != regionHeight) {
+		_dirtyRegion.setSize(regionWidth, regionHeight);
+		_forceFull = true;
+		return;
+	}
+
+	_dirtyRegion.add(Common::Rect(x, y, x + w, y + h));
+}
+
+void SurfaceSdlGraphicsManager::collectDirtyRects(int width, int height) {
+	if (_forceFull) {
+		_numDirtyRects = 1;
+		_dirtyRectList[0].x = 0;
+		_dirtyRectList[0].y = 0;
+		_dirtyRectList[0].w = width;
+		_dirtyRectList[0].h = height;
+		_dirtyRegion.clear();
+		return;
+	}
+
+	Common::Rect rects[NUM_DIRTY_RECT];
+	const int maxRects = NUM_DIRTY_RECT - NUM_RESERVED_DIRTY_RECT - _numDirtyRects;
+	const int numRects = (_dirtyRegion.isEmpty() || maxRects <= 0) ? 0 : _dirtyRegion.getRects(rects, maxRects);
+	_dirtyRegion.clear();
+
+	for (int i = 0; i < numRects; ++i) {
+		int x = rects[i].left;
+		int y = rects[i].top;
+		int w = MIN<int>(rects[i].right, width) - x;
+		int h = MIN<int>(rects[i].bottom, height) - y;
+
+		if (w <= 0 || h <= 0)
+			continue;
+
+#ifdef USE_SCALERS
+		// Merging may have moved the edges of the rects
+		if (_videoMode.aspectRatioCorrection && !_overlayVisible)
+			makeRectStretchable(x, y, w, h);
+#endif
+
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+		r->x = x;
+		r->y = y;
+		r->w = w;
+		r->h = h;
 	}
 }
 
+void SurfaceSdlGraphicsManager::updateScaleStats(uint32 pixels, uint32 millis) {
+	_scaleStats.frames++;
+	_scaleStats.rects += _numDirtyRects;
+	_scaleStats.pixels += pixels;
+	_scaleStats.maxPixels = MAX(_scaleStats.maxPixels, pixels);
+	_scaleStats.millis += millis;
+	_scaleStats.maxMillis = MAX(_scaleStats.maxMillis, millis);
+
+	if (_scaleStats.frames == 1000) {
+		debug(3, "SurfaceSdlGraphicsManager: %u rects and %u pixels scaled per frame on average, at most %u pixels",
+		      _scaleStats.rects / _scaleStats.frames, (uint32)(_scaleStats.pixels / _scaleStats.frames), _scaleStats.maxPixels);
+		// With 1000 frames, the total in ms is the average in us
+		debug(3, "SurfaceSdlGraphicsManager: %u.%03u ms spent scaling per frame on average, at most %u ms, on %u threads",
+		      _scaleStats.millis / 1000, _scaleStats.millis % 1000, _scaleStats.maxMillis, _scalerPool ? _scalerPool->getNumThreads() : 1);
+		memset(&_scaleStats, 0, sizeof(_scaleStats));
+	}
+}
+
+void SurfaceSdlGraphicsManager::addScaleBands(const byte *src, byte *dst, int dstX, int width, int height, int realY, bool stretch, int bandRows) {
+	const int scale = _bandScaleFactor;
+
+#ifndef USE_SCALERS
+	// Without the aspect ratio scaler, the rows are scaled like they are
+	// without stretching, as the unbanded scaling does
+	stretch = false;
+#endif
+
+	for (int first = 0; first < height; first += bandRows) {
+		const int rows = MIN(bandRows, height - first);
+
+		ScaleBand band;
+		band.width = width;
+		band.stretch = stretch;
+		band.firstY = band.lastY = band.srcY = 0;
+		band.scratchOffset = band.scratchPitch = 0;
+
+		if (!stretch) {
+			band.src = src + first * _bandSrcPitch;
+			band.dst = dst + first * scale * _bandDstPitch;
+			band.height = rows;
+		} else {
+			// Also scale the last row above the band, for interpolating the
+			// first rows of this one. For rects starting on an interpolated
+			// row, stretching in place takes the row above from the screen
+			// instead, so this is what stretching the whole screen gives.
+			const int m = real2Aspect(realY) % 6;
+			const int overlap = (first || (m != 0 && m != 5)) ? 1 : 0;
+			band.src = src + (first - overlap) * (int)_bandSrcPitch;
+			band.dst = (byte *)_hwscreen->pixels + dstX * 2;
+			band.height = rows + overlap;
+			band.srcY = realY + (first - overlap) * scale;
+			band.firstY = first ? real2Aspect(realY + first * scale - 1) + 1 : real2Aspect(realY);
+			band.lastY = real2Aspect(realY + (first + rows) * scale - 1);
+
+			// Keep the rows aligned, for the interpolation which works on
+			// two pixels at a time
+			band.scratchPitch = (width * scale * 2 + 3) & ~3;
+			band.scratchOffset = getBandScratchSize();
+		}
+
+		_scaleBands.push_back(band);
+	}
+}
+
+uint32 SurfaceSdlGraphicsManager::getBandScratchSize() const {
+	for (uint i = _scaleBands.size(); i > 0; --i) {
+		const ScaleBand &band = _scaleBands[i - 1];
+		if (band.stretch)
+			return band.scratchOffset + band.scratchPitch * band.height * _bandScaleFactor;
+	}
+	return 0;
+}
+
+void SurfaceSdlGraphicsManager::scaleBand(uint index) {
+	const ScaleBand &band = _scaleBands[index];
+
+	if (!band.stretch) {
+		_bandScalerProc(band.src, _bandSrcPitch, band.dst, _bandDstPitch, band.width, band.height);
+		return;
+	}
+
+#ifdef USE_SCALERS
+	byte *scratch = &_bandScratch[band.scratchOffset];
+	_bandScalerProc(band.src, _bandSrcPitch, scratch, band.scratchPitch, band.width, band.height);
+	stretch200To240Rows(band.dst, _bandDstPitch, scratch, band.scratchPitch, band.width * _bandScaleFactor,
+	                    band.firstY, band.lastY, band.srcY);
+#endif
+}
+
 int16 SurfaceSdlGraphicsManager::getHeight() {
 	return _videoMode.screenHeight;
 }
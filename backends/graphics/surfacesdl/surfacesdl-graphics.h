@@ -25,8 +25,10 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/dirtyregion.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
+#include "common/array.h"
 #include "common/events.h"
 #include "common/system.h"
 
@@ -60,6 +62,10 @@ enum {
 };
 
 
+namespace Common {
+class ThreadPool;
+}
+
 class AspectRatio {
 	int _kw, _kh;
 public:
@@ -242,13 +248,92 @@ protected:
 
 	enum {
 		NUM_DIRTY_RECT = 100,
+		/** Room in _dirtyRectList for the rects added after scaling, e.g. by drawMouse() */
+		NUM_RESERVED_DIRTY_RECT = 4,
 		MAX_SCALING = 3
 	};
 
-	// Dirty rect management
+	// Dirty rect management. Rects are collected in _dirtyRegion, in game
+	// or overlay coordinates, which merges overlapping and adjacent ones.
+	// When the screen is updated, they are turned into _dirtyRectList by
+	// collectDirtyRects(), and converted to hardware coordinates in place.
+	Graphics::DirtyRegion _dirtyRegion;
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
+	/** Statistics about the amount of scaling, reported with debug level 3 */
+	struct ScaleStats {
+		uint32 frames;
+		uint32 rects;
+		uint64 pixels;
+		uint32 maxPixels;
+		uint32 millis;
+		uint32 maxMillis;
+	};
+	ScaleStats _scaleStats;
+
+	/**
+	 * A band of rows of a dirty rect, which is scaled on one of the threads
+	 * of _scalerPool.
+	 *
+	 * With aspect ratio correction, the band is scaled into _bandScratch
+	 * first, together with the last source row of the band above, which
+	 * the stretching reads from. The stretched rows are then written to
+	 * the screen, so that bands never read what others write.
+	 */
+	struct ScaleBand {
+		const byte *src;	///< first source row to scale
+		byte *dst;			///< where to scale to, or the screen column of the rect for stretching
+		int width, height;	///< size of the source area
+		bool stretch;
+		int firstY, lastY;	///< screen rows to stretch
+		int srcY;			///< real screen row of the first scaled row
+		uint32 scratchOffset, scratchPitch;
+	};
+
+	enum {
+		/** The smallest number of source rows of a band */
+		kMinScaleBandRows = 8,
+		/** The number of bands for each thread when a whole frame is scaled */
+		kScaleBandsPerThread = 2,
+		/** Frames with fewer source pixels to scale are scaled on the main thread */
+		kMinBandedPixels = 64 * 64
+	};
+
+	/**
+	 * Threads for scaling, or 0 to scale on the main thread. The number of
+	 * threads is set with the "scaler_threads" config key, 0 meaning one
+	 * for each core.
+	 */
+	Common::ThreadPool *_scalerPool;
+	Common::Array<ScaleBand> _scaleBands;
+	Common::Array<byte> _bandScratch;
+	ScalerProc *_bandScalerProc;
+	uint32 _bandSrcPitch, _bandDstPitch;
+	int _bandScaleFactor;
+
+	/**
+	 * Split a dirty rect into bands for the scaler threads.
+	 *
+	 * @param src      first source pixel of the rect
+	 * @param dst      first destination pixel of the rect, without aspect
+	 *                 ratio correction
+	 * @param dstX     destination column of the rect
+	 * @param width    width of the rect
+	 * @param height   height of the rect
+	 * @param realY    destination row of the rect, without aspect ratio
+	 *                 correction
+	 * @param stretch  whether aspect ratio correction is done
+	 * @param bandRows number of source rows of each band
+	 */
+	void addScaleBands(const byte *src, byte *dst, int dstX, int width, int height, int realY, bool stretch, int bandRows);
+
+	/** Return the scratch space needed by the bands in _scaleBands. */
+	uint32 getBandScratchSize() const;
+
+	/** Scale band number @p index of _scaleBands, on any thread. */
+	void scaleBand(uint index);
+
 	struct MousePos {
 		// The mouse position, using either virtual (game) or real
 		// (overlay) coordinates.
@@ -317,6 +402,19 @@ protected:
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
 
+	/**
+	 * Append the dirty rects to redraw to _dirtyRectList, or a single rect
+	 * covering the whole screen if _forceFull is set, and clear the dirty
+	 * region.
+	 *
+	 * @param width  width of the screen or the overlay, whichever is shown
+	 * @param height height of the screen or the overlay, whichever is shown
+	 */
+	void collectDirtyRects(int width, int height);
+
+	/** Account for the pixels scaled during an update and the time it took, see ScaleStats. */
+	void updateScaleStats(uint32 pixels, uint32 millis);
+
 	virtual void drawMouse();
 	virtual void undrawMouse();
 	virtual void blitCursor();
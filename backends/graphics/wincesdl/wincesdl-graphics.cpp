@@ -545,8 +545,14 @@ void WINCESdlGraphicsManager::internUpdateScreen() {
 			_dirtyRectList[0].h = _videoMode.screenHeight;
 		else
 			_dirtyRectList[0].h = _videoMode.screenHeight / 2;
+		// The rects queued so far are part of the full redraw
+		_dirtyRegion.clear();
 
 		_toolbarHandler.forceRedraw();
+	} else if (!_overlayVisible) {
+		collectDirtyRects(_videoMode.screenWidth, _videoMode.screenHeight);
+	} else {
+		collectDirtyRects(_videoMode.overlayWidth, _videoMode.overlayHeight);
 	}
 
 	// Only draw anything if necessary
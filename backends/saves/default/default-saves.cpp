@@ -31,19 +31,109 @@
 #include "common/fs.h"
 #include "common/archive.h"
 #include "common/config-manager.h"
+#include "common/memstream.h"
 #include "common/zlib.h"
 
 #ifndef _WIN32_WCE
 #include <errno.h>	// for removeSavefile()
 #endif
 
-DefaultSaveFileManager::DefaultSaveFileManager() {
+#if defined(WIN32) && !defined(_WIN32_WCE)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// winnt.h defines ARRAYSIZE, but we want our own one...
+#undef ARRAYSIZE
+#endif
+
+namespace {
+
+/** Savefiles are written to a file with this suffix first */
+const char *const kTempSuffix = ".savetmp";
+
+/** The old savefile is kept with this suffix while it is replaced, where that can't be done at once */
+const char *const kOldSuffix = ".saveold";
+
+/**
+ * Replaces a file by another one, keeping the old one if that fails. This
+ * runs on the save thread, so it takes no strings.
+ */
+bool replaceFile(const char *path, const char *newPath, const char *oldPath) {
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	// rename() doesn't replace existing files on Windows
+	return MoveFileExA(newPath, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#elif defined(WIN32)
+	// Move the old file aside, and restore it if the new one can't take its place
+	remove(oldPath);
+	const bool hadOld = rename(path, oldPath) == 0;
+	if (rename(newPath, path) != 0) {
+		if (hadOld)
+			rename(oldPath, path);
+		return false;
+	}
+	if (hadOld)
+		remove(oldPath);
+	return true;
+#else
+	return rename(newPath, path) == 0;
+#endif
+}
+
+} // End of anonymous namespace
+
+class DefaultSaveFileManager::SaveStream : public Common::WriteStream {
+public:
+	SaveStream(DefaultSaveFileManager *manager, SaveJob *job)
+		: _manager(manager), _job(job), _data(DisposeAfterUse::NO), _err(false) {}
+
+	~SaveStream() {
+		finalize();
+	}
+
+	uint32 write(const void *dataPtr, uint32 dataSize) {
+		if (!_job) {
+			_err = true;
+			return 0;
+		}
+
+		return _data.write(dataPtr, dataSize);
+	}
+
+	bool err() const { return _err; }
+	void clearErr() { _err = false; }
+
+	void finalize() {
+		if (!_job)
+			return;
+
+		_job->data = _data.getData();
+		_job->size = _data.size();
+		if (!_manager->queueSave(_job))
+			_err = true;
+		_job = 0;
+	}
+
+private:
+	DefaultSaveFileManager *_manager;
+	SaveJob *_job;
+	Common::MemoryWriteStreamDynamic _data;
+	bool _err;
+};
+
+DefaultSaveFileManager::DefaultSaveFileManager()
+	: _backgroundSaving(true), _saveThread(0), _saveThreadFailed(false),
+	  _queued(0), _written(0), _saveError(Common::kNoError) {
 }
 
-DefaultSaveFileManager::DefaultSaveFileManager(const Common::String &defaultSavepath) {
+DefaultSaveFileManager::DefaultSaveFileManager(const Common::String &defaultSavepath)
+	: _backgroundSaving(true), _saveThread(0), _saveThreadFailed(false),
+	  _queued(0), _written(0), _saveError(Common::kNoError) {
 	ConfMan.registerDefault("savepath", defaultSavepath);
 }
 
+DefaultSaveFileManager::~DefaultSaveFileManager() {
+	stopSaveThread();
+}
+
 
 void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 	clearError();
@@ -57,9 +147,11 @@ void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &pattern) {
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
-	if (getError().getCode() != Common::kNoError)
+	if (_error.getCode() != Common::kNoError)
 		return Common::StringArray();
 
+	waitForSaves();
+
 	// recreate FSNode since checkPath may have changed/created the directory
 	Common::FSNode savePath(savePathName);
 
@@ -70,10 +162,15 @@ Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &
 
 	if (dir.listMatchingMembers(savefiles, search) > 0) {
 		for (Common::ArchiveMemberList::const_iterator file = savefiles.begin(); file != savefiles.end(); ++file) {
-			results.push_back((*file)->getName());
+			const Common::String &name = (*file)->getName();
+			if (!isObserverSavefile(name) && !name.hasSuffix(kTempSuffix) && !name.hasSuffix(kOldSuffix))
+				results.push_back(name);
 		}
 	}
 
+	for (uint i = 0; i < _observers.size(); ++i)
+		_observers[i]->savefilesListed(pattern, results);
+
 	return results;
 }
 
@@ -81,27 +178,50 @@ Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String
 	// Ensure that the savepath is valid. If not, generate an appropriate error.
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
-	if (getError().getCode() != Common::kNoError)
+	if (_error.getCode() != Common::kNoError)
 		return 0;
 
+	waitForSaves();
+
 	// recreate FSNode since checkPath may have changed/created the directory
 	Common::FSNode savePath(savePathName);
 
 	Common::FSNode file = savePath.getChild(filename);
-	if (!file.exists())
-		return 0;
+	Common::InSaveFile *sf = 0;
 
 	// Open the file for reading
-	Common::SeekableReadStream *sf = file.createReadStream();
+	if (file.exists())
+		sf = Common::wrapCompressedReadStream(file.createReadStream());
+
+	uint32 mtime = 0, mtimeMicros = 0;
+	if (sf && !_observers.empty())
+		mtime = file.getModificationTime(&mtimeMicros);
+
+	for (uint i = 0; i < _observers.size(); ++i)
+		_observers[i]->savefileOpened(filename, sf ? sf->size() : -1, mtime, mtimeMicros);
+
+	return sf;
+}
+
+uint32 DefaultSaveFileManager::getModificationTime(const Common::String &filename, uint32 *microseconds) {
+	if (microseconds)
+		*microseconds = 0;
 
-	return Common::wrapCompressedReadStream(sf);
+	Common::FSNode savePath(getSavePath());
+	if (!savePath.isDirectory())
+		return 0;
+
+	waitForSaves();
+
+	Common::FSNode file = savePath.getChild(filename);
+	return file.exists() ? file.getModificationTime(microseconds) : 0;
 }
 
 Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String &filename, bool compress) {
 	// Ensure that the savepath is valid. If not, generate an appropriate error.
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
-	if (getError().getCode() != Common::kNoError)
+	if (_error.getCode() != Common::kNoError)
 		return 0;
 
 	// recreate FSNode since checkPath may have changed/created the directory
@@ -109,18 +229,50 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 
 	Common::FSNode file = savePath.getChild(filename);
 
-	// Open the file for saving
-	Common::WriteStream *sf = file.createWriteStream();
+	collectSaves(false);
+	// A savefile of the same name still being written would share the
+	// temporary file with this one
+	if (isSavePending(filename))
+		waitForSaves();
+	// Failures of the savefiles before this one are not reported anymore.
+	// Observers write their own savefiles behind the back of the engine and
+	// the user, who must still see those failures.
+	if (!isObserverSavefile(filename)) {
+		_saveError = Common::kNoError;
+		_saveErrorDesc.clear();
+	}
+
+	savefileChanged(filename);
 
-	return compress ? Common::wrapCompressedWriteStream(sf) : sf;
+	// Open the temporary file for saving
+	Common::FSNode tempFile = savePath.getChild(filename + kTempSuffix);
+	Common::WriteStream *sf = tempFile.createWriteStream();
+	if (!sf)
+		return 0;
+
+	SaveJob *job = new SaveJob();
+	job->file = sf;
+	job->data = 0;
+	job->size = 0;
+	job->compress = compress;
+	job->name = Common::String(filename.c_str());
+	job->path = Common::String(file.getPath().c_str());
+	job->tempPath = Common::String(tempFile.getPath().c_str());
+	job->oldPath = job->path + kOldSuffix;
+	job->result = SaveJob::kResultOk;
+
+	return new SaveStream(this, job);
 }
 
 bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
-	if (getError().getCode() != Common::kNoError)
+	if (_error.getCode() != Common::kNoError)
 		return false;
 
+	// Otherwise the savefile might be written again after it was removed
+	waitForSaves();
+
 	// recreate FSNode since checkPath may have changed/created the directory
 	Common::FSNode savePath(savePathName);
 
@@ -139,10 +291,203 @@ bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
 #endif
 		return false;
 	} else {
+		savefileChanged(filename);
 		return true;
 	}
 }
 
+bool DefaultSaveFileManager::addObserver(Common::SaveFileObserver *observer) {
+	_observers.push_back(observer);
+	return true;
+}
+
+void DefaultSaveFileManager::removeObserver(Common::SaveFileObserver *observer) {
+	for (uint i = 0; i < _observers.size(); ++i) {
+		if (_observers[i] == observer) {
+			_observers.remove_at(i);
+			return;
+		}
+	}
+}
+
+Common::Error DefaultSaveFileManager::getError() {
+	// Report the savefiles which failed in the meantime
+	collectSaves(false);
+	if (_error.getCode() == Common::kNoError)
+		return _saveError;
+	return _error;
+}
+
+Common::String DefaultSaveFileManager::getErrorDesc() {
+	collectSaves(false);
+	if (_error.getCode() == Common::kNoError)
+		return _saveErrorDesc;
+	return _errorDesc;
+}
+
+Common::String DefaultSaveFileManager::popErrorDesc() {
+	const Common::String desc = getErrorDesc();
+	clearError();
+	_saveError = Common::kNoError;
+	_saveErrorDesc.clear();
+	return desc;
+}
+
+void DefaultSaveFileManager::waitForSaves() {
+	collectSaves(true);
+}
+
+void DefaultSaveFileManager::setBackgroundSavingEnabled(bool enabled) {
+	if (!enabled)
+		stopSaveThread();
+	_backgroundSaving = enabled;
+}
+
+bool DefaultSaveFileManager::queueSave(SaveJob *job) {
+	if (_backgroundSaving && !_saveThread && !_saveThreadFailed) {
+		_saveThread = new SaveThread(this);
+		if (!_saveThread->start()) {
+			// Write the savefiles on this thread instead
+			delete _saveThread;
+			_saveThread = 0;
+			_saveThreadFailed = true;
+		}
+	}
+
+	if (!_saveThread) {
+		writeSave(*job);
+		const bool failed = job->result != SaveJob::kResultOk;
+		finishSave(job);
+		return !failed;
+	}
+
+	_pendingSaves.push_back(Common::String(job->name.c_str()));
+
+	{
+		Common::StackLock lock(_queueMutex);
+		_queue.push_back(job);
+	}
+	_queued.post();
+	return true;
+}
+
+void DefaultSaveFileManager::collectSaves(bool wait) {
+	while (!_pendingSaves.empty()) {
+		if (wait)
+			_written.wait();
+		else if (!_written.tryWait())
+			break;
+
+		SaveJob *job;
+		{
+			Common::StackLock lock(_queueMutex);
+			job = _done.front();
+			_done.remove_at(0);
+		}
+
+		_pendingSaves.remove_at(0);
+		finishSave(job);
+	}
+}
+
+bool DefaultSaveFileManager::isSavePending(const Common::String &filename) const {
+	for (uint i = 0; i < _pendingSaves.size(); ++i) {
+		if (_pendingSaves[i] == filename)
+			return true;
+	}
+	return false;
+}
+
+void DefaultSaveFileManager::finishSave(SaveJob *job) {
+	if (job->result != SaveJob::kResultOk) {
+		_saveError = Common::kWritingFailed;
+		if (job->result == SaveJob::kResultWriteFailed)
+			_saveErrorDesc = "Could not write the savefile '" + job->name + "'";
+		else
+			_saveErrorDesc = "Could not replace the savefile '" + job->name + "'";
+	}
+
+	delete job;
+}
+
+void DefaultSaveFileManager::stopSaveThread() {
+	if (!_saveThread)
+		return;
+
+	collectSaves(true);
+
+	{
+		Common::StackLock lock(_queueMutex);
+		_queue.push_back(0);
+	}
+	_queued.post();
+
+	_saveThread->join();
+	delete _saveThread;
+	_saveThread = 0;
+}
+
+void DefaultSaveFileManager::writeQueuedSaves() {
+	for (;;) {
+		_queued.wait();
+
+		SaveJob *job;
+		{
+			Common::StackLock lock(_queueMutex);
+			job = _queue.front();
+			_queue.remove_at(0);
+		}
+
+		if (!job)
+			return;
+
+		writeSave(*job);
+
+		{
+			Common::StackLock lock(_queueMutex);
+			_done.push_back(job);
+		}
+		_written.post();
+	}
+}
+
+void DefaultSaveFileManager::writeSave(SaveJob &job) {
+	Common::WriteStream *out = job.compress ? Common::wrapCompressedWriteStream(job.file) : job.file;
+	job.file = 0;
+
+	out->write(job.data, job.size);
+	out->finalize();
+	const bool failed = out->err();
+	delete out;
+
+	free(job.data);
+	job.data = 0;
+
+	if (failed) {
+		remove(job.tempPath.c_str());
+		job.result = SaveJob::kResultWriteFailed;
+		return;
+	}
+
+	if (!replaceFile(job.path.c_str(), job.tempPath.c_str(), job.oldPath.c_str())) {
+		remove(job.tempPath.c_str());
+		job.result = SaveJob::kResultReplaceFailed;
+	}
+}
+
+bool DefaultSaveFileManager::isObserverSavefile(const Common::String &filename) const {
+	for (uint i = 0; i < _observers.size(); ++i) {
+		if (_observers[i]->isOwnSavefile(filename))
+			return true;
+	}
+	return false;
+}
+
+void DefaultSaveFileManager::savefileChanged(const Common::String &filename) {
+	for (uint i = 0; i < _observers.size(); ++i)
+		_observers[i]->savefileChanged(filename);
+}
+
 Common::String DefaultSaveFileManager::getSavePath() const {
 
 	Common::String dir;
@@ -24,23 +24,54 @@
 #define BACKEND_SAVES_DEFAULT_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/fs.h"
+#include "common/mutex.h"
+#include "common/thread.h"
 
 /**
  * Provides a default savefile manager implementation for common platforms.
+ *
+ * Savefiles are written to a temporary file, which replaces the savefile
+ * once it is complete, so a failed save doesn't destroy the old one. The
+ * data written to an OutSaveFile is kept in memory until it is finalized
+ * or deleted, and then compressed and written on a thread of its own, if
+ * threads are available. Failures are reported by getError() once the
+ * savefile is done, unless a later call failed, until popErrorDesc() is
+ * called or the next savefile is opened for saving. Loading, listing and
+ * removing savefiles waits for the savefiles being written first.
  */
 class DefaultSaveFileManager : public Common::SaveFileManager {
 public:
 	DefaultSaveFileManager();
 	DefaultSaveFileManager(const Common::String &defaultSavepath);
+	virtual ~DefaultSaveFileManager();
 
 	virtual Common::StringArray listSavefiles(const Common::String &pattern);
 	virtual Common::InSaveFile *openForLoading(const Common::String &filename);
+	virtual uint32 getModificationTime(const Common::String &filename, uint32 *microseconds = 0);
 	virtual Common::OutSaveFile *openForSaving(const Common::String &filename, bool compress = true);
 	virtual bool removeSavefile(const Common::String &filename);
 
+	virtual Common::Error getError();
+	virtual Common::String getErrorDesc();
+	virtual Common::String popErrorDesc();
+
+	virtual bool addObserver(Common::SaveFileObserver *observer);
+	virtual void removeObserver(Common::SaveFileObserver *observer);
+
+	/**
+	 * Waits until all savefiles are written. Failures are reported by
+	 * getError().
+	 */
+	void waitForSaves();
+
+	/** If disabled, savefiles are written when they are finalized, on the calling thread. */
+	bool isBackgroundSavingEnabled() const { return _backgroundSaving; }
+	void setBackgroundSavingEnabled(bool enabled);
+
 protected:
 	/**
 	 * Get the path to the savegame directory.
@@ -54,6 +85,95 @@ protected:
 	 * Sets the internal error and error message accordingly.
 	 */
 	virtual void checkPath(const Common::FSNode &dir);
+
+	Common::Array<Common::SaveFileObserver *> _observers;
+
+	/** @return true if the savefile is one an observer stores for itself */
+	bool isObserverSavefile(const Common::String &filename) const;
+	/** Tells the observers that a savefile is about to be written, or was renamed or removed. */
+	void savefileChanged(const Common::String &filename);
+
+private:
+	/** A savefile to be written, and afterwards the result */
+	struct SaveJob {
+		/** the temporary file */
+		Common::WriteStream *file;
+		byte *data;
+		uint32 size;
+		bool compress;
+
+		// Copying strings isn't thread safe, so the save thread only reads
+		// these, and they are copies of their own
+		Common::String name;
+		Common::String path;
+		Common::String tempPath;
+		/** where the old savefile is kept while it is replaced, if that can't be done at once */
+		Common::String oldPath;
+
+		enum Result {
+			kResultOk,
+			kResultWriteFailed,
+			kResultReplaceFailed
+		};
+		Result result;
+	};
+
+	/** The OutSaveFile, which keeps the data in memory */
+	class SaveStream;
+
+	class SaveThread : public Common::Thread {
+	public:
+		SaveThread(DefaultSaveFileManager *manager) : _manager(manager) {}
+
+	protected:
+		void run() { _manager->writeQueuedSaves(); }
+
+	private:
+		DefaultSaveFileManager *_manager;
+	};
+
+	bool _backgroundSaving;
+	SaveThread *_saveThread;
+	bool _saveThreadFailed;
+
+	/**
+	 * The main thread queues savefiles, the save thread writes them and
+	 * hands them back. The queues are guarded by _queueMutex, _queued and
+	 * _written count the savefiles in them. A NULL job stops the thread.
+	 */
+	Common::Array<SaveJob *> _queue, _done;
+	Common::Mutex _queueMutex;
+	Common::Semaphore _queued, _written;
+	/**
+	 * The names of the savefiles queued, but not taken back from the save
+	 * thread yet, in the order they are written. These are copies of the
+	 * main thread.
+	 */
+	Common::StringArray _pendingSaves;
+
+	/**
+	 * The last failure of a savefile written in the background. It is kept
+	 * apart from _error, which the checks of the savepath clear.
+	 */
+	Common::Error _saveError;
+	Common::String _saveErrorDesc;
+
+	/**
+	 * Writes a savefile on the save thread, or right away if there is none.
+	 * @return false if it was written right away, and that failed
+	 */
+	bool queueSave(SaveJob *job);
+	/** Takes back the written savefiles from the save thread, optionally waiting for all of them. */
+	void collectSaves(bool wait);
+	/** @return true if a savefile of that name is queued, but not taken back yet */
+	bool isSavePending(const Common::String &filename) const;
+	/** Reports the result of a written savefile, and deletes it. */
+	void finishSave(SaveJob *job);
+	void stopSaveThread();
+	/** The loop of the save thread. */
+	void writeQueuedSaves();
+	/** Compresses and writes a savefile, then replaces the old one by it. */
+	static void writeSave(SaveJob &job);
 };
 
 #endif
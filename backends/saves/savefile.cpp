@@ -71,6 +71,12 @@ bool SaveFileManager::renameSavefile(const String &oldFilename, const String &ne
 	return removeSavefile(oldFilename);
 }
 
+uint32 SaveFileManager::getModificationTime(const String &name, uint32 *microseconds) {
+	if (microseconds)
+		*microseconds = 0;
+	return 0;
+}
+
 String SaveFileManager::popErrorDesc() {
 	String err = _errorDesc;
 	clearError();
@@ -33,6 +33,7 @@
 
 #include "engines/engine.h"
 #include "engines/metaengine.h"
+#include "engines/saveindex.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
@@ -423,6 +424,9 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	MusicManager::instance();
 	Common::DebugManager::instance();
 
+	// Keep the save state indices up to date from the start
+	SaveStateIndexMan.attach(system.getSavefileManager());
+
 	// Init the event manager. As the virtual keyboard is loaded here, it must
 	// take place after the backend is initiated and the screen has been setup
 	system.getEventManager()->init();
@@ -473,6 +477,10 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 			// Try to run the game
 			Common::Error result = runGame(plugin, system, specialDebug);
 
+			// Write what the game changed in the save state indices while
+			// its savepath is still the current one
+			SaveStateIndexMan.flush();
+
 #ifdef ENABLE_EVENTRECORDER
 			// Flush Event recorder file. The recorder does not get reinitialized for next game
 			// which is intentional. Only single game per session is allowed.
@@ -528,6 +536,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
+	// Writes the save state indices of the current savepath
+	SaveStateIndexManager::destroy();
 	Common::ConfigManager::destroy();
 	Common::DebugManager::destroy();
 #ifdef ENABLE_EVENTRECORDER
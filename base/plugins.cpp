@@ -25,6 +25,7 @@
 #include "common/func.h"
 #include "common/debug.h"
 #include "common/config-manager.h"
+#include "common/md5cache.h"
 
 #ifdef DYNAMIC_MODULES
 #include "common/fs.h"
@@ -518,6 +519,8 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
+	// Detectors of different engines often look at the same files
+	Common::MD5Cache::instance().beginBatch();
 	PluginManager::instance().loadFirstPlugin();
 	do {
 		plugins = getPlugins();
@@ -527,6 +530,7 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+	Common::MD5Cache::instance().endBatch();
 	return candidates;
 }
 
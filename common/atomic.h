@@ -0,0 +1,92 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+// Pulls in intrin.h on MSVC
+#include "common/math.h"
+
+namespace Common {
+
+/**
+ * Full memory barrier: neither the compiler nor the CPU may move memory
+ * accesses across it.
+ *
+ * This is the building block for the few places which share data between
+ * threads without a mutex, e.g. between the mixer callback and the engine.
+ * On platforms where we do not know how to issue a barrier, it only
+ * prevents compiler reordering; those are single core systems as far as
+ * ScummVM is concerned.
+ */
+inline void memoryBarrier() {
+#if defined(_MSC_VER)
+	long dummy = 0;
+	_InterlockedExchange(&dummy, 0);
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+	__sync_synchronize();
+#elif defined(__GNUC__)
+	__asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+/**
+ * Reads a value written by another thread with atomicStore(). Memory
+ * accesses following the load are not moved before it.
+ */
+template<typename T>
+inline T atomicLoad(const volatile T &var) {
+	const T value = var;
+	memoryBarrier();
+	return value;
+}
+
+/**
+ * Publishes a value to other threads. Memory accesses preceding the store
+ * are visible to a thread which sees the new value through atomicLoad().
+ *
+ * Only use this with types no larger than a machine word.
+ */
+template<typename T>
+inline void atomicStore(volatile T &var, T value) {
+	memoryBarrier();
+	var = value;
+}
+
+/**
+ * Atomically adds @p delta to @p var and returns the new value.
+ */
+inline int32 atomicAdd(volatile int32 &var, int32 delta) {
+#if defined(_MSC_VER)
+	return _InterlockedExchangeAdd((volatile long *)&var, delta) + delta;
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+	return __sync_add_and_fetch(&var, delta);
+#else
+	// No atomic instructions known, see memoryBarrier()
+	return var += delta;
+#endif
+}
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,124 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/cpudetect.h"
+
+#if defined(SCUMMVM_SSE2)
+#if defined(_MSC_VER)
+// Pulls in intrin.h
+#include "common/math.h"
+#elif defined(__GNUC__)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace Common {
+
+namespace {
+
+#if defined(SCUMMVM_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+
+void cpuid(uint32 leaf, uint32 regs[4]) {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, 0);
+	for (int i = 0; i < 4; ++i)
+		regs[i] = info[i];
+#else
+	__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+#ifdef SCUMMVM_AVX2
+uint32 readXCR0() {
+#if defined(_MSC_VER)
+	return (uint32)_xgetbv(0);
+#else
+	uint32 eax, edx;
+	// xgetbv, spelled out for assemblers which do not know the mnemonic
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#endif
+}
+#endif
+
+uint32 probeCpuFeatures() {
+	uint32 features = 0;
+	uint32 regs[4];
+
+	cpuid(0, regs);
+	const uint32 maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return 0;
+
+	cpuid(1, regs);
+	if (regs[3] & (1 << 26))
+		features |= kCpuFeatureSSE2;
+
+#ifdef SCUMMVM_AVX2
+	// AVX2 needs OS support for saving the YMM registers (OSXSAVE + XCR0)
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	if (osxsave && maxLeaf >= 7 && (readXCR0() & 0x6) == 0x6) {
+		cpuid(7, regs);
+		if (regs[1] & (1 << 5))
+			features |= kCpuFeatureAVX2;
+	}
+#endif
+
+	return features;
+}
+
+#elif defined(SCUMMVM_NEON)
+
+uint32 probeCpuFeatures() {
+	// Builds targeting NEON cannot run on CPUs without it anyway
+	return kCpuFeatureNEON;
+}
+
+#else
+
+uint32 probeCpuFeatures() {
+	return 0;
+}
+
+#endif
+
+bool s_probed = false;
+uint32 s_features = 0;
+uint32 s_mask = 0xFFFFFFFF;
+
+} // End of anonymous namespace
+
+uint32 getCpuFeatures() {
+	if (!s_probed) {
+		s_features = probeCpuFeatures();
+		s_probed = true;
+	}
+
+	return s_features & s_mask;
+}
+
+void setCpuFeatureMask(uint32 mask) {
+	s_mask = mask;
+}
+
+} // End of namespace Common
@@ -0,0 +1,90 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_CPUDETECT_H
+#define COMMON_CPUDETECT_H
+
+#include "common/scummsys.h"
+
+/**
+ * @def SCUMMVM_SSE2
+ * Defined when the compiler targets a CPU for which SSE2 intrinsics
+ * (emmintrin.h) can be used. Code using it must still check
+ * Common::hasCpuFeature(Common::kCpuFeatureSSE2) at runtime.
+ *
+ * @def SCUMMVM_AVX2
+ * Defined when the compiler can emit AVX2 code for individual functions
+ * (via the target attribute), even if the build targets an older CPU.
+ *
+ * @def SCUMMVM_NEON
+ * Defined when the compiler targets an ARM CPU with NEON (arm_neon.h).
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCUMMVM_SSE2
+#endif
+
+#if defined(SCUMMVM_SSE2) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define SCUMMVM_AVX2
+#define SCUMMVM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define SCUMMVM_NEON
+#endif
+
+namespace Common {
+
+/**
+ * Instruction set extensions which may be used by optimized code paths.
+ */
+enum CpuFeature {
+	kCpuFeatureSSE2 = 1 << 0,
+	kCpuFeatureAVX2 = 1 << 1,
+	kCpuFeatureNEON = 1 << 2
+};
+
+/**
+ * Returns a bitmask of CpuFeature values supported both by the CPU we are
+ * running on and by this build. The CPU is only probed on the first call.
+ */
+uint32 getCpuFeatures();
+
+/**
+ * Checks whether the given feature may be used by optimized code paths.
+ */
+inline bool hasCpuFeature(CpuFeature feature) {
+	return (getCpuFeatures() & feature) != 0;
+}
+
+/**
+ * Restricts the features reported by getCpuFeatures() to the given mask.
+ * Passing 0 forces all callers onto their plain C fallbacks, which is
+ * mostly useful for comparing optimized code against the reference paths.
+ * Callers which cache their dispatch decision need to re-query afterwards.
+ *
+ * @param mask	bitmask of CpuFeature values which may be reported
+ */
+void setCpuFeatureMask(uint32 mask);
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,507 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/func.h"
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in alternative to HashMap<Key,Val>, with
+ * the same interface and the same requirements on Key, Val, HashFunc and
+ * EqualFunc.
+ *
+ * Instead of an array of pointers to separately allocated nodes, it keeps
+ * the keys, their hashes and the values inline in a single array, which
+ * is searched by linear probing. A lookup thus usually touches a single
+ * cache line, and keys are only compared when their hashes match. The
+ * price is that growing the map copies all keys and values, and that
+ * empty slots hold default constructed keys and values. Hence it works
+ * best for maps of small keys and values which are looked up much more
+ * often than they are modified.
+ *
+ * Like with HashMap, erasing an entry does not invalidate iterators, so
+ * entries may be erased while iterating over the map.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	enum SlotState {
+		kSlotEmpty = 0,
+		kSlotUsed,
+		kSlotDeleted
+	};
+
+	struct Node {
+		Key _key;
+		Val _value;
+		/** Hash of _key, to avoid comparing keys and rehashing */
+		size_type _hash;
+		byte _state;
+
+		Node() : _key(), _value(), _hash(0), _state(kSlotEmpty) {}
+	};
+
+	enum {
+		HASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage of the hashmap may fill up, including erased
+		// entries, before it is rebuilt.
+		HASHMAP_LOADFACTOR_NUMERATOR = 2,
+		HASHMAP_LOADFACTOR_DENOMINATOR = 3
+	};
+
+	Node *_storage;	///< hashtable of size arrsize.
+	size_type _mask;		///< Capacity of the HashMap minus one; must be a power of two of minus one
+	uint _shift;		///< 32 minus log2 of the capacity
+	size_type _size;
+	size_type _deleted; ///< Number of erased entries
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Map a hash to its home slot. Many hash functions (e.g. the ones
+	 * for integers) do not mix their bits, which linear probing does
+	 * not cope well with, so use the top bits of a multiplicative hash.
+	 */
+	size_type homeSlot(size_type hash) const {
+		return (size_type)((uint32)(hash * 2654435769U) >> _shift);
+	}
+
+	void allocStorage(size_type capacity);
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rebuildStorage(size_type newCapacity);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			Node *node = &_hashmap->_storage[_idx];
+			assert(node->_state == kSlotUsed);
+			return node;
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && _hashmap->_storage[_idx]._state != kSlotUsed);
+			if (_idx > _hashmap->_mask)
+				_idx = (size_type)-1;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		delete[] _storage;
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (_storage[ctr]._state == kSlotUsed)
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (_storage[ctr]._state == kSlotUsed)
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (_storage[ctr]._state == kSlotUsed)
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (_storage[ctr]._state == kSlotUsed)
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(HASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	delete[] _storage;
+}
+
+/**
+ * Internal method for allocating empty storage of the given capacity,
+ * which must be a power of two.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	_mask = capacity - 1;
+	_shift = 32;
+	for (size_type c = capacity; c > 1; c >>= 1)
+		_shift--;
+
+	_storage = new Node[capacity];
+	assert(_storage != NULL);
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Simply clone the storage, slot by slot.
+	for (size_type ctr = 0; ctr <= _mask; ++ctr)
+		_storage[ctr] = map._storage[ctr];
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
+		delete[] _storage;
+		allocStorage(HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	// Reset the slots, so that they release any memory held by keys
+	// and values
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_storage[ctr]._state != kSlotEmpty)
+			_storage[ctr] = Node();
+	}
+
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Move all entries into new storage of the given capacity, which also
+ * drops all erased entries.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rebuildStorage(size_type newCapacity) {
+	assert(newCapacity > _size);
+
+#ifndef NDEBUG
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	Node *old_storage = _storage;
+
+	allocStorage(newCapacity);
+
+	// Reinsert all the old elements. Since we know that no key exists
+	// twice in the old table, and we have their hashes, we neither have
+	// to hash nor to compare keys.
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_storage[ctr]._state != kSlotUsed)
+			continue;
+
+		size_type idx = homeSlot(old_storage[ctr]._hash);
+		while (_storage[idx]._state != kSlotEmpty)
+			idx = (idx + 1) & _mask;
+
+		_storage[idx] = old_storage[ctr];
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	delete[] old_storage;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const size_type hash = _hash(key);
+	size_type ctr = homeSlot(hash);
+	for (;;) {
+		const Node &node = _storage[ctr];
+		if (node._state == kSlotEmpty)
+			break;
+		if (node._state == kSlotUsed && node._hash == hash && _equal(node._key, key))
+			break;
+
+		ctr = (ctr + 1) & _mask;
+	}
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = _hash(key);
+	size_type ctr = homeSlot(hash);
+	const size_type NONE_FOUND = _mask + 1;
+	size_type first_free = NONE_FOUND;
+	for (;;) {
+		const Node &node = _storage[ctr];
+		if (node._state == kSlotEmpty)
+			break;
+		if (node._state == kSlotDeleted) {
+			if (first_free == NONE_FOUND)
+				first_free = ctr;
+		} else if (node._hash == hash && _equal(node._key, key)) {
+			return ctr;
+		}
+
+		ctr = (ctr + 1) & _mask;
+	}
+
+	// Reuse the first erased slot on the way, if any
+	if (first_free != NONE_FOUND) {
+		ctr = first_free;
+		_deleted--;
+	}
+
+	Node &node = _storage[ctr];
+	node._key = key;
+	node._hash = hash;
+	node._state = kSlotUsed;
+	_size++;
+
+	// Keep the load factor below a certain threshold.
+	// Erased entries are also counted
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted) * HASHMAP_LOADFACTOR_DENOMINATOR >
+	        capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+		// Grow unless the map is full of erased entries, in which case
+		// dropping them is enough
+		if (_size * 2 > capacity)
+			capacity = capacity < 500 ? (capacity * 4) : (capacity * 2);
+		rebuildStorage(capacity);
+		ctr = lookup(key);
+		assert(_storage[ctr]._state == kSlotUsed);
+	}
+
+	return ctr;
+}
+
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	size_type ctr = lookup(key);
+	return (_storage[ctr]._state == kSlotUsed);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _storage[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (_storage[ctr]._state == kSlotUsed)
+		return _storage[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_storage[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const size_type ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(_storage[ctr]._state == kSlotUsed);
+
+	// If we remove a key, we mark its slot as erased, so that the probe
+	// sequences of other keys stay intact, and release its memory.
+	_storage[ctr] = Node();
+	_storage[ctr]._state = kSlotDeleted;
+	_size--;
+	_deleted++;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+
+	size_type ctr = lookup(key);
+	if (_storage[ctr]._state != kSlotUsed)
+		return;
+
+	// If we remove a key, we mark its slot as erased, so that the probe
+	// sequences of other keys stay intact, and release its memory.
+	_storage[ctr] = Node();
+	_storage[ctr]._state = kSlotDeleted;
+	_size--;
+	_deleted++;
+}
+
+} // End of namespace Common
+
+#endif
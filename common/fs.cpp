@@ -19,6 +19,10 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/endian.h"
+#include "common/stream.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "backends/fs/abstract-fs.h"
@@ -124,6 +128,25 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+uint32 FSNode::getModificationTime(uint32 *microseconds) const {
+	uint32 fraction = 0;
+	const uint32 seconds = _realNode ? _realNode->getModificationTime(fraction) : 0;
+	if (microseconds)
+		*microseconds = fraction;
+	return seconds;
+}
+
+int32 FSNode::getFileSize() const {
+	return _realNode ? _realNode->getFileSize() : -1;
+}
+
+FSNode FSNode::makeChild(const String &n, bool isDirectory) const {
+	assert(_realNode && _realNode->isDirectory());
+
+	AbstractFSNode *node = _realNode->makeChild(n, isDirectory);
+	return FSNode(node);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -151,6 +174,267 @@ WriteStream *FSNode::createWriteStream() const {
 	return _realNode->createWriteStream();
 }
 
+/**
+ * The on-disk index of a directory tree, used by FSDirectory.
+ *
+ * It stores the listings of all directories of the tree, along with the
+ * modification times of the directories. A listing is reused as long as
+ * the modification time of its directory did not change, which saves
+ * reading the directory and finding out the types of its entries.
+ *
+ * Each tree (root path and depth) has its own index file in the directory
+ * given by the 'fsindexpath' config key. Without it, the index does
+ * nothing.
+ */
+class FSDirectoryIndex {
+public:
+	FSDirectoryIndex(const FSNode &root, int depth);
+
+	/**
+	 * List the given directory, from the index if it is still valid.
+	 */
+	bool getChildren(const FSNode &dir, FSList &list);
+
+	/**
+	 * Save the index, if anything changed, and report the statistics of
+	 * the scan.
+	 *
+	 * @param millis how long the scan took
+	 */
+	void finish(uint32 millis);
+
+private:
+	enum {
+		kVersion = 1,
+		/** limit for names read from an index, to detect garbage */
+		kMaxStringLength = 4096
+	};
+
+	struct Entry {
+		String name;
+		bool isDirectory;
+	};
+
+	struct Listing {
+		/** the modification time of the directory, see FSNode::getModificationTime() */
+		uint32 mtime;
+		uint32 mtimeMicros;
+		Array<Entry> entries;
+	};
+
+	typedef HashMap<String, Listing> ListingMap;
+
+	FSNode _file;
+	/** the path of the directory the index file is in */
+	String _fileDirPath;
+	String _rootPath;
+	int _depth;
+
+	/** the listings loaded from the index file */
+	ListingMap _listings;
+	/** the listings of the directories visited by the current scan */
+	ListingMap _visited;
+	/** duration of the last scan without the index */
+	uint32 _scanMillis;
+
+	uint _hits;
+	uint _misses;
+
+	void load();
+	void save(uint32 scanMillis);
+
+	static bool readString(SeekableReadStream &stream, String &str);
+	static void writeString(WriteStream &stream, const String &str);
+};
+
+FSDirectoryIndex::FSDirectoryIndex(const FSNode &root, int depth)
+	: _depth(depth), _scanMillis(0), _hits(0), _misses(0) {
+
+	const String indexPath = ConfMan.get("fsindexpath");
+	if (indexPath.empty() || !root.isDirectory())
+		return;
+
+	FSNode indexDir(indexPath);
+	if (!indexDir.isDirectory()) {
+		warning("FSDirectoryIndex: '%s' is not a directory", indexPath.c_str());
+		return;
+	}
+
+	_rootPath = root.getPath();
+	_file = indexDir.getChild(String::format("fsindex-%08x-%d.dat", hashit(_rootPath.c_str()), depth));
+	_fileDirPath = indexDir.getPath();
+	load();
+}
+
+void FSDirectoryIndex::load() {
+	if (!_file.exists())
+		return;
+
+	SeekableReadStream *stream = _file.createReadStream();
+	if (!stream)
+		return;
+
+	String rootPath;
+	bool valid = stream->readUint32BE() == MKTAG('F', 'S', 'I', 'X') &&
+	             stream->readUint32LE() == kVersion &&
+	             readString(*stream, rootPath) && rootPath == _rootPath &&
+	             stream->readSint32LE() == _depth;
+
+	_scanMillis = stream->readUint32LE();
+	uint32 count = stream->readUint32LE();
+
+	while (valid && count--) {
+		String path;
+		Listing listing;
+
+		valid = readString(*stream, path);
+		listing.mtime = stream->readUint32LE();
+		listing.mtimeMicros = stream->readUint32LE();
+		uint32 entries = stream->readUint32LE();
+		while (valid && entries--) {
+			Entry entry;
+			valid = readString(*stream, entry.name) && !entry.name.contains('/');
+			entry.isDirectory = stream->readByte() != 0;
+			listing.entries.push_back(entry);
+		}
+
+		valid = valid && !stream->err() && !stream->eos();
+		if (valid)
+			_listings[path] = listing;
+	}
+
+	if (!valid || stream->err()) {
+		warning("FSDirectoryIndex: Ignoring invalid index file '%s'", _file.getPath().c_str());
+		_listings.clear();
+		_scanMillis = 0;
+	}
+
+	delete stream;
+}
+
+void FSDirectoryIndex::save(uint32 scanMillis) {
+	WriteStream *stream = _file.createWriteStream();
+	if (!stream) {
+		warning("FSDirectoryIndex: Can't write index file '%s'", _file.getPath().c_str());
+		return;
+	}
+
+	stream->writeUint32BE(MKTAG('F', 'S', 'I', 'X'));
+	stream->writeUint32LE(kVersion);
+	writeString(*stream, _rootPath);
+	stream->writeSint32LE(_depth);
+	stream->writeUint32LE(scanMillis);
+	stream->writeUint32LE(_visited.size());
+
+	for (ListingMap::const_iterator i = _visited.begin(); i != _visited.end(); ++i) {
+		writeString(*stream, i->_key);
+		stream->writeUint32LE(i->_value.mtime);
+		stream->writeUint32LE(i->_value.mtimeMicros);
+		stream->writeUint32LE(i->_value.entries.size());
+		for (uint j = 0; j < i->_value.entries.size(); ++j) {
+			writeString(*stream, i->_value.entries[j].name);
+			stream->writeByte(i->_value.entries[j].isDirectory ? 1 : 0);
+		}
+	}
+
+	stream->finalize();
+	if (stream->err())
+		warning("FSDirectoryIndex: Can't write index file '%s'", _file.getPath().c_str());
+	delete stream;
+}
+
+bool FSDirectoryIndex::getChildren(const FSNode &dir, FSList &list) {
+	if (_rootPath.empty())
+		return dir.getChildren(list, FSNode::kListAll, true);
+
+	const String path = dir.getPath();
+	uint32 mtimeMicros;
+	const uint32 mtime = dir.getModificationTime(&mtimeMicros);
+
+	// Directories without a modification time are never trusted
+	if (mtime != 0 && _listings.contains(path)) {
+		const Listing &listing = _listings[path];
+		if (listing.mtime == mtime && listing.mtimeMicros == mtimeMicros) {
+			list.clear();
+			for (uint i = 0; i < listing.entries.size(); ++i)
+				list.push_back(dir.makeChild(listing.entries[i].name, listing.entries[i].isDirectory));
+
+			_visited[path] = listing;
+			_hits++;
+			return true;
+		}
+	}
+
+	if (!dir.getChildren(list, FSNode::kListAll, true))
+		return false;
+
+	// The index file may be inside the tree. Leave it out, it isn't part
+	// of the game and its directory changes when it is first written.
+	if (path == _fileDirPath) {
+		const String filePath = _file.getPath();
+		for (uint i = 0; i < list.size(); ++i) {
+			if (list[i].getPath() == filePath) {
+				list.remove_at(i);
+				break;
+			}
+		}
+	}
+
+	_misses++;
+	if (mtime != 0) {
+		Listing &listing = _visited[path];
+		listing.mtime = mtime;
+		listing.mtimeMicros = mtimeMicros;
+		listing.entries.clear();
+		for (FSList::const_iterator i = list.begin(); i != list.end(); ++i) {
+			Entry entry;
+			entry.name = i->getName();
+			entry.isDirectory = i->isDirectory();
+			listing.entries.push_back(entry);
+		}
+	}
+
+	return true;
+}
+
+void FSDirectoryIndex::finish(uint32 millis) {
+	if (_rootPath.empty())
+		return;
+
+	if (_hits == 0) {
+		debug(2, "FSDirectoryIndex: Scanned '%s' in %u ms, %u directories", _rootPath.c_str(), millis, _misses);
+	} else {
+		debug(2, "FSDirectoryIndex: Scanned '%s' in %u ms, %u of %u directories from the index, saving about %d ms",
+		      _rootPath.c_str(), millis, _hits, _hits + _misses, MAX<int>((int)_scanMillis - (int)millis, 0));
+	}
+
+	// Only rewrite the index if a directory changed, or was added or removed
+	if (_misses == 0 && _visited.size() == _listings.size())
+		return;
+
+	// Remember how long scanning without the index takes. If it was only
+	// partly used, keep the previous value.
+	save(_hits == 0 ? millis : MAX(_scanMillis, millis));
+}
+
+bool FSDirectoryIndex::readString(SeekableReadStream &stream, String &str) {
+	const uint32 length = stream.readUint32LE();
+	if (length > kMaxStringLength || stream.eos())
+		return false;
+
+	char buf[kMaxStringLength];
+	if (stream.read(buf, length) != length)
+		return false;
+
+	str = String(buf, length);
+	return true;
+}
+
+void FSDirectoryIndex::writeString(WriteStream &stream, const String &str) {
+	stream.writeUint32LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
 FSDirectory::FSDirectory(const FSNode &node, int depth, bool flat)
   : _node(node), _cached(false), _depth(depth), _flat(flat) {
 }
@@ -251,12 +535,12 @@ FSDirectory *FSDirectory::getSubDirectory(const String &prefix, const String &na
 	return new FSDirectory(prefix, *node, depth, flat);
 }
 
-void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String& prefix) const {
+void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String& prefix, FSDirectoryIndex &index) const {
 	if (depth <= 0)
 		return;
 
 	FSList list;
-	node.getChildren(list, FSNode::kListAll, true);
+	index.getChildren(node, list);
 
 	FSList::iterator it = list.begin();
 	for ( ; it != list.end(); ++it) {
@@ -274,7 +558,7 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String&
 				if (_subDirCache.contains(lowercaseName)) {
 					warning("FSDirectory::cacheDirectory: name clash when building subDirCache with subdirectory '%s'", name.c_str());
 				}
-				cacheDirectoryRecursive(*it, depth - 1, _flat ? prefix : lowercaseName + "/");
+				cacheDirectoryRecursive(*it, depth - 1, _flat ? prefix : lowercaseName + "/", index);
 				_subDirCache[lowercaseName] = *it;
 			}
 		} else {
@@ -291,7 +575,11 @@ void FSDirectory::cacheDirectoryRecursive(FSNode node, int depth, const String&
 void FSDirectory::ensureCached() const  {
 	if (_cached)
 		return;
-	cacheDirectoryRecursive(_node, _depth, _prefix);
+
+	FSDirectoryIndex index(_node, _depth);
+	const uint32 start = g_system->getMillis();
+	cacheDirectoryRecursive(_node, _depth, _prefix, index);
+	index.finish(g_system->getMillis() - start);
 	_cached = true;
 }
 
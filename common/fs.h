@@ -34,6 +34,7 @@ class AbstractFSNode;
 namespace Common {
 
 class FSNode;
+class FSDirectoryIndex;
 class SeekableReadStream;
 class WriteStream;
 
@@ -56,9 +57,16 @@ class FSList : public Array<FSNode> {};
  */
 class FSNode : public ArchiveMember {
 private:
+	friend class FSDirectoryIndex;
 	SharedPtr<AbstractFSNode>	_realNode;
 	FSNode(AbstractFSNode *realNode);
 
+	/**
+	 * Create a child node of a known type, without accessing the filesystem
+	 * if the backend supports that. Used for cached directory listings.
+	 */
+	FSNode makeChild(const String &name, bool isDirectory) const;
+
 public:
 	/**
 	 * Flag to tell listDir() which kind of files to list.
@@ -205,6 +213,27 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Return the time of the last modification of the file or directory,
+	 * which is only meaningful when compared with an earlier value for the
+	 * same node. For directories, it changes whenever entries are added,
+	 * removed or renamed.
+	 *
+	 * @param microseconds	if not 0, set to the fraction of the second, or
+	 *						to 0 if the backend doesn't know it
+	 * @return the modification time in seconds, or 0 if it is unknown or
+	 *         the backend does not support it
+	 */
+	uint32 getModificationTime(uint32 *microseconds = 0) const;
+
+	/**
+	 * Return the size of the file in bytes, without opening it.
+	 *
+	 * @return the size, or -1 if the node is not a file, or the backend
+	 *         does not support it
+	 */
+	int32 getFileSize() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -257,6 +286,11 @@ public:
  * and using 'your' as prefix, the cache entry would have been 'your/data/file.ext'.
  * This is done both in non-flat and flat mode.
  *
+ * Scanning large trees on slow media takes a while, so if the 'fsindexpath'
+ * config key is set, the directory listings are saved to an index file in
+ * that directory. The next scan of the same tree reuses the listings of all
+ * directories whose modification time did not change.
+ *
  */
 class FSDirectory : public Archive {
 	FSNode	_node;
@@ -276,7 +310,7 @@ class FSDirectory : public Archive {
 	FSNode *lookupCache(NodeCache &cache, const String &name) const;
 
 	// cache management
-	void cacheDirectoryRecursive(FSNode node, int depth, const String& prefix) const;
+	void cacheDirectoryRecursive(FSNode node, int depth, const String& prefix, FSDirectoryIndex &index) const;
 
 	// fill cache if not already cached
 	void ensureCached() const;
@@ -0,0 +1,289 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/md5cache.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/endian.h"
+#include "common/md5.h"
+#include "common/stream.h"
+#include "common/textconsole.h"
+#include "common/thread.h"
+
+namespace Common {
+
+DECLARE_SINGLETON(MD5Cache);
+
+MD5Cache::MD5Cache()
+	: _pool(0), _loaded(false), _dirty(false), _transient(false), _batchDepth(0), _hits(0), _misses(0) {
+}
+
+MD5Cache::~MD5Cache() {
+	delete _pool;
+}
+
+void MD5Cache::compute(Array<Request> &requests) {
+	if (!_loaded) {
+		load();
+		_loaded = true;
+	}
+
+	// Everything touching strings, nodes or the cache happens on this
+	// thread, because copying strings isn't thread safe. The jobs only get
+	// plain data and the opened files, so only a limited number of them
+	// runs at a time. Files whose size and modification time match the
+	// cache aren't opened at all.
+	for (uint i = 0; i < requests.size(); ++i) {
+		Request &request = requests[i];
+
+		Job job;
+		job.request = &request;
+		job.mtime = request.node.getModificationTime(&job.mtimeMicros);
+		job.key = String::format("%s:%u", request.node.getPath().c_str(), request.length);
+		job.cached = _entries.contains(job.key);
+		if (job.cached) {
+			job.entry = _entries[job.key];
+			if (job.entry.mtime == job.mtime && job.entry.mtimeMicros == job.mtimeMicros &&
+			    job.entry.size == request.node.getFileSize()) {
+				job.valid = job.hit = true;
+				finishJob(job);
+				continue;
+			}
+		}
+
+		job.stream = request.node.createReadStream();
+		_jobs.push_back(job);
+		if (_jobs.size() == kMaxOpenFiles)
+			runJobs();
+	}
+
+	runJobs();
+
+	if (_batchDepth == 0)
+		finish();
+}
+
+void MD5Cache::runJobs() {
+	if (_jobs.empty())
+		return;
+
+	if (_jobs.size() > 1 && !_pool)
+		_pool = new ThreadPool();
+
+	const Functor1Mem<uint, void, MD5Cache> task(this, &MD5Cache::hashFile);
+	if (_pool)
+		_pool->run(_jobs.size(), task);
+	else
+		task(0);
+
+	for (uint i = 0; i < _jobs.size(); ++i) {
+		delete _jobs[i].stream;
+		finishJob(_jobs[i]);
+	}
+
+	_jobs.clear();
+}
+
+void MD5Cache::finishJob(const Job &job) {
+	Request &request = *job.request;
+
+	request.valid = job.valid;
+	if (!job.valid)
+		return;
+
+	request.size = job.entry.size;
+	request.md5.clear();
+	for (int j = 0; j < 16; ++j)
+		request.md5 += String::format("%02x", job.entry.digest[j]);
+
+	if (job.hit) {
+		_hits++;
+		_entries[job.key].used = true;
+	} else {
+		_misses++;
+		// Without a modification time, changes of the file can't be
+		// detected, but it is safe to assume there are none during
+		// a batch
+		if (job.entry.mtime != 0 || _batchDepth > 0) {
+			_entries[job.key] = job.entry;
+			_dirty = _dirty || job.entry.mtime != 0;
+			_transient = _transient || job.entry.mtime == 0;
+		}
+	}
+}
+
+void MD5Cache::hashFile(uint index) {
+	Job &job = _jobs[index];
+
+	job.valid = false;
+	job.hit = false;
+
+	if (!job.stream)
+		return;
+
+	const int32 size = (int32)job.stream->size();
+	if (job.cached && job.entry.mtime == job.mtime && job.entry.mtimeMicros == job.mtimeMicros && job.entry.size == size) {
+		job.hit = true;
+	} else {
+		job.entry.mtime = job.mtime;
+		job.entry.mtimeMicros = job.mtimeMicros;
+		job.entry.size = size;
+		job.entry.used = true;
+		if (!computeStreamMD5(*job.stream, job.entry.digest, job.request->length))
+			return;
+	}
+
+	job.valid = true;
+}
+
+void MD5Cache::beginBatch() {
+	_batchDepth++;
+}
+
+void MD5Cache::endBatch() {
+	assert(_batchDepth > 0);
+	if (--_batchDepth == 0)
+		finish();
+}
+
+void MD5Cache::finish() {
+	if (_hits + _misses > 0)
+		debug(2, "MD5Cache: %u of %u files from the cache", _hits, _hits + _misses);
+	_hits = _misses = 0;
+
+	delete _pool;
+	_pool = 0;
+
+	if (_transient) {
+		for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+			if (i->_value.mtime == 0)
+				_entries.erase(i);
+		}
+		_transient = false;
+	}
+
+	if (_dirty) {
+		save();
+		_dirty = false;
+	}
+}
+
+FSNode MD5Cache::getCacheFile() const {
+	const String indexPath = ConfMan.get("fsindexpath");
+	if (indexPath.empty())
+		return FSNode();
+
+	FSNode indexDir(indexPath);
+	if (!indexDir.isDirectory()) {
+		warning("MD5Cache: '%s' is not a directory", indexPath.c_str());
+		return FSNode();
+	}
+
+	return indexDir.getChild("md5cache.dat");
+}
+
+void MD5Cache::load() {
+	FSNode file = getCacheFile();
+	if (!file.exists())
+		return;
+
+	SeekableReadStream *stream = file.createReadStream();
+	if (!stream)
+		return;
+
+	bool valid = stream->readUint32BE() == MKTAG('M', 'D', '5', 'C') &&
+	             stream->readUint32LE() == kVersion;
+	uint32 count = stream->readUint32LE();
+
+	while (valid && count--) {
+		const uint32 length = stream->readUint32LE();
+		if (length > kMaxStringLength || stream->eos()) {
+			valid = false;
+			break;
+		}
+
+		char buf[kMaxStringLength];
+		valid = stream->read(buf, length) == length;
+
+		Entry entry;
+		entry.mtime = stream->readUint32LE();
+		entry.mtimeMicros = stream->readUint32LE();
+		entry.size = stream->readSint32LE();
+		stream->read(entry.digest, sizeof(entry.digest));
+		entry.used = false;
+
+		valid = valid && entry.mtime != 0 && !stream->err() && !stream->eos();
+		if (valid)
+			_entries[String(buf, length)] = entry;
+	}
+
+	if (!valid || stream->err()) {
+		warning("MD5Cache: Ignoring invalid cache file '%s'", file.getPath().c_str());
+		_entries.clear();
+	}
+
+	delete stream;
+}
+
+void MD5Cache::save() {
+	FSNode file = getCacheFile();
+	if (!file.exists() && !file.getParent().isDirectory())
+		return;
+
+	// Forget about files which were not seen for a while, or rather, since
+	// we don't know that, during this run
+	const bool prune = _entries.size() > kMaxEntries;
+	uint32 count = 0;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (!prune || i->_value.used)
+			count++;
+	}
+
+	WriteStream *stream = file.createWriteStream();
+	if (!stream) {
+		warning("MD5Cache: Can't write cache file '%s'", file.getPath().c_str());
+		return;
+	}
+
+	stream->writeUint32BE(MKTAG('M', 'D', '5', 'C'));
+	stream->writeUint32LE(kVersion);
+	stream->writeUint32LE(count);
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (prune && !i->_value.used)
+			continue;
+
+		stream->writeUint32LE(i->_key.size());
+		stream->write(i->_key.c_str(), i->_key.size());
+		stream->writeUint32LE(i->_value.mtime);
+		stream->writeUint32LE(i->_value.mtimeMicros);
+		stream->writeSint32LE(i->_value.size);
+		stream->write(i->_value.digest, sizeof(i->_value.digest));
+	}
+
+	stream->finalize();
+	if (stream->err())
+		warning("MD5Cache: Can't write cache file '%s'", file.getPath().c_str());
+	delete stream;
+}
+
+} // End of namespace Common
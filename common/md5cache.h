@@ -0,0 +1,154 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_MD5CACHE_H
+#define COMMON_MD5CACHE_H
+
+#include "common/array.h"
+#include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+
+class ThreadPool;
+
+/**
+ * Computes the sizes and the MD5 checksums of the beginning of files, as
+ * used for game detection, and remembers them.
+ *
+ * A checksum is reused as long as the size and the modification time of
+ * the file did not change, so files which are seen by several detectors,
+ * or again on later runs, are only read once, and files found in the
+ * cache are not even opened. The files which are not in the cache are
+ * hashed concurrently on threads which are kept for the whole batch.
+ *
+ * If the 'fsindexpath' config key is set, the cache is kept there across
+ * runs. Files without a modification time are only cached until the end
+ * of the current batch.
+ */
+class MD5Cache : public Singleton<MD5Cache> {
+public:
+	/** A file to compute the checksum of, and the results. */
+	struct Request {
+		Request() : length(0), valid(false), size(0) {}
+		Request(const FSNode &n, uint32 l) : node(n), length(l), valid(false), size(0) {}
+
+		FSNode node;
+		/** Number of bytes to hash, 0 for the whole file */
+		uint32 length;
+
+		/** false if the file could not be read */
+		bool valid;
+		int32 size;
+		String md5;
+	};
+
+	MD5Cache();
+	~MD5Cache();
+
+	/**
+	 * Fill in the results of all requests.
+	 *
+	 * Unless this is part of a batch, the cache is saved afterwards if it
+	 * changed.
+	 */
+	void compute(Array<Request> &requests);
+
+	/**
+	 * Start a batch of compute() calls, e.g. the detection of all engines
+	 * in a directory. The cache is saved when the outermost batch ends.
+	 */
+	void beginBatch();
+
+	/** End a batch of compute() calls started by beginBatch(). */
+	void endBatch();
+
+private:
+	friend class Singleton<SingletonBaseType>;
+
+	enum {
+		kVersion = 1,
+		/** Entries not used during this run are dropped above this number */
+		kMaxEntries = 32768,
+		/** limit for paths read from the cache file, to detect garbage */
+		kMaxStringLength = 4096,
+		/** files opened for the jobs at a time */
+		kMaxOpenFiles = 64
+	};
+
+	struct Entry {
+		/** the modification time of the file, see FSNode::getModificationTime() */
+		uint32 mtime;
+		uint32 mtimeMicros;
+		int32 size;
+		uint8 digest[16];
+		/** whether the entry was used or added during this run */
+		bool used;
+	};
+
+	/** A file to be looked up or hashed by hashFile(), possibly on another thread. */
+	struct Job {
+		Job() : request(0), stream(0), mtime(0), mtimeMicros(0), cached(false), valid(false), hit(false) {}
+
+		Request *request;
+		/** the opened file, the only part of it the thread running the job uses */
+		SeekableReadStream *stream;
+		uint32 mtime, mtimeMicros;
+		String key;
+		bool cached;
+		Entry entry;
+		bool valid;
+		bool hit;
+	};
+
+	typedef HashMap<String, Entry> EntryMap;
+
+	EntryMap _entries;
+	Array<Job> _jobs;
+	/** the threads hashing the files, kept until the outermost batch ends */
+	ThreadPool *_pool;
+
+	bool _loaded;
+	bool _dirty;
+	/** whether there are entries without modification time */
+	bool _transient;
+	int _batchDepth;
+
+	uint _hits;
+	uint _misses;
+
+	void runJobs();
+	void hashFile(uint index);
+	void finishJob(const Job &job);
+
+	FSNode getCacheFile() const;
+	void load();
+	void save();
+	void finish();
+};
+
+} // End of namespace Common
+
+#endif
@@ -170,7 +170,8 @@ private:
 
 		byte *old_data = _data;
 
-		_capacity = new_len + 32;
+		// Grow geometrically, so that writing in small pieces takes linear time
+		_capacity = (new_len + 32 > _capacity * 2) ? new_len + 32 : _capacity * 2;
 		_data = (byte *)malloc(_capacity);
 		_ptr = _data + _pos;
 
@@ -46,6 +46,45 @@ typedef SeekableReadStream InSaveFile;
  */
 typedef WriteStream OutSaveFile;
 
+/**
+ * Is told by a SaveFileManager which savefiles are opened for loading,
+ * listed, written and removed, e.g. to keep information read from the
+ * savefiles up to date.
+ */
+class SaveFileObserver {
+public:
+	virtual ~SaveFileObserver() {}
+
+	/**
+	 * A savefile was opened for loading.
+	 * @param name			the name of the savefile
+	 * @param size			the size of the savefile, or -1 if it doesn't exist
+	 * @param mtime			the modification time of the savefile, see
+	 *						SaveFileManager::getModificationTime()
+	 * @param mtimeMicros	the fraction of the second of the modification time
+	 */
+	virtual void savefileOpened(const String &name, int32 size, uint32 mtime, uint32 mtimeMicros) = 0;
+
+	/**
+	 * Savefiles were listed.
+	 * @param pattern	the pattern passed to SaveFileManager::listSavefiles
+	 * @param names		the names of the savefiles which were found
+	 */
+	virtual void savefilesListed(const String &pattern, const StringArray &names) = 0;
+
+	/**
+	 * A savefile is about to be written, or it was renamed or removed.
+	 * @param name	the name of the savefile
+	 */
+	virtual void savefileChanged(const String &name) = 0;
+
+	/**
+	 * Savefiles which the observer stores for itself are never listed.
+	 * @param name	the name of the savefile
+	 * @return true if the savefile is one of the observer's own
+	 */
+	virtual bool isOwnSavefile(const String &name) const { return false; }
+};
 
 /**
  * The SaveFileManager is serving as a factory for InSaveFile
@@ -129,6 +168,17 @@ public:
 	 */
 	virtual InSaveFile *openForLoading(const String &name) = 0;
 
+	/**
+	 * Return the time of the last modification of a savefile, which is
+	 * only meaningful when compared with an earlier value for the same
+	 * savefile.
+	 * @param name			the name of the savefile
+	 * @param microseconds	if not 0, set to the fraction of the second
+	 * @return the modification time in seconds, or 0 if the savefile
+	 *         doesn't exist or the time is unknown
+	 */
+	virtual uint32 getModificationTime(const String &name, uint32 *microseconds = 0);
+
 	/**
 	 * Removes the given savefile from the system.
 	 * @param name the name of the savefile to be removed.
@@ -161,6 +211,21 @@ public:
 	 * @see Common::matchString()
 	 */
 	virtual StringArray listSavefiles(const String &pattern) = 0;
+
+	/**
+	 * Adds an observer, which is told about the savefiles opened, listed
+	 * and changed through this savefile manager from now on.
+	 * @param observer	the observer, which is not owned by the savefile manager
+	 * @return true if the observer was added, false if this savefile
+	 *         manager doesn't support observers
+	 */
+	virtual bool addObserver(SaveFileObserver *observer) { return false; }
+
+	/**
+	 * Removes an observer which was added by addObserver.
+	 * @param observer	the observer to remove
+	 */
+	virtual void removeObserver(SaveFileObserver *observer) {}
 };
 
 } // End of namespace Common
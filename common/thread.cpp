@@ -0,0 +1,349 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Needed for pthread.h and sysconf()
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
+
+#include "common/thread.h"
+#include "common/atomic.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#ifdef USE_THREADS
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#undef ARRAYSIZE
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace Common {
+
+/** The entry points handed to the native thread API. */
+struct ThreadEntry {
+#ifdef USE_THREADS
+#ifdef WIN32
+	static DWORD WINAPI run(LPVOID thread) {
+		((Thread *)thread)->run();
+		return 0;
+	}
+#else
+	static void *run(void *thread) {
+		((Thread *)thread)->run();
+		return 0;
+	}
+#endif
+#endif
+};
+
+Thread::Thread() : _handle(0) {
+}
+
+Thread::~Thread() {
+	assert(!isStarted());
+}
+
+bool Thread::start() {
+	assert(!isStarted());
+
+#ifdef USE_THREADS
+#ifdef WIN32
+	_handle = CreateThread(NULL, 0, ThreadEntry::run, this, 0, NULL);
+#else
+	pthread_t *thread = new pthread_t;
+	if (pthread_create(thread, NULL, ThreadEntry::run, this) == 0) {
+		_handle = thread;
+	} else {
+		delete thread;
+	}
+#endif
+#endif
+
+	return isStarted();
+}
+
+void Thread::join() {
+	if (!isStarted())
+		return;
+
+#ifdef USE_THREADS
+#ifdef WIN32
+	WaitForSingleObject((HANDLE)_handle, INFINITE);
+	CloseHandle((HANDLE)_handle);
+#else
+	pthread_t *thread = (pthread_t *)_handle;
+	pthread_join(*thread, NULL);
+	delete thread;
+#endif
+#endif
+
+	_handle = 0;
+}
+
+#if defined(USE_THREADS) && !defined(WIN32)
+/** A semaphore made of a mutex and a condition, as POSIX semaphores are optional */
+struct PosixSemaphore {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint count;
+};
+#endif
+
+Semaphore::Semaphore(uint count) : _handle(0), _count(count) {
+#ifdef USE_THREADS
+#ifdef WIN32
+	_handle = CreateSemaphore(NULL, count, 0x7FFFFFFF, NULL);
+	if (!_handle)
+		error("Could not create a semaphore");
+#else
+	PosixSemaphore *semaphore = new PosixSemaphore;
+	pthread_mutex_init(&semaphore->mutex, NULL);
+	pthread_cond_init(&semaphore->cond, NULL);
+	semaphore->count = count;
+	_handle = semaphore;
+#endif
+#endif
+}
+
+Semaphore::~Semaphore() {
+#ifdef USE_THREADS
+#ifdef WIN32
+	CloseHandle((HANDLE)_handle);
+#else
+	PosixSemaphore *semaphore = (PosixSemaphore *)_handle;
+	pthread_cond_destroy(&semaphore->cond);
+	pthread_mutex_destroy(&semaphore->mutex);
+	delete semaphore;
+#endif
+#endif
+}
+
+void Semaphore::post() {
+#ifdef USE_THREADS
+#ifdef WIN32
+	ReleaseSemaphore((HANDLE)_handle, 1, NULL);
+#else
+	PosixSemaphore *semaphore = (PosixSemaphore *)_handle;
+	pthread_mutex_lock(&semaphore->mutex);
+	semaphore->count++;
+	pthread_cond_signal(&semaphore->cond);
+	pthread_mutex_unlock(&semaphore->mutex);
+#endif
+#else
+	_count++;
+#endif
+}
+
+void Semaphore::wait() {
+#ifdef USE_THREADS
+#ifdef WIN32
+	WaitForSingleObject((HANDLE)_handle, INFINITE);
+#else
+	PosixSemaphore *semaphore = (PosixSemaphore *)_handle;
+	pthread_mutex_lock(&semaphore->mutex);
+	while (!semaphore->count)
+		pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+	semaphore->count--;
+	pthread_mutex_unlock(&semaphore->mutex);
+#endif
+#else
+	assert(_count > 0);
+	_count--;
+#endif
+}
+
+bool Semaphore::tryWait() {
+#ifdef USE_THREADS
+#ifdef WIN32
+	return WaitForSingleObject((HANDLE)_handle, 0) == WAIT_OBJECT_0;
+#else
+	PosixSemaphore *semaphore = (PosixSemaphore *)_handle;
+	pthread_mutex_lock(&semaphore->mutex);
+	const bool taken = semaphore->count > 0;
+	if (taken)
+		semaphore->count--;
+	pthread_mutex_unlock(&semaphore->mutex);
+	return taken;
+#endif
+#else
+	if (!_count)
+		return false;
+	_count--;
+	return true;
+#endif
+}
+
+uint getNumCores() {
+	static uint numCores = 0;
+
+	if (!numCores) {
+		numCores = 1;
+#ifdef USE_THREADS
+#ifdef WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		numCores = MAX<uint>(info.dwNumberOfProcessors, 1);
+#elif defined(_SC_NPROCESSORS_ONLN)
+		const long count = sysconf(_SC_NPROCESSORS_ONLN);
+		if (count > 1)
+			numCores = (uint)count;
+#endif
+#endif
+	}
+
+	return numCores;
+}
+
+namespace {
+
+/**
+ * Takes the indices for runInParallel() one after the other, until all
+ * of them are taken. One of these runs on each thread.
+ */
+class ParallelWorker : public Thread {
+public:
+	ParallelWorker(volatile int32 *next, uint count, const Functor1<uint, void> *task)
+		: _next(next), _count(count), _task(task) {}
+
+	void run() {
+		int32 index;
+		while ((index = atomicAdd(*_next, 1) - 1) < (int32)_count)
+			(*_task)((uint)index);
+	}
+
+private:
+	volatile int32 *_next;
+	uint _count;
+	const Functor1<uint, void> *_task;
+};
+
+} // End of anonymous namespace
+
+void runInParallel(uint count, const Functor1<uint, void> &task, uint maxThreads) {
+	if (!maxThreads)
+		maxThreads = getNumCores();
+
+	const uint numThreads = MIN(maxThreads, count);
+	if (numThreads <= 1) {
+		for (uint i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	volatile int32 next = 0;
+	ParallelWorker **workers = new ParallelWorker *[numThreads - 1];
+	for (uint i = 0; i < numThreads - 1; ++i) {
+		workers[i] = new ParallelWorker(&next, count, &task);
+		// Whatever a thread which failed to start would have done is done
+		// by the others
+		workers[i]->start();
+	}
+
+	ParallelWorker(&next, count, &task).run();
+
+	for (uint i = 0; i < numThreads - 1; ++i) {
+		workers[i]->join();
+		delete workers[i];
+	}
+	delete[] workers;
+}
+
+class ThreadPool::Worker : public Thread {
+public:
+	Worker(ThreadPool *pool) : _pool(pool) {}
+
+	void run() {
+		while (true) {
+			_pool->_start.wait();
+			if (_pool->_quit)
+				break;
+			_pool->work();
+			_pool->_done.post();
+		}
+	}
+
+private:
+	ThreadPool *_pool;
+};
+
+ThreadPool::ThreadPool(uint numThreads) : _next(0), _count(0), _task(0), _quit(false) {
+	if (!numThreads)
+		numThreads = getNumCores();
+
+	for (uint i = 1; i < numThreads; ++i) {
+		Worker *worker = new Worker(this);
+		if (!worker->start()) {
+			delete worker;
+			break;
+		}
+		_workers.push_back(worker);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	_quit = true;
+	for (uint i = 0; i < _workers.size(); ++i)
+		_start.post();
+
+	for (uint i = 0; i < _workers.size(); ++i) {
+		_workers[i]->join();
+		delete _workers[i];
+	}
+}
+
+void ThreadPool::run(uint count, const Functor1<uint, void> &task) {
+	if (_workers.empty() || count <= 1) {
+		for (uint i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	_next = 0;
+	_count = count;
+	_task = &task;
+
+	// Workers which are woken up after all indices are taken simply find
+	// nothing left to do
+	const uint numWorkers = MIN<uint>(_workers.size(), count - 1);
+	for (uint i = 0; i < numWorkers; ++i)
+		_start.post();
+
+	work();
+
+	for (uint i = 0; i < numWorkers; ++i)
+		_done.wait();
+
+	_task = 0;
+}
+
+void ThreadPool::work() {
+	int32 index;
+	while ((index = atomicAdd(_next, 1) - 1) < (int32)_count)
+		(*_task)((uint)index);
+}
+
+} // End of namespace Common
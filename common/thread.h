@@ -0,0 +1,182 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_THREAD_H
+#define COMMON_THREAD_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/func.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A thread of execution, running the run() method of a derived class.
+ *
+ * Threads are only available if ScummVM was built with USE_THREADS
+ * (POSIX threads or Win32 threads). Everywhere else start() fails, and
+ * the caller has to do the work itself, so code using this class must
+ * always have a way to get along without it.
+ *
+ * Keep in mind that most of ScummVM is not thread safe: in particular,
+ * copies of a String or a SharedPtr share a reference count which is not
+ * updated atomically, and the OSystem methods may only be called from the
+ * main thread, unless they are documented otherwise. Work done on another
+ * thread should be on data prepared for it in advance.
+ */
+class Thread : NonCopyable {
+public:
+	Thread();
+
+	/** A started thread has to be joined before it is destroyed. */
+	virtual ~Thread();
+
+	/**
+	 * Start running run() on a new thread.
+	 *
+	 * @return true if the thread was started, false if threads are not
+	 *         supported or could not be created
+	 */
+	bool start();
+
+	/**
+	 * Wait until run() returned. Does nothing if the thread was not
+	 * started.
+	 */
+	void join();
+
+	/** Return whether the thread was started and not joined yet. */
+	bool isStarted() const { return _handle != 0; }
+
+protected:
+	/** The code to run on the thread. */
+	virtual void run() = 0;
+
+private:
+	void *_handle;
+
+	friend struct ThreadEntry;
+};
+
+/**
+ * A counting semaphore, for threads which hand work to each other, like a
+ * producer and a consumer of a bounded queue.
+ *
+ * It does not use OSystem, so it may be used on any thread. Without
+ * USE_THREADS, wait() must not be called while the count is zero, as
+ * nothing could ever raise it.
+ */
+class Semaphore : NonCopyable {
+public:
+	explicit Semaphore(uint count = 0);
+	~Semaphore();
+
+	/** Increase the count, waking up a thread waiting for it. */
+	void post();
+
+	/** Wait until the count is above zero, then decrease it. */
+	void wait();
+
+	/**
+	 * Decrease the count if it is above zero, without waiting.
+	 *
+	 * @return whether the count was decreased
+	 */
+	bool tryWait();
+
+private:
+	void *_handle;
+	uint _count;
+};
+
+/**
+ * Return the number of threads which can run at the same time on this
+ * system, which is 1 if threads are not supported.
+ */
+uint getNumCores();
+
+/**
+ * Call @p task for all indices from 0 to @p count - 1 and wait for all
+ * of the calls to return.
+ *
+ * The calls are spread over the calling thread and up to
+ * @p maxThreads - 1 additional threads, in no particular order. Without
+ * threads, or if only one is requested, they are made in order on the
+ * calling thread.
+ *
+ * @param count      number of calls
+ * @param task       called with the index of each item, possibly from
+ *                   several threads at once
+ * @param maxThreads upper limit for the number of threads to use, 0 for
+ *                   the number of cores
+ */
+void runInParallel(uint count, const Functor1<uint, void> &task, uint maxThreads = 0);
+
+/**
+ * A set of threads which are kept around for running tasks like
+ * runInParallel() does, for work which is split up many times per second,
+ * where starting new threads every time would cost too much.
+ *
+ * Only one thread may use a pool at a time.
+ */
+class ThreadPool : NonCopyable {
+public:
+	/**
+	 * Start the threads of the pool.
+	 *
+	 * @param numThreads number of threads working on tasks, including the
+	 *                   thread calling run(), 0 for the number of cores
+	 */
+	explicit ThreadPool(uint numThreads = 0);
+	~ThreadPool();
+
+	/**
+	 * Return the number of threads working on tasks, including the
+	 * calling thread. This is 1 if no threads could be started.
+	 */
+	uint getNumThreads() const { return _workers.size() + 1; }
+
+	/**
+	 * Call @p task for all indices from 0 to @p count - 1 and wait for all
+	 * of the calls to return, like runInParallel().
+	 */
+	void run(uint count, const Functor1<uint, void> &task);
+
+private:
+	class Worker;
+
+	Array<Worker *> _workers;
+	Semaphore _start, _done;
+
+	// The current task, only changed while the workers wait
+	volatile int32 _next;
+	uint _count;
+	const Functor1<uint, void> *_task;
+	bool _quit;
+
+	void work();
+};
+
+} // End of namespace Common
+
+#endif
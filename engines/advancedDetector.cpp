@@ -25,6 +25,8 @@
 #include "common/file.h"
 #include "common/macresman.h"
 #include "common/md5.h"
+#include "common/md5cache.h"
+#include "common/str-array.h"
 #include "common/config-manager.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -386,13 +388,15 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	if (!allFiles.contains(fname))
 		return false;
 
-	Common::File testFile;
+	Common::Array<Common::MD5Cache::Request> requests;
+	requests.push_back(Common::MD5Cache::Request(allFiles[fname], _md5Bytes));
+	Common::MD5Cache::instance().compute(requests);
 
-	if (!testFile.open(allFiles[fname]))
+	if (!requests[0].valid)
 		return false;
 
-	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	fileProps.size = requests[0].size;
+	fileProps.md5 = requests[0].md5;
 	return true;
 }
 
@@ -406,7 +410,12 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 	debug(3, "Starting detection in dir '%s'", parent.getPath().c_str());
 
 	// Check which files are included in some ADGameDescription *and* are present.
-	// Compute MD5s and file sizes for these files.
+	// Compute MD5s and file sizes for these files. Resource forks are done
+	// right away, the data forks all at once afterwards.
+	Common::Array<Common::MD5Cache::Request> requests;
+	Common::StringArray requestedNames;
+	ADFilePropertiesMap requested;
+
 	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameid != 0; descPtr += _descItemSize) {
 		g = (const ADGameDescription *)descPtr;
 
@@ -414,16 +423,34 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 			Common::String fname = fileDesc->fileName;
 			ADFileProperties tmp;
 
-			if (filesProps.contains(fname))
+			if (filesProps.contains(fname) || requested.contains(fname))
 				continue;
 
-			if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
+			if (!(g->flags & ADGF_MACRESFORK)) {
+				if (allFiles.contains(fname)) {
+					requests.push_back(Common::MD5Cache::Request(allFiles[fname], _md5Bytes));
+					requestedNames.push_back(fname);
+					requested[fname] = tmp;
+				}
+			} else if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
 				debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
 				filesProps[fname] = tmp;
 			}
 		}
 	}
 
+	Common::MD5Cache::instance().compute(requests);
+
+	for (uint j = 0; j < requests.size(); ++j) {
+		if (!requests[j].valid)
+			continue;
+
+		ADFileProperties &fileProps = filesProps[requestedNames[j]];
+		fileProps.size = requests[j].size;
+		fileProps.md5 = requests[j].md5;
+		debug(3, "> '%s': '%s'", requestedNames[j].c_str(), fileProps.md5.c_str());
+	}
+
 	ADGameDescList matched;
 	int maxFilesMatched = 0;
 	bool gotAnyMatchesWithAllFiles = false;
@@ -6,6 +6,7 @@ MODULE_OBJS := \
 	engine.o \
 	game.o \
 	obsolete.o \
+	saveindex.o \
 	savestate.o
 
 # Include common rules
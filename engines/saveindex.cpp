@@ -0,0 +1,630 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/saveindex.h"
+#include "engines/metaengine.h"
+
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/endian.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+#include "graphics/surface.h"
+
+namespace Common {
+DECLARE_SINGLETON(SaveStateIndexManager);
+}
+
+namespace {
+
+enum {
+	kIndexVersion = 2
+};
+
+const char *const kIndexSuffix = ".saveindex";
+
+void writeFormat(Common::WriteStream &stream, const Graphics::PixelFormat &format) {
+	stream.writeByte(format.bytesPerPixel);
+	stream.writeByte(format.rLoss);
+	stream.writeByte(format.gLoss);
+	stream.writeByte(format.bLoss);
+	stream.writeByte(format.aLoss);
+	stream.writeByte(format.rShift);
+	stream.writeByte(format.gShift);
+	stream.writeByte(format.bShift);
+	stream.writeByte(format.aShift);
+}
+
+Graphics::PixelFormat readFormat(Common::SeekableReadStream &stream) {
+	Graphics::PixelFormat format;
+	format.bytesPerPixel = stream.readByte();
+	format.rLoss = stream.readByte();
+	format.gLoss = stream.readByte();
+	format.bLoss = stream.readByte();
+	format.aLoss = stream.readByte();
+	format.rShift = stream.readByte();
+	format.gShift = stream.readByte();
+	format.bShift = stream.readByte();
+	format.aShift = stream.readByte();
+	return format;
+}
+
+/** Writes the pixels of a surface in little endian order */
+void writePixels(Common::WriteStream &stream, const Graphics::Surface &surface) {
+	for (int y = 0; y < surface.h; ++y) {
+		const byte *src = (const byte *)surface.getBasePtr(0, y);
+		if (surface.format.bytesPerPixel == 2) {
+			for (int x = 0; x < surface.w; ++x, src += 2)
+				stream.writeUint16LE(*(const uint16 *)src);
+		} else {
+			for (int x = 0; x < surface.w; ++x, src += 4)
+				stream.writeUint32LE(*(const uint32 *)src);
+		}
+	}
+}
+
+} // End of anonymous namespace
+
+bool SaveStateIndex::Sources::contains(const Common::String &name) const {
+	for (uint i = 0; i < files.size(); ++i) {
+		if (files[i].equalsIgnoreCase(name))
+			return true;
+	}
+
+	for (uint i = 0; i < patterns.size(); ++i) {
+		if (name.matchString(patterns[i], true))
+			return true;
+	}
+
+	return false;
+}
+
+void SaveStateIndex::Sources::clear() {
+	files.clear();
+	sizes.clear();
+	mtimes.clear();
+	mtimeMicros.clear();
+	patterns.clear();
+	listed.clear();
+}
+
+SaveStateIndex::SaveStateIndex(Common::SaveFileManager *saveFileMan, const Common::String &target, const Common::String &savePath)
+	: _saveFileMan(saveFileMan), _fileName(getFileName(target)), _savePath(savePath), _loaded(false), _changed(false),
+	  _listValid(false), _listChecked(false), _recording(0) {
+}
+
+SaveStateIndex::~SaveStateIndex() {
+}
+
+Common::String SaveStateIndex::getFileName(const Common::String &target) {
+	return target + kIndexSuffix;
+}
+
+bool SaveStateIndex::isIndexFile(const Common::String &name) {
+	Common::String lowerName(name);
+	lowerName.toLowercase();
+	return lowerName.hasSuffix(kIndexSuffix);
+}
+
+SaveStateList SaveStateIndex::listSaves(const MetaEngine &metaEngine, const Common::String &target) {
+	load();
+
+	if (_listValid && !_listChecked) {
+		_listValid = isUpToDate(_listSources);
+		_listChecked = true;
+		if (!_listValid)
+			_changed = true;
+	}
+
+	if (_listValid)
+		return _list;
+
+	_listSources.clear();
+	_recording = &_listSources;
+	_list = metaEngine.listSaves(target.c_str());
+	_recording = 0;
+
+	// Nothing is known about lists which weren't read from savefiles
+	_listValid = !_listSources.isEmpty();
+	_listChecked = true;
+	_changed = true;
+
+	return _list;
+}
+
+SaveStateDescriptor SaveStateIndex::querySaveMetaInfos(const MetaEngine &metaEngine, const Common::String &target, int slot, bool thumbnail) {
+	load();
+
+	EntryMap::iterator i = _entries.find(slot);
+	if (i != _entries.end() && !i->_value.checked) {
+		if (isUpToDate(i->_value.sources)) {
+			i->_value.checked = true;
+		} else {
+			_entries.erase(i);
+			i = _entries.end();
+			_changed = true;
+		}
+	}
+
+	if (i != _entries.end()) {
+		Entry &entry = i->_value;
+		SaveStateDescriptor desc(entry.desc);
+
+		if (!thumbnail || entry.thumbnail) {
+			if (thumbnail)
+				desc._thumbnail = entry.thumbnail;
+			return desc;
+		}
+
+		if (!entry.thumbnailOffset)
+			return desc;
+
+		Graphics::Surface *surface = 0;
+		Common::SeekableReadStream *stream = _saveFileMan->openForLoading(_fileName);
+		if (stream) {
+			surface = readThumbnail(*stream, entry);
+			delete stream;
+		}
+
+		if (surface) {
+			desc.setThumbnail(surface);
+			return desc;
+		}
+
+		// The index file is gone or broken, ask the engine again
+		warning("SaveStateIndex: Could not read a thumbnail from '%s'", _fileName.c_str());
+		_entries.erase(i);
+		_changed = true;
+	}
+
+	Entry entry;
+	_recording = &entry.sources;
+	SaveStateDescriptor desc = metaEngine.querySaveMetaInfos(target.c_str(), slot);
+	_recording = 0;
+
+	if (desc.getSaveSlot() == slot && !entry.sources.isEmpty()) {
+		entry.desc = desc;
+		entry.desc._thumbnail.reset();
+		entry.thumbnail = desc._thumbnail;
+		entry.checked = true;
+		_entries[slot] = entry;
+		_changed = true;
+	}
+
+	return desc;
+}
+
+void SaveStateIndex::flush() {
+	if (!_changed)
+		return;
+
+	const Graphics::PixelFormat format = g_system->getOverlayFormat();
+
+	Common::SeekableReadStream *oldFile = 0;
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end() && !oldFile; ++i) {
+		if (i->_value.thumbnailOffset)
+			oldFile = _saveFileMan->openForLoading(_fileName);
+	}
+
+	Common::MemoryWriteStreamDynamic data(DisposeAfterUse::YES);
+	data.writeUint32BE(MKTAG('S','I','D','X'));
+	data.writeUint32LE(kIndexVersion);
+	writeFormat(data, format);
+
+	data.writeByte(_listValid);
+	if (_listValid) {
+		writeSources(data, _listSources);
+		data.writeUint32LE(_list.size());
+		for (uint i = 0; i < _list.size(); ++i)
+			writeDescriptor(data, _list[i]);
+	}
+
+	// Entries whose thumbnails can't be stored are left out
+	Common::Array<int> written;
+	Common::Array<uint32> offsets;
+	Common::Array<byte> pixels;
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		const Entry &entry = i->_value;
+		if (entry.thumbnail) {
+			if (entry.thumbnail->format != format || (format.bytesPerPixel != 2 && format.bytesPerPixel != 4))
+				continue;
+		} else if (entry.thumbnailOffset) {
+			pixels.resize(entry.thumbnailWidth * entry.thumbnailHeight * format.bytesPerPixel);
+			if (!oldFile || !oldFile->seek(entry.thumbnailOffset) || oldFile->read(pixels.begin(), pixels.size()) != pixels.size())
+				continue;
+		}
+
+		writeDescriptor(data, entry.desc);
+		writeSources(data, entry.sources);
+
+		if (entry.thumbnail) {
+			data.writeUint16LE(entry.thumbnail->w);
+			data.writeUint16LE(entry.thumbnail->h);
+			offsets.push_back(data.pos());
+			writePixels(data, *entry.thumbnail);
+		} else if (entry.thumbnailOffset) {
+			data.writeUint16LE(entry.thumbnailWidth);
+			data.writeUint16LE(entry.thumbnailHeight);
+			offsets.push_back(data.pos());
+			data.write(pixels.begin(), pixels.size());
+		} else {
+			data.writeUint16LE(0);
+			data.writeUint16LE(0);
+			offsets.push_back(0);
+		}
+
+		written.push_back(i->_key);
+	}
+	data.writeUint32LE(0xFFFFFFFF);
+
+	delete oldFile;
+
+	// Uncompressed, so that the thumbnails can be read without the rest
+	Common::OutSaveFile *file = _saveFileMan->openForSaving(_fileName, false);
+	bool success = false;
+	if (file) {
+		file->write(data.getData(), data.size());
+		file->finalize();
+		success = !file->err();
+		delete file;
+	}
+
+	if (!success) {
+		// Thumbnails which were only in the old file are lost now
+		warning("SaveStateIndex: Could not write '%s'", _fileName.c_str());
+		_loaded = true;
+		_changed = false;
+		for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+			if (i->_value.thumbnailOffset)
+				_entries.erase(i);
+		}
+		return;
+	}
+
+	// Keep only the entries which were written, with their thumbnails in the file
+	EntryMap entries;
+	for (uint i = 0; i < written.size(); ++i) {
+		Entry &entry = entries[written[i]];
+		entry = _entries[written[i]];
+		if (entry.thumbnail) {
+			entry.thumbnailWidth = entry.thumbnail->w;
+			entry.thumbnailHeight = entry.thumbnail->h;
+			entry.thumbnail.reset();
+		}
+		entry.thumbnailOffset = offsets[i];
+	}
+	_entries = entries;
+	_changed = false;
+}
+
+void SaveStateIndex::savefileOpened(const Common::String &name, int32 size, uint32 mtime, uint32 mtimeMicros) {
+	if (!_recording)
+		return;
+
+	_recording->files.push_back(name);
+	_recording->sizes.push_back(size);
+	_recording->mtimes.push_back(mtime);
+	_recording->mtimeMicros.push_back(mtimeMicros);
+}
+
+void SaveStateIndex::savefilesListed(const Common::String &pattern, const Common::StringArray &names) {
+	if (!_recording)
+		return;
+
+	_recording->patterns.push_back(pattern);
+	_recording->listed.push_back(names);
+	Common::sort(_recording->listed.back().begin(), _recording->listed.back().end());
+}
+
+void SaveStateIndex::savefileChanged(const Common::String &name) {
+	// The index file has to be updated, even if it isn't used in this session
+	load();
+
+	if (_listValid && _listSources.contains(name)) {
+		_listValid = false;
+		_changed = true;
+	}
+
+	for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->_value.sources.contains(name)) {
+			_entries.erase(i);
+			_changed = true;
+		}
+	}
+}
+
+void SaveStateIndex::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::SeekableReadStream *stream = _saveFileMan->openForLoading(_fileName);
+	if (!stream)
+		return;
+
+	bool valid = stream->readUint32BE() == MKTAG('S','I','D','X') && stream->readUint32LE() == kIndexVersion;
+
+	// Thumbnails are stored in the overlay format
+	const Graphics::PixelFormat format = readFormat(*stream);
+	valid = valid && format == g_system->getOverlayFormat();
+
+	if (valid && stream->readByte()) {
+		readSources(*stream, _listSources);
+		const uint32 count = stream->readUint32LE();
+		for (uint32 i = 0; i < count && !stream->eos(); ++i) {
+			_list.push_back(SaveStateDescriptor());
+			readDescriptor(*stream, _list.back());
+		}
+		_listValid = true;
+	}
+
+	while (valid) {
+		Entry entry;
+		readDescriptor(*stream, entry.desc);
+		if (stream->eos() || stream->err() || entry.desc.getSaveSlot() == -1)
+			break;
+
+		readSources(*stream, entry.sources);
+		entry.thumbnailWidth = stream->readUint16LE();
+		entry.thumbnailHeight = stream->readUint16LE();
+		if (entry.thumbnailWidth && entry.thumbnailHeight) {
+			entry.thumbnailOffset = stream->pos();
+			stream->skip(entry.thumbnailWidth * entry.thumbnailHeight * format.bytesPerPixel);
+		}
+
+		_entries[entry.desc.getSaveSlot()] = entry;
+	}
+
+	// The list ends with a slot number of -1
+	if (!valid || stream->eos() || stream->err()) {
+		warning("SaveStateIndex: Ignoring '%s'", _fileName.c_str());
+		_list.clear();
+		_listSources.clear();
+		_listValid = false;
+		_entries.clear();
+		_changed = true;
+	}
+
+	delete stream;
+}
+
+bool SaveStateIndex::isUpToDate(const Sources &sources) {
+	for (uint i = 0; i < sources.files.size(); ++i) {
+		// The modification time tells apart savefiles of the same size,
+		// and it is checked first since it doesn't need the file opened
+		uint32 mtimeMicros;
+		const uint32 mtime = _saveFileMan->getModificationTime(sources.files[i], &mtimeMicros);
+		if (mtime != sources.mtimes[i] || mtimeMicros != sources.mtimeMicros[i])
+			return false;
+
+		Common::InSaveFile *file = _saveFileMan->openForLoading(sources.files[i]);
+		const int32 size = file ? file->size() : -1;
+		delete file;
+
+		if (size != sources.sizes[i])
+			return false;
+	}
+
+	for (uint i = 0; i < sources.patterns.size(); ++i) {
+		Common::StringArray names = _saveFileMan->listSavefiles(sources.patterns[i]);
+		Common::sort(names.begin(), names.end());
+
+		if (names != sources.listed[i])
+			return false;
+	}
+
+	return true;
+}
+
+Graphics::Surface *SaveStateIndex::readThumbnail(Common::SeekableReadStream &stream, const Entry &entry) const {
+	Graphics::Surface *surface = new Graphics::Surface();
+	surface->create(entry.thumbnailWidth, entry.thumbnailHeight, g_system->getOverlayFormat());
+
+	const uint32 size = surface->h * surface->pitch;
+	if (!stream.seek(entry.thumbnailOffset) || stream.read(surface->getPixels(), size) != size) {
+		surface->free();
+		delete surface;
+		return 0;
+	}
+
+#ifdef SCUMM_BIG_ENDIAN
+	byte *pixels = (byte *)surface->getPixels();
+	if (surface->format.bytesPerPixel == 2) {
+		for (uint32 i = 0; i < size; i += 2)
+			WRITE_UINT16(pixels + i, READ_LE_UINT16(pixels + i));
+	} else {
+		for (uint32 i = 0; i < size; i += 4)
+			WRITE_UINT32(pixels + i, READ_LE_UINT32(pixels + i));
+	}
+#endif
+
+	return surface;
+}
+
+void SaveStateIndex::writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+Common::String SaveStateIndex::readString(Common::SeekableReadStream &stream) {
+	Common::String str;
+	for (uint16 size = stream.readUint16LE(); size > 0 && !stream.eos(); --size)
+		str += (char)stream.readByte();
+	return str;
+}
+
+void SaveStateIndex::writeSources(Common::WriteStream &stream, const Sources &sources) {
+	stream.writeUint32LE(sources.files.size());
+	for (uint i = 0; i < sources.files.size(); ++i) {
+		writeString(stream, sources.files[i]);
+		stream.writeSint32LE(sources.sizes[i]);
+		stream.writeUint32LE(sources.mtimes[i]);
+		stream.writeUint32LE(sources.mtimeMicros[i]);
+	}
+
+	stream.writeUint32LE(sources.patterns.size());
+	for (uint i = 0; i < sources.patterns.size(); ++i) {
+		writeString(stream, sources.patterns[i]);
+		stream.writeUint32LE(sources.listed[i].size());
+		for (uint j = 0; j < sources.listed[i].size(); ++j)
+			writeString(stream, sources.listed[i][j]);
+	}
+}
+
+void SaveStateIndex::readSources(Common::SeekableReadStream &stream, Sources &sources) {
+	const uint32 files = stream.readUint32LE();
+	for (uint32 i = 0; i < files && !stream.eos(); ++i) {
+		sources.files.push_back(readString(stream));
+		sources.sizes.push_back(stream.readSint32LE());
+		sources.mtimes.push_back(stream.readUint32LE());
+		sources.mtimeMicros.push_back(stream.readUint32LE());
+	}
+
+	const uint32 patterns = stream.readUint32LE();
+	for (uint32 i = 0; i < patterns && !stream.eos(); ++i) {
+		sources.patterns.push_back(readString(stream));
+		sources.listed.push_back(Common::StringArray());
+
+		const uint32 names = stream.readUint32LE();
+		for (uint32 j = 0; j < names && !stream.eos(); ++j)
+			sources.listed.back().push_back(readString(stream));
+	}
+}
+
+void SaveStateIndex::writeDescriptor(Common::WriteStream &stream, const SaveStateDescriptor &desc) {
+	stream.writeSint32LE(desc.getSaveSlot());
+	writeString(stream, desc.getDescription());
+	stream.writeByte(desc.getDeletableFlag());
+	stream.writeByte(desc.getWriteProtectedFlag());
+	writeString(stream, desc.getSaveDate());
+	writeString(stream, desc.getSaveTime());
+	writeString(stream, desc.getPlayTime());
+}
+
+void SaveStateIndex::readDescriptor(Common::SeekableReadStream &stream, SaveStateDescriptor &desc) {
+	desc.setSaveSlot(stream.readSint32LE());
+	if (desc.getSaveSlot() == -1)
+		return;
+
+	desc.setDescription(readString(stream));
+	desc.setDeletableFlag(stream.readByte() != 0);
+	desc.setWriteProtectedFlag(stream.readByte() != 0);
+	desc._saveDate = readString(stream);
+	desc._saveTime = readString(stream);
+	desc._playTime = readString(stream);
+}
+
+SaveStateIndexManager::SaveStateIndexManager() : _saveFileMan(0) {
+}
+
+SaveStateIndexManager::~SaveStateIndexManager() {
+	detach();
+}
+
+bool SaveStateIndexManager::attach(Common::SaveFileManager *saveFileMan) {
+	detach();
+
+	if (!saveFileMan || !saveFileMan->addObserver(this))
+		return false;
+
+	_saveFileMan = saveFileMan;
+	return true;
+}
+
+void SaveStateIndexManager::detach() {
+	if (!_saveFileMan)
+		return;
+
+	// Indices of other savepaths would be written to the wrong place, so
+	// what changed in them since they were last flushed is lost
+	flush();
+
+	for (IndexMap::iterator i = _indices.begin(); i != _indices.end(); ++i)
+		delete i->_value;
+	_indices.clear();
+
+	_saveFileMan->removeObserver(this);
+	_saveFileMan = 0;
+}
+
+void SaveStateIndexManager::flush() {
+	const Common::String savePath = ConfMan.get("savepath");
+
+	for (IndexMap::iterator i = _indices.begin(); i != _indices.end(); ++i) {
+		if (i->_value->getSavePath() == savePath)
+			i->_value->flush();
+	}
+}
+
+SaveStateIndex *SaveStateIndexManager::getIndex(const Common::String &target) {
+	if (!_saveFileMan || target.empty())
+		return 0;
+
+	const Common::String savePath = ConfMan.get("savepath");
+
+	SaveStateIndex *&index = _indices[target];
+	if (index && index->getSavePath() != savePath) {
+		// The savepath was changed, what is known about the old one is dropped
+		delete index;
+		index = 0;
+	}
+
+	if (!index)
+		index = new SaveStateIndex(_saveFileMan, target, savePath);
+
+	return index;
+}
+
+void SaveStateIndexManager::savefileOpened(const Common::String &name, int32 size, uint32 mtime, uint32 mtimeMicros) {
+	if (SaveStateIndex::isIndexFile(name))
+		return;
+
+	for (IndexMap::iterator i = _indices.begin(); i != _indices.end(); ++i)
+		i->_value->savefileOpened(name, size, mtime, mtimeMicros);
+}
+
+void SaveStateIndexManager::savefilesListed(const Common::String &pattern, const Common::StringArray &names) {
+	for (IndexMap::iterator i = _indices.begin(); i != _indices.end(); ++i)
+		i->_value->savefilesListed(pattern, names);
+}
+
+void SaveStateIndexManager::savefileChanged(const Common::String &name) {
+	if (SaveStateIndex::isIndexFile(name))
+		return;
+
+	getIndex(ConfMan.getActiveDomainName());
+
+	// The savefile is in the current savepath, not in that of other indices
+	const Common::String savePath = ConfMan.get("savepath");
+
+	for (IndexMap::iterator i = _indices.begin(); i != _indices.end(); ++i) {
+		if (i->_value->getSavePath() == savePath)
+			i->_value->savefileChanged(name);
+	}
+}
+
+bool SaveStateIndexManager::isOwnSavefile(const Common::String &name) const {
+	return SaveStateIndex::isIndexFile(name);
+}
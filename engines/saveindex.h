@@ -0,0 +1,235 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_SAVEINDEX_H
+#define ENGINES_SAVEINDEX_H
+
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/ptr.h"
+#include "common/savefile.h"
+#include "common/singleton.h"
+#include "common/str.h"
+#include "common/str-array.h"
+
+#include "engines/savestate.h"
+
+namespace Common {
+class SeekableReadStream;
+class WriteStream;
+}
+
+namespace Graphics {
+struct Surface;
+}
+
+class MetaEngine;
+
+/**
+ * Caches what MetaEngine::listSaves and MetaEngine::querySaveMetaInfos
+ * return for a target, so that the save/load chooser doesn't have to open
+ * and parse every savefile, including its thumbnail, each time it is shown.
+ *
+ * Engines read their savefiles in their own formats, so the index doesn't
+ * know which savefiles a save state is stored in. Instead, the
+ * SaveStateIndexManager tells the index which savefiles are opened and
+ * listed while the engine is asked for the information, and which
+ * savefiles are written or removed later on. Cached information is dropped
+ * as soon as one of the savefiles it was read from changes.
+ *
+ * The index is stored as a savefile of its own. Thumbnails are only read
+ * from it when they are asked for. Savefiles changed outside of ScummVM
+ * are noticed by their sizes and modification times, the first time an
+ * entry is used.
+ */
+class SaveStateIndex {
+public:
+	/**
+	 * @param saveFileMan	the savefile manager the savefiles and the index are read through
+	 * @param target		the target whose save states are indexed
+	 * @param savePath		the savepath the index is used for
+	 */
+	SaveStateIndex(Common::SaveFileManager *saveFileMan, const Common::String &target, const Common::String &savePath);
+	~SaveStateIndex();
+
+	/** @return the name of the savefile the index of a target is stored in */
+	static Common::String getFileName(const Common::String &target);
+
+	/** @return true if a savefile name is the name of an index file, which is never listed */
+	static bool isIndexFile(const Common::String &name);
+
+	const Common::String &getSavePath() const { return _savePath; }
+
+	/**
+	 * Lists the save states like MetaEngine::listSaves, asking the engine
+	 * only if the cached list is out of date.
+	 */
+	SaveStateList listSaves(const MetaEngine &metaEngine, const Common::String &target);
+
+	/**
+	 * Queries a save state like MetaEngine::querySaveMetaInfos, asking the
+	 * engine only if the cached information is out of date.
+	 * @param thumbnail	if false, the thumbnail isn't read from the index
+	 */
+	SaveStateDescriptor querySaveMetaInfos(const MetaEngine &metaEngine, const Common::String &target, int slot, bool thumbnail = true);
+
+	/** Writes the index to its file, if it changed. */
+	void flush();
+
+	/**
+	 * @name Notifications from the SaveStateIndexManager
+	 * @{
+	 */
+
+	/** A savefile was opened for loading, its size is -1 if it doesn't exist. */
+	void savefileOpened(const Common::String &name, int32 size, uint32 mtime, uint32 mtimeMicros);
+	/** Savefiles were listed. */
+	void savefilesListed(const Common::String &pattern, const Common::StringArray &names);
+	/** A savefile was written, renamed or removed. */
+	void savefileChanged(const Common::String &name);
+
+	/** @} */
+
+private:
+	/** The savefiles some information was read from */
+	struct Sources {
+		Common::StringArray files;
+		Common::Array<int32> sizes;
+		/** see SaveFileManager::getModificationTime() */
+		Common::Array<uint32> mtimes;
+		Common::Array<uint32> mtimeMicros;
+		Common::StringArray patterns;
+		Common::Array<Common::StringArray> listed;
+
+		bool isEmpty() const { return files.empty() && patterns.empty(); }
+		bool contains(const Common::String &name) const;
+		void clear();
+	};
+
+	struct Entry {
+		SaveStateDescriptor desc;
+		Sources sources;
+		/** checked against the savefiles since the index was loaded */
+		bool checked;
+
+		/** the thumbnail, if it isn't in the index file yet */
+		Common::SharedPtr<Graphics::Surface> thumbnail;
+		/** where the thumbnail is in the index file, 0 if it's in memory or there is none */
+		uint32 thumbnailOffset;
+		uint16 thumbnailWidth, thumbnailHeight;
+
+		Entry() : checked(false), thumbnailOffset(0), thumbnailWidth(0), thumbnailHeight(0) {}
+	};
+
+	typedef Common::HashMap<int, Entry> EntryMap;
+
+	Common::SaveFileManager *_saveFileMan;
+	const Common::String _fileName;
+	const Common::String _savePath;
+	bool _loaded;
+	bool _changed;
+
+	SaveStateList _list;
+	Sources _listSources;
+	bool _listValid;
+	bool _listChecked;
+
+	EntryMap _entries;
+
+	/** where the notifications go while the engine is asked, or NULL */
+	Sources *_recording;
+
+	void load();
+	bool isUpToDate(const Sources &sources);
+	Graphics::Surface *readThumbnail(Common::SeekableReadStream &stream, const Entry &entry) const;
+
+	static void writeString(Common::WriteStream &stream, const Common::String &str);
+	static Common::String readString(Common::SeekableReadStream &stream);
+	static void writeSources(Common::WriteStream &stream, const Sources &sources);
+	static void readSources(Common::SeekableReadStream &stream, Sources &sources);
+	static void writeDescriptor(Common::WriteStream &stream, const SaveStateDescriptor &desc);
+	static void readDescriptor(Common::SeekableReadStream &stream, SaveStateDescriptor &desc);
+};
+
+/**
+ * Keeps the save state indices of the targets whose save states were
+ * listed, and keeps them up to date by observing the savefile manager
+ * they are read through.
+ */
+class SaveStateIndexManager : public Common::SaveFileObserver, public Common::Singleton<SaveStateIndexManager> {
+public:
+	/**
+	 * Starts observing a savefile manager. Indices are only available
+	 * while one is observed. Changes are noticed from now on, so this
+	 * should be done before any savefiles are written.
+	 * @return false if the savefile manager doesn't support observers
+	 */
+	bool attach(Common::SaveFileManager *saveFileMan);
+
+	/**
+	 * Writes the indices which are stored in the current savepath to their
+	 * files, drops all indices and stops observing the savefile manager.
+	 */
+	void detach();
+
+	/**
+	 * Writes the indices which are stored in the current savepath to their
+	 * files. The savefile manager only reads and writes savefiles in the
+	 * current savepath, so this should be done while the domain whose
+	 * savefiles were changed is still active.
+	 */
+	void flush();
+
+	/**
+	 * Returns the index of the save states of a target. The index is
+	 * stored in the savepath of the active domain, so the target should be
+	 * the active domain.
+	 * @return the index, or NULL if no savefile manager is observed
+	 */
+	SaveStateIndex *getIndex(const Common::String &target);
+
+	virtual void savefileOpened(const Common::String &name, int32 size, uint32 mtime, uint32 mtimeMicros);
+	virtual void savefilesListed(const Common::String &pattern, const Common::StringArray &names);
+	/**
+	 * The index of the active domain is loaded first, so that it doesn't
+	 * miss the change. Indices of other savepaths are left alone.
+	 */
+	virtual void savefileChanged(const Common::String &name);
+	virtual bool isOwnSavefile(const Common::String &name) const;
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	SaveStateIndexManager();
+	~SaveStateIndexManager();
+
+	typedef Common::HashMap<Common::String, SaveStateIndex *, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> IndexMap;
+
+	Common::SaveFileManager *_saveFileMan;
+	/** The indices which were used, by target */
+	IndexMap _indices;
+};
+
+/** Shortcut for accessing the save state index manager. */
+#define SaveStateIndexMan SaveStateIndexManager::instance()
+
+#endif
@@ -160,6 +160,9 @@ public:
 	const Common::String &getPlayTime() const { return _playTime; }
 
 private:
+	/** The index stores the human readable strings, and shares the thumbnail */
+	friend class SaveStateIndex;
+
 	/**
 	 * The saveslot id, as it would be passed to the "-x" command line switch.
 	 */
@@ -29,6 +29,7 @@
 #include "sci/resource.h"
 #include "sci/engine/state.h"
 #include "sci/engine/kernel.h"
+#include "sci/engine/kpathing.h"
 #include "sci/engine/selector.h"
 #include "sci/engine/savegame.h"
 #include "sci/engine/gc.h"
@@ -59,6 +60,7 @@
 #endif
 
 #include "common/file.h"
+#include "common/memstream.h"
 #include "common/savefile.h"
 
 #include "engines/util.h"
@@ -81,6 +83,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	// Variables
 	DVar_Register("sleeptime_factor",	&g_debug_sleeptime_factor, DVAR_INT, 0);
 	DVar_Register("gc_interval",		&engine->_gamestate->scriptGCInterval, DVAR_INT, 0);
+	DVar_Register("gc_incremental",		&engine->_gamestate->scriptGCIncremental, DVAR_BOOL, 0);
 	DVar_Register("simulated_key",		&g_debug_simulated_key, DVAR_INT, 0);
 	DVar_Register("track_mouse_clicks",	&g_debug_track_mouse_clicks, DVAR_BOOL, 0);
 	DVar_Register("script_abort_flag",	&_engine->_gamestate->abortScriptProcessing, DVAR_INT, 0);
@@ -92,6 +95,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("opcodes",			WRAP_METHOD(Console, cmdOpcodes));
 	DCmd_Register("selector",			WRAP_METHOD(Console, cmdSelector));
 	DCmd_Register("selectors",			WRAP_METHOD(Console, cmdSelectors));
+	DCmd_Register("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	DCmd_Register("functions",			WRAP_METHOD(Console, cmdKernelFunctions));
 	DCmd_Register("class_table",		WRAP_METHOD(Console, cmdClassTable));
 	// Parser
@@ -109,6 +113,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	DCmd_Register("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	DCmd_Register("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	DCmd_Register("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
+	DCmd_Register("gfx_cache",			WRAP_METHOD(Console, cmdGfxCache));
 	DCmd_Register("list",				WRAP_METHOD(Console, cmdList));
 	DCmd_Register("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	DCmd_Register("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -136,6 +142,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("pl",                 WRAP_METHOD(Console, cmdPlaneList));	// alias
 	DCmd_Register("plane_items",        WRAP_METHOD(Console, cmdPlaneItemList));
 	DCmd_Register("pi",                 WRAP_METHOD(Console, cmdPlaneItemList));	// alias
+	DCmd_Register("frameout_stats",     WRAP_METHOD(Console, cmdFrameoutStats));
 	DCmd_Register("saved_bits",         WRAP_METHOD(Console, cmdSavedBits));
 	DCmd_Register("show_saved_bits",    WRAP_METHOD(Console, cmdShowSavedBits));
 	// Segments
@@ -147,6 +154,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("segkill",			WRAP_METHOD(Console, cmdKillSegment));			// alias
 	// Garbage collection
 	DCmd_Register("gc",					WRAP_METHOD(Console, cmdGCInvoke));
+	DCmd_Register("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	DCmd_Register("gc_objects",			WRAP_METHOD(Console, cmdGCObjects));
 	DCmd_Register("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	DCmd_Register("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
@@ -186,6 +194,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("find_callk",			WRAP_METHOD(Console, cmdFindKernelFunctionCall));
 	DCmd_Register("send",				WRAP_METHOD(Console, cmdSend));
 	DCmd_Register("go",					WRAP_METHOD(Console, cmdGo));
+	DCmd_Register("vm_benchmark",		WRAP_METHOD(Console, cmdVMBenchmark));
+	DCmd_Register("avoidpath_bench",	WRAP_METHOD(Console, cmdAvoidPathBenchmark));
 	DCmd_Register("logkernel",          WRAP_METHOD(Console, cmdLogKernel));
 	// Breakpoints
 	DCmd_Register("bp_list",			WRAP_METHOD(Console, cmdBreakpointList));
@@ -293,6 +303,8 @@ void Console::postEnter() {
 			// Switch back to 8bpp if we played a duck video
 			if (duckMode)
 				initGraphics(oldWidth, oldHeight, oldWidth > 320);
+			if (_engine->_gfxFrameout)
+				_engine->_gfxFrameout->invalidate();
 #endif
 
 			_engine->_gfxCursor->kernelShow();
@@ -329,6 +341,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" opcodes - Lists the opcode names\n");
 	DebugPrintf(" selectors - Lists the selector names\n");
 	DebugPrintf(" selector - Attempts to find the requested selector by name\n");
+	DebugPrintf(" selector_cache - Shows statistics of the selector lookup cache\n");
 	DebugPrintf(" functions - Lists the kernel functions\n");
 	DebugPrintf(" class_table - Shows the available classes\n");
 	DebugPrintf("\n");
@@ -348,6 +361,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	DebugPrintf(" resource_info - Shows info about a resource\n");
 	DebugPrintf(" resource_types - Shows the valid resource types\n");
+	DebugPrintf(" resource_cache - Shows statistics of the resource cache, or changes its size\n");
+	DebugPrintf(" gfx_cache - Shows statistics of the view and font cache, or changes its size\n");
 	DebugPrintf(" list - Lists all the resources of a given type\n");
 	DebugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	DebugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -373,6 +388,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" window_list / wl - Shows a list of all the windows (ports) in the draw list (SCI0 - SCI1.1)\n");
 	DebugPrintf(" plane_list / pl - Shows a list of all the planes in the draw list (SCI2+)\n");
 	DebugPrintf(" plane_items / pi - Shows a list of all items for a plane (SCI2+)\n");
+	DebugPrintf(" frameout_stats - Shows how much of the screen is drawn again in each frame (SCI2+)\n");
 	DebugPrintf(" saved_bits - List saved bits on the hunk\n");
 	DebugPrintf(" show_saved_bits - Display saved bits\n");
 	DebugPrintf("\n");
@@ -383,6 +399,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf("\n");
 	DebugPrintf("Garbage collection:\n");
 	DebugPrintf(" gc - Invokes the garbage collector\n");
+	DebugPrintf(" gc_stats - Shows how long the garbage collector paused the game\n");
 	DebugPrintf(" gc_objects - Lists all reachable objects, normalized\n");
 	DebugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	DebugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
@@ -414,6 +431,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" disasm - Disassembles a method by name\n");
 	DebugPrintf(" disasm_addr - Disassembles one or more commands\n");
 	DebugPrintf(" send - Sends a message to an object\n");
+	DebugPrintf(" vm_benchmark - Measures how fast a method is executed, with and without pre-decoded instructions\n");
+	DebugPrintf(" avoidpath_bench - Records pathfinding calls and measures how fast they are, with and without caching\n");
 	DebugPrintf(" go - Executes the script\n");
 	DebugPrintf(" logkernel - Logs kernel calls\n");
 	DebugPrintf("\n");
@@ -541,6 +560,29 @@ bool Console::cmdSelector(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	SegManager *segMan = _engine->_gamestate->_segMan;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows statistics of the cache of selector lookups\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		DebugPrintf("With reset, the statistics are cleared\n");
+		return true;
+	}
+
+	if (argc == 2)
+		segMan->resetSelectorLookupStats();
+
+	const SegManager::SelectorLookupStats &stats = segMan->getSelectorLookupStats();
+	const uint32 lookups = stats.hits + stats.misses;
+
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate)\n", stats.hits, stats.misses,
+		lookups ? (int)((double)stats.hits * 100 / lookups) : 0);
+	DebugPrintf("Flushes: %d\n", stats.flushes);
+
+	return true;
+}
+
 bool Console::cmdSelectors(int argc, const char **argv) {
 	DebugPrintf("Selector names in numeric order:\n");
 	Common::String selectorName;
@@ -792,6 +834,70 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") && atoi(argv[1]) <= 0)) {
+		DebugPrintf("Shows statistics of the cache of resources which are not in use\n");
+		DebugPrintf("Usage: %s [<size in KB> | reset]\n", argv[0]);
+		DebugPrintf("With a size, the cache is resized, with reset, the statistics are cleared\n");
+		return true;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "reset"))
+			resMan->resetCacheStats();
+		else
+			resMan->setCacheSize(atoi(argv[1]) * 1024);
+	}
+
+	const ResourceManager::CacheStats &stats = resMan->getCacheStats();
+	const uint32 lookups = stats.hits + stats.misses;
+
+	DebugPrintf("Cache: %d of %d KB used by %d resources, %d KB locked\n",
+		resMan->getCacheMemory() / 1024, resMan->getCacheSize() / 1024,
+		resMan->getCacheCount(), resMan->getLockedMemory() / 1024);
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate)\n", stats.hits, stats.misses,
+		lookups ? (int)((double)stats.hits * 100 / lookups) : 0);
+	DebugPrintf("Loaded: %d KB, evictions: %d (%d KB)\n", stats.bytesLoaded / 1024,
+		stats.evictions, stats.bytesEvicted / 1024);
+
+	return true;
+}
+
+bool Console::cmdGfxCache(int argc, const char **argv) {
+	GfxCache *cache = _engine->_gfxCache;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") && atoi(argv[1]) <= 0)) {
+		DebugPrintf("Shows statistics of the cache of views and fonts\n");
+		DebugPrintf("Usage: %s [<size in KB> | reset]\n", argv[0]);
+		DebugPrintf("With a size, the cache is resized, with reset, the statistics are cleared\n");
+		return true;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "reset"))
+			cache->resetStats();
+		else
+			cache->setCacheSize(atoi(argv[1]) * 1024);
+	}
+
+	const GfxCache::Stats &stats = cache->getStats();
+	const uint32 viewLookups = stats.viewHits + stats.viewMisses;
+	const uint32 fontLookups = stats.fontHits + stats.fontMisses;
+
+	DebugPrintf("Cache: %d of %d KB used by %d views and %d fonts\n",
+		cache->getMemoryUsage() / 1024, cache->getCacheSize() / 1024,
+		cache->getViewCount(), cache->getFontCount());
+	DebugPrintf("Views: %d hits, %d misses (%d%% hit rate)\n", stats.viewHits, stats.viewMisses,
+		viewLookups ? (int)((double)stats.viewHits * 100 / viewLookups) : 0);
+	DebugPrintf("Fonts: %d hits, %d misses (%d%% hit rate)\n", stats.fontHits, stats.fontMisses,
+		fontLookups ? (int)((double)stats.fontHits * 100 / fontLookups) : 0);
+	DebugPrintf("Evictions: %d (%d KB)\n", stats.evictions, stats.bytesEvicted / 1024);
+
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		DebugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
@@ -1675,6 +1781,45 @@ bool Console::cmdPlaneItemList(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdFrameoutStats(int argc, const char **argv) {
+#ifdef ENABLE_SCI32
+	if (!_engine->_gfxFrameout) {
+		DebugPrintf("This SCI version does not use kFrameOut\n");
+		return true;
+	}
+
+	GfxFrameout *frameout = _engine->_gfxFrameout;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		frameout->resetStats();
+	} else if (argc == 3 && (!strcmp(argv[1], "overlay") || !strcmp(argv[1], "tracking"))
+	           && (!strcmp(argv[2], "on") || !strcmp(argv[2], "off"))) {
+		const bool on = !strcmp(argv[2], "on");
+		if (!strcmp(argv[1], "overlay"))
+			frameout->setShowStats(on);
+		else
+			frameout->setTrackingChanges(on);
+	} else if (argc != 1) {
+		DebugPrintf("Shows how many frames had to be drawn again, and how much of the screen\n");
+		DebugPrintf("was copied to the backend.\n");
+		DebugPrintf("Usage: %s [reset | overlay <on/off> | tracking <on/off>]\n", argv[0]);
+		DebugPrintf("overlay shows the numbers of every frame on the screen. Without tracking,\n");
+		DebugPrintf("every frame is drawn and copied completely.\n");
+		return true;
+	}
+
+	const FrameoutStats &stats = frameout->getStats();
+	DebugPrintf("Change tracking: %s\n", frameout->isTrackingChanges() ? "on" : "off");
+	DebugPrintf("Frames: %d, %d of them drawn\n", stats.frames, stats.composited);
+	DebugPrintf("Items: %d drawn, %d skipped\n", stats.drawn, stats.skipped);
+	DebugPrintf("Pixels copied: %d per frame\n", stats.frames ? (int)(stats.pixels / stats.frames) : 0);
+	DebugPrintf("Last frame: %d of %d items drawn, %d pixels copied\n", stats.lastDrawn, stats.lastOps, stats.lastPixels);
+#else
+	DebugPrintf("SCI32 isn't included in this compiled executable\n");
+#endif
+	return true;
+}
+
 bool Console::cmdSavedBits(int argc, const char **argv) {
 	SegManager *segman = _engine->_gamestate->_segMan;
 	SegmentId id = segman->findSegmentByType(SEG_TYPE_HUNK);
@@ -2237,6 +2382,36 @@ bool Console::cmdGCInvoke(int argc, const char **argv) {
 	return true;
 }
 
+static void printGCPauses(Console *con, const char *name, const GCPauseStats &pauses) {
+	con->DebugPrintf("%-22s %6d pauses, %6d ms in total, %4d ms max, %4d ms last\n", name, pauses.count,
+		pauses.totalTime, pauses.maxTime, pauses.lastTime);
+}
+
+bool Console::cmdGCStats(int argc, const char **argv) {
+	GarbageCollector *gc = _engine->_gamestate->_gc;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows how long the garbage collector paused the game\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		DebugPrintf("With reset, the statistics are cleared\n");
+		return true;
+	}
+
+	if (argc == 2)
+		gc->resetStats();
+
+	const GCStats &stats = gc->getStats();
+
+	DebugPrintf("Incremental collections: %s%s\n", _engine->_gamestate->scriptGCIncremental ? "on" : "off",
+		gc->isMarking() ? " (marking)" : "");
+	printGCPauses(this, "Complete collections:", stats.full);
+	printGCPauses(this, "Incremental steps:", stats.steps);
+	printGCPauses(this, "Incremental ends:", stats.final);
+	DebugPrintf("Freed objects: %d\n", stats.freed);
+
+	return true;
+}
+
 bool Console::cmdGCObjects(int argc, const char **argv) {
 	AddrSet *use_map = findAllActiveReferences(_engine->_gamestate);
 
@@ -3201,6 +3376,188 @@ bool Console::cmdSend(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdVMBenchmark(int argc, const char **argv) {
+	if (argc < 3 || argc > 4) {
+		DebugPrintf("Measures how fast the VM executes a method, once parsing every instruction\n");
+		DebugPrintf("when it is executed and once from pre-decoded instructions.\n");
+		DebugPrintf("Usage: %s <object> <selector name> [<repetitions>]\n", argv[0]);
+		DebugPrintf("The method is invoked without parameters. Each run starts from the current\n");
+		DebugPrintf("game state, and the game continues from it afterwards, as if it was restored.\n");
+		DebugPrintf("Example: %s ?fooScript calculate 1000\n", argv[0]);
+		return true;
+	}
+
+	EngineState *s = _engine->_gamestate;
+	reg_t object;
+
+	if (parse_reg_t(s, argv[1], &object, false)) {
+		DebugPrintf("Invalid address \"%s\" passed.\n", argv[1]);
+		DebugPrintf("Check the \"addresses\" command on how to use addresses\n");
+		return true;
+	}
+
+	const char *selectorName = argv[2];
+	int selectorId = _engine->getKernel()->findSelector(selectorName);
+
+	if (selectorId < 0) {
+		DebugPrintf("Unknown selector: \"%s\"\n", selectorName);
+		return true;
+	}
+
+	if (!s->_segMan->getObject(object)) {
+		DebugPrintf("Address \"%04x:%04x\" is not an object\n", PRINT_REG(object));
+		return true;
+	}
+
+	if (lookupSelector(s->_segMan, object, selectorId, NULL, NULL) != kSelectorMethod) {
+		DebugPrintf("Object does not have a method \"%s\"\n", selectorName);
+		return true;
+	}
+
+	const int repetitions = (argc == 4) ? atoi(argv[3]) : 1000;
+	if (repetitions <= 0) {
+		DebugPrintf("Invalid number of repetitions \"%s\"\n", argv[3]);
+		return true;
+	}
+
+	// The method may change the game state, so every run starts from a
+	// copy of it
+	Common::MemoryWriteStreamDynamic snapshot(DisposeAfterUse::YES);
+	if (!gamestate_save(s, &snapshot, "vm_benchmark", "")) {
+		DebugPrintf("The game state can't be saved here, try again after continuing the game\n");
+		return true;
+	}
+
+	const bool oldPredecodeScripts = s->_predecodeScripts;
+	const int frameOffset = s->_executionStack.back().sp - s->stack_base;
+	uint32 steps[2] = { 0, 0 };
+	uint32 time[2] = { 0, 0 };
+
+	// Run both modes twice, in the order ABBA, so that neither profits
+	// from running later, e.g. from warm caches
+	for (int run = 0; run < 4 && s->abortScriptProcessing != kAbortQuitGame; run++) {
+		const int predecode = (run == 1 || run == 2) ? 1 : 0;
+
+		Common::MemoryReadStream in(snapshot.getData(), snapshot.size());
+		gamestate_restore(s, &in);
+		s->abortScriptProcessing = kAbortNone;
+		s->_predecodeScripts = (predecode != 0);
+
+		const uint32 startSteps = s->scriptStepCounter;
+		const uint32 startTime = g_system->getMillis();
+
+		for (int i = 0; i < repetitions && s->abortScriptProcessing == kAbortNone; i++) {
+			// Create the data block for send_selector() at the top of the stack
+			StackPtr stackframe = s->stack_base + frameOffset;
+			stackframe[0] = make_reg(0, selectorId);
+			stackframe[1] = NULL_REG;
+
+			send_selector(s, object, object, stackframe + 2, 2, stackframe);
+			s->_executionStackPosChanged = true;
+			run_vm(s);
+		}
+
+		steps[predecode] += s->scriptStepCounter - startSteps;
+		time[predecode] += g_system->getMillis() - startTime;
+	}
+
+	for (int predecode = 0; predecode < 2; predecode++) {
+		const uint32 totalTime = MAX<uint32>(time[predecode], 1);
+		DebugPrintf("%s: %d instructions in %d ms, %d instructions per second\n",
+			predecode ? "Pre-decoded" : "Parsed", steps[predecode], totalTime, (int)((double)steps[predecode] * 1000 / totalTime));
+	}
+
+	s->_predecodeScripts = oldPredecodeScripts;
+
+	if (s->abortScriptProcessing == kAbortQuitGame)
+		return Cmd_Exit(0, 0);
+
+	// Continue the game from the state before the benchmark
+	Common::MemoryReadStream in(snapshot.getData(), snapshot.size());
+	gamestate_restore(s, &in);
+
+	return Cmd_Exit(0, 0);
+}
+
+bool Console::cmdAvoidPathBenchmark(int argc, const char **argv) {
+	AvoidPathCache *cache = _engine->_gamestate->_avoidPathCache;
+
+	if (argc > 3 || (argc >= 2 && strcmp(argv[1], "record") && strcmp(argv[1], "stop") && strcmp(argv[1], "clear")
+	        && strcmp(argv[1], "run") && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Records kAvoidPath calls and measures how fast paths are found for them,\n");
+		DebugPrintf("once without and once with the visibility graph cache and edge grid.\n");
+		DebugPrintf("Usage: %s [record | stop | clear | run [<repetitions>] | reset]\n", argv[0]);
+		DebugPrintf("Without parameters, the cache statistics are shown. With reset, they are cleared\n");
+		DebugPrintf("Example: %s record, then walk around in the game, then %s run 20\n", argv[0], argv[0]);
+		return true;
+	}
+
+	if (argc >= 2 && !strcmp(argv[1], "record")) {
+		cache->setRecording(true);
+	} else if (argc >= 2 && !strcmp(argv[1], "stop")) {
+		cache->setRecording(false);
+	} else if (argc >= 2 && !strcmp(argv[1], "clear")) {
+		cache->clearRecorded();
+	} else if (argc >= 2 && !strcmp(argv[1], "reset")) {
+		cache->resetStats();
+	} else if (argc >= 2) {
+		const Common::Array<AvoidPathInput> &recorded = cache->getRecorded();
+		if (recorded.empty()) {
+			DebugPrintf("No calls have been recorded\n");
+			return true;
+		}
+
+		const int repetitions = (argc == 3) ? atoi(argv[2]) : 10;
+		if (repetitions <= 0) {
+			DebugPrintf("Invalid number of repetitions \"%s\"\n", argv[2]);
+			return true;
+		}
+
+		const bool oldEnabled = cache->isEnabled();
+		Common::Array<Common::Array<Common::Point> > paths[2];
+		Common::Array<Common::Point> path;
+
+		for (int cached = 0; cached < 2; cached++) {
+			cache->setEnabled(cached != 0);
+			cache->clear();
+			cache->resetStats();
+			paths[cached].resize(recorded.size());
+
+			const uint32 startTime = g_system->getMillis();
+
+			for (int i = 0; i < repetitions; i++) {
+				for (uint j = 0; j < recorded.size(); j++) {
+					replayAvoidPath(_engine->_gamestate, recorded[j], path);
+					if (i == 0)
+						paths[cached][j] = path;
+				}
+			}
+
+			const uint32 time = MAX<uint32>(g_system->getMillis() - startTime, 1);
+			const uint32 count = repetitions * recorded.size();
+			DebugPrintf("%s: %d paths in %d ms, %d paths per second\n",
+				cached ? "Cached" : "Uncached", count, time, (int)((double)count * 1000 / time));
+		}
+
+		int differences = 0;
+		for (uint j = 0; j < recorded.size(); j++) {
+			if (!(paths[0][j] == paths[1][j]))
+				differences++;
+		}
+		if (differences)
+			DebugPrintf("Warning: %d paths differ between both runs\n", differences);
+
+		cache->setEnabled(oldEnabled);
+	}
+
+	const AvoidPathStats &stats = cache->getStats();
+	DebugPrintf("Recorded calls: %d%s\n", cache->getRecorded().size(), cache->isRecording() ? " (recording)" : "");
+	DebugPrintf("Polygon sets: %d found in cache, %d added\n", stats.hits, stats.misses);
+	DebugPrintf("Visibility rows: %d found in cache, %d computed\n", stats.rowsReused, stats.rowsComputed);
+
+	return true;
+}
+
 bool Console::cmdGo(int argc, const char **argv) {
 	// CHECKME: is this necessary?
 	_debugState.seeking = kDebugSeekNothing;
@@ -22,6 +22,7 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
@@ -80,26 +81,35 @@ static AddrSet *normalizeAddresses(SegManager *segMan, const AddrSet &nonnormal_
 	return normal_map;
 }
 
-static void processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap) {
+static bool processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap,
+		uint budget = 0xFFFFFFFF, bool skipFreed = false) {
 	SegmentId stackSegment = segMan->findSegmentByType(SEG_TYPE_STACK);
 	while (!wm._worklist.empty()) {
+		if (!budget--)
+			return false;
+
 		reg_t reg = wm._worklist.back();
 		wm._worklist.pop_back();
 		if (reg.getSegment() != stackSegment) { // No need to repeat this one
 			debugC(kDebugLevelGC, "[GC] Checking %04x:%04x", PRINT_REG(reg));
 			if (reg.getSegment() < heap.size() && heap[reg.getSegment()]) {
+				// During incremental collections, scripts can free
+				// entries which are still on the worklist
+				if (skipFreed && !heap[reg.getSegment()]->isValidOffset(reg.getOffset()))
+					continue;
+
 				// Valid heap object? Find its outgoing references!
 				wm.pushArray(heap[reg.getSegment()]->listAllOutgoingReferences(reg));
 			}
 		}
 	}
+
+	return true;
 }
 
-AddrSet *findAllActiveReferences(EngineState *s) {
+static void pushRootSet(EngineState *s, WorklistManager &wm) {
 	assert(!s->_executionStack.empty());
 
-	WorklistManager wm;
-
 	// Initialize registers
 	wm.push(s->r_acc);
 	wm.push(s->r_prev);
@@ -151,7 +161,14 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	}
 
 	debugC(kDebugLevelGC, "[GC] -- Finished explicitly loaded scripts, done with root set");
+}
+
+AddrSet *findAllActiveReferences(EngineState *s) {
+	WorklistManager wm;
+
+	pushRootSet(s, wm);
 
+	const Common::Array<SegmentObj *> &heap = s->_segMan->getSegments();
 	processWorkList(s->_segMan, wm, heap);
 
 	if (g_sci->_gfxPorts)
@@ -160,11 +177,14 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	return normalizeAddresses(s->_segMan, wm._map);
 }
 
-void run_gc(EngineState *s) {
-	SegManager *segMan = s->_segMan;
+/**
+ * Free everything which is not in the set of active references.
+ * @return the number of freed objects
+ */
+static uint sweep(SegManager *segMan, const AddrSet &activeRefs) {
+	uint freed = 0;
 
 	// Some debug stuff
-	debugC(kDebugLevelGC, "[GC] Running...");
 #ifdef GC_DEBUG_CODE
 	const char *segnames[SEG_TYPE_MAX + 1];
 	int segcount[SEG_TYPE_MAX + 1];
@@ -172,9 +192,6 @@ void run_gc(EngineState *s) {
 	memset(segcount, 0, sizeof(segcount));
 #endif
 
-	// Compute the set of all segments references currently in use.
-	AddrSet *activeRefs = findAllActiveReferences(s);
-
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
 	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
@@ -192,10 +209,11 @@ void run_gc(EngineState *s) {
 			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
 			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
 				const reg_t addr = *it;
-				if (!activeRefs->contains(addr)) {
+				if (!activeRefs.contains(addr)) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+					freed++;
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
 #endif
@@ -205,8 +223,6 @@ void run_gc(EngineState *s) {
 		}
 	}
 
-	delete activeRefs;
-
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
 	debugC(kDebugLevelGC, "[GC] Summary:");
@@ -214,6 +230,149 @@ void run_gc(EngineState *s) {
 		if (segcount[i])
 			debugC(kDebugLevelGC, "\t%d\t* %s", segcount[i], segnames[i]);
 #endif
+
+	return freed;
+}
+
+void run_gc(EngineState *s) {
+	s->_gc->collect(s);
+}
+
+void GCPauseStats::add(uint32 time) {
+	count++;
+	totalTime += time;
+	maxTime = MAX(maxTime, time);
+	lastTime = time;
+}
+
+GarbageCollector::GarbageCollector() : _marking(false) {
+	resetStats();
+}
+
+void GarbageCollector::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+void GarbageCollector::collect(EngineState *s) {
+	if (_marking)
+		cancel(s);
+
+	debugC(kDebugLevelGC, "[GC] Running...");
+	const uint32 startTime = g_system->getMillis();
+
+	// Compute the set of all segments references currently in use.
+	AddrSet *activeRefs = findAllActiveReferences(s);
+
+	_stats.freed += sweep(s->_segMan, *activeRefs);
+
+	delete activeRefs;
+
+	_stats.full.add(g_system->getMillis() - startTime);
+}
+
+void GarbageCollector::start(EngineState *s) {
+	assert(!_marking);
+
+	debugC(kDebugLevelGC, "[GC] Starting incremental collection");
+	const uint32 startTime = g_system->getMillis();
+
+	_wm._worklist.clear();
+	_wm._map.clear();
+	pushRootSet(s, _wm);
+
+	s->_segMan->startWriteBarrier();
+	_marking = true;
+
+	_stats.steps.add(g_system->getMillis() - startTime);
+}
+
+void GarbageCollector::step(EngineState *s) {
+	enum {
+		kStepBudget = 64	///< Number of entries of the worklist to process in one step
+	};
+
+	if (!_marking)
+		return;
+
+	SegManager *segMan = s->_segMan;
+
+	if (segMan->segmentFreedDuringWriteBarrier()) {
+		// Addresses which were already marked may refer to other objects
+		// now, so start over with a complete collection
+		debugC(kDebugLevelGC, "[GC] Segment freed during incremental collection");
+		collect(s);
+		return;
+	}
+
+	const uint32 startTime = g_system->getMillis();
+	const bool done = processWorkList(segMan, _wm, segMan->getSegments(), kStepBudget, true);
+	_stats.steps.add(g_system->getMillis() - startTime);
+
+	if (done)
+		finish(s);
+}
+
+void GarbageCollector::finish(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+
+	const uint32 startTime = g_system->getMillis();
+
+	Common::Array<reg_t> written;
+	segMan->stopWriteBarrier(written);
+	_marking = false;
+
+	// The roots may have changed completely in the meantime
+	pushRootSet(s, _wm);
+
+	// The VM writes to the local variables through pointers it keeps, so
+	// changes to these are not recorded
+	for (uint i = 1; i < heap.size(); i++) {
+		if (heap[i] && heap[i]->getType() == SEG_TYPE_LOCALS)
+			rescan(segMan, make_reg(i, 0));
+	}
+
+	// Scan everything again which might have been changed after it was scanned
+	for (uint i = 0; i < written.size(); i++)
+		rescan(segMan, written[i]);
+
+	processWorkList(segMan, _wm, heap, 0xFFFFFFFF, true);
+
+	if (g_sci->_gfxPorts)
+		g_sci->_gfxPorts->processEngineHunkList(_wm);
+
+	AddrSet *activeRefs = normalizeAddresses(segMan, _wm._map);
+	_wm._map.clear();
+
+	_stats.freed += sweep(segMan, *activeRefs);
+
+	delete activeRefs;
+
+	_stats.final.add(g_system->getMillis() - startTime);
+	debugC(kDebugLevelGC, "[GC] Finished incremental collection");
+}
+
+void GarbageCollector::cancel(EngineState *s) {
+	if (!_marking)
+		return;
+
+	Common::Array<reg_t> written;
+	s->_segMan->stopWriteBarrier(written);
+
+	_wm._worklist.clear();
+	_wm._map.clear();
+	_marking = false;
+}
+
+void GarbageCollector::rescan(SegManager *segMan, reg_t addr) {
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+
+	if (addr.getSegment() >= heap.size() || !heap[addr.getSegment()])
+		return;
+
+	SegmentObj *mobj = heap[addr.getSegment()];
+	if (mobj->isValidOffset(addr.getOffset()))
+		_wm.pushArray(mobj->listAllOutgoingReferences(addr));
 }
 
 } // End of namespace Sci
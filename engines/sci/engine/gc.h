@@ -30,12 +30,6 @@
 
 namespace Sci {
 
-struct reg_t_Hash {
-	uint operator()(const reg_t& x) const {
-		return (x.getSegment() << 3) ^ x.getOffset() ^ (x.getOffset() << 16);
-	}
-};
-
 /*
  * The AddrSet is a "set" of reg_t values.
  * We don't have a HashSet type, so we abuse a HashMap for this.
@@ -63,6 +57,61 @@ struct WorklistManager {
 	void pushArray(const Common::Array<reg_t> &tmp);
 };
 
+/** Timing of one kind of garbage collector pause, in milliseconds */
+struct GCPauseStats {
+	uint32 count;
+	uint32 totalTime;
+	uint32 maxTime;
+	uint32 lastTime;
+
+	void add(uint32 time);
+};
+
+struct GCStats {
+	GCPauseStats full;	///< complete collections
+	GCPauseStats steps;	///< incremental marking steps
+	GCPauseStats final;	///< end of incremental collections, where the roots are scanned again and garbage is freed
+	uint32 freed;		///< number of freed objects
+};
+
+/**
+ * Spreads the marking phase of garbage collections over many kernel calls.
+ *
+ * While marking, the SegManager records all objects, lists, nodes and
+ * arrays which are accessed or allocated, as scripts can change them
+ * after they were scanned. At the end, these are scanned again together
+ * with the root set, before anything is freed.
+ */
+class GarbageCollector {
+public:
+	GarbageCollector();
+
+	/** Run a complete collection, after cancelling an incremental one. */
+	void collect(EngineState *s);
+
+	/** Start an incremental collection. */
+	void start(EngineState *s);
+
+	/** Mark some more objects of the current incremental collection, and finish it when done. */
+	void step(EngineState *s);
+
+	/** Stop the current incremental collection without freeing anything. */
+	void cancel(EngineState *s);
+
+	bool isMarking() const { return _marking; }
+
+	const GCStats &getStats() const { return _stats; }
+	void resetStats();
+
+private:
+	void finish(EngineState *s);
+	void rescan(SegManager *segMan, reg_t addr);
+
+	WorklistManager _wm;
+	bool _marking;
+	GCStats _stats;
+};
+
 
 } // End of namespace Sci
 
@@ -210,6 +210,7 @@ static void addToFront(EngineState *s, reg_t listRef, reg_t nodeRef) {
 
 	newNode->pred = NULL_REG;
 	newNode->succ = list->first;
+	s->_segMan->recordWrite(nodeRef);
 
 	// Set node to be the first and last node if it's the only node of the list
 	if (list->first.isNull())
@@ -217,8 +218,10 @@ static void addToFront(EngineState *s, reg_t listRef, reg_t nodeRef) {
 	else {
 		Node *oldNode = s->_segMan->lookupNode(list->first);
 		oldNode->pred = nodeRef;
+		s->_segMan->recordWrite(list->first);
 	}
 	list->first = nodeRef;
+	s->_segMan->recordWrite(listRef);
 }
 
 static void addToEnd(EngineState *s, reg_t listRef, reg_t nodeRef) {
@@ -236,6 +239,7 @@ static void addToEnd(EngineState *s, reg_t listRef, reg_t nodeRef) {
 
 	newNode->pred = list->last;
 	newNode->succ = NULL_REG;
+	s->_segMan->recordWrite(nodeRef);
 
 	// Set node to be the first and last node if it's the only node of the list
 	if (list->last.isNull())
@@ -243,8 +247,10 @@ static void addToEnd(EngineState *s, reg_t listRef, reg_t nodeRef) {
 	else {
 		Node *old_n = s->_segMan->lookupNode(list->last);
 		old_n->succ = nodeRef;
+		s->_segMan->recordWrite(list->last);
 	}
 	list->last = nodeRef;
+	s->_segMan->recordWrite(listRef);
 }
 
 reg_t kNextNode(EngineState *s, int argc, reg_t *argv) {
@@ -321,6 +327,7 @@ reg_t kAddAfter(EngineState *s, int argc, reg_t *argv) {
 
 	if (argc == 4)
 		newnode->key = argv[3];
+	s->_segMan->recordWrite(argv[2]);
 
 	if (firstnode) { // We're really appending after
 		reg_t oldnext = firstnode->succ;
@@ -328,12 +335,16 @@ reg_t kAddAfter(EngineState *s, int argc, reg_t *argv) {
 		newnode->pred = argv[1];
 		firstnode->succ = argv[2];
 		newnode->succ = oldnext;
+		s->_segMan->recordWrite(argv[1]);
 
-		if (oldnext.isNull())  // Appended after last node?
+		if (oldnext.isNull()) { // Appended after last node?
 			// Set new node as last list node
 			list->last = argv[2];
-		else
+			s->_segMan->recordWrite(argv[0]);
+		} else {
 			s->_segMan->lookupNode(oldnext)->pred = argv[2];
+			s->_segMan->recordWrite(oldnext);
+		}
 
 	} else { // !firstnode
 		addToFront(s, argv[0], argv[2]); // Set as initial list node
@@ -385,11 +396,16 @@ reg_t kDeleteKey(EngineState *s, int argc, reg_t *argv) {
 		list->first = n->succ;
 	if (list->last == node_pos)
 		list->last = n->pred;
+	s->_segMan->recordWrite(argv[0]);
 
-	if (!n->pred.isNull())
+	if (!n->pred.isNull()) {
 		s->_segMan->lookupNode(n->pred)->succ = n->succ;
-	if (!n->succ.isNull())
+		s->_segMan->recordWrite(n->pred);
+	}
+	if (!n->succ.isNull()) {
 		s->_segMan->lookupNode(n->succ)->pred = n->pred;
+		s->_segMan->recordWrite(n->succ);
+	}
 
 	// Erase references to the predecessor and successor nodes, as the game
 	// scripts could reference the node itself again.
@@ -729,6 +745,7 @@ reg_t kArray(EngineState *s, int argc, reg_t *argv) {
 
 		for (uint16 i = 0; i < count; i++)
 			array->setValue(i + index, argv[i + 3]);
+		s->_segMan->recordWrite(argv[1]);
 
 		return argv[1]; // We also have to return the handle
 	}
@@ -748,6 +765,7 @@ reg_t kArray(EngineState *s, int argc, reg_t *argv) {
 
 		for (uint16 i = 0; i < count; i++)
 			array->setValue(i + index, argv[4]);
+		s->_segMan->recordWrite(argv[1]);
 
 		return argv[1];
 	}
@@ -781,6 +799,7 @@ reg_t kArray(EngineState *s, int argc, reg_t *argv) {
 
 		for (uint16 i = 0; i < count; i++)
 			array1->setValue(i + index1, array2->getValue(i + index2));
+		s->_segMan->recordWrite(arrayHandle);
 
 		return arrayHandle;
 	}
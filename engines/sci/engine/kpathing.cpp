@@ -24,6 +24,7 @@
 #include "sci/engine/state.h"
 #include "sci/engine/selector.h"
 #include "sci/engine/kernel.h"
+#include "sci/engine/kpathing.h"
 #include "sci/graphics/paint16.h"
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
@@ -111,10 +112,18 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Index in the visibility graph, -1 if not part of it
+	int graphIndex;
+
+	// Last edge grid query which returned the edge starting here
+	uint32 gridQuery;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		graphIndex = -1;
+		gridQuery = 0;
 	}
 };
 
@@ -236,6 +245,34 @@ public:
 
 typedef Common::List<Polygon *> PolygonList;
 
+/**
+ * The edges of the polygon set sorted into a grid of cells, so only the
+ * edges near a line segment need to be checked for intersections.
+ */
+struct EdgeGrid {
+	enum {
+		kCells = 16,
+		kMinVertices = 32	// checking every edge is cheaper for fewer vertices
+	};
+
+	int _left, _top;
+	int _cellWidth, _cellHeight;
+
+	// Edges of cell i are _edges[_cellStart[i]] to _edges[_cellStart[i + 1] - 1]
+	uint _cellStart[kCells * kCells + 1];
+	Common::Array<Vertex *> _edges;
+
+	uint32 _query;
+
+	EdgeGrid(Vertex **vertices, int count);
+
+	// Checks whether any edge blocks the line segment (p, q)
+	bool blocks(const Common::Point &p, const Common::Point &q);
+
+private:
+	Common::Rect cellRange(const Common::Point &p, const Common::Point &q) const;
+};
+
 // Pathfinding state
 struct PathfindingState {
 	// List of all polygons
@@ -257,17 +294,31 @@ struct PathfindingState {
 	// Screen size
 	int _width, _height;
 
-	PathfindingState(int width, int height) : _width(width), _height(height) {
+	// Cache for visibility graphs, NULL if disabled
+	AvoidPathCache *_cache;
+
+	// Visibility graph of the obstacles, and its vertices
+	VisibilityGraph *_graph;
+	Common::Array<Vertex *> _graphVertices;
+
+	// Edges sorted by position, NULL for small polygon sets
+	EdgeGrid *_edgeGrid;
+
+	PathfindingState(int width, int height, AvoidPathCache *cache) : _width(width), _height(height) {
 		vertex_start = NULL;
 		vertex_end = NULL;
 		vertex_index = NULL;
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		_cache = (cache && cache->isEnabled()) ? cache : NULL;
+		_graph = NULL;
+		_edgeGrid = NULL;
 	}
 
 	~PathfindingState() {
 		free(vertex_index);
+		delete _edgeGrid;
 
 		delete _prependPoint;
 		delete _appendPoint;
@@ -659,6 +710,185 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 	return 0;
 }
 
+/**
+ * Determines whether or not an edge blocks the line segment between two
+ * vertices
+ * Parameters: (const Common::Point &) p, q: The vertices
+ *             (Vertex *) edge: The first vertex of the edge
+ * Returns   : (bool) true if the edge is in the way, false otherwise
+ */
+static bool edge_blocks(const Common::Point &p, const Common::Point &q, Vertex *edge) {
+	if (!VERTEX_HAS_EDGES(edge))
+		return false;
+
+	if (between(p, q, edge->v)) {
+		// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+		return inside(p, edge) || inside(q, edge);
+	}
+
+	return intersect_proper(p, q, edge->v, CLIST_NEXT(edge)->v);
+}
+
+EdgeGrid::EdgeGrid(Vertex **vertices, int count) : _query(0) {
+	int right, bottom;
+
+	_left = right = vertices[0]->v.x;
+	_top = bottom = vertices[0]->v.y;
+
+	for (int i = 1; i < count; i++) {
+		const Common::Point &p = vertices[i]->v;
+		_left = MIN<int>(_left, p.x);
+		_top = MIN<int>(_top, p.y);
+		right = MAX<int>(right, p.x);
+		bottom = MAX<int>(bottom, p.y);
+	}
+
+	_cellWidth = (right - _left) / kCells + 1;
+	_cellHeight = (bottom - _top) / kCells + 1;
+
+	// Every edge is added to all cells its bounding box touches. Count
+	// the edges per cell first, so they can be stored in one array.
+	uint cellEnd[kCells * kCells];
+	memset(cellEnd, 0, sizeof(cellEnd));
+
+	for (int i = 0; i < count; i++) {
+		Vertex *edge = vertices[i];
+		if (!VERTEX_HAS_EDGES(edge))
+			continue;
+
+		const Common::Rect cells = cellRange(edge->v, CLIST_NEXT(edge)->v);
+		for (int y = cells.top; y < cells.bottom; y++)
+			for (int x = cells.left; x < cells.right; x++)
+				cellEnd[y * kCells + x]++;
+	}
+
+	uint total = 0;
+	for (int i = 0; i < kCells * kCells; i++) {
+		_cellStart[i] = total;
+		total += cellEnd[i];
+		cellEnd[i] = _cellStart[i];
+	}
+	_cellStart[kCells * kCells] = total;
+
+	_edges.resize(total);
+
+	for (int i = 0; i < count; i++) {
+		Vertex *edge = vertices[i];
+		if (!VERTEX_HAS_EDGES(edge))
+			continue;
+
+		const Common::Rect cells = cellRange(edge->v, CLIST_NEXT(edge)->v);
+		for (int y = cells.top; y < cells.bottom; y++)
+			for (int x = cells.left; x < cells.right; x++)
+				_edges[cellEnd[y * kCells + x]++] = edge;
+	}
+}
+
+Common::Rect EdgeGrid::cellRange(const Common::Point &p, const Common::Point &q) const {
+	return Common::Rect(CLIP<int>((MIN(p.x, q.x) - _left) / _cellWidth, 0, kCells - 1),
+	                    CLIP<int>((MIN(p.y, q.y) - _top) / _cellHeight, 0, kCells - 1),
+	                    CLIP<int>((MAX(p.x, q.x) - _left) / _cellWidth, 0, kCells - 1) + 1,
+	                    CLIP<int>((MAX(p.y, q.y) - _top) / _cellHeight, 0, kCells - 1) + 1);
+}
+
+bool EdgeGrid::blocks(const Common::Point &p, const Common::Point &q) {
+	const Common::Rect cells = cellRange(p, q);
+
+	// An edge in several cells is only checked once per query
+	_query++;
+
+	for (int y = cells.top; y < cells.bottom; y++) {
+		int left = cells.left, right = cells.right;
+
+		if (p.y != q.y) {
+			// Only visit the cells the segment passes through in this
+			// row, with a pixel of slack for rounding
+			const int y0 = MAX<int>(_top + y * _cellHeight, MIN(p.y, q.y));
+			const int y1 = MIN<int>(_top + (y + 1) * _cellHeight, MAX(p.y, q.y));
+			const int x0 = p.x + (y0 - p.y) * (q.x - p.x) / (q.y - p.y);
+			const int x1 = p.x + (y1 - p.y) * (q.x - p.x) / (q.y - p.y);
+
+			left = MAX<int>(left, (MIN(x0, x1) - 1 - _left) / _cellWidth);
+			right = MIN<int>(right, (MAX(x0, x1) + 1 - _left) / _cellWidth + 1);
+		}
+
+		for (int x = left; x < right; x++) {
+			const int cell = y * kCells + x;
+
+			for (uint i = _cellStart[cell]; i < _cellStart[cell + 1]; i++) {
+				Vertex *edge = _edges[i];
+
+				if (edge->gridQuery == _query)
+					continue;
+				edge->gridQuery = _query;
+
+				if (edge_blocks(p, q, edge))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Determines whether or not two vertices are visible from each other
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (Vertex *) vertex_cur, vertex: The vertices
+ * Returns   : (bool) true if the vertices are visible, false otherwise
+ */
+static bool is_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// For two vertices at the same position, between() accepts every point
+	// on the same line, so these are checked against all edges
+	if (s->_edgeGrid && vertex_cur->v != vertex->v)
+		return !s->_edgeGrid->blocks(vertex_cur->v, vertex->v);
+
+	// Check for intersecting edges
+	for (int j = 0; j < s->vertices; j++) {
+		if (edge_blocks(vertex_cur->v, vertex->v, s->vertex_index[j]))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Returns the row of the visibility graph for a vertex of the obstacles,
+ * computing it first if necessary. Start and end points can only split
+ * edges, or be single-vertex polygons, so they don't change which of
+ * these vertices are visible from each other.
+ * @param s				the pathfinding state
+ * @param vertex_cur	the vertex
+ * @return one byte per vertex of the graph, non-zero if visible
+ */
+static const byte *visibility_row(PathfindingState *s, Vertex *vertex_cur) {
+	VisibilityGraph *graph = s->_graph;
+	const uint n = graph->vertices;
+	const uint cur = vertex_cur->graphIndex;
+	byte *row = &graph->visible[cur * n];
+
+	if (graph->rowKnown[cur]) {
+		s->_cache->getStats().rowsReused++;
+		return row;
+	}
+
+	for (uint i = 0; i < n; i++) {
+		// Visibility is symmetric, so known rows already provide parts of this one
+		if (graph->rowKnown[i])
+			row[i] = graph->visible[i * n + cur];
+		else
+			row[i] = is_visible(s, vertex_cur, s->_graphVertices[i]);
+	}
+
+	graph->rowKnown[cur] = 1;
+	s->_cache->getStats().rowsComputed++;
+	return row;
+}
+
 /**
  * Returns a list of all vertices that are visible from a particular vertex.
  * @param s				the pathfinding state
@@ -667,34 +897,21 @@ static int inside(const Common::Point &p, Vertex *vertex) {
  */
 static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 	VertexList *visVerts = new VertexList();
+	const byte *row = NULL;
+
+	if (s->_graph && vertex_cur->graphIndex >= 0)
+		row = visibility_row(s, vertex_cur);
 
 	for (int i = 0; i < s->vertices; i++) {
 		Vertex *vertex = s->vertex_index[i];
+		bool visible;
 
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
-			continue;
-
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
-
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
-			}
-		}
+		if (row && vertex->graphIndex >= 0)
+			visible = row[vertex->graphIndex] != 0;
+		else
+			visible = is_visible(s, vertex_cur, vertex);
 
-		if (j == s->vertices)
+		if (visible)
 			visVerts->push_front(vertex);
 	}
 
@@ -1186,39 +1403,54 @@ static void change_polygons_opt_0(PathfindingState *s) {
 }
 
 /**
- * Converts the SCI input data for pathfinding
+ * Looks up the visibility graph for the obstacles of a polygon set, and
+ * numbers their vertices accordingly
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ */
+static void attach_visibility_graph(PathfindingState *s) {
+	Common::Array<int16> key;
+	Vertex *vertex;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		const uint sizePos = key.size();
+		key.push_back(0);
+
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			vertex->graphIndex = s->_graphVertices.size();
+			s->_graphVertices.push_back(vertex);
+			key.push_back(vertex->v.x);
+			key.push_back(vertex->v.y);
+		}
+
+		key[sizePos] = (key.size() - sizePos - 1) / 2;
+	}
+
+	s->_graph = s->_cache->getGraph(key, s->_graphVertices.size());
+}
+
+/**
+ * Determines whether or not a merged point has split up an edge of length
+ * zero
+ * Parameters: (Vertex *) vertex: The vertex of the merged point
+ * Returns   : (bool) true if the vertex split up an edge of length zero
+ */
+static bool splits_empty_edge(Vertex *vertex) {
+	return (vertex->graphIndex < 0) && VERTEX_HAS_EDGES(vertex) && (CLIST_PREV(vertex)->v == CLIST_NEXT(vertex)->v);
+}
+
+/**
+ * Prepares converted polygons for pathfinding
  * Parameters: (EngineState *) s: The game state
- *             (reg_t) poly_list: Polygon list
+ *             (PathfindingState *) pf_s: The pathfinding state with the converted polygons
+ *             (int) count: The maximum number of vertices of the polygons
  *             (Common::Point) start: The start point
  *             (Common::Point) end: The end point
  *             (int) opt: Optimization level (0, 1 or 2)
- * Returns   : (PathfindingState *) On success a newly allocated pathfinding state,
- *                            NULL otherwise
+ * Returns   : (PathfindingState *) pf_s on success, NULL otherwise, in which
+ *                            case pf_s has been deleted
  */
-static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Common::Point start, Common::Point end, int width, int height, int opt) {
-	SegManager *segMan = s->_segMan;
+static PathfindingState *prepare_polygon_set(EngineState *s, PathfindingState *pf_s, int count, Common::Point start, Common::Point end, int opt) {
 	Polygon *polygon;
-	int count = 0;
-	PathfindingState *pf_s = new PathfindingState(width, height);
-
-	// Convert all polygons
-	if (poly_list.getSegment()) {
-		List *list = s->_segMan->lookupList(poly_list);
-		Node *node = s->_segMan->lookupNode(list->first);
-
-		while (node) {
-			// The node value might be null, in which case there's no polygon to parse.
-			// Happens in LB2 floppy - refer to bug #3041232
-			polygon = !node->value.isNull() ? convert_polygon(s, node->value) : NULL;
-
-			if (polygon) {
-				pf_s->polygons.push_back(polygon);
-				count += readSelectorValue(segMan, node->value, SELECTOR(size));
-			}
-
-			node = s->_segMan->lookupNode(node->succ);
-		}
-	}
 
 	if (opt == 0)
 		change_polygons_opt_0(pf_s);
@@ -1276,10 +1508,19 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		}
 	}
 
+	// Visibility between the obstacles doesn't depend on start and end points
+	if (pf_s->_cache)
+		attach_visibility_graph(pf_s);
+
 	// Merge start and end points into polygon set
 	pf_s->vertex_start = merge_point(pf_s, *new_start);
 	pf_s->vertex_end = merge_point(pf_s, *new_end);
 
+	// between() accepts any point on the same line as an edge of length
+	// zero, so merging a point into such an edge changes the obstacles
+	if (pf_s->_graph && (splits_empty_edge(pf_s->vertex_start) || splits_empty_edge(pf_s->vertex_end)))
+		pf_s->_graph = NULL;
+
 	delete new_start;
 	delete new_end;
 
@@ -1299,9 +1540,71 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 
 	pf_s->vertices = count;
 
+	if (pf_s->_cache && count >= EdgeGrid::kMinVertices)
+		pf_s->_edgeGrid = new EdgeGrid(pf_s->vertex_index, count);
+
 	return pf_s;
 }
 
+/**
+ * Converts the SCI input data for pathfinding
+ * Parameters: (EngineState *) s: The game state
+ *             (reg_t) poly_list: Polygon list
+ *             (Common::Point) start: The start point
+ *             (Common::Point) end: The end point
+ *             (int) opt: Optimization level (0, 1 or 2)
+ * Returns   : (PathfindingState *) On success a newly allocated pathfinding state,
+ *                            NULL otherwise
+ */
+static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Common::Point start, Common::Point end, int width, int height, int opt) {
+	SegManager *segMan = s->_segMan;
+	AvoidPathCache *cache = s->_avoidPathCache;
+	Polygon *polygon;
+	int count = 0;
+	PathfindingState *pf_s = new PathfindingState(width, height, cache);
+	AvoidPathInput input;
+
+	// Convert all polygons
+	if (poly_list.getSegment()) {
+		List *list = s->_segMan->lookupList(poly_list);
+		Node *node = s->_segMan->lookupNode(list->first);
+
+		while (node) {
+			// The node value might be null, in which case there's no polygon to parse.
+			// Happens in LB2 floppy - refer to bug #3041232
+			polygon = !node->value.isNull() ? convert_polygon(s, node->value) : NULL;
+
+			if (polygon) {
+				pf_s->polygons.push_back(polygon);
+				count += readSelectorValue(segMan, node->value, SELECTOR(size));
+
+				if (cache->isRecording()) {
+					input.polygons.push_back(AvoidPathPolygon());
+					input.polygons.back().type = polygon->type;
+
+					Vertex *vertex;
+					CLIST_FOREACH(vertex, &polygon->vertices) {
+						input.polygons.back().points.push_back(vertex->v);
+					}
+				}
+			}
+
+			node = s->_segMan->lookupNode(node->succ);
+		}
+	}
+
+	if (cache->isRecording()) {
+		input.start = start;
+		input.end = end;
+		input.width = width;
+		input.height = height;
+		input.opt = opt;
+		cache->record(input);
+	}
+
+	return prepare_polygon_set(s, pf_s, count, start, end, opt);
+}
+
 /**
  * Computes a shortest path from vertex_start to vertex_end. The caller can
  * construct the resulting path by following the path_prev links from
@@ -1579,6 +1882,119 @@ reg_t kAvoidPath(EngineState *s, int argc, reg_t *argv) {
 	}
 }
 
+AvoidPathCache::AvoidPathCache() : _useCounter(0), _enabled(true), _recording(false) {
+	for (int i = 0; i < kMaxGraphs; i++)
+		_graphs[i] = NULL;
+
+	resetStats();
+}
+
+AvoidPathCache::~AvoidPathCache() {
+	clear();
+}
+
+VisibilityGraph *AvoidPathCache::getGraph(const Common::Array<int16> &key, uint vertices) {
+	if (vertices > kMaxVertices)
+		return NULL;
+
+	_useCounter++;
+
+	int oldest = 0;
+	for (int i = 0; i < kMaxGraphs; i++) {
+		VisibilityGraph *graph = _graphs[i];
+
+		if (!graph) {
+			oldest = i;
+			break;
+		}
+
+		if (graph->key == key) {
+			graph->lastUsed = _useCounter;
+			_stats.hits++;
+			return graph;
+		}
+
+		if (graph->lastUsed < _graphs[oldest]->lastUsed)
+			oldest = i;
+	}
+
+	VisibilityGraph *graph = _graphs[oldest];
+	if (!graph)
+		graph = _graphs[oldest] = new VisibilityGraph();
+
+	graph->key = key;
+	graph->vertices = vertices;
+	graph->rowKnown.resize(vertices);
+	if (vertices)
+		memset(&graph->rowKnown[0], 0, vertices);
+	graph->visible.resize(vertices * vertices);
+	graph->lastUsed = _useCounter;
+
+	_stats.misses++;
+	return graph;
+}
+
+void AvoidPathCache::clear() {
+	for (int i = 0; i < kMaxGraphs; i++) {
+		delete _graphs[i];
+		_graphs[i] = NULL;
+	}
+}
+
+void AvoidPathCache::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+void AvoidPathCache::record(const AvoidPathInput &input) {
+	if (_recorded.size() < kMaxRecorded)
+		_recorded.push_back(input);
+}
+
+bool replayAvoidPath(EngineState *s, const AvoidPathInput &input, Common::Array<Common::Point> &path) {
+	PathfindingState *p = new PathfindingState(input.width, input.height, s->_avoidPathCache);
+	int count = 0;
+
+	path.clear();
+
+	for (uint i = 0; i < input.polygons.size(); i++) {
+		const AvoidPathPolygon &recorded = input.polygons[i];
+		Polygon *polygon = new Polygon(recorded.type);
+
+		// The vertices were recorded in their final order
+		for (uint j = 0; j < recorded.points.size(); j++)
+			polygon->vertices.insertAtEnd(new Vertex(recorded.points[j]));
+
+		p->polygons.push_back(polygon);
+		count += recorded.points.size();
+	}
+
+	p = prepare_polygon_set(s, p, count, input.start, input.end, input.opt);
+	if (!p)
+		return false;
+
+	AStar(p);
+
+	// The same points as output_path() stores
+	Vertex *vertex = p->vertex_end;
+	if (!vertex->path_prev) {
+		path.push_back(p->_prependPoint ? *p->_prependPoint : p->vertex_start->v);
+		path.push_back(p->vertex_start->v);
+	} else {
+		if (p->_prependPoint)
+			path.push_back(*p->_prependPoint);
+
+		const uint first = path.size();
+		for (; vertex; vertex = vertex->path_prev)
+			path.insert_at(first, vertex->v);
+
+		if (p->_appendPoint)
+			path.push_back(*p->_appendPoint);
+	}
+
+	delete p;
+	return true;
+}
+
 static bool PointInRect(const Common::Point &point, int16 rectX1, int16 rectY1, int16 rectX2, int16 rectY2) {
 	int16 top = MIN<int16>(rectY1, rectY2);
 	int16 left = MIN<int16>(rectX1, rectX2);
@@ -0,0 +1,135 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SCI_ENGINE_KPATHING_H
+#define SCI_ENGINE_KPATHING_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Sci {
+
+struct EngineState;
+
+/** A polygon of the input of kAvoidPath, with its vertices in the order used for pathfinding */
+struct AvoidPathPolygon {
+	int type;
+	Common::Array<Common::Point> points;
+};
+
+/** The input of a kAvoidPath call, recorded to replay it later */
+struct AvoidPathInput {
+	Common::Array<AvoidPathPolygon> polygons;
+	Common::Point start, end;
+	int width, height;
+	int opt;
+};
+
+/**
+ * Which pairs of obstacle vertices of a polygon set can see each other.
+ * Rows are filled in when pathfinding first needs them.
+ */
+struct VisibilityGraph {
+	/** number of points of each polygon, followed by its points */
+	Common::Array<int16> key;
+	uint vertices;
+	/** one byte per vertex, non-zero if its row has been computed */
+	Common::Array<byte> rowKnown;
+	/** vertices * vertices bytes, non-zero if the vertices see each other */
+	Common::Array<byte> visible;
+	uint32 lastUsed;
+};
+
+struct AvoidPathStats {
+	uint32 hits;		///< polygon sets found in the cache
+	uint32 misses;		///< polygon sets added to the cache
+	uint32 rowsComputed;	///< visibility rows computed
+	uint32 rowsReused;	///< visibility rows taken from the cache
+};
+
+/**
+ * Keeps the visibility graphs of recently used polygon sets, as games
+ * usually ask for many paths around the same obstacles. Graphs are looked
+ * up by the contents of the polygons, so changed polygons simply result in
+ * a new graph.
+ *
+ * The calls to kAvoidPath can also be recorded here, for measuring how
+ * long pathfinding takes.
+ */
+class AvoidPathCache {
+public:
+	AvoidPathCache();
+	~AvoidPathCache();
+
+	/**
+	 * Finds the visibility graph of a polygon set, or replaces the least
+	 * recently used graph by an empty one for it.
+	 * @return the graph, or NULL if the polygon set has too many vertices
+	 */
+	VisibilityGraph *getGraph(const Common::Array<int16> &key, uint vertices);
+
+	/** Removes all graphs. */
+	void clear();
+
+	/** If disabled, pathfinding neither caches graphs nor sorts edges spatially. */
+	bool isEnabled() const { return _enabled; }
+	void setEnabled(bool enabled) { _enabled = enabled; }
+
+	AvoidPathStats &getStats() { return _stats; }
+	void resetStats();
+
+	bool isRecording() const { return _recording; }
+	void setRecording(bool recording) { _recording = recording; }
+	/** Stores a call, unless the maximum number of calls has been recorded. */
+	void record(const AvoidPathInput &input);
+	const Common::Array<AvoidPathInput> &getRecorded() const { return _recorded; }
+	void clearRecorded() { _recorded.clear(); }
+
+private:
+	enum {
+		kMaxGraphs = 4,
+		kMaxVertices = 512,
+		kMaxRecorded = 256
+	};
+
+	VisibilityGraph *_graphs[kMaxGraphs];
+	uint32 _useCounter;
+	bool _enabled;
+	AvoidPathStats _stats;
+
+	bool _recording;
+	Common::Array<AvoidPathInput> _recorded;
+};
+
+/**
+ * Finds a path for a recorded kAvoidPath call, like kAvoidPath itself
+ * does, but without creating the path in script memory.
+ * @param s		the engine state, for game specific workarounds
+ * @param input	the recorded call
+ * @param path	the points of the path
+ * @return false if the input couldn't be converted
+ */
+bool replayAvoidPath(EngineState *s, const AvoidPathInput &input, Common::Array<Common::Point> &path);
+
+} // End of namespace Sci
+
+#endif // SCI_ENGINE_KPATHING_H
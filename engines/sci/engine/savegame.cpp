@@ -241,6 +241,9 @@ void SegManager::saveLoadWithSerializer(Common::Serializer &s) {
 				}
 			}
 		}
+
+		if (s.isLoading())
+			scr->decodeInstructions();
 	}
 }
 
@@ -63,6 +63,9 @@ void Script::freeScript() {
 	_lockers = 1;
 	_markedAsDeleted = false;
 	_objects.clear();
+
+	_decodedInstructions.clear();
+	_decodedIndex.clear();
 }
 
 void Script::load(int script_nr, ResourceManager *resMan) {
@@ -770,4 +773,94 @@ bool Script::offsetIsObject(uint16 offset) const {
 	return (READ_SCI11ENDIAN_UINT16((const byte *)_buf + offset + SCRIPT_OBJECT_MAGIC_OFFSET) == SCRIPT_OBJECT_MAGIC_NUMBER);
 }
 
+void Script::decodeInstructions() {
+	_decodedInstructions.clear();
+	_decodedIndex.clear();
+
+	// Script 0 is loaded before the opcode formats are known, so its code
+	// is only decoded once it is executed
+	if (!g_sci->_opcode_formats)
+		return;
+
+	for (ObjMap::const_iterator it = _objects.begin(); it != _objects.end(); ++it) {
+		const Object &obj = it->_value;
+
+		for (uint16 i = 0; i < obj.getMethodCount(); i++) {
+			const uint32 offset = obj.getFunction(i).getOffset();
+			if (offset < _bufSize && !_decodedIndex.contains(offset))
+				decodeFrom(offset);
+		}
+	}
+}
+
+uint32 Script::findDecodedInstruction(uint32 offset) {
+	assert(offset < _bufSize);
+
+	if (!_decodedIndex.contains(offset))
+		decodeFrom(offset);
+
+	return _decodedIndex.getVal(offset);
+}
+
+void Script::decodeFrom(uint32 offset) {
+	enum {
+		kMaxInstructionSize = 8	///< Longer than any instruction but op_file
+	};
+
+	const uint32 firstNew = _decodedInstructions.size();
+	Common::Array<uint32> entries;
+	entries.push_back(offset);
+
+	while (!entries.empty()) {
+		uint32 pos = entries.back();
+		entries.pop_back();
+
+		// Decode until the code ends or reaches instructions decoded before
+		while (pos < _bufSize && !_decodedIndex.contains(pos)) {
+			DecodedInstruction instruction;
+			instruction.offset = pos;
+			instruction.next = instruction.target = -1;
+
+			// Don't read past the end of the buffer
+			if (_bufSize - pos < kMaxInstructionSize) {
+				byte end[kMaxInstructionSize];
+				memset(end, 0, sizeof(end));
+				memcpy(end, _buf + pos, _bufSize - pos);
+				instruction.size = readPMachineInstruction(end, instruction.extOpcode, instruction.opparams);
+			} else {
+				instruction.size = readPMachineInstruction(_buf + pos, instruction.extOpcode, instruction.opparams);
+			}
+
+			_decodedIndex[pos] = _decodedInstructions.size();
+			_decodedInstructions.push_back(instruction);
+
+			const byte opcode = instruction.extOpcode >> 1;
+			pos += instruction.size;
+
+			// Jumps and calls are relative to the end of the instruction
+			if (opcode == op_bt || opcode == op_bnt || opcode == op_jmp || opcode == op_call)
+				entries.push_back(pos + instruction.opparams[0]);
+
+			if (opcode == op_ret || opcode == op_jmp)
+				break;
+		}
+	}
+
+	// All code executed after the new instructions is decoded now
+	for (uint32 i = firstNew; i < _decodedInstructions.size(); i++) {
+		DecodedInstruction &instruction = _decodedInstructions[i];
+		const byte opcode = instruction.extOpcode >> 1;
+		const uint32 nextOffset = instruction.offset + instruction.size;
+
+		if (opcode != op_ret && opcode != op_jmp && _decodedIndex.contains(nextOffset))
+			instruction.next = _decodedIndex.getVal(nextOffset);
+
+		if (opcode == op_bt || opcode == op_bnt || opcode == op_jmp) {
+			const uint32 targetOffset = nextOffset + instruction.opparams[0];
+			if (_decodedIndex.contains(targetOffset))
+				instruction.target = _decodedIndex.getVal(targetOffset);
+		}
+	}
+}
+
 } // End of namespace Sci
@@ -74,6 +74,21 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	/**
+	 * The decoded instructions of the script. Jumps can lead into the middle
+	 * of what a linear scan would see as an instruction, so the code is
+	 * decoded by following the control flow, starting from the methods of
+	 * the objects. Code which can only be reached otherwise, like exported
+	 * procedures, is decoded when it is first executed.
+	 */
+	Common::Array<DecodedInstruction> _decodedInstructions;
+	/** The index into _decodedInstructions for the offset of each decoded instruction */
+	Common::HashMap<uint32, uint32> _decodedIndex;
+
+	/** Decodes the instructions which can be executed after the one at the given offset. */
+	void decodeFrom(uint32 offset);
+	uint32 findDecodedInstruction(uint32 offset);
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -91,6 +106,28 @@ public:
 	const ObjMap &getObjectMap() const { return _objects; }
 	bool offsetIsObject(uint16 offset) const;
 
+	/**
+	 * Decodes the instructions of the methods of the objects in the script.
+	 * This is done when the script is loaded, once the objects are set up.
+	 */
+	void decodeInstructions();
+
+	/**
+	 * Return the index of the decoded instruction at the given offset. The
+	 * given indices of the instructions which follow the one executed last
+	 * are checked first, so that stepping through the code needs no lookup.
+	 */
+	uint32 getDecodedInstructionIndex(uint32 offset, int32 next = -1, int32 target = -1) {
+		if (next >= 0 && (uint32)next < _decodedInstructions.size() && _decodedInstructions[next].offset == offset)
+			return next;
+		if (target >= 0 && (uint32)target < _decodedInstructions.size() && _decodedInstructions[target].offset == offset)
+			return target;
+		return findDecodedInstruction(offset);
+	}
+
+	const DecodedInstruction &getDecodedInstruction(uint32 index) const { return _decodedInstructions[index]; }
+	uint32 getDecodedInstructionCount() const { return _decodedInstructions.size(); }
+
 public:
 	Script();
 	~Script();
@@ -46,6 +46,12 @@ SegManager::SegManager(ResourceManager *resMan) {
 
 	_resMan = resMan;
 
+	flushSelectorLookups();
+	resetSelectorLookupStats();
+
+	_writeBarrierActive = false;
+	_writeBarrierSegmentFreed = false;
+
 	createClassTable();
 }
 
@@ -153,6 +159,12 @@ void SegManager::deallocate(SegmentId seg) {
 	if (!mobj)
 		error("Attempt to deallocate an already freed segment");
 
+	// The segment ID may be reused for other objects
+	if (mobj->getType() == SEG_TYPE_SCRIPT || mobj->getType() == SEG_TYPE_CLONES) {
+		flushSelectorLookups();
+		_writeBarrierSegmentFreed = _writeBarrierActive;
+	}
+
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
 		_scriptSegMap.erase(scr->getScriptNumber());
@@ -419,6 +431,7 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_clonesSegId, offset);
+	recordWrite(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -433,6 +446,7 @@ List *SegManager::allocateList(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_listsSegId, offset);
+	recordWrite(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -447,6 +461,7 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_nodesSegId, offset);
+	recordWrite(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -510,6 +525,7 @@ SegmentRef SegManager::dereference(reg_t pointer) {
 	}
 
 	SegmentObj *mobj = _heap[pointer.getSegment()];
+
 	return mobj->dereference(pointer);
 }
 
@@ -850,6 +866,7 @@ SciArray<reg_t> *SegManager::allocateArray(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_arraysSegId, offset);
+	recordWrite(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -977,10 +994,15 @@ int SegManager::instantiateScript(int scriptNum) {
 		scr = allocateScript(scriptNum, &segmentId);
 	}
 
+	// A script which was marked as deleted is reloaded in place, and objects
+	// of the new script can take the addresses of other ones
+	flushSelectorLookups();
+
 	scr->load(scriptNum, _resMan);
 	scr->initializeLocals(this);
 	scr->initializeClasses(this);
 	scr->initializeObjects(this, segmentId);
+	scr->decodeInstructions();
 
 	return segmentId;
 }
@@ -1059,4 +1081,38 @@ void SegManager::uninstantiateScriptSci0(int script_nr) {
 	} while (objType != 0);
 }
 
+void SegManager::flushSelectorLookups() {
+	for (uint i = 0; i < kSelectorLookupCacheSize; i++)
+		_selectorLookups[i].obj = NULL_REG;
+	_selectorLookupStats.flushes++;
+}
+
+void SegManager::flushSelectorLookups(reg_t obj) {
+	for (uint i = 0; i < kSelectorLookupCacheSize; i++) {
+		if (_selectorLookups[i].obj == obj)
+			_selectorLookups[i].obj = NULL_REG;
+	}
+}
+
+void SegManager::startWriteBarrier() {
+	_writeBarrierActive = true;
+	_writeBarrierSegmentFreed = false;
+	_writeBarrierAddresses.clear();
+}
+
+void SegManager::stopWriteBarrier(Common::Array<reg_t> &addresses) {
+	_writeBarrierActive = false;
+	addresses.clear();
+	addresses.reserve(_writeBarrierAddresses.size());
+	for (Common::HashMap<reg_t, bool, reg_t_Hash>::const_iterator i = _writeBarrierAddresses.begin(); i != _writeBarrierAddresses.end(); ++i)
+		addresses.push_back(i->_key);
+	_writeBarrierAddresses.clear();
+}
+
+void SegManager::resetSelectorLookupStats() {
+	_selectorLookupStats.hits = 0;
+	_selectorLookupStats.misses = 0;
+	_selectorLookupStats.flushes = 0;
+}
+
 } // End of namespace Sci
@@ -441,7 +441,98 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	// 10. Selector lookup cache
+
+	/** Statistics of the selector lookup cache */
+	struct SelectorLookupStats {
+		uint32 hits;
+		uint32 misses;
+		uint32 flushes;
+	};
+
+	/**
+	 * Look up the result of an earlier selector lookup.
+	 * @param obj		the object the selector was looked up in
+	 * @param selector	the selector
+	 * @return the cached result, or NULL if there is none
+	 */
+	const SelectorLookup *findSelectorLookup(reg_t obj, Selector selector) {
+		const SelectorLookup &entry = _selectorLookups[hashSelectorLookup(obj, selector)];
+		if (entry.obj == obj && entry.selector == selector && !entry.obj.isNull()) {
+			_selectorLookupStats.hits++;
+			return &entry;
+		}
+		_selectorLookupStats.misses++;
+		return NULL;
+	}
+
+	/** Remember the result of a selector lookup, replacing any older one in its slot. */
+	void addSelectorLookup(const SelectorLookup &lookup) {
+		_selectorLookups[hashSelectorLookup(lookup.obj, lookup.selector)] = lookup;
+	}
+
+	/**
+	 * Forget all cached selector lookups. This has to happen whenever
+	 * objects go away or an address can refer to a different object.
+	 */
+	void flushSelectorLookups();
+
+	/** Forget the cached selector lookups of a single object. */
+	void flushSelectorLookups(reg_t obj);
+
+	const SelectorLookupStats &getSelectorLookupStats() const { return _selectorLookupStats; }
+	void resetSelectorLookupStats();
+
+	// 11. Write barrier
+
+	/**
+	 * Start recording the addresses of all objects, lists, nodes and arrays
+	 * which are allocated or changed. This is used by the incremental
+	 * garbage collector, which has to scan these again before it can free
+	 * anything.
+	 */
+	void startWriteBarrier();
+
+	/**
+	 * Stop recording changes.
+	 * @param[out] addresses	the addresses recorded since startWriteBarrier(), each once
+	 */
+	void stopWriteBarrier(Common::Array<reg_t> &addresses);
+
+	/**
+	 * Record a change of an object, list, node or array while the write
+	 * barrier is active. Only changes which can store a reference in it
+	 * have to be recorded.
+	 */
+	void recordWrite(reg_t addr) {
+		if (_writeBarrierActive)
+			_writeBarrierAddresses.setVal(addr, true);
+	}
+
+	/**
+	 * Check whether a script or clone segment was freed since
+	 * startWriteBarrier(). Its segment ID can then refer to something else.
+	 */
+	bool segmentFreedDuringWriteBarrier() const { return _writeBarrierSegmentFreed; }
+
+private:
+	bool _writeBarrierActive;
+	bool _writeBarrierSegmentFreed;
+	Common::HashMap<reg_t, bool, reg_t_Hash> _writeBarrierAddresses;	///< Used as a set, so each address is scanned once
+
 private:
+	enum {
+		kSelectorLookupCacheSize = 1024	///< Number of cached lookups, must be a power of two
+	};
+
+	static uint hashSelectorLookup(reg_t obj, Selector selector) {
+		return (obj.getSegment() * 61 + obj.getOffset() * 7 + selector) & (kSelectorLookupCacheSize - 1);
+	}
+
+	/** Direct mapped cache of lookupSelector() results, indexed by hashSelectorLookup() */
+	SelectorLookup _selectorLookups[kSelectorLookupCacheSize];
+	SelectorLookupStats _selectorLookupStats;
+
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
 	/** Map script ids to segment ids. */
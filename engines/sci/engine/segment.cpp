@@ -124,6 +124,8 @@ void CloneTable::freeAtAddress(SegManager *segMan, reg_t addr) {
 #endif
 #endif
 
+	// The address is reused by the next clone
+	segMan->flushSelectorLookups(addr);
 	freeEntry(addr.getOffset());
 }
 
@@ -211,8 +211,10 @@ void writeSelector(SegManager *segMan, reg_t object, Selector selectorId, reg_t
 	if (lookupSelector(segMan, object, selectorId, &address, NULL) != kSelectorVariable)
 		error("Selector '%s' of object at %04x:%04x could not be"
 		         " written to", g_sci->getKernel()->getSelectorName(selectorId).c_str(), PRINT_REG(object));
-	else
+	else {
 		*address.getPointer(segMan) = value;
+		segMan->recordWrite(address.obj);
+	}
 }
 
 void invokeSelector(EngineState *s, reg_t object, int selectorId,
@@ -250,9 +252,16 @@ void invokeSelector(EngineState *s, reg_t object, int selectorId,
 	run_vm(s); // Start a new vm
 }
 
+static void fillSelectorLookup(const SelectorLookup &lookup, ObjVarRef *varp, reg_t *fptr) {
+	if (lookup.type == kSelectorVariable && varp) {
+		varp->obj = lookup.obj;
+		varp->varindex = lookup.varIndex;
+	} else if (lookup.type == kSelectorMethod && fptr) {
+		*fptr = lookup.func;
+	}
+}
+
 SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr) {
-	const Object *obj = segMan->getObject(obj_location);
-	int index;
 	bool oldScriptHeader = (getSciVersion() == SCI_VERSION_0_EARLY);
 
 	// Early SCI versions used the LSB in the selector ID as a read/write
@@ -260,39 +269,52 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 	if (oldScriptHeader)
 		selectorId &= ~1;
 
+	// Objects are sent the same few selectors over and over again, so the
+	// results are cached instead of searching the superclass chain each time
+	const SelectorLookup *cached = segMan->findSelectorLookup(obj_location, selectorId);
+	if (cached) {
+		fillSelectorLookup(*cached, varp, fptr);
+		return cached->type;
+	}
+
+	const Object *obj = segMan->getObject(obj_location);
+	int index;
+
 	if (!obj) {
 		error("lookupSelector(): Attempt to send to non-object or invalid script. Address was %04x:%04x",
 				PRINT_REG(obj_location));
 	}
 
+	SelectorLookup lookup;
+	lookup.obj = obj_location;
+	lookup.selector = selectorId;
+	lookup.type = kSelectorNone;
+	lookup.varIndex = -1;
+	lookup.func = NULL_REG;
+
 	index = obj->locateVarSelector(segMan, selectorId);
 
 	if (index >= 0) {
 		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
-		}
-		return kSelectorVariable;
+		lookup.type = kSelectorVariable;
+		lookup.varIndex = index;
 	} else {
 		// Check if it's a method, with recursive lookup in superclasses
 		while (obj) {
 			index = obj->funcSelectorPosition(selectorId);
 			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
-
-				return kSelectorMethod;
+				lookup.type = kSelectorMethod;
+				lookup.func = obj->getFunction(index);
+				break;
 			} else {
 				obj = segMan->getObject(obj->getSuperClassSelector());
 			}
 		}
-
-		return kSelectorNone;
 	}
 
-
-//	return _lookupSelector_function(segMan, obj, selectorId, fptr);
+	segMan->addSelectorLookup(lookup);
+	fillSelectorLookup(lookup, varp, fptr);
+	return lookup.type;
 }
 
 } // End of namespace Sci
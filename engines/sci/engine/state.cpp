@@ -27,7 +27,9 @@
 #include "sci/event.h"
 
 #include "sci/engine/file.h"
+#include "sci/engine/gc.h"
 #include "sci/engine/kernel.h"
+#include "sci/engine/kpathing.h"
 #include "sci/engine/state.h"
 #include "sci/engine/selector.h"
 #include "sci/engine/vm.h"
@@ -73,13 +75,15 @@ EngineState::EngineState(SegManager *segMan)
 #ifdef ENABLE_SCI32
 	_virtualIndexFile(0),
 #endif
-	_dirseeker() {
+	_dirseeker(), _gc(new GarbageCollector()), _avoidPathCache(new AvoidPathCache()) {
 
 	reset(false);
 }
 
 EngineState::~EngineState() {
 	delete _msgState;
+	delete _gc;
+	delete _avoidPathCache;
 #ifdef ENABLE_SCI32
 	delete _virtualIndexFile;
 #endif
@@ -90,6 +94,8 @@ void EngineState::reset(bool isRestoring) {
 		_memorySegmentSize = 0;
 		_fileHandles.resize(5);
 		abortScriptProcessing = kAbortNone;
+		_predecodeScripts = true;
+		scriptGCIncremental = false;
 	}
 
 	executionStackBase = 0;
@@ -104,6 +110,7 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	_gc->cancel(this);
 
 	_throttleCounter = 0;
 	_throttleLastTime = 0;
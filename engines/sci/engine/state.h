@@ -46,6 +46,8 @@ namespace Sci {
 class FileHandle;
 class DirSeeker;
 class EventManager;
+class AvoidPathCache;
+class GarbageCollector;
 class MessageState;
 class SoundCommandParser;
 class VirtualIndexFile;
@@ -147,6 +149,7 @@ public:
 	 */
 	int executionStackBase;
 	bool _executionStackPosChanged;   /**< Set to true if the execution stack position should be re-evaluated by the vm */
+	bool _predecodeScripts; /**< Set to true if the vm should execute instructions decoded in advance, instead of parsing them each time */
 
 	// Registers
 	reg_t r_acc; /**< Accumulator */
@@ -168,6 +171,7 @@ public:
 
 	int scriptStepCounter; // Counts the number of steps executed
 	int scriptGCInterval; // Number of steps in between gcs
+	bool scriptGCIncremental; // Spread the marking of gcs over many kernel calls
 
 	uint16 currentRoomNumber() const;
 	void setRoomNumber(uint16 roomNumber);
@@ -184,6 +188,9 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	GarbageCollector *_gc;
+
+	AvoidPathCache *_avoidPathCache; /**< Visibility graphs and recorded calls of kAvoidPath */
 
 	MessageState *_msgState;
 
@@ -187,6 +187,7 @@ static void write_var(EngineState *s, int type, int index, reg_t value) {
 				if (lookupSelector(s->_segMan, stopGroopPos, SELECTOR(client), &varp, NULL) == kSelectorVariable) {
 					reg_t *clientVar = varp.getPointer(s->_segMan);
 					*clientVar = value;
+					s->_segMan->recordWrite(stopGroopPos);
 				}
 			}
 		}
@@ -250,6 +251,7 @@ static void _exec_varselectors(EngineState *s) {
 			// varselector access?
 			if (xs.argc) { // write?
 				*var = xs.variables_argp[1];
+				s->_segMan->recordWrite(xs.addr.varp.obj);
 
 			} else // No, read
 				s->r_acc = *var;
@@ -556,6 +558,11 @@ void run_vm(EngineState *s) {
 
 	s->_executionStackPosChanged = true; // Force initialization
 
+	// The decoded instructions which may be executed next, so that these
+	// don't have to be looked up
+	int32 decodedNext = -1;
+	int32 decodedTarget = -1;
+
 #ifdef ABORT_ON_INFINITE_LOOP
 	byte prevOpcode = 0xFF;
 #endif
@@ -576,6 +583,7 @@ void run_vm(EngineState *s) {
 				error("No script in segment %d",  s->xs->addr.pc.getSegment());
 			s->xs = &(s->_executionStack.back());
 			s->_executionStackPosChanged = false;
+			decodedNext = decodedTarget = -1;
 
 			obj = s->_segMan->getObject(s->xs->objp);
 			local_script = s->_segMan->getScriptIfLoaded(s->xs->local_segment);
@@ -604,6 +612,10 @@ void run_vm(EngineState *s) {
 		Console *con = g_sci->getSciDebugger();
 		con->onFrame();
 
+		// The console may have restored the game, which replaces the scripts
+		if (s->abortScriptProcessing != kAbortNone)
+			return;
+
 		if (s->xs->sp < s->xs->fp)
 			error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
 			PRINT_REG(*s->xs->sp), PRINT_REG(*s->xs->fp));
@@ -616,7 +628,17 @@ void run_vm(EngineState *s) {
 
 		// Get opcode
 		byte extOpcode;
-		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		if (s->_predecodeScripts) {
+			const uint32 index = scr->getDecodedInstructionIndex(s->xs->addr.pc.getOffset(), decodedNext, decodedTarget);
+			const DecodedInstruction &instruction = scr->getDecodedInstruction(index);
+			extOpcode = instruction.extOpcode;
+			memcpy(opparams, instruction.opparams, sizeof(opparams));
+			s->xs->addr.pc.incOffset(instruction.size);
+			decodedNext = instruction.next;
+			decodedTarget = instruction.target;
+		} else {
+			s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		}
 		const byte opcode = extOpcode >> 1;
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
@@ -839,9 +861,14 @@ void run_vm(EngineState *s) {
 
 		case op_callk: { // 0x21 (33)
 			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
+			if (s->_gc->isMarking()) {
+				s->_gc->step(s);
+			} else if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				if (s->scriptGCIncremental)
+					s->_gc->start(s);
+				else
+					run_gc(s);
 			}
 
 			// Call kernel function
@@ -921,9 +948,10 @@ void run_vm(EngineState *s) {
 				if (old_xs->type == EXEC_STACK_TYPE_VARSELECTOR) {
 					// varselector access?
 					reg_t *var = old_xs->getVarPointer(s->_segMan);
-					if (old_xs->argc) // write?
+					if (old_xs->argc) { // write?
 						*var = old_xs->variables_argp[1];
-					else // No, read
+						s->_segMan->recordWrite(old_xs->addr.varp.obj);
+					} else // No, read
 						s->r_acc = *var;
 				}
 
@@ -1079,6 +1107,7 @@ void run_vm(EngineState *s) {
 		case op_aTop: // 0x32 (50)
 			// Accumulator To Property
 			validate_property(s, obj, opparams[0]) = s->r_acc;
+			s->_segMan->recordWrite(s->xs->objp);
 			break;
 
 		case op_pTos: // 0x33 (51)
@@ -1089,6 +1118,7 @@ void run_vm(EngineState *s) {
 		case op_sTop: // 0x34 (52)
 			// Stack To Property
 			validate_property(s, obj, opparams[0]) = POP32();
+			s->_segMan->recordWrite(s->xs->objp);
 			break;
 
 		case op_ipToa: // 0x35 (53)
@@ -1103,6 +1133,7 @@ void run_vm(EngineState *s) {
 				opProperty += 1;
 			else
 				opProperty -= 1;
+			s->_segMan->recordWrite(s->xs->objp);
 
 			if (opcode == op_ipToa || opcode == op_dpToa)
 				s->r_acc = opProperty;
@@ -70,6 +70,15 @@ struct ObjVarRef {
 	reg_t* getPointer(SegManager *segMan) const;
 };
 
+/** The result of looking up a selector in an object, as cached by the SegManager */
+struct SelectorLookup {
+	reg_t obj;			///< the object the selector was looked up in, NULL_REG for unused entries
+	Selector selector;
+	SelectorType type;
+	int varIndex;		///< index of the variable, for kSelectorVariable
+	reg_t func;			///< address of the method, for kSelectorMethod
+};
+
 enum ExecStackType {
 	EXEC_STACK_TYPE_CALL = 0,
 	EXEC_STACK_TYPE_KERNEL = 1,
@@ -366,6 +375,21 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj, Selector selectorid,
  */
 int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4]);
 
+/**
+ * A PMachine instruction as parsed by readPMachineInstruction(), so that
+ * it does not need to be parsed again each time it is executed. The
+ * instructions executed after it are looked up as well, so the VM can
+ * step from one decoded instruction to the next.
+ */
+struct DecodedInstruction {
+	uint32 offset;		///< offset of the instruction in the script buffer
+	uint16 size;		///< length of the instruction in bytes
+	byte extOpcode;		///< "extended" opcode of the instruction
+	int16 opparams[4];	///< parameters of the instruction
+	int32 next;			///< index of the instruction following this one, or -1
+	int32 target;		///< index of the instruction bt, bnt and jmp jump to, or -1
+};
+
 } // End of namespace Sci
 
 #endif // SCI_ENGINE_VM_H
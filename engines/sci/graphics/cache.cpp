@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/config-manager.h"
 #include "common/util.h"
 #include "common/stack.h"
 #include "graphics/primitives.h"
@@ -35,7 +36,11 @@
 namespace Sci {
 
 GfxCache::GfxCache(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette)
-	: _resMan(resMan), _screen(screen), _palette(palette) {
+	: _resMan(resMan), _screen(screen), _palette(palette), _useCounter(0), _memoryUsage(0) {
+	_maxMemory = getSciVersion() >= SCI_VERSION_2 ? MAX_MEMORY_SCI32 : MAX_MEMORY;
+	if (ConfMan.hasKey("gfx_cache") && ConfMan.getInt("gfx_cache") > 0)
+		_maxMemory = ConfMan.getInt("gfx_cache") * 1024;
+	resetStats();
 }
 
 GfxCache::~GfxCache() {
@@ -45,8 +50,8 @@ GfxCache::~GfxCache() {
 
 void GfxCache::purgeFontCache() {
 	for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.font;
+		iter->_value.font = 0;
 	}
 
 	_cachedFonts.clear();
@@ -54,36 +59,136 @@ void GfxCache::purgeFontCache() {
 
 void GfxCache::purgeViewCache() {
 	for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
-		delete iter->_value;
-		iter->_value = 0;
+		delete iter->_value.view;
+		iter->_value.view = 0;
 	}
 
 	_cachedViews.clear();
 }
 
+void GfxCache::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+void GfxCache::countMemoryUsage(FontCacheEntry &entry) {
+	const uint32 memory = entry.font->getMemoryUsage();
+	_memoryUsage += memory - entry.memoryUsage;
+	entry.memoryUsage = memory;
+}
+
+void GfxCache::countMemoryUsage(ViewCacheEntry &entry) {
+	// Views grow as their cels are unpacked and scaled
+	const uint32 memory = entry.view->getMemoryUsage();
+	_memoryUsage += memory - entry.memoryUsage;
+	entry.memoryUsage = memory;
+}
+
+void GfxCache::setCacheSize(uint32 size) {
+	_maxMemory = size;
+	freeOldEntries();
+}
+
+/**
+ * Frees the least recently used views and fonts until the cache fits into
+ * its budget again. The most recently used view and font are always kept.
+ */
+void GfxCache::freeOldEntries() {
+	while (_memoryUsage > _maxMemory) {
+		// Find the least recently used entry, and the most recently used
+		// one of each kind, which may not be freed. The memory of all
+		// entries is counted again on the way.
+		FontCache::iterator oldestFont = _cachedFonts.end(), newestFont = _cachedFonts.end();
+		for (FontCache::iterator iter = _cachedFonts.begin(); iter != _cachedFonts.end(); ++iter) {
+			countMemoryUsage(iter->_value);
+			if (oldestFont == _cachedFonts.end() || iter->_value.lastUsed < oldestFont->_value.lastUsed)
+				oldestFont = iter;
+			if (newestFont == _cachedFonts.end() || iter->_value.lastUsed > newestFont->_value.lastUsed)
+				newestFont = iter;
+		}
+		if (oldestFont == newestFont)
+			oldestFont = _cachedFonts.end();
+
+		ViewCache::iterator oldestView = _cachedViews.end(), newestView = _cachedViews.end();
+		for (ViewCache::iterator iter = _cachedViews.begin(); iter != _cachedViews.end(); ++iter) {
+			countMemoryUsage(iter->_value);
+			if (oldestView == _cachedViews.end() || iter->_value.lastUsed < oldestView->_value.lastUsed)
+				oldestView = iter;
+			if (newestView == _cachedViews.end() || iter->_value.lastUsed > newestView->_value.lastUsed)
+				newestView = iter;
+		}
+		if (oldestView == newestView)
+			oldestView = _cachedViews.end();
+
+		if (_memoryUsage <= _maxMemory)
+			break;
+
+		uint32 freed;
+		if (oldestView != _cachedViews.end() &&
+		    (oldestFont == _cachedFonts.end() || oldestView->_value.lastUsed < oldestFont->_value.lastUsed)) {
+			freed = oldestView->_value.memoryUsage;
+			delete oldestView->_value.view;
+			_cachedViews.erase(oldestView);
+		} else if (oldestFont != _cachedFonts.end()) {
+			freed = oldestFont->_value.memoryUsage;
+			delete oldestFont->_value.font;
+			_cachedFonts.erase(oldestFont);
+		} else {
+			// Only the entries in use are left
+			break;
+		}
+
+		_stats.evictions++;
+		_stats.bytesEvicted += freed;
+		_memoryUsage -= freed;
+	}
+}
+
 GfxFont *GfxCache::getFont(GuiResourceId fontId) {
-	if (_cachedFonts.size() >= MAX_CACHED_FONTS)
-		purgeFontCache();
-
-	if (!_cachedFonts.contains(fontId)) {
-		// Create special SJIS font in japanese games, when font 900 is selected
-		if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
-			_cachedFonts[fontId] = new GfxFontSjis(_screen, fontId);
-		else
-			_cachedFonts[fontId] = new GfxFontFromResource(_resMan, _screen, fontId);
+	FontCache::iterator iter = _cachedFonts.find(fontId);
+	if (iter != _cachedFonts.end()) {
+		_stats.fontHits++;
+		iter->_value.lastUsed = ++_useCounter;
+		countMemoryUsage(iter->_value);
+		return iter->_value.font;
 	}
 
-	return _cachedFonts[fontId];
+	_stats.fontMisses++;
+
+	FontCacheEntry &entry = _cachedFonts[fontId];
+	// Create special SJIS font in japanese games, when font 900 is selected
+	if ((fontId == 900) && (g_sci->getLanguage() == Common::JA_JPN))
+		entry.font = new GfxFontSjis(_screen, fontId);
+	else
+		entry.font = new GfxFontFromResource(_resMan, _screen, fontId);
+	entry.lastUsed = ++_useCounter;
+	entry.memoryUsage = 0;
+	countMemoryUsage(entry);
+
+	GfxFont *font = entry.font;
+	freeOldEntries();
+	return font;
 }
 
 GfxView *GfxCache::getView(GuiResourceId viewId) {
-	if (_cachedViews.size() >= MAX_CACHED_VIEWS)
-		purgeViewCache();
+	ViewCache::iterator iter = _cachedViews.find(viewId);
+	if (iter != _cachedViews.end()) {
+		_stats.viewHits++;
+		iter->_value.lastUsed = ++_useCounter;
+		countMemoryUsage(iter->_value);
+		return iter->_value.view;
+	}
+
+	_stats.viewMisses++;
 
-	if (!_cachedViews.contains(viewId))
-		_cachedViews[viewId] = new GfxView(_resMan, _screen, _palette, viewId);
+	ViewCacheEntry &entry = _cachedViews[viewId];
+	entry.view = new GfxView(_resMan, _screen, _palette, viewId);
+	entry.lastUsed = ++_useCounter;
+	entry.memoryUsage = 0;
+	countMemoryUsage(entry);
 
-	return _cachedViews[viewId];
+	GfxView *view = entry.view;
+	freeOldEntries();
+	return view;
 }
 
 int16 GfxCache::kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo) {
@@ -30,11 +30,31 @@ namespace Sci {
 class GfxFont;
 class GfxView;
 
-typedef Common::HashMap<int, GfxFont *> FontCache;
-typedef Common::HashMap<int, GfxView *> ViewCache;
+struct FontCacheEntry {
+	GfxFont *font;
+	uint32 lastUsed;
+	uint32 memoryUsage;	///< as last counted in the total of the cache
+};
+
+struct ViewCacheEntry {
+	GfxView *view;
+	uint32 lastUsed;
+	uint32 memoryUsage;	///< as last counted in the total of the cache
+};
+
+typedef Common::HashMap<int, FontCacheEntry> FontCache;
+typedef Common::HashMap<int, ViewCacheEntry> ViewCache;
 
 /**
  * Cache class, handles caching of views/fonts
+ *
+ * Views and fonts are kept until the memory they use, including unpacked
+ * and scaled cels, exceeds a budget. Then the least recently used ones are
+ * freed, but never the most recently used view and font, as callers keep
+ * pointers to those. The budget is checked whenever something new is added,
+ * so it may be exceeded for a while by cels unpacked in between. The memory
+ * of a view or font is counted again whenever it is used, and when the cache
+ * looks for entries to free.
  */
 class GfxCache {
 public:
@@ -44,6 +64,27 @@ public:
 	GfxFont *getFont(GuiResourceId fontId);
 	GfxView *getView(GuiResourceId viewId);
 
+	struct Stats {
+		uint32 viewHits;	///< Views which were found in the cache
+		uint32 viewMisses;	///< Views which had to be loaded
+		uint32 fontHits;
+		uint32 fontMisses;
+		uint32 evictions;	///< Views and fonts freed to stay within the budget
+		uint32 bytesEvicted;
+	};
+
+	const Stats &getStats() const { return _stats; }
+	void resetStats();
+
+	/** Number of bytes used by the cached views and fonts */
+	uint32 getMemoryUsage() const { return _memoryUsage; }
+	uint getViewCount() const { return _cachedViews.size(); }
+	uint getFontCount() const { return _cachedFonts.size(); }
+
+	/** Maximum number of bytes used by the cached views and fonts */
+	uint32 getCacheSize() const { return _maxMemory; }
+	void setCacheSize(uint32 size);
+
 	int16 kernelViewGetCelWidth(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetCelHeight(GuiResourceId viewId, int16 loopNo, int16 celNo);
 	int16 kernelViewGetLoopCount(GuiResourceId viewId);
@@ -52,8 +93,17 @@ public:
 	byte kernelViewGetColorAtCoordinate(GuiResourceId viewId, int16 loopNo, int16 celNo, int16 x, int16 y);
 
 private:
+	// The default can be overridden with the "gfx_cache" setting, in KB.
+	enum {
+		MAX_MEMORY = 2 * 1024 * 1024,	// 2MB
+		MAX_MEMORY_SCI32 = 16 * 1024 * 1024	// 16MB, for hi-res views
+	};
+
 	void purgeFontCache();
 	void purgeViewCache();
+	void countMemoryUsage(FontCacheEntry &entry);
+	void countMemoryUsage(ViewCacheEntry &entry);
+	void freeOldEntries();
 
 	ResourceManager *_resMan;
 	GfxScreen *_screen;
@@ -61,6 +111,10 @@ private:
 
 	FontCache _cachedFonts;
 	ViewCache _cachedViews;
+	uint32 _useCounter;
+	uint32 _memoryUsage;
+	uint32 _maxMemory;
+	Stats _stats;
 };
 
 } // End of namespace Sci
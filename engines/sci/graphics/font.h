@@ -38,6 +38,8 @@ public:
 	virtual byte getCharWidth(uint16 chr) { return 0; }
 	virtual void draw(uint16 chr, int16 top, int16 left, byte color, bool greyedOutput) {}
 	virtual void drawToBuffer(uint16 chr, int16 top, int16 left, byte color, bool greyedOutput, byte *buffer, int16 width, int16 height) {}
+	/** Returns the number of bytes used by the font, for the cache budget. */
+	virtual uint32 getMemoryUsage() { return 0; }
 };
 
 
@@ -54,6 +56,7 @@ public:
 	byte getHeight();
 	byte getCharWidth(uint16 chr);
 	void draw(uint16 chr, int16 top, int16 left, byte color, bool greyedOutput);
+	uint32 getMemoryUsage();
 #ifdef ENABLE_SCI32
 	// SCI2/2.1 equivalent
 	void drawToBuffer(uint16 chr, int16 top, int16 left, byte color, bool greyedOutput, byte *buffer, int16 width, int16 height);
@@ -66,6 +66,10 @@ GfxFrameout::GfxFrameout(SegManager *segMan, ResourceManager *resMan, GfxCoordAd
 	_curScrollText = -1;
 	_showScrollText = false;
 	_maxScrollTexts = 0;
+	_redrawAll = true;
+	_trackChanges = true;
+	_showStats = false;
+	resetStats();
 }
 
 GfxFrameout::~GfxFrameout() {
@@ -77,6 +81,7 @@ void GfxFrameout::clear() {
 	_planes.clear();
 	deletePlanePictures(NULL_REG);
 	clearScrollTexts();
+	invalidate();
 }
 
 void GfxFrameout::clearScrollTexts() {
@@ -258,6 +263,7 @@ void GfxFrameout::kernelDeletePlane(reg_t object) {
 
 			// Blackout removed plane rect
 			_paint32->fillRect(planeRect, 0);
+			invalidate();
 			return;
 		}
 	}
@@ -489,8 +495,17 @@ void GfxFrameout::kernelAddPicAt(reg_t planeObj, GuiResourceId pictureId, int16
 
 bool sortHelper(const FrameoutEntry* entry1, const FrameoutEntry* entry2) {
 	if (entry1->priority == entry2->priority) {
-		if (entry1->y == entry2->y)
-			return (entry1->givenOrderNr < entry2->givenOrderNr);
+		if (entry1->y == entry2->y) {
+			if (entry1->givenOrderNr != entry2->givenOrderNr)
+				return (entry1->givenOrderNr < entry2->givenOrderNr);
+			// Keep the order the same in every frame, so that unchanged
+			// items are drawn just like before
+			if (entry1->object.getSegment() != entry2->object.getSegment())
+				return (entry1->object.getSegment() < entry2->object.getSegment());
+			if (entry1->object.getOffset() != entry2->object.getOffset())
+				return (entry1->object.getOffset() < entry2->object.getOffset());
+			return (entry1->celNo < entry2->celNo);
+		}
 		return (entry1->y < entry2->y);
 	}
 	return (entry1->priority < entry2->priority);
@@ -565,12 +580,13 @@ void GfxFrameout::createPlaneItemList(reg_t planeObject, FrameoutList &itemList)
 		if (pictureIt->object == planeObject) {
 			GfxPicture *planePicture = pictureIt->picture;
 			// Allocate memory for picture cels
-			pictureIt->pictureCels = new FrameoutEntry[planePicture->getSci32celCount()];
+			pictureIt->pictureCels = new FrameoutEntry[planePicture->getSci32celCount()]();
 
 			// Add following cels to the itemlist
 			FrameoutEntry *picEntry = pictureIt->pictureCels;
 			int planePictureCels = planePicture->getSci32celCount();
 			for (int pictureCelNr = 0; pictureCelNr < planePictureCels; pictureCelNr++) {
+				picEntry->givenOrderNr = pictureCelNr;
 				picEntry->celNo = pictureCelNr;
 				picEntry->object = NULL_REG;
 				picEntry->picture = planePicture;
@@ -616,7 +632,8 @@ bool GfxFrameout::isPictureOutOfView(FrameoutEntry *itemEntry, Common::Rect plan
 	return false;
 }
 
-void GfxFrameout::drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored) {
+void GfxFrameout::drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored,
+                              const Common::Rect *clipRects, uint clipRectCount) {
 	int16 pictureOffsetX = planeOffsetX;
 	int16 pictureX = itemEntry->x;
 	if ((planeOffsetX) || (itemEntry->picStartX)) {
@@ -639,21 +656,312 @@ void GfxFrameout::drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int1
 		}
 	}
 
-	itemEntry->picture->drawSci32Vga(itemEntry->celNo, pictureX, itemEntry->y, pictureOffsetX, pictureOffsetY, planePictureMirrored);
+	itemEntry->picture->drawSci32Vga(itemEntry->celNo, pictureX, itemEntry->y, pictureOffsetX, pictureOffsetY, planePictureMirrored,
+	                                 clipRects, clipRectCount);
 	//	warning("picture cel %d %d", itemEntry->celNo, itemEntry->priority);
 }
 
+FrameoutDrawOp &GfxFrameout::addDrawOp(FrameoutDrawType type, PlaneEntry &plane, FrameoutEntry *itemEntry, int16 sortY) {
+	_drawOps.push_back(FrameoutDrawOp());
+	FrameoutDrawOp &op = _drawOps.back();
+	op.plane = &plane;
+	op.item = itemEntry;
+
+	// Clear everything, so that unused fields compare as equal
+	FrameoutDrawRecord &record = op.record;
+	memset((void *)&record, 0, sizeof(record));
+	record.plane = plane.object;
+	record.type = type;
+	record.planePriority = plane.priority;
+	record.offsetX = plane.planeOffsetX;
+	record.offsetY = plane.planeOffsetY;
+
+	if (itemEntry) {
+		record.object = itemEntry->object;
+		record.priority = itemEntry->priority;
+		record.sortY = sortY;
+		record.order = itemEntry->givenOrderNr;
+		record.loopNo = itemEntry->loopNo;
+		record.celNo = itemEntry->celNo;
+		record.x = itemEntry->x;
+		record.y = itemEntry->y;
+		record.z = itemEntry->z;
+		record.scaleX = itemEntry->scaleX;
+		record.scaleY = itemEntry->scaleY;
+	}
+
+	return op;
+}
+
+void GfxFrameout::prepareItems(PlaneEntry &plane, FrameoutList &itemList) {
+	for (FrameoutList::iterator listIterator = itemList.begin(); listIterator != itemList.end(); listIterator++) {
+		FrameoutEntry *itemEntry = *listIterator;
+
+		if (!itemEntry->visible)
+			continue;
+
+		// The items have been sorted by this
+		const int16 sortY = itemEntry->y;
+
+		if (itemEntry->object.isNull()) {
+			// Picture cel data
+			_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
+			_coordAdjuster->fromScriptToDisplay(itemEntry->picStartY, itemEntry->picStartX);
+
+			if (!isPictureOutOfView(itemEntry, plane.planeRect, plane.planeOffsetX, plane.planeOffsetY)) {
+				FrameoutDrawOp &op = addDrawOp(kFrameoutDrawPicture, plane, itemEntry, sortY);
+				op.record.resourceId = itemEntry->picture->getResourceId();
+				op.record.x2 = itemEntry->picStartX;
+				op.record.y2 = itemEntry->picStartY;
+				op.record.mirrored = plane.planePictureMirrored;
+				op.record.rect = plane.planeRect;
+			}
+		} else {
+			GfxView *view = (itemEntry->viewId != 0xFFFF) ? _cache->getView(itemEntry->viewId) : NULL;
+			int16 dummyX = 0;
+
+			if (view && view->isSci2Hires()) {
+				view->adjustToUpscaledCoordinates(itemEntry->y, itemEntry->x);
+				view->adjustToUpscaledCoordinates(itemEntry->z, dummyX);
+			} else if (getSciVersion() >= SCI_VERSION_2_1) {
+				_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
+				_coordAdjuster->fromScriptToDisplay(itemEntry->z, dummyX);
+			}
+
+			// Adjust according to current scroll position
+			itemEntry->x -= plane.planeOffsetX;
+			itemEntry->y -= plane.planeOffsetY;
+
+			uint16 useInsetRect = readSelectorValue(_segMan, itemEntry->object, SELECTOR(useInsetRect));
+			if (useInsetRect) {
+				itemEntry->celRect.top = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inTop));
+				itemEntry->celRect.left = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inLeft));
+				itemEntry->celRect.bottom = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inBottom));
+				itemEntry->celRect.right = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inRight));
+				if (view && view->isSci2Hires()) {
+					view->adjustToUpscaledCoordinates(itemEntry->celRect.top, itemEntry->celRect.left);
+					view->adjustToUpscaledCoordinates(itemEntry->celRect.bottom, itemEntry->celRect.right);
+				}
+				itemEntry->celRect.translate(itemEntry->x, itemEntry->y);
+				// TODO: maybe we should clip the cels rect with this, i'm not sure
+				//  the only currently known usage is game menu of gk1
+			} else if (view) {
+				// Process global scaling, if needed.
+				// TODO: Seems like SCI32 always processes global scaling for scaled objects
+				// TODO: We can only process symmetrical scaling for now (i.e. same value for scaleX/scaleY)
+				if ((itemEntry->scaleSignal & kScaleSignalDoScaling32) &&
+				   !(itemEntry->scaleSignal & kScaleSignalDisableGlobalScaling32) &&
+				    (itemEntry->scaleX == itemEntry->scaleY) &&
+					itemEntry->scaleX != 128)
+					applyGlobalScaling(itemEntry, plane.planeRect, view->getHeight(itemEntry->loopNo, itemEntry->celNo));
+
+				if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
+					view->getCelRect(itemEntry->loopNo, itemEntry->celNo,
+						itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->celRect);
+				else
+					view->getCelScaledRect(itemEntry->loopNo, itemEntry->celNo,
+						itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->scaleX,
+						itemEntry->scaleY, itemEntry->celRect);
+
+				Common::Rect nsRect = itemEntry->celRect;
+				// Translate back to actual coordinate within scrollable plane
+				nsRect.translate(plane.planeOffsetX, plane.planeOffsetY);
+
+				if (g_sci->getGameId() == GID_PHANTASMAGORIA2) {
+					// HACK: Some (?) objects in Phantasmagoria 2 have no NS rect. Skip them for now.
+					// TODO: Remove once we figure out how Phantasmagoria 2 draws objects on screen.
+					if (lookupSelector(_segMan, itemEntry->object, SELECTOR(nsLeft), NULL, NULL) != kSelectorVariable)
+						continue;
+				}
+
+				if (view && view->isSci2Hires()) {
+					view->adjustBackUpscaledCoordinates(nsRect.top, nsRect.left);
+					view->adjustBackUpscaledCoordinates(nsRect.bottom, nsRect.right);
+					g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
+				} else if (getSciVersion() >= SCI_VERSION_2_1 && _resMan->detectHires()) {
+					_coordAdjuster->fromDisplayToScript(nsRect.top, nsRect.left);
+					_coordAdjuster->fromDisplayToScript(nsRect.bottom, nsRect.right);
+					g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
+				}
+
+				// TODO: For some reason, the top left nsRect coordinates get
+				// swapped in the GK1 inventory screen, investigate why.
+				// HACK: Fix the coordinates by explicitly setting them here.
+				Common::Rect objNSRect = g_sci->_gfxCompare->getNSRect(itemEntry->object);
+				if (objNSRect.top == nsRect.left && objNSRect.left == nsRect.top && nsRect.top != 0 && nsRect.left != 0) {
+					g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
+				}
+			}
+
+			// Don't attempt to draw sprites that are outside the visible
+			// screen area. An example is the random people walking in
+			// Jackson Square in GK1.
+			if (itemEntry->celRect.bottom < 0 || itemEntry->celRect.top  >= _screen->getDisplayHeight() ||
+			    itemEntry->celRect.right  < 0 || itemEntry->celRect.left >= _screen->getDisplayWidth())
+				continue;
+
+			Common::Rect clipRect, translatedClipRect;
+			clipRect = itemEntry->celRect;
+
+			if (view && view->isSci2Hires()) {
+				clipRect.clip(plane.upscaledPlaneClipRect);
+				translatedClipRect = clipRect;
+				translatedClipRect.translate(plane.upscaledPlaneRect.left, plane.upscaledPlaneRect.top);
+			} else {
+				// QFG4 passes invalid rectangles when a battle is starting
+				if (!clipRect.isValidRect())
+					continue;
+				clipRect.clip(plane.planeClipRect);
+				translatedClipRect = clipRect;
+				translatedClipRect.translate(plane.planeRect.left, plane.planeRect.top);
+			}
+
+			if (view && !clipRect.isEmpty()) {
+				FrameoutDrawOp &op = addDrawOp(kFrameoutDrawView, plane, itemEntry, sortY);
+				op.record.resourceId = itemEntry->viewId;
+				op.record.remapGeneration = _palette->getRemapGeneration();
+				op.record.celRect = itemEntry->celRect;
+				op.record.rect = translatedClipRect;
+				op.clipRect = clipRect;
+			}
+
+			// Draw text, if it exists
+			if (lookupSelector(_segMan, itemEntry->object, SELECTOR(text), NULL, NULL) == kSelectorVariable) {
+				Common::Rect textRect;
+				uint32 checksum;
+				if (g_sci->_gfxText32->getTextBitmapArea(itemEntry->x, itemEntry->y, plane.planeRect, itemEntry->object, textRect, checksum)) {
+					FrameoutDrawOp &op = addDrawOp(kFrameoutDrawText, plane, itemEntry, sortY);
+					op.record.data = checksum;
+					op.record.rect = textRect;
+				}
+			}
+		}
+	}
+}
+
+bool GfxFrameout::draw(const FrameoutDrawOp &op, const Common::Rect *rects, uint numRects) {
+	const FrameoutDrawRecord &record = op.record;
+	FrameoutEntry *itemEntry = op.item;
+
+	// The parts of the operation inside the rectangles
+	Common::Rect clipRects[kMaxDirtyRects];
+	uint numClipRects = 0;
+	if (rects) {
+		for (uint i = 0; i < numRects; i++) {
+			if (record.rect.intersects(rects[i]))
+				clipRects[numClipRects++] = record.rect.findIntersectingRect(rects[i]);
+		}
+		if (!numClipRects)
+			return false;
+	} else {
+		clipRects[numClipRects++] = record.rect;
+	}
+
+	switch (record.type) {
+	case kFrameoutDrawLine:
+		_screen->drawLine(record.x, record.y, record.x2, record.y2,
+			record.data & 0xFF, (record.data >> 8) & 0xFF, (record.data >> 16) & 0xFF);
+		break;
+	case kFrameoutDrawFill:
+		for (uint i = 0; i < numClipRects; i++)
+			_paint32->fillRect(clipRects[i], record.data);
+		break;
+	case kFrameoutDrawPicture:
+		// The picture is only unpacked once for all rectangles
+		_coordAdjuster->pictureSetDisplayArea(op.plane->planeRect);
+		if (rects)
+			drawPicture(itemEntry, record.offsetX, record.offsetY, record.mirrored, clipRects, numClipRects);
+		else
+			drawPicture(itemEntry, record.offsetX, record.offsetY, record.mirrored);
+		break;
+	case kFrameoutDrawView: {
+		// Looked up again, as the cache may have been purged since
+		GfxView *view = _cache->getView(itemEntry->viewId);
+		for (uint i = 0; i < numClipRects; i++) {
+			// The clip rect within the plane moves along with the one on the screen
+			Common::Rect clipRect = op.clipRect;
+			clipRect.translate(clipRects[i].left - record.rect.left, clipRects[i].top - record.rect.top);
+			clipRect.setWidth(clipRects[i].width());
+			clipRect.setHeight(clipRects[i].height());
+
+			if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
+				view->draw(itemEntry->celRect, clipRect, clipRects[i],
+					itemEntry->loopNo, itemEntry->celNo, 255, 0, view->isSci2Hires());
+			else
+				view->drawScaled(itemEntry->celRect, clipRect, clipRects[i],
+					itemEntry->loopNo, itemEntry->celNo, 255, itemEntry->scaleX, itemEntry->scaleY);
+		}
+		break;
+	}
+	case kFrameoutDrawText:
+		for (uint i = 0; i < numClipRects; i++)
+			g_sci->_gfxText32->drawTextBitmap(itemEntry->x, itemEntry->y, op.plane->planeRect, itemEntry->object, rects ? &clipRects[i] : NULL);
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+void GfxFrameout::addDirtyLines() {
+	Common::Rect rects[kMaxDirtyRects];
+	uint numRects = _dirtyRegion.getRects(rects, ARRAYSIZE(rects));
+
+	// Adding a line can make the region touch other lines
+	Common::Array<bool> added;
+	added.resize(_drawOps.size());
+	bool grown = true;
+	while (grown) {
+		grown = false;
+		for (uint i = 0; i < _drawOps.size(); i++) {
+			const FrameoutDrawRecord &record = _drawOps[i].record;
+			if (record.type != kFrameoutDrawLine || added[i])
+				continue;
+
+			for (uint j = 0; j < numRects; j++) {
+				if (record.rect.intersects(rects[j])) {
+					_dirtyRegion.add(record.rect);
+					added[i] = true;
+					grown = true;
+					break;
+				}
+			}
+		}
+
+		if (grown)
+			numRects = _dirtyRegion.getRects(rects, ARRAYSIZE(rects));
+	}
+}
+
+void GfxFrameout::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
 void GfxFrameout::kernelFrameout() {
 	if (g_sci->_robotDecoder->isVideoLoaded()) {
 		showVideo();
+		invalidate();
 		return;
 	}
 
 	_palette->palVaryUpdate();
 
+	// A frame is handled in two passes. The first one does everything which
+	// the scripts can notice, like setting the NS rects of the screen items,
+	// and collects what is to be drawn. The screen is only drawn again if
+	// that differs from the last frame, and then only the parts of it which
+	// changed are drawn again and copied to the backend.
+	_drawOps.clear();
+	Common::Rect displayArea = _coordAdjuster->pictureGetDisplayArea();
+
 	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); it++) {
 		reg_t planeObject = it->object;
 
+		// Update priority here, sq6 sets it w/o UpdatePlane
+		int16 planeLastPriority = it->lastPriority;
+		int16 planePriority = it->priority = readSelectorValue(_segMan, planeObject, SELECTOR(priority));
+
 		// Draw any plane lines, if they exist
 		// These are drawn on invisible planes as well. (e.g. "invisiblePlane" in LSL6 hires)
 		// FIXME: Lines aren't always drawn (e.g. when the narrator speaks in LSL6 hires).
@@ -663,19 +971,23 @@ void GfxFrameout::kernelFrameout() {
 			Common::Point endPoint = it2->endPoint;
 			_coordAdjuster->kernelLocalToGlobal(startPoint.x, startPoint.y, it->object);
 			_coordAdjuster->kernelLocalToGlobal(endPoint.x, endPoint.y, it->object);
-			_screen->drawLine(startPoint, endPoint, it2->color, it2->priority, it2->control);
-		}
-
-		int16 planeLastPriority = it->lastPriority;
 
-		// Update priority here, sq6 sets it w/o UpdatePlane
-		int16 planePriority = it->priority = readSelectorValue(_segMan, planeObject, SELECTOR(priority));
+			FrameoutDrawOp &op = addDrawOp(kFrameoutDrawLine, *it, NULL, 0);
+			op.record.object = it2->hunkId;
+			op.record.x = startPoint.x;
+			op.record.y = startPoint.y;
+			op.record.x2 = endPoint.x;
+			op.record.y2 = endPoint.y;
+			op.record.data = it2->color | (it2->priority << 8) | (it2->control << 16);
+			op.record.rect = Common::Rect(MIN(startPoint.x, endPoint.x), MIN(startPoint.y, endPoint.y),
+			                              MAX(startPoint.x, endPoint.x) + 1, MAX(startPoint.y, endPoint.y) + 1);
+		}
 
 		it->lastPriority = planePriority;
 		if (planePriority < 0) { // Plane currently not meant to be shown
 			// If plane was shown before, delete plane rect
 			if (planePriority != planeLastPriority)
-				_paint32->fillRect(it->planeRect, 0);
+				addDrawOp(kFrameoutDrawFill, *it, NULL, 0).record.rect = it->planeRect;
 			continue;
 		}
 
@@ -683,10 +995,14 @@ void GfxFrameout::kernelFrameout() {
 		// Since I first wrote the patch, the race has stopped occurring for me though.
 		// I'll leave this for investigation later, when someone can reproduce.
 		//if (it->pictureId == kPlanePlainColored)	// FIXME: This is what SSCI does, and fixes the intro of LSL7, but breaks the dialogs in GK1 (adds black boxes)
-		if (it->pictureId == kPlanePlainColored && (it->planeBack || g_sci->getGameId() != GID_GK1))
-			_paint32->fillRect(it->planeRect, it->planeBack);
+		if (it->pictureId == kPlanePlainColored && (it->planeBack || g_sci->getGameId() != GID_GK1)) {
+			FrameoutDrawOp &op = addDrawOp(kFrameoutDrawFill, *it, NULL, 0);
+			op.record.data = it->planeBack;
+			op.record.rect = it->planeRect;
+		}
 
 		_coordAdjuster->pictureSetDisplayArea(it->planeRect);
+		displayArea = it->planeRect;
 		// Invoking drewPicture() with an invalid picture ID in SCI32 results in
 		// invalidating the palVary palette when a palVary effect is active. This
 		// is quite obvious in QFG4, where the day time palette is incorrectly
@@ -698,149 +1014,88 @@ void GfxFrameout::kernelFrameout() {
 		FrameoutList itemList;
 
 		createPlaneItemList(planeObject, itemList);
+		prepareItems(*it, itemList);
+	}
 
-		for (FrameoutList::iterator listIterator = itemList.begin(); listIterator != itemList.end(); listIterator++) {
-			FrameoutEntry *itemEntry = *listIterator;
-
-			if (!itemEntry->visible)
-				continue;
-
-			if (itemEntry->object.isNull()) {
-				// Picture cel data
-				_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
-				_coordAdjuster->fromScriptToDisplay(itemEntry->picStartY, itemEntry->picStartX);
-
-				if (!isPictureOutOfView(itemEntry, it->planeRect, it->planeOffsetX, it->planeOffsetY))
-					drawPicture(itemEntry, it->planeOffsetX, it->planeOffsetY, it->planePictureMirrored);
-			} else {
-				GfxView *view = (itemEntry->viewId != 0xFFFF) ? _cache->getView(itemEntry->viewId) : NULL;
-				int16 dummyX = 0;
-
-				if (view && view->isSci2Hires()) {
-					view->adjustToUpscaledCoordinates(itemEntry->y, itemEntry->x);
-					view->adjustToUpscaledCoordinates(itemEntry->z, dummyX);
-				} else if (getSciVersion() >= SCI_VERSION_2_1) {
-					_coordAdjuster->fromScriptToDisplay(itemEntry->y, itemEntry->x);
-					_coordAdjuster->fromScriptToDisplay(itemEntry->z, dummyX);
-				}
-
-				// Adjust according to current scroll position
-				itemEntry->x -= it->planeOffsetX;
-				itemEntry->y -= it->planeOffsetY;
-
-				uint16 useInsetRect = readSelectorValue(_segMan, itemEntry->object, SELECTOR(useInsetRect));
-				if (useInsetRect) {
-					itemEntry->celRect.top = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inTop));
-					itemEntry->celRect.left = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inLeft));
-					itemEntry->celRect.bottom = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inBottom));
-					itemEntry->celRect.right = readSelectorValue(_segMan, itemEntry->object, SELECTOR(inRight));
-					if (view && view->isSci2Hires()) {
-						view->adjustToUpscaledCoordinates(itemEntry->celRect.top, itemEntry->celRect.left);
-						view->adjustToUpscaledCoordinates(itemEntry->celRect.bottom, itemEntry->celRect.right);
-					}
-					itemEntry->celRect.translate(itemEntry->x, itemEntry->y);
-					// TODO: maybe we should clip the cels rect with this, i'm not sure
-					//  the only currently known usage is game menu of gk1
-				} else if (view) {
-					// Process global scaling, if needed.
-					// TODO: Seems like SCI32 always processes global scaling for scaled objects
-					// TODO: We can only process symmetrical scaling for now (i.e. same value for scaleX/scaleY)
-					if ((itemEntry->scaleSignal & kScaleSignalDoScaling32) &&
-					   !(itemEntry->scaleSignal & kScaleSignalDisableGlobalScaling32) &&
-					    (itemEntry->scaleX == itemEntry->scaleY) &&
-						itemEntry->scaleX != 128)
-						applyGlobalScaling(itemEntry, it->planeRect, view->getHeight(itemEntry->loopNo, itemEntry->celNo));
-
-					if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
-						view->getCelRect(itemEntry->loopNo, itemEntry->celNo,
-							itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->celRect);
-					else
-						view->getCelScaledRect(itemEntry->loopNo, itemEntry->celNo,
-							itemEntry->x, itemEntry->y, itemEntry->z, itemEntry->scaleX,
-							itemEntry->scaleY, itemEntry->celRect);
-
-					Common::Rect nsRect = itemEntry->celRect;
-					// Translate back to actual coordinate within scrollable plane
-					nsRect.translate(it->planeOffsetX, it->planeOffsetY);
-
-					if (g_sci->getGameId() == GID_PHANTASMAGORIA2) {
-						// HACK: Some (?) objects in Phantasmagoria 2 have no NS rect. Skip them for now.
-						// TODO: Remove once we figure out how Phantasmagoria 2 draws objects on screen.
-						if (lookupSelector(_segMan, itemEntry->object, SELECTOR(nsLeft), NULL, NULL) != kSelectorVariable)
-							continue;
-					}
-
-					if (view && view->isSci2Hires()) {
-						view->adjustBackUpscaledCoordinates(nsRect.top, nsRect.left);
-						view->adjustBackUpscaledCoordinates(nsRect.bottom, nsRect.right);
-						g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
-					} else if (getSciVersion() >= SCI_VERSION_2_1 && _resMan->detectHires()) {
-						_coordAdjuster->fromDisplayToScript(nsRect.top, nsRect.left);
-						_coordAdjuster->fromDisplayToScript(nsRect.bottom, nsRect.right);
-						g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
-					}
-
-					// TODO: For some reason, the top left nsRect coordinates get
-					// swapped in the GK1 inventory screen, investigate why.
-					// HACK: Fix the coordinates by explicitly setting them here.
-					Common::Rect objNSRect = g_sci->_gfxCompare->getNSRect(itemEntry->object);
-					if (objNSRect.top == nsRect.left && objNSRect.left == nsRect.top && nsRect.top != 0 && nsRect.left != 0) {
-						g_sci->_gfxCompare->setNSRect(itemEntry->object, nsRect);
-					}
-				}
-
-				// Don't attempt to draw sprites that are outside the visible
-				// screen area. An example is the random people walking in
-				// Jackson Square in GK1.
-				if (itemEntry->celRect.bottom < 0 || itemEntry->celRect.top  >= _screen->getDisplayHeight() ||
-				    itemEntry->celRect.right  < 0 || itemEntry->celRect.left >= _screen->getDisplayWidth())
-					continue;
-
-				Common::Rect clipRect, translatedClipRect;
-				clipRect = itemEntry->celRect;
-
-				if (view && view->isSci2Hires()) {
-					clipRect.clip(it->upscaledPlaneClipRect);
-					translatedClipRect = clipRect;
-					translatedClipRect.translate(it->upscaledPlaneRect.left, it->upscaledPlaneRect.top);
-				} else {
-					// QFG4 passes invalid rectangles when a battle is starting
-					if (!clipRect.isValidRect())
-						continue;
-					clipRect.clip(it->planeClipRect);
-					translatedClipRect = clipRect;
-					translatedClipRect.translate(it->planeRect.left, it->planeRect.top);
-				}
-
-				if (view) {
-					if (!clipRect.isEmpty()) {
-						if ((itemEntry->scaleX == 128) && (itemEntry->scaleY == 128))
-							view->draw(itemEntry->celRect, clipRect, translatedClipRect,
-								itemEntry->loopNo, itemEntry->celNo, 255, 0, view->isSci2Hires());
-						else
-							view->drawScaled(itemEntry->celRect, clipRect, translatedClipRect,
-								itemEntry->loopNo, itemEntry->celNo, 255, itemEntry->scaleX, itemEntry->scaleY);
-					}
-				}
+	// Scroll texts and upscaled screens are not tracked
+	bool redrawAll = _redrawAll || !_trackChanges ||
+		_screen->getUpscaledHires() != GFX_SCREEN_UPSCALED_DISABLED ||
+		(_showScrollText && _curScrollText >= 0);
+	_redrawAll = false;
+
+	if (_lastPlanes.size() != _planes.size())
+		redrawAll = true;
+	_lastPlanes.resize(_planes.size());
+	uint planeNr = 0;
+	for (PlaneList::iterator it = _planes.begin(); it != _planes.end(); it++, planeNr++) {
+		if (_lastPlanes[planeNr] != it->object) {
+			_lastPlanes[planeNr] = it->object;
+			redrawAll = true;
+		}
+	}
 
-				// Draw text, if it exists
-				if (lookupSelector(_segMan, itemEntry->object, SELECTOR(text), NULL, NULL) == kSelectorVariable) {
-					g_sci->_gfxText32->drawTextBitmap(itemEntry->x, itemEntry->y, it->planeRect, itemEntry->object);
-				}
-			}
+	if (_dirtyRegion.getWidth() != _screen->getDisplayWidth() || _dirtyRegion.getHeight() != _screen->getDisplayHeight())
+		_dirtyRegion.setSize(_screen->getDisplayWidth(), _screen->getDisplayHeight());
+	_dirtyRegion.clear();
+
+	for (uint i = 0; i < _drawOps.size(); i++)
+		_changes.addRecord(_drawOps[i].record);
+	_changes.findChanges(_dirtyRegion);
+	if (redrawAll)
+		_dirtyRegion.addAll();
+	else if (!_dirtyRegion.isEmpty())
+		addDirtyLines();
+
+	_stats.frames++;
+	_stats.lastOps = _drawOps.size();
+	_stats.lastDrawn = 0;
+	_stats.lastPixels = 0;
+
+	if (redrawAll) {
+		for (uint i = 0; i < _drawOps.size(); i++)
+			draw(_drawOps[i], NULL, 0);
+		_coordAdjuster->pictureSetDisplayArea(displayArea);
+
+		showCurrentScrollText();
+
+		_screen->copyToScreen();
+		_stats.lastPixels = _screen->getDisplayWidth() * _screen->getDisplayHeight();
+		_stats.lastDrawn = _drawOps.size();
+	} else if (!_dirtyRegion.isEmpty()) {
+		// Only the dirty region is drawn again, everything outside of it
+		// looks just like before
+		Common::Rect rects[kMaxDirtyRects];
+		const uint numRects = _dirtyRegion.getRects(rects, ARRAYSIZE(rects));
+		for (uint i = 0; i < _drawOps.size(); i++) {
+			if (draw(_drawOps[i], rects, numRects))
+				_stats.lastDrawn++;
 		}
+		_coordAdjuster->pictureSetDisplayArea(displayArea);
 
-		for (PlanePictureList::iterator pictureIt = _planePictures.begin(); pictureIt != _planePictures.end(); pictureIt++) {
-			if (pictureIt->object == planeObject) {
-				delete[] pictureIt->pictureCels;
-				pictureIt->pictureCels = 0;
-			}
+		for (uint i = 0; i < numRects; i++) {
+			_screen->copyRectToScreen(rects[i]);
+			_stats.lastPixels += rects[i].width() * rects[i].height();
 		}
 	}
 
-	showCurrentScrollText();
+	if (!_dirtyRegion.isEmpty()) {
+		_stats.composited++;
+		_stats.drawn += _stats.lastDrawn;
+		_stats.skipped += _drawOps.size() - _stats.lastDrawn;
+		_stats.pixels += _stats.lastPixels;
+	} else {
+		_stats.skipped += _drawOps.size();
+	}
+
+	for (PlanePictureList::iterator pictureIt = _planePictures.begin(); pictureIt != _planePictures.end(); pictureIt++) {
+		delete[] pictureIt->pictureCels;
+		pictureIt->pictureCels = 0;
+	}
 
-	_screen->copyToScreen();
+	if (_showStats) {
+		g_system->displayMessageOnOSD(Common::String::format("Frame %u: %u of %u items drawn, %u pixels",
+			_stats.frames, _stats.lastDrawn, _stats.lastOps, _stats.lastPixels).c_str());
+	}
 
 	g_sci->getEngineState()->_throttleTrigger = true;
 }
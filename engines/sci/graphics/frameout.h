@@ -23,6 +23,10 @@
 #ifndef SCI_GRAPHICS_FRAMEOUT_H
 #define SCI_GRAPHICS_FRAMEOUT_H
 
+#include "graphics/dirtyregion.h"
+
+#include "sci/graphics/frameout_changes.h"
+
 namespace Sci {
 
 class GfxPicture;
@@ -97,6 +101,27 @@ struct ScrollTextEntry {
 
 typedef Common::Array<ScrollTextEntry> ScrollTextList;
 
+/** A drawing operation of a frame, prepared before anything is drawn */
+struct FrameoutDrawOp {
+	FrameoutDrawRecord record;
+	PlaneEntry *plane;
+	FrameoutEntry *item;
+	Common::Rect clipRect;
+};
+
+/** How much kFrameOut had to draw */
+struct FrameoutStats {
+	uint32 frames;		///< frames shown
+	uint32 composited;	///< frames which were drawn again
+	uint32 drawn;		///< drawing operations executed
+	uint32 skipped;		///< drawing operations left out as nothing changed where they draw
+	uint64 pixels;		///< pixels copied to the screen
+
+	uint32 lastOps;		///< drawing operations of the last frame
+	uint32 lastDrawn;	///< drawing operations executed in the last frame
+	uint32 lastPixels;	///< pixels copied to the screen in the last frame
+};
+
 enum ViewScaleSignals32 {
 	kScaleSignalDoScaling32				= 0x0001, // enables scaling when drawing that cel (involves scaleX and scaleY)
 	kScaleSignalUnk1					= 0x0002, // unknown
@@ -151,11 +176,40 @@ public:
 	void printPlaneList(Console *con);
 	void printPlaneItemList(Console *con, reg_t planeObject);
 
+	/** Makes the next frame draw and show the whole screen, after something else drew to it. */
+	void invalidate() { _redrawAll = true; }
+
+	/** If disabled, every frame is drawn and shown completely, like the original interpreter does. */
+	bool isTrackingChanges() const { return _trackChanges; }
+	void setTrackingChanges(bool track) { _trackChanges = track; invalidate(); }
+
+	/** Shows how much was drawn for every frame on the screen. */
+	void setShowStats(bool show) { _showStats = show; }
+	const FrameoutStats &getStats() const { return _stats; }
+	void resetStats();
+
 private:
+	enum {
+		/** The dirty region is drawn and copied to the backend in at most this many rectangles */
+		kMaxDirtyRects = 16
+	};
+
 	void showVideo();
 	void createPlaneItemList(reg_t planeObject, FrameoutList &itemList);
 	bool isPictureOutOfView(FrameoutEntry *itemEntry, Common::Rect planeRect, int16 planeOffsetX, int16 planeOffsetY);
-	void drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored);
+	void drawPicture(FrameoutEntry *itemEntry, int16 planeOffsetX, int16 planeOffsetY, bool planePictureMirrored,
+	                 const Common::Rect *clipRects = NULL, uint clipRectCount = 0);
+	FrameoutDrawOp &addDrawOp(FrameoutDrawType type, PlaneEntry &plane, FrameoutEntry *itemEntry, int16 sortY);
+	void prepareItems(PlaneEntry &plane, FrameoutList &itemList);
+	/**
+	 * Draws an operation, clipped to the given rectangles, which must not
+	 * overlap. Lines can't be clipped, they are drawn whole if they touch
+	 * any of them. Without rectangles, the operation is drawn whole.
+	 * @return false if the operation was outside of the rectangles
+	 */
+	bool draw(const FrameoutDrawOp &op, const Common::Rect *rects, uint numRects);
+	/** Adds the lines which touch the dirty region to it, as they can't be clipped. */
+	void addDirtyLines();
 
 	SegManager *_segMan;
 	ResourceManager *_resMan;
@@ -173,6 +227,16 @@ private:
 	bool _showScrollText;
 	uint16 _maxScrollTexts;
 
+	// Change tracking, see kernelFrameout()
+	Common::Array<FrameoutDrawOp> _drawOps;
+	FrameoutChangeTracker _changes;
+	Common::Array<reg_t> _lastPlanes;
+	Graphics::DirtyRegion _dirtyRegion;
+	bool _redrawAll;
+	bool _trackChanges;
+	bool _showStats;
+	FrameoutStats _stats;
+
 	void sortPlanes();
 };
 
@@ -0,0 +1,60 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/algorithm.h"
+
+#include "sci/graphics/frameout_changes.h"
+
+namespace Sci {
+
+static bool drawRecordLess(const FrameoutDrawRecord &record1, const FrameoutDrawRecord &record2) {
+	return memcmp(&record1, &record2, sizeof(FrameoutDrawRecord)) < 0;
+}
+
+void FrameoutChangeTracker::findChanges(Graphics::DirtyRegion &dirtyRegion) {
+	Common::sort(_records.begin(), _records.end(), drawRecordLess);
+
+	uint cur = 0, last = 0;
+	while (cur < _records.size() || last < _lastRecords.size()) {
+		int cmp;
+		if (cur == _records.size())
+			cmp = 1;
+		else if (last == _lastRecords.size())
+			cmp = -1;
+		else
+			cmp = memcmp(&_records[cur], &_lastRecords[last], sizeof(FrameoutDrawRecord));
+
+		if (cmp < 0) {
+			dirtyRegion.add(_records[cur++].rect);
+		} else if (cmp > 0) {
+			dirtyRegion.add(_lastRecords[last++].rect);
+		} else {
+			cur++;
+			last++;
+		}
+	}
+
+	SWAP(_records, _lastRecords);
+	_records.clear();
+}
+
+} // End of namespace Sci
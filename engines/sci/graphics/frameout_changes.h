@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SCI_GRAPHICS_FRAMEOUT_CHANGES_H
+#define SCI_GRAPHICS_FRAMEOUT_CHANGES_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+#include "graphics/dirtyregion.h"
+
+#include "sci/engine/vm_types.h"
+
+namespace Sci {
+
+enum FrameoutDrawType {
+	kFrameoutDrawLine = 0,
+	kFrameoutDrawFill = 1,
+	kFrameoutDrawPicture = 2,
+	kFrameoutDrawView = 3,
+	kFrameoutDrawText = 4
+};
+
+/**
+ * Something drawn by kFrameOut, with everything that affects the pixels it
+ * draws. The parts of the screen which changed since the last frame are
+ * found by comparing these. Records are compared byte by byte, so there
+ * must not be any padding.
+ */
+struct FrameoutDrawRecord {
+	reg_t plane;
+	reg_t object;		///< the screen item, if any
+	int16 type;		///< FrameoutDrawType
+	int16 planePriority;
+	int16 priority;		///< order in the plane: priority, sortY and order
+	int16 sortY;
+	uint16 order;
+	uint16 resourceId;	///< view or picture
+	int16 loopNo;
+	int16 celNo;
+	int16 x, y, z;		///< position of cels and text, start of lines
+	int16 x2, y2;		///< end of lines, start of pictures
+	int16 offsetX, offsetY;	///< scroll position of the plane
+	int16 scaleX, scaleY;
+	int16 mirrored;
+	uint32 data;		///< colors of lines and fills, checksum of text
+	uint32 remapGeneration;	///< GfxPalette::getRemapGeneration() for views, whose remapped colors depend on it
+	Common::Rect celRect;
+	Common::Rect rect;	///< the area drawn to, in screen coordinates
+};
+
+/**
+ * Finds the parts of the screen which changed since the last frame, by
+ * comparing the records of what is drawn in both frames.
+ */
+class FrameoutChangeTracker {
+public:
+	/** Adds a record of the current frame. */
+	void addRecord(const FrameoutDrawRecord &record) { _records.push_back(record); }
+
+	/**
+	 * Adds the areas of everything which was drawn in only one of the
+	 * current and the last frame to the dirty region. The current frame
+	 * then becomes the last one.
+	 */
+	void findChanges(Graphics::DirtyRegion &dirtyRegion);
+
+private:
+	Common::Array<FrameoutDrawRecord> _records;
+	Common::Array<FrameoutDrawRecord> _lastRecords;
+};
+
+} // End of namespace Sci
+
+#endif
@@ -102,6 +102,7 @@ GfxPalette::GfxPalette(ResourceManager *resMan, GfxScreen *screen)
 	}
 
 	_remapOn = false;
+	_remapGeneration = 0;
 	resetRemapping();
 }
 
@@ -346,6 +347,10 @@ byte GfxPalette::remapColor(byte remappedColor, byte screenColor) {
 }
 
 void GfxPalette::resetRemapping() {
+	// Nothing is remapped while remapping is off
+	if (_remapOn)
+		_remapGeneration++;
+
 	_remapOn = false;
 	_remappingPercentToSet = 0;
 
@@ -357,6 +362,7 @@ void GfxPalette::resetRemapping() {
 }
 
 void GfxPalette::setRemappingPercent(byte color, byte percent) {
+	bool changed = !_remapOn || _remappingType[color] != kRemappingByPercent;
 	_remapOn = true;
 
 	// We need to defer the setup of the remapping table every time the screen
@@ -369,13 +375,18 @@ void GfxPalette::setRemappingPercent(byte color, byte percent) {
 		byte r = _sysPalette.colors[i].r * _remappingPercentToSet / 100;
 		byte g = _sysPalette.colors[i].g * _remappingPercentToSet / 100;
 		byte b = _sysPalette.colors[i].b * _remappingPercentToSet / 100;
-		_remappingByPercent[i] = kernelFindColor(r, g, b);
+		const byte remapped = kernelFindColor(r, g, b);
+		changed = changed || _remappingByPercent[i] != remapped;
+		_remappingByPercent[i] = remapped;
 	}
 
 	_remappingType[color] = kRemappingByPercent;
+	if (changed)
+		_remapGeneration++;
 }
 
 void GfxPalette::setRemappingPercentGray(byte color, byte percent) {
+	bool changed = !_remapOn || _remappingType[color] != kRemappingByPercent;
 	_remapOn = true;
 
 	// We need to defer the setup of the remapping table every time the screen
@@ -390,20 +401,28 @@ void GfxPalette::setRemappingPercentGray(byte color, byte percent) {
 		byte gComponent = (byte)(_sysPalette.colors[i].g * _remappingPercentToSet * 0.59 / 100);
 		byte bComponent = (byte)(_sysPalette.colors[i].b * _remappingPercentToSet * 0.11 / 100);
 		byte luminosity = rComponent + gComponent + bComponent;
-		_remappingByPercent[i] = kernelFindColor(luminosity, luminosity, luminosity);
+		const byte remapped = kernelFindColor(luminosity, luminosity, luminosity);
+		changed = changed || _remappingByPercent[i] != remapped;
+		_remappingByPercent[i] = remapped;
 	}
 
 	_remappingType[color] = kRemappingByPercent;
+	if (changed)
+		_remapGeneration++;
 }
 
 void GfxPalette::setRemappingRange(byte color, byte from, byte to, byte base) {
+	bool changed = !_remapOn || _remappingType[color] != kRemappingByRange;
 	_remapOn = true;
 
 	for (int i = from; i <= to; i++) {
+		changed = changed || _remappingByRange[i] != (byte)(i + base);
 		_remappingByRange[i] = i + base;
 	}
 
 	_remappingType[color] = kRemappingByRange;
+	if (changed)
+		_remapGeneration++;
 }
 
 bool GfxPalette::insert(Palette *newPalette, Palette *destPalette) {
@@ -570,12 +589,17 @@ void GfxPalette::copySysPaletteToScreen() {
 
 	// Check if we need to reset remapping by percent with the new colors.
 	if (_remappingPercentToSet) {
+		bool changed = false;
 		for (int i = 0; i < 256; i++) {
 			byte r = _sysPalette.colors[i].r * _remappingPercentToSet / 100;
 			byte g = _sysPalette.colors[i].g * _remappingPercentToSet / 100;
 			byte b = _sysPalette.colors[i].b * _remappingPercentToSet / 100;
-			_remappingByPercent[i] = kernelFindColor(r, g, b);
+			const byte remapped = kernelFindColor(r, g, b);
+			changed = changed || _remappingByPercent[i] != remapped;
+			_remappingByPercent[i] = remapped;
 		}
+		if (changed)
+			_remapGeneration++;
 	}
 
 	g_system->getPaletteManager()->setPalette(bpal, 0, 256);
@@ -63,6 +63,8 @@ public:
 	void setRemappingPercent(byte color, byte percent);
 	void setRemappingPercentGray(byte color, byte percent);
 	void setRemappingRange(byte color, byte from, byte to, byte base);
+	/** Incremented whenever the remapped colors change, so that drawings using them can be redone. */
+	uint32 getRemapGeneration() const { return _remapGeneration; }
 	bool isRemapped(byte color) const {
 		return _remapOn && (_remappingType[color] != kRemappingNone);
 	}
@@ -143,6 +145,7 @@ private:
 	byte _remappingByPercent[256];
 	byte _remappingByRange[256];
 	uint16 _remappingPercentToSet;
+	uint32 _remapGeneration;
 
 	void loadMacIconBarPalette();
 	byte *_macClut;
@@ -184,7 +184,8 @@ int16 GfxPicture::getSci32celPriority(int16 celNo) {
 	return READ_SCI11ENDIAN_UINT16(inbuffer + cel_headerPos + 36);
 }
 
-void GfxPicture::drawSci32Vga(int16 celNo, int16 drawX, int16 drawY, int16 pictureX, int16 pictureY, bool mirrored) {
+void GfxPicture::drawSci32Vga(int16 celNo, int16 drawX, int16 drawY, int16 pictureX, int16 pictureY, bool mirrored,
+                              const Common::Rect *clipRects, uint clipRectCount) {
 	byte *inbuffer = _resource->data;
 	int size = _resource->size;
 	int header_size = READ_SCI11ENDIAN_UINT16(inbuffer);
@@ -224,14 +225,15 @@ void GfxPicture::drawSci32Vga(int16 celNo, int16 drawX, int16 drawY, int16 pictu
 	cel_RlePos = READ_SCI11ENDIAN_UINT32(inbuffer + cel_headerPos + 24);
 	cel_LiteralPos = READ_SCI11ENDIAN_UINT32(inbuffer + cel_headerPos + 28);
 
-	drawCelData(inbuffer, size, cel_headerPos, cel_RlePos, cel_LiteralPos, drawX, drawY, pictureX, pictureY);
+	drawCelData(inbuffer, size, cel_headerPos, cel_RlePos, cel_LiteralPos, drawX, drawY, pictureX, pictureY, clipRects, clipRectCount);
 	cel_headerPos += 42;
 }
 #endif
 
 extern void unpackCelData(byte *inBuffer, byte *celBitmap, byte clearColor, int pixelCount, int rlePos, int literalPos, ViewType viewType, uint16 width, bool isMacSci11ViewData);
 
-void GfxPicture::drawCelData(byte *inbuffer, int size, int headerPos, int rlePos, int literalPos, int16 drawX, int16 drawY, int16 pictureX, int16 pictureY) {
+void GfxPicture::drawCelData(byte *inbuffer, int size, int headerPos, int rlePos, int literalPos, int16 drawX, int16 drawY, int16 pictureX, int16 pictureY,
+                             const Common::Rect *clipRects, uint clipRectCount) {
 	byte *celBitmap = NULL;
 	byte *ptr = NULL;
 	byte *headerPtr = inbuffer + headerPos;
@@ -243,7 +245,7 @@ void GfxPicture::drawCelData(byte *inbuffer, int size, int headerPos, int rlePos
 	byte clearColor;
 	bool compression = true;
 	byte curByte;
-	int16 y, lastY, x, leftX, rightX;
+	int16 y, lastY, x, leftX, rightX, topY;
 	int pixelCount;
 	uint16 width, height;
 
@@ -338,15 +340,11 @@ void GfxPicture::drawCelData(byte *inbuffer, int size, int headerPos, int rlePos
 	}
 
 	if (displayWidth > 0 && displayHeight > 0) {
-		y = displayArea.top + drawY;
-		lastY = MIN<int16>(height + y, displayArea.bottom);
+		topY = displayArea.top + drawY;
+		lastY = MIN<int16>(height + topY, displayArea.bottom);
 		leftX = displayArea.left + drawX;
 		rightX = MIN<int16>(displayWidth + leftX, displayArea.right);
 
-		uint16 sourcePixelSkipPerRow = 0;
-		if (width > rightX - leftX)
-			sourcePixelSkipPerRow = width - (rightX - leftX);
-
 		// Change clearcolor to white, if we dont add to an existing picture. That way we will paint everything on screen
 		// but white and that won't matter because the screen is supposed to be already white. It seems that most (if not all)
 		// SCI1.1 games use color 0 as transparency and SCI1 games use color 255 as transparency. Sierra SCI seems to paint
@@ -357,40 +355,25 @@ void GfxPicture::drawCelData(byte *inbuffer, int size, int headerPos, int rlePos
 
 		byte drawMask = priority > 15 ? GFX_SCREEN_MASK_VISUAL : GFX_SCREEN_MASK_VISUAL | GFX_SCREEN_MASK_PRIORITY;
 
-		ptr = celBitmap;
-		ptr += skipCelBitmapPixels;
-		ptr += skipCelBitmapLines * width;
-		if (!_mirroredFlag) {
-			// Draw bitmap to screen
-			x = leftX;
-			while (y < lastY) {
-				curByte = *ptr++;
-				if ((curByte != clearColor) && (priority >= _screen->getPriority(x, y)))
-					_screen->putPixel(x, y, drawMask, curByte, priority, 0);
-
-				x++;
-
-				if (x >= rightX) {
-					ptr += sourcePixelSkipPerRow;
-					x = leftX;
-					y++;
-				}
+		// Without clip rectangles, the whole bitmap is drawn
+		const uint rectCount = clipRects ? clipRectCount : 1;
+		for (uint i = 0; i < rectCount; i++) {
+			int16 top = topY, bottom = lastY, left = leftX, right = rightX;
+			if (clipRects) {
+				top = MAX<int16>(top, clipRects[i].top);
+				bottom = MIN<int16>(bottom, clipRects[i].bottom);
+				left = MAX<int16>(left, clipRects[i].left);
+				right = MIN<int16>(right, clipRects[i].right);
 			}
-		} else {
-			// Draw bitmap to screen (mirrored)
-			x = rightX - 1;
-			while (y < lastY) {
-				curByte = *ptr++;
-				if ((curByte != clearColor) && (priority >= _screen->getPriority(x, y)))
-					_screen->putPixel(x, y, drawMask, curByte, priority, 0);
-
-				if (x == leftX) {
-					ptr += sourcePixelSkipPerRow;
-					x = rightX;
-					y++;
-				}
 
-				x--;
+			for (y = top; y < bottom; y++) {
+				ptr = celBitmap + skipCelBitmapPixels + (skipCelBitmapLines + y - topY) * width;
+				for (x = left; x < right; x++) {
+					// Mirrored bitmaps are drawn from right to left
+					curByte = _mirroredFlag ? ptr[rightX - 1 - x] : ptr[x - leftX];
+					if ((curByte != clearColor) && (priority >= _screen->getPriority(x, y)))
+						_screen->putPixel(x, y, drawMask, curByte, priority, 0);
+				}
 			}
 		}
 	}
@@ -199,9 +199,48 @@ void GfxText32::disposeTextBitmap(reg_t hunkId) {
 	_segMan->freeHunkEntry(hunkId);
 }
 
-void GfxText32::drawTextBitmap(int16 x, int16 y, Common::Rect planeRect, reg_t textObject) {
+void GfxText32::drawTextBitmap(int16 x, int16 y, Common::Rect planeRect, reg_t textObject, const Common::Rect *clipRect) {
 	reg_t hunkId = readSelector(_segMan, textObject, SELECTOR(bitmap));
-	drawTextBitmapInternal(x, y, planeRect, textObject, hunkId);
+	drawTextBitmapInternal(x, y, planeRect, textObject, hunkId, clipRect);
+}
+
+bool GfxText32::getTextBitmapArea(int16 x, int16 y, Common::Rect planeRect, reg_t textObject, Common::Rect &area, uint32 &checksum) {
+	reg_t hunkId = readSelector(_segMan, textObject, SELECTOR(bitmap));
+	if (hunkId.isNull() || x < 0 || y < 0)
+		return false;
+
+	const byte *memoryPtr = _segMan->getHunkPointer(hunkId);
+	if (!memoryPtr)
+		return false;
+
+	// The same as in drawTextBitmapInternal()
+	uint16 textX = planeRect.left + x;
+	uint16 textY = planeRect.top + y;
+	uint16 width = READ_LE_UINT16(memoryPtr);
+	uint16 height = READ_LE_UINT16(memoryPtr + 2);
+
+	if (_screen->fontIsUpscaled()) {
+		textX = textX * _screen->getDisplayWidth() / _screen->getWidth();
+		textY = textY * _screen->getDisplayHeight() / _screen->getHeight();
+	}
+
+	area = Common::Rect(textX, textY, textX + width, textY + height);
+
+	// FNV-1a over the colors and the pixels
+	checksum = 2166136261u;
+	const uint16 colors[2] = {
+		readSelectorValue(_segMan, textObject, SELECTOR(back)),
+		readSelectorValue(_segMan, textObject, SELECTOR(skip))
+	};
+	const byte *colorBytes = (const byte *)colors;
+	for (uint i = 0; i < sizeof(colors); i++)
+		checksum = (checksum ^ colorBytes[i]) * 16777619u;
+
+	const byte *surface = memoryPtr + BITMAP_HEADER_SIZE;
+	for (uint i = 0; i < (uint)width * height; i++)
+		checksum = (checksum ^ surface[i]) * 16777619u;
+
+	return true;
 }
 
 void GfxText32::drawScrollTextBitmap(reg_t textObject, reg_t hunkId, uint16 x, uint16 y) {
@@ -218,7 +257,7 @@ void GfxText32::drawScrollTextBitmap(reg_t textObject, reg_t hunkId, uint16 x, u
 	drawTextBitmapInternal(0, 0, Common::Rect(20, 390, 600, 460), textObject, hunkId);
 }
 
-void GfxText32::drawTextBitmapInternal(int16 x, int16 y, Common::Rect planeRect, reg_t textObject, reg_t hunkId) {
+void GfxText32::drawTextBitmapInternal(int16 x, int16 y, Common::Rect planeRect, reg_t textObject, reg_t hunkId, const Common::Rect *clipRect) {
 	int16 backColor = (int16)readSelectorValue(_segMan, textObject, SELECTOR(back));
 	// Sanity check: Check if the hunk is set. If not, either the game scripts
 	// didn't set it, or an old saved game has been loaded, where it wasn't set.
@@ -256,8 +295,17 @@ void GfxText32::drawTextBitmapInternal(int16 x, int16 y, Common::Rect planeRect,
 
 	bool translucent = (skipColor == -1 && backColor == -1);
 
-	for (int curY = 0; curY < height; curY++) {
-		for (int curX = 0; curX < width; curX++) {
+	int firstX = 0, firstY = 0, lastX = width, lastY = height;
+	if (clipRect) {
+		firstX = MAX<int>(firstX, clipRect->left - textX);
+		firstY = MAX<int>(firstY, clipRect->top - textY);
+		lastX = MIN<int>(lastX, clipRect->right - textX);
+		lastY = MIN<int>(lastY, clipRect->bottom - textY);
+	}
+
+	for (int curY = firstY; curY < lastY; curY++) {
+		curByte = curY * width + firstX;
+		for (int curX = firstX; curX < lastX; curX++) {
 			byte pixel = surface[curByte++];
 			if ((!translucent && pixel != skipColor && pixel != backColor) ||
 				(translucent && pixel != 0xFF))
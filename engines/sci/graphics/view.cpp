@@ -31,7 +31,8 @@
 namespace Sci {
 
 GfxView::GfxView(ResourceManager *resMan, GfxScreen *screen, GfxPalette *palette, GuiResourceId resourceId)
-	: _resMan(resMan), _screen(screen), _palette(palette), _resourceId(resourceId) {
+	: _resMan(resMan), _screen(screen), _palette(palette), _resourceId(resourceId),
+	  _scaledCelCounter(0), _bitmapMemory(0) {
 	assert(resourceId != -1);
 	_coordAdjuster = g_sci->_gfxCoordAdjuster;
 	initData(resourceId);
@@ -48,6 +49,9 @@ GfxView::~GfxView() {
 	}
 	delete[] _loop;
 
+	for (uint i = 0; i < _scaledCels.size(); i++)
+		delete[] _scaledCels[i].bitmap;
+
 	_resMan->unlockResource(_resource);
 }
 
@@ -590,6 +594,7 @@ const byte *GfxView::getBitmap(int16 loopNo, int16 celNo) {
 	// allocating memory to store cel's bitmap
 	int pixelCount = width * height;
 	_loop[loopNo].cel[celNo].rawBitmap = new byte[pixelCount];
+	_bitmapMemory += pixelCount;
 	byte *pBitmap = _loop[loopNo].cel[celNo].rawBitmap;
 
 	// unpack the actual cel bitmap data
@@ -783,30 +788,76 @@ void GfxView::draw(const Common::Rect &rect, const Common::Rect &clipRect, const
 void GfxView::drawScaled(const Common::Rect &rect, const Common::Rect &clipRect, const Common::Rect &clipRectTranslated,
 			int16 loopNo, int16 celNo, byte priority, int16 scaleX, int16 scaleY) {
 	const Palette *palette = _embeddedPal ? &_viewPalette : &_palette->_sysPalette;
+	const CelInfo *celInfo = getCelInfo(loopNo, celNo);
+	const byte clearKey = celInfo->clearKey;
+	const byte drawMask = priority > 15 ? GFX_SCREEN_MASK_VISUAL : GFX_SCREEN_MASK_VISUAL|GFX_SCREEN_MASK_PRIORITY;
+
+	if (_embeddedPal)
+		// Merge view palette in...
+		_palette->set(&_viewPalette, false);
+
+	const ScaledCel &scaledCel = getScaledCel(loopNo, celNo, scaleX, scaleY);
+
+	const int16 offsetY = clipRect.top - rect.top;
+	const int16 offsetX = clipRect.left - rect.left;
+
+	// Happens in SQ6, first room
+	if (offsetX < 0 || offsetY < 0)
+		return;
+
+	int16 scaledWidth = CLIP<int16>((celInfo->width * scaleX) >> 7, 0, _screen->getWidth());
+	int16 scaledHeight = CLIP<int16>((celInfo->height * scaleY) >> 7, 0, _screen->getHeight());
+	scaledWidth = MIN<int16>(MIN(clipRect.width(), scaledWidth), scaledCel.width - offsetX);
+	scaledHeight = MIN<int16>(MIN(clipRect.height(), scaledHeight), scaledCel.height - offsetY);
+
+	for (int y = 0; y < scaledHeight; y++) {
+		const byte *scaledRow = scaledCel.bitmap + (y + offsetY) * scaledCel.width + offsetX;
+		for (int x = 0; x < scaledWidth; x++) {
+			const byte color = scaledRow[x];
+			const int x2 = clipRectTranslated.left + x;
+			const int y2 = clipRectTranslated.top + y;
+			if (color != clearKey && priority >= _screen->getPriority(x2, y2)) {
+				if (!_palette->isRemapped(palette->mapping[color])) {
+					_screen->putPixel(x2, y2, drawMask, palette->mapping[color], priority, 0);
+				} else {
+					byte remappedColor = _palette->remapColor(palette->mapping[color], _screen->getVisual(x2, y2));
+					_screen->putPixel(x2, y2, drawMask, remappedColor, priority, 0);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Returns a cel scaled to the given size, either from the scaled cels kept
+ * for the view, or by scaling it now and replacing the least recently used
+ * scaled cel by it.
+ */
+const GfxView::ScaledCel &GfxView::getScaledCel(int16 loopNo, int16 celNo, int16 scaleX, int16 scaleY) {
+	_scaledCelCounter++;
+
+	for (uint i = 0; i < _scaledCels.size(); i++) {
+		ScaledCel &cel = _scaledCels[i];
+		if (cel.loopNo == loopNo && cel.celNo == celNo && cel.scaleX == scaleX && cel.scaleY == scaleY) {
+			cel.lastUsed = _scaledCelCounter;
+			return cel;
+		}
+	}
+
 	const CelInfo *celInfo = getCelInfo(loopNo, celNo);
 	const byte *bitmap = getBitmap(loopNo, celNo);
 	const int16 celHeight = celInfo->height;
 	const int16 celWidth = celInfo->width;
-	const byte clearKey = celInfo->clearKey;
-	const byte drawMask = priority > 15 ? GFX_SCREEN_MASK_VISUAL : GFX_SCREEN_MASK_VISUAL|GFX_SCREEN_MASK_PRIORITY;
 	uint16 scalingX[640];
 	uint16 scalingY[480];
 	int16 scaledWidth, scaledHeight;
 	int pixelNo, scaledPixel, scaledPixelNo, prevScaledPixelNo;
 
-	if (_embeddedPal)
-		// Merge view palette in...
-		_palette->set(&_viewPalette, false);
-
 	scaledWidth = (celInfo->width * scaleX) >> 7;
 	scaledHeight = (celInfo->height * scaleY) >> 7;
 	scaledWidth = CLIP<int16>(scaledWidth, 0, _screen->getWidth());
 	scaledHeight = CLIP<int16>(scaledHeight, 0, _screen->getHeight());
 
-	// Do we really need to do this?!
-	//memset(scalingX, 0, sizeof(scalingX));
-	//memset(scalingY, 0, sizeof(scalingY));
-
 	// Create height scaling table
 	pixelNo = 0;
 	scaledPixel = scaledPixelNo = prevScaledPixelNo = 0;
@@ -822,6 +873,8 @@ void GfxView::drawScaled(const Common::Rect &rect, const Common::Rect &clipRect,
 	scaledPixelNo++;
 	for (; scaledPixelNo < scaledHeight; scaledPixelNo++)
 		scalingY[scaledPixelNo] = pixelNo;
+	// Rows which have been filled in, the scaled cel may extend past the scaled height
+	const int16 tableHeight = MAX<int>(prevScaledPixelNo, scaledPixelNo);
 
 	// Create width scaling table
 	pixelNo = 0;
@@ -838,34 +891,49 @@ void GfxView::drawScaled(const Common::Rect &rect, const Common::Rect &clipRect,
 	scaledPixelNo++;
 	for (; scaledPixelNo < scaledWidth; scaledPixelNo++)
 		scalingX[scaledPixelNo] = pixelNo;
+	const int16 tableWidth = MAX<int>(prevScaledPixelNo, scaledPixelNo);
 
-	scaledWidth = MIN(clipRect.width(), scaledWidth);
-	scaledHeight = MIN(clipRect.height(), scaledHeight);
+	ScaledCel *cel;
+	if (_scaledCels.size() < kMaxScaledCels) {
+		_scaledCels.push_back(ScaledCel());
+		cel = &_scaledCels.back();
+	} else {
+		cel = &_scaledCels[0];
+		for (uint i = 1; i < _scaledCels.size(); i++) {
+			if (_scaledCels[i].lastUsed < cel->lastUsed)
+				cel = &_scaledCels[i];
+		}
+		_bitmapMemory -= cel->width * cel->height;
+		delete[] cel->bitmap;
+	}
 
-	const int16 offsetY = clipRect.top - rect.top;
-	const int16 offsetX = clipRect.left - rect.left;
+	cel->loopNo = loopNo;
+	cel->celNo = celNo;
+	cel->scaleX = scaleX;
+	cel->scaleY = scaleY;
+	cel->width = tableWidth;
+	cel->height = tableHeight;
+	cel->bitmap = new byte[tableWidth * tableHeight];
+	cel->lastUsed = _scaledCelCounter;
+	_bitmapMemory += tableWidth * tableHeight;
+
+	byte *scaledBitmap = cel->bitmap;
+	for (int y = 0; y < tableHeight; y++) {
+		const byte *row = bitmap + scalingY[y] * celWidth;
+		for (int x = 0; x < tableWidth; x++)
+			*scaledBitmap++ = row[scalingX[x]];
+	}
 
-	// Happens in SQ6, first room
-	if (offsetX < 0 || offsetY < 0)
-		return;
+	return *cel;
+}
 
-	assert(scaledHeight + offsetY <= ARRAYSIZE(scalingY));
-	assert(scaledWidth + offsetX <= ARRAYSIZE(scalingX));
-	for (int y = 0; y < scaledHeight; y++) {
-		for (int x = 0; x < scaledWidth; x++) {
-			const byte color = bitmap[scalingY[y + offsetY] * celWidth + scalingX[x + offsetX]];
-			const int x2 = clipRectTranslated.left + x;
-			const int y2 = clipRectTranslated.top + y;
-			if (color != clearKey && priority >= _screen->getPriority(x2, y2)) {
-				if (!_palette->isRemapped(palette->mapping[color])) {
-					_screen->putPixel(x2, y2, drawMask, palette->mapping[color], priority, 0);
-				} else {
-					byte remappedColor = _palette->remapColor(palette->mapping[color], _screen->getVisual(x2, y2));
-					_screen->putPixel(x2, y2, drawMask, remappedColor, priority, 0);
-				}
-			}
-		}
-	}
+uint32 GfxView::getMemoryUsage() const {
+	uint32 memory = sizeof(GfxView) + _resourceSize + _bitmapMemory;
+	memory += _loopCount * sizeof(LoopInfo);
+	for (uint16 loopNo = 0; loopNo < _loopCount; loopNo++)
+		memory += _loop[loopNo].celCount * sizeof(CelInfo);
+	memory += _scaledCels.size() * sizeof(ScaledCel);
+	return memory;
 }
 
 void GfxView::adjustToUpscaledCoordinates(int16 &y, int16 &x) {
@@ -23,6 +23,8 @@
 #ifndef SCI_GRAPHICS_VIEW_H
 #define SCI_GRAPHICS_VIEW_H
 
+#include "common/array.h"
+
 namespace Sci {
 
 enum Sci32ViewNativeResolution {
@@ -87,7 +89,25 @@ public:
 
 	byte getColorAtCoordinate(int16 loopNo, int16 celNo, int16 x, int16 y);
 
+	/** Returns the number of bytes used by the view, including its resource and unpacked cels. */
+	uint32 getMemoryUsage() const;
+
 private:
+	/** A cel scaled to a particular size, kept as games usually draw the same scaled cel for many frames */
+	struct ScaledCel {
+		int16 loopNo, celNo;
+		int16 scaleX, scaleY;
+		int16 width, height;
+		byte *bitmap;
+		uint32 lastUsed;
+	};
+
+	enum {
+		kMaxScaledCels = 4
+	};
+
+	const ScaledCel &getScaledCel(int16 loopNo, int16 celNo, int16 scaleX, int16 scaleY);
+
 	void initData(GuiResourceId resourceId);
 	void unpackCel(int16 loopNo, int16 celNo, byte *outPtr, uint32 pixelCount);
 	void unditherBitmap(byte *bitmap, int16 width, int16 height, byte clearKey);
@@ -118,6 +138,11 @@ private:
 	// this is not set for some views in laura bow 2 floppy and signals that the view shall never get scaled
 	//  even if scaleX/Y are set (inside kAnimate)
 	bool _isScaleable;
+
+	Common::Array<ScaledCel> _scaledCels;
+	uint32 _scaledCelCounter;
+	/** bytes used by unpacked and scaled cels */
+	uint32 _bitmapMemory;
 };
 
 } // End of namespace Sci
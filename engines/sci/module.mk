@@ -83,6 +83,7 @@ MODULE_OBJS += \
 	engine/kgraphics32.o \
 	graphics/controls32.o \
 	graphics/frameout.o \
+	graphics/frameout_changes.o \
 	graphics/paint32.o \
 	graphics/text32.o \
 	video/robot_decoder.o
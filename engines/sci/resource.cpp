@@ -22,6 +22,7 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
@@ -188,6 +189,10 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_fileOffset = 0;
 	_status = kResStatusNoMalloc;
 	_lockers = 0;
+	_loadCost = 0;
+	_cachePriority = 0;
+	_cacheSequence = 0;
+	_cacheIndex = 0;
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
@@ -367,7 +372,18 @@ Common::SeekableReadStream *ResourceManager::getVolumeFile(ResourceSource *sourc
 }
 
 void ResourceManager::loadResource(Resource *res) {
+	res->_loadCost = 0;
 	res->_source->loadResource(this, res);
+
+	// Resources which weren't decompressed were read as they are. On top of
+	// that comes finding and opening the file, which is worth a few KB.
+	if (!res->_loadCost)
+		res->_loadCost = res->size;
+	res->_loadCost += 4096;
+
+	_cacheStats.misses++;
+	if (res->data)
+		_cacheStats.bytesLoaded += res->size;
 }
 
 
@@ -889,7 +905,11 @@ ResourceManager::ResourceManager() {
 void ResourceManager::init(bool initFromFallbackDetector) {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
+	_maxMemoryLRU = MAX_MEMORY;
 	_LRU.clear();
+	_cacheClock = 0;
+	_cacheSequence = 0;
+	resetCacheStats();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -941,6 +961,11 @@ void ResourceManager::init(bool initFromFallbackDetector) {
 
 	debugC(1, kDebugLevelResMan, "resMan: Detected %s", getSciVersionDesc(getSciVersion()));
 
+	if (getSciVersion() >= SCI_VERSION_2)
+		_maxMemoryLRU = MAX_MEMORY_SCI32;
+	if (ConfMan.hasKey("resource_cache") && ConfMan.getInt("resource_cache") > 0)
+		_maxMemoryLRU = ConfMan.getInt("resource_cache") * 1024;
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -987,12 +1012,64 @@ ResourceManager::~ResourceManager() {
 	}
 }
 
+// The resources under LRU control form a binary heap, with the one to be
+// freed next at the top. On a tie, the least recently used resource goes.
+bool ResourceManager::freeBefore(const Resource *a, const Resource *b) {
+	if (a->_cachePriority != b->_cachePriority)
+		return a->_cachePriority < b->_cachePriority;
+	return (int32)(a->_cacheSequence - b->_cacheSequence) < 0;
+}
+
+void ResourceManager::siftUpLRU(uint index) {
+	Resource *res = _LRU[index];
+	while (index > 0) {
+		const uint parent = (index - 1) / 2;
+		if (!freeBefore(res, _LRU[parent]))
+			break;
+		_LRU[index] = _LRU[parent];
+		_LRU[index]->_cacheIndex = index;
+		index = parent;
+	}
+	_LRU[index] = res;
+	res->_cacheIndex = index;
+}
+
+void ResourceManager::siftDownLRU(uint index) {
+	Resource *res = _LRU[index];
+	while (true) {
+		uint child = index * 2 + 1;
+		if (child >= _LRU.size())
+			break;
+		if (child + 1 < _LRU.size() && freeBefore(_LRU[child + 1], _LRU[child]))
+			child++;
+		if (!freeBefore(_LRU[child], res))
+			break;
+		_LRU[index] = _LRU[child];
+		_LRU[index]->_cacheIndex = index;
+		index = child;
+	}
+	_LRU[index] = res;
+	res->_cacheIndex = index;
+}
+
 void ResourceManager::removeFromLRU(Resource *res) {
 	if (res->_status != kResStatusEnqueued) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+
+	// Move the last resource into the gap, then restore the heap order
+	// from there
+	const uint index = res->_cacheIndex;
+	Resource *last = _LRU.back();
+	_LRU.pop_back();
+	if (last != res) {
+		_LRU[index] = last;
+		last->_cacheIndex = index;
+		siftUpLRU(index);
+		siftDownLRU(last->_cacheIndex);
+	}
+
 	_memoryLRU -= res->size;
 	res->_status = kResStatusAllocated;
 }
@@ -1002,7 +1079,12 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+	// Resources which are expensive to load for their size are kept longer,
+	// see freeOldResources()
+	res->_cachePriority = _cacheClock + res->_loadCost / MAX<uint32>(res->size / 16, 1);
+	res->_cacheSequence = _cacheSequence++;
+	_LRU.push_back(res);
+	siftUpLRU(_LRU.size() - 1);
 	_memoryLRU += res->size;
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s.%03d (%d bytes) to lru control: %d bytes total",
@@ -1015,30 +1097,53 @@ void ResourceManager::addToLRU(Resource *res) {
 void ResourceManager::printLRU() {
 	int mem = 0;
 	int entries = 0;
-	Common::List<Resource *>::iterator it = _LRU.begin();
-	Resource *res;
 
-	while (it != _LRU.end()) {
-		res = *it;
-		debug("\t%s: %d bytes", res->_id.toString().c_str(), res->size);
+	for (uint i = 0; i < _LRU.size(); ++i) {
+		Resource *res = _LRU[i];
+		debug("\t%s: %d bytes, priority %u", res->_id.toString().c_str(), res->size, res->_cachePriority - _cacheClock);
 		mem += res->size;
 		++entries;
-		++it;
 	}
 
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
+// This is the GreedyDual-Size policy: every resource gets a priority from
+// its load cost per byte when it is enqueued, and the one with the lowest
+// priority is freed first. The clock is raised to that priority, so
+// resources which are enqueued later start out higher, and those which
+// stay unused for long enough are freed no matter how expensive they are.
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
+	while (_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
-		Resource *goner = *_LRU.reverse_begin();
+
+		Resource *goner = _LRU.front();
+
+		_cacheClock = goner->_cachePriority;
+		_cacheStats.evictions++;
+		_cacheStats.bytesEvicted += goner->size;
+		debugC(2, kDebugLevelResMan, "resMan: Freeing %s (%d bytes)", goner->_id.toString().c_str(), goner->size);
+
 		removeFromLRU(goner);
 		goner->unalloc();
-#ifdef SCI_VERBOSE_RESMAN
-		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
-#endif
 	}
+
+	// Keep the priorities from overflowing. This doesn't change their
+	// order, so the heap stays as it is.
+	if (_cacheClock >= 0x40000000) {
+		for (uint i = 0; i < _LRU.size(); ++i)
+			_LRU[i]->_cachePriority -= _cacheClock;
+		_cacheClock = 0;
+	}
+}
+
+void ResourceManager::setCacheSize(int size) {
+	_maxMemoryLRU = size;
+	freeOldResources();
+}
+
+void ResourceManager::resetCacheStats() {
+	memset(&_cacheStats, 0, sizeof(_cacheStats));
 }
 
 Common::List<ResourceId> ResourceManager::listResources(ResourceType type, int mapNumber) {
@@ -1060,10 +1165,13 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+	} else {
+		_cacheStats.hits++;
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1964,6 +2072,25 @@ int Resource::readResourceInfo(ResVersion volVersion, Common::SeekableReadStream
 	return (compression == kCompUnknown) ? SCI_ERROR_UNKNOWN_COMPRESSION : SCI_ERROR_NONE;
 }
 
+/**
+ * Rough cost of unpacking a byte with the given compression method, compared
+ * to reading a byte from disk. Only used to weigh resources in the cache.
+ */
+static uint32 getDecompressionCost(ResourceCompression compression) {
+	switch (compression) {
+	case kCompNone:
+		return 0;
+	case kCompLZW1View:
+	case kCompLZW1Pic:
+		// Reordering the data afterwards costs about as much as the LZW part
+		return 4;
+	case kCompHuffman:
+		return 3;
+	default:
+		return 2;
+	}
+}
+
 int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file) {
 	int errorNum;
 	uint32 szPacked = 0;
@@ -2004,6 +2131,7 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 
 	data = new byte[size];
 	_status = kResStatusAllocated;
+	_loadCost = szPacked + size * getDecompressionCost(compression);
 	errorNum = data ? dec->unpack(file, data, szPacked, size) : SCI_ERROR_RESOURCE_TOO_BIG;
 	if (errorNum)
 		unalloc();
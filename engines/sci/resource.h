@@ -240,6 +240,10 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	uint32 _loadCost; /**< Estimated cost of loading the resource again, in bytes read */
+	uint32 _cachePriority; /**< Resources with the lowest priority are freed first */
+	uint32 _cacheSequence; /**< When the resource was enqueued, to free the least recently used first on a tie */
+	uint _cacheIndex; /**< Position in the LRU heap while enqueued */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -302,6 +306,29 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	/** Statistics about the cache of resources which are not locked */
+	struct CacheStats {
+		uint32 hits;         ///< Resources which were found in memory
+		uint32 misses;       ///< Resources which had to be loaded
+		uint32 evictions;    ///< Resources freed to stay within the budget
+		uint32 bytesLoaded;  ///< Size of the loaded resources
+		uint32 bytesEvicted; ///< Size of the freed resources
+	};
+
+	const CacheStats &getCacheStats() const { return _cacheStats; }
+	void resetCacheStats();
+
+	/** Amount of resource bytes in memory which are not locked */
+	int getCacheMemory() const { return _memoryLRU; }
+	/** Number of resources in memory which are not locked */
+	uint getCacheCount() const { return _LRU.size(); }
+	/** Amount of resource bytes in locked memory */
+	int getLockedMemory() const { return _memoryLocked; }
+
+	/** Maximum amount of resource bytes to keep in memory when not locked */
+	int getCacheSize() const { return _maxMemoryLRU; }
+	void setCacheSize(int size);
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -383,15 +410,21 @@ protected:
 	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
 	// for resources which are not explicitly locked. However, a warning will be
 	// issued whenever this limit is exceeded.
+	// The default can be overridden with the "resource_cache" setting, in KB.
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+		MAX_MEMORY = 256 * 1024,	// 256KB
+		MAX_MEMORY_SCI32 = 4 * 1024 * 1024	// 4MB, for hi-res views and pictures
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _maxMemoryLRU;	///< Amount of resource bytes allowed under LRU control
+	Common::Array<Resource *> _LRU; ///< Enqueued resources, a heap with the next one to free first
+	uint32 _cacheClock;	///< Priority of the last freed resource, see freeOldResources()
+	uint32 _cacheSequence;	///< Number of resources enqueued so far
+	CacheStats _cacheStats;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -511,6 +544,9 @@ protected:
 	void printLRU();
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
+	static bool freeBefore(const Resource *a, const Resource *b);
+	void siftUpLRU(uint index);
+	void siftDownLRU(uint index);
 
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
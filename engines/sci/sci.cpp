@@ -195,6 +195,7 @@ Common::Error SciEngine::run() {
 	ConfMan.registerDefault("native_fb01", "false");
 	ConfMan.registerDefault("windows_cursors", "false");	// Windows cursors for KQ6 Windows
 	ConfMan.registerDefault("silver_cursors", "false");	// Silver cursors for SQ4 CD
+	ConfMan.registerDefault("gc_incremental", "false");
 
 	_resMan = new ResourceManager();
 	assert(_resMan);
@@ -568,6 +569,7 @@ bool SciEngine::initGame() {
 
 	_gamestate->_msgState = new MessageState(_gamestate->_segMan);
 	_gamestate->gcCountDown = GC_INTERVAL - 1;
+	_gamestate->scriptGCIncremental = ConfMan.getBool("gc_incremental");
 
 	// Script 0 should always be at segment 1
 	if (script0Segment != 1) {
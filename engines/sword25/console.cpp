@@ -22,14 +22,111 @@
 
 #include "sword25/console.h"
 #include "sword25/sword25.h"
+#include "sword25/kernel/kernel.h"
+#include "sword25/script/luascript.h"
 
 namespace Sword25 {
 
 Sword25Console::Sword25Console(Sword25Engine *vm) : GUI::Debugger(), _vm(vm) {
 	assert(_vm);
+
+	DCmd_Register("lua_mem",     WRAP_METHOD(Sword25Console, Cmd_luaMem));
+	DCmd_Register("lua_gc",      WRAP_METHOD(Sword25Console, Cmd_luaGC));
+	DCmd_Register("lua_profile", WRAP_METHOD(Sword25Console, Cmd_luaProfile));
 }
 
 Sword25Console::~Sword25Console() {
 }
 
+static LuaScriptEngine *getLuaScript() {
+	return static_cast<LuaScriptEngine *>(Kernel::getInstance()->getScript());
+}
+
+/**
+ * Shows the memory statistics of the Lua state, optionally resetting them
+ */
+bool Sword25Console::Cmd_luaMem(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	LuaScriptEngine *script = getLuaScript();
+	const LuaMemoryStats &stats = script->getMemoryStats();
+	DebugPrintf("In use:          %u KB (peak %u KB)\n", stats.currentBytes >> 10, stats.peakBytes >> 10);
+	DebugPrintf("Allocated:       %u KB, max. %u KB per frame\n", (uint32)(stats.bytesAllocated >> 10), stats.maxFrameBytes >> 10);
+	DebugPrintf("Allocations:     %u\n", stats.allocations);
+	DebugPrintf("Reallocations:   %u\n", stats.reallocations);
+	DebugPrintf("Frees:           %u\n", stats.frees);
+	DebugPrintf("Frame GC steps:  %u, %u cycles finished\n", stats.gcSteps, stats.gcCycles);
+
+	if (argc == 2)
+		script->resetMemoryStats();
+	return true;
+}
+
+/**
+ * Shows or sets the garbage collector step budget per frame, and the
+ * pause and step multiplier of the collector
+ */
+bool Sword25Console::Cmd_luaGC(int argc, const char **argv) {
+	LuaScriptEngine *script = getLuaScript();
+
+	if (argc == 1) {
+		DebugPrintf("Step budget per frame: %u KB\n", script->getGCStepBudget());
+		DebugPrintf("Usage: %s budget <KB> | pause <percent> | stepmul <percent>\n", argv[0]);
+		return true;
+	}
+
+	if (argc != 3) {
+		DebugPrintf("Usage: %s budget <KB> | pause <percent> | stepmul <percent>\n", argv[0]);
+		return true;
+	}
+
+	const int value = atoi(argv[2]);
+	if (!strcmp(argv[1], "budget")) {
+		script->setGCStepBudget(MAX(value, 0));
+	} else if (!strcmp(argv[1], "pause")) {
+		DebugPrintf("Pause was %d%%\n", script->setGCPause(value));
+	} else if (!strcmp(argv[1], "stepmul")) {
+		DebugPrintf("Step multiplier was %d%%\n", script->setGCStepMultiplier(value));
+	} else {
+		DebugPrintf("Unknown setting '%s'\n", argv[1]);
+	}
+	return true;
+}
+
+/**
+ * Controls the sampling profiler of the Lua scripts, and lists the
+ * functions the scripts spent the most time in
+ */
+bool Sword25Console::Cmd_luaProfile(int argc, const char **argv) {
+	LuaScriptEngine *script = getLuaScript();
+
+	if (argc >= 2 && !strcmp(argv[1], "start")) {
+		const int interval = (argc >= 3) ? atoi(argv[2]) : 1000;
+		script->startProfiling(MAX(interval, 1));
+		DebugPrintf("Sampling every %d instructions\n", MAX(interval, 1));
+	} else if (argc == 2 && !strcmp(argv[1], "stop")) {
+		script->stopProfiling();
+	} else if (argc == 2 && !strcmp(argv[1], "reset")) {
+		script->resetProfile();
+	} else if (argc >= 2 && !strcmp(argv[1], "dump")) {
+		Common::Array<LuaProfileEntry> profile;
+		script->getProfile(profile);
+
+		uint32 total = 0;
+		for (uint i = 0; i < profile.size(); ++i)
+			total += profile[i].hits;
+
+		const uint count = MIN<uint>(profile.size(), (argc >= 3) ? atoi(argv[2]) : 20);
+		DebugPrintf("%u samples in %u functions%s\n", total, profile.size(), script->isProfiling() ? "" : " (stopped)");
+		for (uint i = 0; i < count; ++i)
+			DebugPrintf("%8u %5.1f%%  %s\n", profile[i].hits, 100.0 * profile[i].hits / total, profile[i].function.c_str());
+	} else {
+		DebugPrintf("Usage: %s start [interval] | stop | reset | dump [count]\n", argv[0]);
+	}
+	return true;
+}
+
 } // End of namespace Sword25
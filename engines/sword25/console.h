@@ -36,6 +36,10 @@ public:
 
 private:
 	Sword25Engine *_vm;
+
+	bool Cmd_luaMem(int argc, const char **argv);
+	bool Cmd_luaGC(int argc, const char **argv);
+	bool Cmd_luaProfile(int argc, const char **argv);
 };
 
 } // End of namespace Sword25
@@ -42,6 +42,7 @@
 #include "sword25/gfx/image/swimage.h"
 #include "sword25/gfx/image/vectorimage.h"
 #include "sword25/package/packagemanager.h"
+#include "sword25/script/script.h"
 #include "sword25/kernel/inputpersistenceblock.h"
 #include "sword25/kernel/outputpersistenceblock.h"
 
@@ -139,6 +140,8 @@ bool GraphicEngine::startFrame(bool updateAll) {
 }
 
 bool GraphicEngine::endFrame() {
+	Kernel::getInstance()->getScript()->endFrame();
+
 #ifndef THEORA_INDIRECT_RENDERING
 	if (Kernel::getInstance()->getFMV()->isMovieLoaded())
 		return true;
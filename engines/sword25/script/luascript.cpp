@@ -30,6 +30,8 @@
  */
 
 #include "common/array.h"
+#include "common/algorithm.h"
+#include "common/config-manager.h"
 #include "common/debug-channels.h"
 
 #include "sword25/sword25.h"
@@ -50,7 +52,11 @@ namespace Sword25 {
 LuaScriptEngine::LuaScriptEngine(Kernel *KernelPtr) :
 	ScriptEngine(KernelPtr),
 	_state(0),
-	_pcallErrorhandlerRegistryIndex(0) {
+	_pcallErrorhandlerRegistryIndex(0),
+	_gcStepBudget(0),
+	_debugHookMask(0),
+	_profileInterval(0) {
+	memset(&_memoryStats, 0, sizeof(_memoryStats));
 }
 
 LuaScriptEngine::~LuaScriptEngine() {
@@ -60,22 +66,72 @@ LuaScriptEngine::~LuaScriptEngine() {
 }
 
 namespace {
+// The least number of Kbytes which can be allocated during a frame before
+// the collector runs, with a step budget
+const uint kGCMinDeferral = 256;
+
 int panicCB(lua_State *L) {
 	error("Lua panic. Error message: %s", lua_isnil(L, -1) ? "" : lua_tostring(L, -1));
 	return 0;
 }
 
-void debugHook(lua_State *L, lua_Debug *ar) {
+}
+
+void *LuaScriptEngine::allocCB(void *ud, void *ptr, size_t osize, size_t nsize) {
+	LuaMemoryStats &stats = static_cast<LuaScriptEngine *>(ud)->_memoryStats;
+
+	if (nsize == 0) {
+		if (ptr) {
+			stats.frees++;
+			stats.currentBytes -= osize;
+		}
+		free(ptr);
+		return 0;
+	}
+
+	void *block = realloc(ptr, nsize);
+	if (!block)
+		return 0;
+
+	if (ptr)
+		stats.reallocations++;
+	else
+		stats.allocations++;
+
+	if (nsize > osize) {
+		stats.bytesAllocated += nsize - osize;
+		stats.frameBytes += nsize - osize;
+	}
+	stats.currentBytes = stats.currentBytes - osize + nsize;
+	stats.peakBytes = MAX(stats.peakBytes, stats.currentBytes);
+
+	return block;
+}
+
+void LuaScriptEngine::hookCB(lua_State *L, lua_Debug *ar) {
+	if (ar->event == LUA_HOOKCOUNT) {
+		// The allocator data is the script engine
+		void *ud;
+		lua_getallocf(L, &ud);
+		LuaScriptEngine *engine = static_cast<LuaScriptEngine *>(ud);
+
+		if (engine->_profileInterval && lua_getinfo(L, "S", ar))
+			engine->_profileHits[Common::String::format("%s:%d", ar->short_src, ar->linedefined)]++;
+		return;
+	}
+
 	if (!lua_getinfo(L, "Sn", ar))
 		return;
 
 	debug("LUA: %s %s: %s %d", ar->namewhat, ar->name, ar->short_src, ar->currentline);
 }
-}
 
 bool LuaScriptEngine::init() {
-	// Lua-State initialisation, as well as standard libaries initialisation
-	_state = luaL_newstate();
+	// Lua-State initialisation, as well as standard libaries initialisation.
+	// The allocations go through the engine, for the memory statistics.
+	_state = lua_newstate(allocCB, this);
+	if (_state)
+		lua_atpanic(_state, panicCB);
 	if (!_state || ! registerStandardLibs() || !registerStandardLibExtensions()) {
 		error("Lua could not be initialized.");
 		return false;
@@ -126,15 +182,104 @@ bool LuaScriptEngine::init() {
 		if ((gDebugLevel & 4) != 0)
 			mask |= LUA_MASKLINE;
 
-		if (mask != 0)
-			lua_sethook(_state, debugHook, mask, 0);
+		_debugHookMask = mask;
+		updateHook();
 	}
 
+	if (ConfMan.hasKey("lua_gc_step_budget"))
+		setGCStepBudget(ConfMan.getInt("lua_gc_step_budget"));
+
 	debugC(kDebugScript, "Lua initialized.");
 
 	return true;
 }
 
+void LuaScriptEngine::endFrame() {
+	if (_state && _gcStepBudget) {
+		// Do at least as much work as the incremental collector would
+		// have done for the allocations of the frame
+		const uint step = MAX<uint>(_gcStepBudget, _memoryStats.frameBytes >> 10);
+		if (lua_gc(_state, LUA_GCSTEP, step))
+			_memoryStats.gcCycles++;
+		_memoryStats.gcSteps++;
+
+		// Only let the collector interrupt the scripts during the next frame
+		// if they allocate far more than usual, e.g. while loading
+		lua_gc(_state, LUA_GCDEFER, MAX<uint>(4 * step, kGCMinDeferral));
+	}
+
+	_memoryStats.maxFrameBytes = MAX(_memoryStats.maxFrameBytes, _memoryStats.frameBytes);
+	_memoryStats.frameBytes = 0;
+}
+
+void LuaScriptEngine::setGCStepBudget(uint kilobytes) {
+	_gcStepBudget = kilobytes;
+
+	// Collection continues where it is, and is deferred again at the end
+	// of the frame
+	if (_state)
+		lua_gc(_state, LUA_GCRESTART, 0);
+}
+
+int LuaScriptEngine::setGCPause(int pause) {
+	return lua_gc(_state, LUA_GCSETPAUSE, pause);
+}
+
+int LuaScriptEngine::setGCStepMultiplier(int multiplier) {
+	return lua_gc(_state, LUA_GCSETSTEPMUL, multiplier);
+}
+
+void LuaScriptEngine::resetMemoryStats() {
+	const uint32 currentBytes = _memoryStats.currentBytes;
+	memset(&_memoryStats, 0, sizeof(_memoryStats));
+	_memoryStats.currentBytes = currentBytes;
+	_memoryStats.peakBytes = currentBytes;
+}
+
+void LuaScriptEngine::startProfiling(uint interval) {
+	assert(interval > 0);
+	_profileInterval = interval;
+	updateHook();
+}
+
+void LuaScriptEngine::stopProfiling() {
+	_profileInterval = 0;
+	updateHook();
+}
+
+namespace {
+bool compareProfileEntries(const LuaProfileEntry &a, const LuaProfileEntry &b) {
+	return a.hits > b.hits;
+}
+}
+
+void LuaScriptEngine::getProfile(Common::Array<LuaProfileEntry> &profile) const {
+	profile.clear();
+	for (ProfileMap::const_iterator it = _profileHits.begin(); it != _profileHits.end(); ++it) {
+		LuaProfileEntry entry;
+		entry.function = it->_key;
+		entry.hits = it->_value;
+		profile.push_back(entry);
+	}
+
+	Common::sort(profile.begin(), profile.end(), compareProfileEntries);
+}
+
+void LuaScriptEngine::resetProfile() {
+	_profileHits.clear();
+}
+
+void LuaScriptEngine::updateHook() {
+	int mask = _debugHookMask;
+	if (_profileInterval)
+		mask |= LUA_MASKCOUNT;
+
+	if (mask)
+		lua_sethook(_state, hookCB, mask, _profileInterval);
+	else
+		lua_sethook(_state, 0, 0, 0);
+}
+
 bool LuaScriptEngine::executeFile(const Common::String &fileName) {
 #ifdef DEBUG
 	int __startStackDepth = lua_gettop(_state);
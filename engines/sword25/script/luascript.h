@@ -32,17 +32,41 @@
 #ifndef SWORD25_LUASCRIPT_H
 #define SWORD25_LUASCRIPT_H
 
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/str.h"
 #include "common/str-array.h"
 #include "sword25/kernel/common.h"
 #include "sword25/script/script.h"
 
 struct lua_State;
+struct lua_Debug;
 
 namespace Sword25 {
 
 class Kernel;
 
+/** Memory allocation statistics of the Lua state */
+struct LuaMemoryStats {
+	uint32 allocations;		///< blocks allocated
+	uint32 reallocations;	///< blocks resized
+	uint32 frees;			///< blocks freed
+	uint64 bytesAllocated;	///< bytes requested by allocations and growing blocks
+	uint32 currentBytes;	///< bytes in use
+	uint32 peakBytes;		///< most bytes in use at a time
+	uint32 frameBytes;		///< bytes allocated since the end of the last frame
+	uint32 maxFrameBytes;	///< most bytes allocated during a frame
+	uint32 gcSteps;			///< garbage collector steps taken at the end of frames
+	uint32 gcCycles;		///< garbage collection cycles finished by these steps
+};
+
+/** The number of samples the profiler took in a Lua function */
+struct LuaProfileEntry {
+	Common::String function;	///< source file and line of the function
+	uint32 hits;
+};
+
 class LuaScriptEngine : public ScriptEngine {
 public:
 	LuaScriptEngine(Kernel *KernelPtr);
@@ -93,13 +117,65 @@ public:
 	 */
 	virtual bool unpersist(InputPersistenceBlock &reader);
 
+	/**
+	 * Runs the garbage collector for the frame, if a step budget is set.
+	 */
+	virtual void endFrame();
+
+	/**
+	 * Sets how much garbage collection work is done at the end of each
+	 * frame, in kilobytes of allocations, like LUA_GCSTEP.
+	 *
+	 * With a budget, the collector no longer interrupts scripts whenever
+	 * they allocate, but only runs between frames. The step grows to keep
+	 * up with the allocations of the frame, so memory use stays bounded.
+	 * A budget of 0 restores the normal incremental collection.
+	 */
+	void setGCStepBudget(uint kilobytes);
+	uint getGCStepBudget() const { return _gcStepBudget; }
+
+	/** Sets the pause of the collector, in percent, and returns the previous one. */
+	int setGCPause(int pause);
+	/** Sets the step multiplier of the collector, in percent, and returns the previous one. */
+	int setGCStepMultiplier(int multiplier);
+
+	const LuaMemoryStats &getMemoryStats() const { return _memoryStats; }
+	/** Resets the counters of the memory statistics, but not the bytes in use. */
+	void resetMemoryStats();
+
+	/**
+	 * Starts counting in which Lua functions the scripts spend their time,
+	 * by taking a sample every few virtual machine instructions. Only
+	 * coroutines created after this call are sampled.
+	 * @param interval      The number of instructions between samples
+	 */
+	void startProfiling(uint interval);
+	void stopProfiling();
+	bool isProfiling() const { return _profileInterval != 0; }
+	/** Returns the sampled functions, the most frequently hit first. */
+	void getProfile(Common::Array<LuaProfileEntry> &profile) const;
+	void resetProfile();
+
 private:
 	lua_State *_state;
 	int _pcallErrorhandlerRegistryIndex;
 
+	uint _gcStepBudget;
+	LuaMemoryStats _memoryStats;
+
+	/** The hooks needed for the script debug channel */
+	int _debugHookMask;
+	uint _profileInterval;
+	typedef Common::HashMap<Common::String, uint32> ProfileMap;
+	ProfileMap _profileHits;
+
 	bool registerStandardLibs();
 	bool registerStandardLibExtensions();
 	bool executeBuffer(const byte *data, uint size, const Common::String &name) const;
+	void updateHook();
+
+	static void *allocCB(void *ud, void *ptr, size_t osize, size_t nsize);
+	static void hookCB(lua_State *L, lua_Debug *ar);
 };
 
 } // End of namespace Sword25
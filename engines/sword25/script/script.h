@@ -86,6 +86,12 @@ public:
 
 	virtual bool persist(OutputPersistenceBlock &writer) = 0;
 	virtual bool unpersist(InputPersistenceBlock &reader) = 0;
+
+	/**
+	 * Called at the end of each frame, when the script engine can do
+	 * housekeeping without slowing down animations.
+	 */
+	virtual void endFrame() {}
 };
 
 } // End of namespace Sword25
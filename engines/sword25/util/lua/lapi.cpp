@@ -938,6 +938,14 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
       g->gcstepmul = data;
       break;
     }
+    case LUA_GCDEFER: {
+      /* Added in ScummVM: no automatic collection steps until another
+         'data' Kbytes have been allocated */
+      lu_mem threshold = g->totalbytes + (cast(lu_mem, data) << 10);
+      if (threshold > g->GCthreshold)
+        g->GCthreshold = threshold;
+      break;
+    }
     default: res = -1;  /* invalid option */
   }
   lua_unlock(L);
@@ -28,6 +28,7 @@
 
 
 #include "common/algorithm.h"
+#include "common/cpudetect.h"
 #include "common/endian.h"
 #include "common/util.h"
 #include "common/rect.h"
@@ -39,11 +40,26 @@
 
 //#define ENABLE_BILINEAR
 
+// The vector code relies on the little endian channel order
+#ifdef SCUMM_BIG_ENDIAN
+#undef SCUMMVM_NEON
+#endif
+
+#if defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#elif defined(SCUMMVM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace Wintermute {
 
 void doBlitOpaqueFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
 void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep);
 
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_NEON)
+struct ColorMod;
+#endif
+
 // These gather together various blendPixel functions for use with templates.
 
 class BlenderAdditive {
@@ -52,6 +68,13 @@ public:
 	inline void blendPixel(byte ina, byte inr, byte ing, byte inb, byte *outa, byte *outr, byte *outg, byte *outb, byte *ca, byte *cr, byte *cg, byte *cb);
 	inline void blendPixel(byte *in, byte *out);
 	inline void blendPixel(byte *in, byte *out, int colorMod);
+#if defined(SCUMMVM_SSE2)
+	inline __m128i blendPixels(__m128i in, __m128i out);
+	inline __m128i blendPixels(__m128i in, __m128i out, const ColorMod &mod);
+#elif defined(SCUMMVM_NEON)
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out);
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod);
+#endif
 };
 
 class BlenderSubtractive {
@@ -60,6 +83,13 @@ public:
 	inline void blendPixel(byte ina, byte inr, byte ing, byte inb, byte *outa, byte *outr, byte *outg, byte *outb, byte *ca, byte *cr, byte *cg, byte *cb);
 	inline void blendPixel(byte *in, byte *out);
 	inline void blendPixel(byte *in, byte *out, int colorMod);
+#if defined(SCUMMVM_SSE2)
+	inline __m128i blendPixels(__m128i in, __m128i out);
+	inline __m128i blendPixels(__m128i in, __m128i out, const ColorMod &mod);
+#elif defined(SCUMMVM_NEON)
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out);
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod);
+#endif
 };
 
 class BlenderNormal {
@@ -68,6 +98,13 @@ public:
 	inline void blendPixel(byte ina, byte inr, byte ing, byte inb, byte *outa, byte *outr, byte *outg, byte *outb, byte *ca, byte *cr, byte *cg, byte *cb);
 	inline void blendPixel(byte *in, byte *out);
 	inline void blendPixel(byte *in, byte *out, int colorMod);
+#if defined(SCUMMVM_SSE2)
+	inline __m128i blendPixels(__m128i in, __m128i out);
+	inline __m128i blendPixels(__m128i in, __m128i out, const ColorMod &mod);
+#elif defined(SCUMMVM_NEON)
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out);
+	inline uint16x8_t blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod);
+#endif
 };
 
 /**
@@ -421,6 +458,393 @@ void doBlit(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, in
 	}
 }
 
+/*
+ * The vector versions of doBlit() below produce exactly the same output as
+ * the blendPixel() functions. They work on four pixels at a time, which are
+ * widened to one 16 bit lane per channel and handled two pixels per vector.
+ *
+ * Colormod factors of 255 mean "no modulation" to the C code, which is the
+ * same as multiplying by 256 and shifting by 8 more bits. The factors are
+ * stored that way, so only subtractive blending still needs to tell those
+ * channels apart.
+ */
+
+#if defined(SCUMMVM_SSE2)
+
+#pragma mark --- SSE2 blending ---
+
+/**
+ * Colormod factors for two pixels, in 16 bit lanes.
+ */
+struct ColorMod {
+	ColorMod(uint32 color);
+
+	__m128i alpha;    ///< the alpha factor in every lane
+	__m128i channels; ///< the factor of each colour channel
+	__m128i raw;      ///< the factor of each colour channel as given
+	__m128i full;     ///< all bits set in the colour channels given as 255
+};
+
+ColorMod::ColorMod(uint32 color) {
+	int16 c[4], channelLanes[8], rawLanes[8], fullLanes[8];
+	c[TransparentSurface::kAIndex] = (color >> TransparentSurface::kAModShift) & 0xFF;
+	c[TransparentSurface::kRIndex] = (color >> TransparentSurface::kRModShift) & 0xFF;
+	c[TransparentSurface::kGIndex] = (color >> TransparentSurface::kGModShift) & 0xFF;
+	c[TransparentSurface::kBIndex] = (color >> TransparentSurface::kBModShift) & 0xFF;
+
+	for (int i = 0; i < 8; ++i) {
+		const bool isAlpha = (i & 3) == TransparentSurface::kAIndex;
+		channelLanes[i] = isAlpha ? 0 : (c[i & 3] == 255 ? 256 : c[i & 3]);
+		rawLanes[i] = isAlpha ? 0 : c[i & 3];
+		fullLanes[i] = (!isAlpha && c[i & 3] == 255) ? -1 : 0;
+	}
+
+	alpha = _mm_set1_epi16(c[TransparentSurface::kAIndex] == 255 ? 256 : c[TransparentSurface::kAIndex]);
+	channels = _mm_loadu_si128((const __m128i *)channelLanes);
+	raw = _mm_loadu_si128((const __m128i *)rawLanes);
+	full = _mm_loadu_si128((const __m128i *)fullLanes);
+}
+
+/** All bits set in the alpha lanes */
+static inline __m128i alphaLanesSSE2() {
+	const int a = TransparentSurface::kAIndex;
+	return _mm_set_epi16(a == 3 ? -1 : 0, a == 2 ? -1 : 0, a == 1 ? -1 : 0, a == 0 ? -1 : 0,
+	                     a == 3 ? -1 : 0, a == 2 ? -1 : 0, a == 1 ? -1 : 0, a == 0 ? -1 : 0);
+}
+
+/** The alpha value of each pixel, in all of its lanes */
+static inline __m128i broadcastAlphaSSE2(__m128i pixels) {
+	const int a = TransparentSurface::kAIndex;
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(a, a, a, a)), _MM_SHUFFLE(a, a, a, a));
+}
+
+static inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__m128i BlenderNormal::blendPixels(__m128i in, __m128i out) {
+	const __m128i c255 = _mm_set1_epi16(255);
+	const __m128i ina = broadcastAlphaSSE2(in);
+
+	__m128i result = _mm_add_epi16(_mm_mullo_epi16(in, ina), _mm_mullo_epi16(out, _mm_sub_epi16(c255, ina)));
+	result = _mm_or_si128(_mm_srli_epi16(result, 8), _mm_and_si128(alphaLanesSSE2(), c255));
+	result = selectSSE2(_mm_cmpeq_epi16(ina, c255), in, result);
+	return selectSSE2(_mm_cmpeq_epi16(ina, _mm_setzero_si128()), out, result);
+}
+
+__m128i BlenderNormal::blendPixels(__m128i in, __m128i out, const ColorMod &mod) {
+	const __m128i c255 = _mm_set1_epi16(255);
+	const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlphaSSE2(in), mod.alpha), 8);
+	const __m128i modulated = _mm_mullo_epi16(in, mod.channels);
+
+	__m128i result = _mm_srli_epi16(_mm_mullo_epi16(out, _mm_sub_epi16(c255, ina)), 8);
+	result = _mm_add_epi16(result, _mm_mulhi_epu16(modulated, ina));
+	result = selectSSE2(_mm_cmpeq_epi16(ina, c255), _mm_srli_epi16(modulated, 8), result);
+	result = _mm_or_si128(result, _mm_and_si128(alphaLanesSSE2(), c255));
+	return selectSSE2(_mm_cmpeq_epi16(ina, _mm_setzero_si128()), out, result);
+}
+
+__m128i BlenderAdditive::blendPixels(__m128i in, __m128i out) {
+	__m128i ina = broadcastAlphaSSE2(in);
+	ina = _mm_sub_epi16(ina, _mm_cmpeq_epi16(ina, _mm_set1_epi16(255)));
+
+	const __m128i add = _mm_andnot_si128(alphaLanesSSE2(), _mm_srli_epi16(_mm_mullo_epi16(in, ina), 8));
+	return _mm_min_epi16(_mm_add_epi16(out, add), _mm_set1_epi16(255));
+}
+
+__m128i BlenderAdditive::blendPixels(__m128i in, __m128i out, const ColorMod &mod) {
+	const __m128i ina = _mm_srli_epi16(_mm_mullo_epi16(broadcastAlphaSSE2(in), mod.alpha), 8);
+
+	const __m128i add = _mm_andnot_si128(alphaLanesSSE2(), _mm_mulhi_epu16(_mm_mullo_epi16(in, mod.channels), ina));
+	return _mm_min_epi16(_mm_add_epi16(out, add), _mm_set1_epi16(255));
+}
+
+__m128i BlenderSubtractive::blendPixels(__m128i in, __m128i out) {
+	__m128i ina = broadcastAlphaSSE2(in);
+	ina = _mm_sub_epi16(ina, _mm_cmpeq_epi16(ina, _mm_set1_epi16(255)));
+
+	const __m128i sub = _mm_andnot_si128(alphaLanesSSE2(), _mm_mulhi_epu16(_mm_mullo_epi16(in, out), ina));
+	return _mm_sub_epi16(out, sub);
+}
+
+__m128i BlenderSubtractive::blendPixels(__m128i in, __m128i out, const ColorMod &mod) {
+	const __m128i ina = broadcastAlphaSSE2(in);
+
+	// Unmodulated channels
+	const __m128i sub = _mm_mulhi_epu16(_mm_mullo_epi16(in, out), ina);
+
+	// The C code overflows the signed 32 bit product of the modulated
+	// channels, so do the same
+	const __m128i a = _mm_mullo_epi16(in, mod.raw);
+	const __m128i b = _mm_mullo_epi16(out, ina);
+	const __m128i lo = _mm_mullo_epi16(a, b);
+	const __m128i hi = _mm_mulhi_epu16(a, b);
+	const __m128i subModulated = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 24),
+	                                             _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 24));
+
+	__m128i result = selectSSE2(mod.full, _mm_sub_epi16(out, sub),
+	                            _mm_and_si128(_mm_sub_epi16(out, subModulated), _mm_set1_epi16(0xFF)));
+	return selectSSE2(alphaLanesSSE2(), out, result);
+}
+
+/**
+ * Loads four pixels in the order they are drawn in, that is, from right
+ * to left if the image is flipped horizontally.
+ */
+static inline __m128i loadPixelsSSE2(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return _mm_loadu_si128((const __m128i *)in);
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+template<class Blender, bool colorMod>
+void doBlitVector(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	Blender b;
+	const ColorMod mod(color);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(0xFF << TransparentSurface::kAShift);
+
+	for (uint32 i = 0; i < height; i++) {
+		byte *in = ino;
+		byte *out = outo;
+		for (uint32 j = 0; j < width; j += 4) {
+			const __m128i src = loadPixelsSSE2(in, inStep);
+
+			// Fully transparent pixels are left alone by all blenders
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(src, alphaMask), zero)) != 0xFFFF) {
+				const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+				__m128i lo, hi;
+				if (colorMod) {
+					lo = b.blendPixels(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero), mod);
+					hi = b.blendPixels(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero), mod);
+				} else {
+					lo = b.blendPixels(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+					hi = b.blendPixels(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+				}
+				_mm_storeu_si128((__m128i *)out, _mm_packus_epi16(lo, hi));
+			}
+
+			in += 4 * inStep;
+			out += 16;
+		}
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+#elif defined(SCUMMVM_NEON)
+
+#pragma mark --- NEON blending ---
+
+/**
+ * Colormod factors for two pixels, in 16 bit lanes.
+ */
+struct ColorMod {
+	ColorMod(uint32 color);
+
+	uint16x8_t alpha;    ///< the alpha factor in every lane
+	uint16x8_t channels; ///< the factor of each colour channel
+	uint16x8_t raw;      ///< the factor of each colour channel as given
+	uint16x8_t full;     ///< all bits set in the colour channels given as 255
+};
+
+ColorMod::ColorMod(uint32 color) {
+	uint16 c[4], channelLanes[8], rawLanes[8], fullLanes[8];
+	c[TransparentSurface::kAIndex] = (color >> TransparentSurface::kAModShift) & 0xFF;
+	c[TransparentSurface::kRIndex] = (color >> TransparentSurface::kRModShift) & 0xFF;
+	c[TransparentSurface::kGIndex] = (color >> TransparentSurface::kGModShift) & 0xFF;
+	c[TransparentSurface::kBIndex] = (color >> TransparentSurface::kBModShift) & 0xFF;
+
+	for (int i = 0; i < 8; ++i) {
+		const bool isAlpha = (i & 3) == TransparentSurface::kAIndex;
+		channelLanes[i] = isAlpha ? 0 : (c[i & 3] == 255 ? 256 : c[i & 3]);
+		rawLanes[i] = isAlpha ? 0 : c[i & 3];
+		fullLanes[i] = (!isAlpha && c[i & 3] == 255) ? 0xFFFF : 0;
+	}
+
+	alpha = vdupq_n_u16(c[TransparentSurface::kAIndex] == 255 ? 256 : c[TransparentSurface::kAIndex]);
+	channels = vld1q_u16(channelLanes);
+	raw = vld1q_u16(rawLanes);
+	full = vld1q_u16(fullLanes);
+}
+
+/** All bits set in the alpha lanes */
+static inline uint16x8_t alphaLanesNEON() {
+	uint16 lanes[8];
+	for (int i = 0; i < 8; ++i)
+		lanes[i] = ((i & 3) == TransparentSurface::kAIndex) ? 0xFFFF : 0;
+	return vld1q_u16(lanes);
+}
+
+/** The alpha value of each pixel, in all of its lanes */
+static inline uint16x8_t broadcastAlphaNEON(uint16x8_t pixels) {
+	return vcombine_u16(vdup_lane_u16(vget_low_u16(pixels), TransparentSurface::kAIndex),
+	                    vdup_lane_u16(vget_high_u16(pixels), TransparentSurface::kAIndex));
+}
+
+/** The high 16 bits of the products of a and b */
+static inline uint16x8_t mulHiNEON(uint16x8_t a, uint16x8_t b) {
+	return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)), 16),
+	                    vshrn_n_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)), 16));
+}
+
+uint16x8_t BlenderNormal::blendPixels(uint16x8_t in, uint16x8_t out) {
+	const uint16x8_t c255 = vdupq_n_u16(255);
+	const uint16x8_t ina = broadcastAlphaNEON(in);
+
+	uint16x8_t result = vmlaq_u16(vmulq_u16(in, ina), out, vsubq_u16(c255, ina));
+	result = vorrq_u16(vshrq_n_u16(result, 8), vandq_u16(alphaLanesNEON(), c255));
+	result = vbslq_u16(vceqq_u16(ina, c255), in, result);
+	return vbslq_u16(vceqq_u16(ina, vdupq_n_u16(0)), out, result);
+}
+
+uint16x8_t BlenderNormal::blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod) {
+	const uint16x8_t c255 = vdupq_n_u16(255);
+	const uint16x8_t ina = vshrq_n_u16(vmulq_u16(broadcastAlphaNEON(in), mod.alpha), 8);
+	const uint16x8_t modulated = vmulq_u16(in, mod.channels);
+
+	uint16x8_t result = vshrq_n_u16(vmulq_u16(out, vsubq_u16(c255, ina)), 8);
+	result = vaddq_u16(result, mulHiNEON(modulated, ina));
+	result = vbslq_u16(vceqq_u16(ina, c255), vshrq_n_u16(modulated, 8), result);
+	result = vorrq_u16(result, vandq_u16(alphaLanesNEON(), c255));
+	return vbslq_u16(vceqq_u16(ina, vdupq_n_u16(0)), out, result);
+}
+
+uint16x8_t BlenderAdditive::blendPixels(uint16x8_t in, uint16x8_t out) {
+	uint16x8_t ina = broadcastAlphaNEON(in);
+	ina = vsubq_u16(ina, vceqq_u16(ina, vdupq_n_u16(255)));
+
+	const uint16x8_t add = vbicq_u16(vshrq_n_u16(vmulq_u16(in, ina), 8), alphaLanesNEON());
+	return vminq_u16(vaddq_u16(out, add), vdupq_n_u16(255));
+}
+
+uint16x8_t BlenderAdditive::blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod) {
+	const uint16x8_t ina = vshrq_n_u16(vmulq_u16(broadcastAlphaNEON(in), mod.alpha), 8);
+
+	const uint16x8_t add = vbicq_u16(mulHiNEON(vmulq_u16(in, mod.channels), ina), alphaLanesNEON());
+	return vminq_u16(vaddq_u16(out, add), vdupq_n_u16(255));
+}
+
+uint16x8_t BlenderSubtractive::blendPixels(uint16x8_t in, uint16x8_t out) {
+	uint16x8_t ina = broadcastAlphaNEON(in);
+	ina = vsubq_u16(ina, vceqq_u16(ina, vdupq_n_u16(255)));
+
+	const uint16x8_t sub = vbicq_u16(mulHiNEON(vmulq_u16(in, out), ina), alphaLanesNEON());
+	return vsubq_u16(out, sub);
+}
+
+uint16x8_t BlenderSubtractive::blendPixels(uint16x8_t in, uint16x8_t out, const ColorMod &mod) {
+	const uint16x8_t ina = broadcastAlphaNEON(in);
+
+	// Unmodulated channels
+	const uint16x8_t sub = mulHiNEON(vmulq_u16(in, out), ina);
+
+	// The C code overflows the signed 32 bit product of the modulated
+	// channels, so do the same
+	const uint16x8_t a = vmulq_u16(in, mod.raw);
+	const uint16x8_t b = vmulq_u16(out, ina);
+	const int32x4_t lo = vreinterpretq_s32_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)));
+	const int32x4_t hi = vreinterpretq_s32_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)));
+	const uint16x8_t subModulated = vreinterpretq_u16_s16(vcombine_s16(vmovn_s32(vshrq_n_s32(lo, 24)), vmovn_s32(vshrq_n_s32(hi, 24))));
+
+	uint16x8_t result = vbslq_u16(mod.full, vsubq_u16(out, sub),
+	                              vandq_u16(vsubq_u16(out, subModulated), vdupq_n_u16(0xFF)));
+	return vbslq_u16(alphaLanesNEON(), out, result);
+}
+
+/**
+ * Loads four pixels in the order they are drawn in, that is, from right
+ * to left if the image is flipped horizontally.
+ */
+static inline uint8x16_t loadPixelsNEON(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return vld1q_u8(in);
+	const uint32x4_t pixels = vrev64q_u32(vreinterpretq_u32_u8(vld1q_u8(in - 12)));
+	return vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(pixels), vget_low_u32(pixels)));
+}
+
+template<class Blender, bool colorMod>
+void doBlitVector(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	Blender b;
+	const ColorMod mod(color);
+	const uint32x4_t alphaMask = vdupq_n_u32(0xFF << TransparentSurface::kAShift);
+
+	for (uint32 i = 0; i < height; i++) {
+		byte *in = ino;
+		byte *out = outo;
+		for (uint32 j = 0; j < width; j += 4) {
+			const uint8x16_t src = loadPixelsNEON(in, inStep);
+
+			// Fully transparent pixels are left alone by all blenders
+			const uint32x4_t alpha = vandq_u32(vreinterpretq_u32_u8(src), alphaMask);
+			const uint32x2_t anyAlpha = vorr_u32(vget_low_u32(alpha), vget_high_u32(alpha));
+			if (vget_lane_u32(anyAlpha, 0) | vget_lane_u32(anyAlpha, 1)) {
+				const uint8x16_t dst = vld1q_u8(out);
+				uint16x8_t lo, hi;
+				if (colorMod) {
+					lo = b.blendPixels(vmovl_u8(vget_low_u8(src)), vmovl_u8(vget_low_u8(dst)), mod);
+					hi = b.blendPixels(vmovl_u8(vget_high_u8(src)), vmovl_u8(vget_high_u8(dst)), mod);
+				} else {
+					lo = b.blendPixels(vmovl_u8(vget_low_u8(src)), vmovl_u8(vget_low_u8(dst)));
+					hi = b.blendPixels(vmovl_u8(vget_high_u8(src)), vmovl_u8(vget_high_u8(dst)));
+				}
+				vst1q_u8(out, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+			}
+
+			in += 4 * inStep;
+			out += 16;
+		}
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+#endif
+
+#pragma mark -
+
+/**
+ * Blits as many whole groups of four pixels per row as possible with the
+ * vector code, if the CPU supports it.
+ *
+ * @return the number of columns done, the rest is left to doBlit()
+ */
+static uint32 doBlitVectorized(TSpriteBlendMode blendMode, byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_NEON)
+#if defined(SCUMMVM_SSE2)
+	if (!Common::hasCpuFeature(Common::kCpuFeatureSSE2))
+		return 0;
+#else
+	if (!Common::hasCpuFeature(Common::kCpuFeatureNEON))
+		return 0;
+#endif
+
+	width &= ~3;
+	if (width == 0)
+		return 0;
+
+	if (color == 0xffffffff) {
+		if (blendMode == BLEND_ADDITIVE)
+			doBlitVector<BlenderAdditive, false>(ino, outo, width, height, pitch, inStep, inoStep, color);
+		else if (blendMode == BLEND_SUBTRACTIVE)
+			doBlitVector<BlenderSubtractive, false>(ino, outo, width, height, pitch, inStep, inoStep, color);
+		else
+			doBlitVector<BlenderNormal, false>(ino, outo, width, height, pitch, inStep, inoStep, color);
+	} else {
+		if (blendMode == BLEND_ADDITIVE)
+			doBlitVector<BlenderAdditive, true>(ino, outo, width, height, pitch, inStep, inoStep, color);
+		else if (blendMode == BLEND_SUBTRACTIVE)
+			doBlitVector<BlenderSubtractive, true>(ino, outo, width, height, pitch, inStep, inoStep, color);
+		else
+			doBlitVector<BlenderNormal, true>(ino, outo, width, height, pitch, inStep, inoStep, color);
+	}
+
+	return width;
+#else
+	return 0;
+#endif
+}
+
 Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, TSpriteBlendMode blendMode) {
 
 	Common::Rect retSize;
@@ -528,13 +952,20 @@ Common::Rect TransparentSurface::blit(Graphics::Surface &target, int posX, int p
 		} else if (color == 0xFFFFFF && blendMode == BLEND_NORMAL && _alphaMode == ALPHA_BINARY) {
 			doBlitBinaryFast(ino, outo, img->w, img->h, target.pitch, inStep, inoStep);
 		} else {
-			if (blendMode == BLEND_ADDITIVE) {
-				doBlit<BlenderAdditive>(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
+			const uint32 done = doBlitVectorized(blendMode, ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
+			const uint32 rest = img->w - done;
+			ino += (int32)done * inStep;
+			outo += done * 4;
+
+			if (rest == 0) {
+				// Nothing left
+			} else if (blendMode == BLEND_ADDITIVE) {
+				doBlit<BlenderAdditive>(ino, outo, rest, img->h, target.pitch, inStep, inoStep, color);
 			} else if (blendMode == BLEND_SUBTRACTIVE) {
-				doBlit<BlenderSubtractive>(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
+				doBlit<BlenderSubtractive>(ino, outo, rest, img->h, target.pitch, inStep, inoStep, color);
 			} else {
 				assert(blendMode == BLEND_NORMAL);
-				doBlit<BlenderNormal>(ino, outo, img->w, img->h, target.pitch, inStep, inoStep, color);
+				doBlit<BlenderNormal>(ino, outo, rest, img->h, target.pitch, inStep, inoStep, color);
 			}
 		}
 
@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "graphics/dirtyregion.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Graphics {
+
+DirtyRegion::DirtyRegion(int tileWidth, int tileHeight)
+	: _tileWidth(tileWidth), _tileHeight(tileHeight), _width(0), _height(0),
+	  _columns(0), _rows(0), _firstRow(0), _lastRow(-1), _full(false) {
+	assert(tileWidth > 0 && tileHeight > 0);
+}
+
+void DirtyRegion::setSize(int width, int height) {
+	_width = MAX(width, 0);
+	_height = MAX(height, 0);
+	_columns = (_width + _tileWidth - 1) / _tileWidth;
+	_rows = (_height + _tileHeight - 1) / _tileHeight;
+
+	_tiles.resize(_columns * _rows);
+	if (!_tiles.empty())
+		memset(&_tiles[0], 0, _tiles.size());
+
+	// A row can't have more runs than every other tile being dirty
+	_open.resize((_columns + 1) / 2);
+	_runs.resize((_columns + 1) / 2);
+
+	_firstRow = _rows;
+	_lastRow = -1;
+	_full = false;
+}
+
+void DirtyRegion::add(const Common::Rect &rect) {
+	if (_full || !rect.isValidRect())
+		return;
+
+	Common::Rect r(rect);
+	r.clip(Common::Rect(0, 0, _width, _height));
+	if (r.isEmpty())
+		return;
+
+	const int left = r.left / _tileWidth;
+	const int right = (r.right - 1) / _tileWidth;
+	const int top = r.top / _tileHeight;
+	const int bottom = (r.bottom - 1) / _tileHeight;
+
+	for (int row = top; row <= bottom; ++row)
+		memset(&_tiles[row * _columns + left], 1, right - left + 1);
+
+	_firstRow = MIN(_firstRow, top);
+	_lastRow = MAX(_lastRow, bottom);
+}
+
+void DirtyRegion::addAll() {
+	if (_width > 0 && _height > 0)
+		_full = true;
+}
+
+void DirtyRegion::clear() {
+	if (_firstRow <= _lastRow)
+		memset(&_tiles[_firstRow * _columns], 0, (_lastRow - _firstRow + 1) * _columns);
+
+	_firstRow = _rows;
+	_lastRow = -1;
+	_full = false;
+}
+
+uint DirtyRegion::getRects(Common::Rect *rects, uint maxRects) const {
+	assert(maxRects > 0);
+
+	if (_full) {
+		rects[0] = Common::Rect(0, 0, _width, _height);
+		return 1;
+	}
+
+	if (isEmpty())
+		return 0;
+
+	// First try to keep the shape of the region, then make do with one
+	// span per row
+	uint count = mergeRuns(rects, maxRects, false);
+	if (count <= maxRects)
+		return count;
+
+	count = mergeRuns(rects, maxRects, true);
+	if (count <= maxRects)
+		return count;
+
+	int left = _columns, right = 0;
+	for (int row = _firstRow; row <= _lastRow; ++row) {
+		if (findRuns(row, true)) {
+			left = MIN(left, _runs[0].left);
+			right = MAX(right, _runs[0].right);
+		}
+	}
+
+	rects[0] = toPixels(left, _firstRow, right, _lastRow + 1);
+	return 1;
+}
+
+/*
+ * Find the runs of dirty tiles in a row, sorted from left to right, and
+ * return their number. If bounds is true, find a single run from the
+ * first to the last dirty tile instead.
+ */
+uint DirtyRegion::findRuns(int row, bool bounds) const {
+	const byte *tiles = &_tiles[row * _columns];
+	uint count = 0;
+	int column = 0;
+
+	while (column < _columns) {
+		while (column < _columns && !tiles[column])
+			column++;
+		if (column == _columns)
+			break;
+
+		const int left = column;
+		while (column < _columns && tiles[column])
+			column++;
+
+		if (bounds && count > 0) {
+			_runs[0].right = column;
+		} else {
+			_runs[count].left = left;
+			_runs[count].right = column;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/*
+ * Turn the region into rectangles, by growing rectangles downwards for
+ * as long as the next row has a run with exactly the same extent.
+ * Returns maxRects + 1 if there would be too many rectangles.
+ */
+uint DirtyRegion::mergeRuns(Common::Rect *rects, uint maxRects, bool bounds) const {
+	uint count = 0;
+	uint numOpen = 0;
+
+	for (int row = _firstRow; row <= _lastRow + 1; ++row) {
+		const uint numRuns = (row <= _lastRow) ? findRuns(row, bounds) : 0;
+
+		// Both lists are sorted, so walk them side by side. Rectangles
+		// without a continuation in this row are done.
+		uint run = 0;
+		for (uint open = 0; open < numOpen; ++open) {
+			const Span &span = _open[open];
+			while (run < numRuns && _runs[run].left < span.left)
+				_runs[run++].top = row;
+
+			if (run < numRuns && _runs[run].left == span.left && _runs[run].right == span.right) {
+				_runs[run++].top = span.top;
+			} else {
+				if (count == maxRects)
+					return maxRects + 1;
+				rects[count++] = toPixels(span.left, span.top, span.right, row);
+			}
+		}
+		while (run < numRuns)
+			_runs[run++].top = row;
+
+		for (uint i = 0; i < numRuns; ++i)
+			_open[i] = _runs[i];
+		numOpen = numRuns;
+	}
+
+	return count;
+}
+
+Common::Rect DirtyRegion::toPixels(int left, int top, int right, int bottom) const {
+	return Common::Rect(left * _tileWidth, top * _tileHeight,
+	                    MIN(right * _tileWidth, _width), MIN(bottom * _tileHeight, _height));
+}
+
+} // End of namespace Graphics
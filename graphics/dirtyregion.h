@@ -0,0 +1,100 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GRAPHICS_DIRTYREGION_H
+#define GRAPHICS_DIRTYREGION_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * Keeps track of the parts of a surface which need to be redrawn, on a
+ * grid of tiles.
+ *
+ * Rectangles added to the region mark the tiles they touch. When the
+ * region is turned into a list of rectangles again, overlapping and
+ * adjacent rectangles come out merged, so an area which is drawn to
+ * many times is still only redrawn once, and the length of the list does
+ * not depend on the number of rectangles added. The price is that the
+ * rectangles are rounded up to tile boundaries.
+ */
+class DirtyRegion {
+public:
+	DirtyRegion(int tileWidth = 8, int tileHeight = 8);
+
+	/** Set the size of the surface, which also clears the region. */
+	void setSize(int width, int height);
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+
+	/** Mark a rectangle as dirty. It is clipped to the surface. */
+	void add(const Common::Rect &rect);
+
+	/** Mark the whole surface as dirty. */
+	void addAll();
+
+	/** Mark the whole surface as clean. */
+	void clear();
+
+	bool isEmpty() const { return !_full && _firstRow > _lastRow; }
+
+	/**
+	 * Get non-overlapping rectangles which cover all dirty tiles,
+	 * clipped to the surface.
+	 *
+	 * If more than @p maxRects rectangles would be needed, fewer but
+	 * larger ones are returned, down to the bounding box of the region.
+	 *
+	 * @return the number of rectangles stored in @p rects
+	 */
+	uint getRects(Common::Rect *rects, uint maxRects) const;
+
+private:
+	/** A run of dirty tiles in a row, or a rectangle of tiles while it grows downwards. */
+	struct Span {
+		int left, right;
+		int top;
+	};
+
+	const int _tileWidth, _tileHeight;
+	int _width, _height;
+	int _columns, _rows;
+
+	/** one byte per tile, non-zero if dirty */
+	Common::Array<byte> _tiles;
+	/** rows which contain dirty tiles */
+	int _firstRow, _lastRow;
+	bool _full;
+
+	/** scratch space for getRects() */
+	mutable Common::Array<Span> _open, _runs;
+
+	uint findRuns(int row, bool bounds) const;
+	uint mergeRuns(Common::Rect *rects, uint maxRects, bool bounds) const;
+	Common::Rect toPixels(int left, int top, int right, int bottom) const;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -22,12 +22,24 @@
 
 #include "graphics/scaler/intern.h"
 #include "graphics/scaler/scalebit.h"
+#include "graphics/scaler/scale3x.h"
+#include "common/cpudetect.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
+#if defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#endif
+
 int gBitFormat = 565;
 
+/**
+ * Whether the scalers use their SSE2 versions. This is decided by
+ * InitScalers(), so that the scalers don't have to check for every frame.
+ */
+static bool g_scalersUseSSE2 = false;
+
 #ifdef USE_HQ_SCALERS
 // RGB-to-YUV lookup table
 extern "C" {
@@ -102,6 +114,10 @@ void InitLUT(Graphics::PixelFormat format) {
 		RGBtoYUV[color] = (Y << 16) | (u << 8) | v;
 	}
 
+#ifndef USE_NASM
+	InitHQPatterns();
+#endif
+
 #ifdef USE_NASM
 	hqx_lowbits  = (1 << format.rShift) | (1 << format.gShift) | (1 << format.bShift),
 	hqx_low2bits = (3 << format.rShift) | (3 << format.gShift) | (3 << format.bShift),
@@ -127,6 +143,10 @@ uint16 g_dotmatrix[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
 void InitScalers(uint32 BitFormat) {
 	gBitFormat = BitFormat;
 
+#if defined(SCUMMVM_SSE2)
+	g_scalersUseSSE2 = Common::hasCpuFeature(Common::kCpuFeatureSSE2);
+#endif
+
 	// FIXME: The pixelformat should be param to this function, not the bitformat.
 	// Until then, determine the pixelformat in other ways. Unfortunately,
 	// calling OSystem::getOverlayFormat() here might not be safe on all ports.
@@ -209,7 +229,22 @@ void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 	assert(IS_ALIGNED(dstPtr, 4));
 	while (height--) {
 		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 4) {
+		int i = 0;
+#if defined(SCUMMVM_SSE2)
+		if (g_scalersUseSSE2) {
+			for (; i + 8 <= width; i += 8, r += 32) {
+				const __m128i color = _mm_loadu_si128((const __m128i *)(srcPtr + i * 2));
+				const __m128i lo = _mm_unpacklo_epi16(color, color);
+				const __m128i hi = _mm_unpackhi_epi16(color, color);
+
+				_mm_storeu_si128((__m128i *)r, lo);
+				_mm_storeu_si128((__m128i *)(r + 16), hi);
+				_mm_storeu_si128((__m128i *)(r + dstPitch), lo);
+				_mm_storeu_si128((__m128i *)(r + dstPitch + 16), hi);
+			}
+		}
+#endif
+		for (; i < width; ++i, r += 4) {
 			uint32 color = *(((const uint16 *)srcPtr) + i);
 
 			color |= color << 16;
@@ -223,6 +258,18 @@ void Normal2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 }
 #endif
 
+#if defined(SCUMMVM_SSE2)
+/** Repeats each of the eight pixels in a vector three times, filling three vectors. */
+static inline void repeat3SSE2(__m128i v, __m128i *out) {
+	const __m128i lo = _mm_unpacklo_epi16(v, v);
+	const __m128i hi = _mm_unpackhi_epi16(v, v);
+
+	out[0] = _mm_unpacklo_epi64(_mm_shufflelo_epi16(v, _MM_SHUFFLE(1, 0, 0, 0)), _mm_srli_si128(lo, 4));
+	out[1] = _mm_unpacklo_epi64(_mm_shufflelo_epi16(_mm_srli_si128(v, 4), _MM_SHUFFLE(1, 1, 1, 0)), _mm_shufflelo_epi16(_mm_srli_si128(v, 8), _MM_SHUFFLE(1, 0, 0, 0)));
+	out[2] = _mm_unpacklo_epi64(_mm_srli_si128(hi, 4), _mm_shufflelo_epi16(_mm_srli_si128(v, 12), _MM_SHUFFLE(1, 1, 1, 0)));
+}
+#endif
+
 /**
  * Trivial nearest-neighbor 3x scaler.
  */
@@ -235,7 +282,22 @@ void Normal3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 	assert(IS_ALIGNED(dstPtr, 2));
 	while (height--) {
 		r = dstPtr;
-		for (int i = 0; i < width; ++i, r += 6) {
+		int i = 0;
+#if defined(SCUMMVM_SSE2)
+		if (g_scalersUseSSE2) {
+			for (; i + 8 <= width; i += 8, r += 48) {
+				__m128i color[3];
+				repeat3SSE2(_mm_loadu_si128((const __m128i *)(srcPtr + i * 2)), color);
+
+				for (int k = 0; k < 3; ++k) {
+					_mm_storeu_si128((__m128i *)(r + 16 * k), color[k]);
+					_mm_storeu_si128((__m128i *)(r + 16 * k + dstPitch), color[k]);
+					_mm_storeu_si128((__m128i *)(r + 16 * k + dstPitch2), color[k]);
+				}
+			}
+		}
+#endif
+		for (; i < width; ++i, r += 6) {
 			uint16 color = *(((const uint16 *)srcPtr) + i);
 
 			*(uint16 *)(r + 0) = color;
@@ -314,6 +376,18 @@ void AdvMame2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
  */
 void AdvMame3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 							 int width, int height) {
+#if defined(SCUMMVM_SSE2)
+	if (g_scalersUseSSE2) {
+		while (height--) {
+			scale3x_16_sse2((uint16 *)dstPtr, (uint16 *)(dstPtr + dstPitch), (uint16 *)(dstPtr + 2 * dstPitch),
+			                (const uint16 *)(srcPtr - srcPitch), (const uint16 *)srcPtr, (const uint16 *)(srcPtr + srcPitch), width);
+			srcPtr += srcPitch;
+			dstPtr += 3 * dstPitch;
+		}
+		return;
+	}
+#endif
+
 	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
 }
 
@@ -327,7 +401,27 @@ void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 ds
 	uint16 *q = (uint16 *)dstPtr;
 
 	while (height--) {
-		for (int i = 0, j = 0; i < width; ++i, j += 2) {
+		int i = 0, j = 0;
+#if defined(SCUMMVM_SSE2)
+		if (g_scalersUseSSE2) {
+			const __m128i redBlueMask = _mm_set1_epi16((int16)ColorMask::kRedBlueMask);
+			const __m128i greenMask = _mm_set1_epi16((int16)ColorMask::kGreenMask);
+			// Multiplying by 7/8 in the high word of the product gives exactly (x * 7) >> 3
+			const __m128i sevenEighths = _mm_set1_epi16((int16)(7 << 13));
+
+			for (; i + 8 <= width; i += 8, j += 16) {
+				const __m128i p1 = _mm_loadu_si128((const __m128i *)(p + i));
+				__m128i pi = _mm_and_si128(_mm_mulhi_epu16(_mm_and_si128(p1, redBlueMask), sevenEighths), redBlueMask);
+				pi = _mm_or_si128(pi, _mm_and_si128(_mm_mulhi_epu16(_mm_and_si128(p1, greenMask), sevenEighths), greenMask));
+
+				_mm_storeu_si128((__m128i *)(q + j), _mm_unpacklo_epi16(p1, p1));
+				_mm_storeu_si128((__m128i *)(q + j + 8), _mm_unpackhi_epi16(p1, p1));
+				_mm_storeu_si128((__m128i *)(q + j + nextlineDst), _mm_unpacklo_epi16(pi, pi));
+				_mm_storeu_si128((__m128i *)(q + j + nextlineDst + 8), _mm_unpackhi_epi16(pi, pi));
+			}
+		}
+#endif
+		for (; i < width; ++i, j += 2) {
 			uint16 p1 = *(p + i);
 			uint32 pi;
 
@@ -374,7 +468,30 @@ void DotMatrix(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
 	uint16 *q = (uint16 *)dstPtr;
 
 	for (int j = 0, jj = 0; j < height; ++j, jj += 2) {
-		for (int i = 0, ii = 0; i < width; ++i, ii += 2) {
+		int i = 0, ii = 0;
+#if defined(SCUMMVM_SSE2)
+		if (g_scalersUseSSE2) {
+			// The dots of both destination rows, which repeat every four pixels
+			const uint16 *dots0 = dotmatrix + ((jj & 3) << 2);
+			const uint16 *dots1 = dotmatrix + (((jj + 1) & 3) << 2);
+			const __m128i dot0 = _mm_set_epi16(dots0[3], dots0[2], dots0[1], dots0[0], dots0[3], dots0[2], dots0[1], dots0[0]);
+			const __m128i dot1 = _mm_set_epi16(dots1[3], dots1[2], dots1[1], dots1[0], dots1[3], dots1[2], dots1[1], dots1[0]);
+
+			for (; i + 8 <= width; i += 8, ii += 16) {
+				const __m128i c = _mm_loadu_si128((const __m128i *)(p + i));
+				const __m128i lo = _mm_unpacklo_epi16(c, c);
+				const __m128i hi = _mm_unpackhi_epi16(c, c);
+				const __m128i lo4 = _mm_srli_epi16(lo, 2);
+				const __m128i hi4 = _mm_srli_epi16(hi, 2);
+
+				_mm_storeu_si128((__m128i *)(q + ii), _mm_sub_epi16(lo, _mm_and_si128(lo4, dot0)));
+				_mm_storeu_si128((__m128i *)(q + ii + 8), _mm_sub_epi16(hi, _mm_and_si128(hi4, dot0)));
+				_mm_storeu_si128((__m128i *)(q + ii + nextlineDst), _mm_sub_epi16(lo, _mm_and_si128(lo4, dot1)));
+				_mm_storeu_si128((__m128i *)(q + ii + nextlineDst + 8), _mm_sub_epi16(hi, _mm_and_si128(hi4, dot1)));
+			}
+		}
+#endif
+		for (; i < width; ++i, ii += 2) {
 			uint16 c = *(p + i);
 			*(q + ii) = DOT_16(dotmatrix, c, jj, ii);
 			*(q + ii + 1) = DOT_16(dotmatrix, c, jj, ii + 1);
@@ -187,6 +187,39 @@ void makeRectStretchable(int &x, int &y, int &w, int &h) {
 #endif
 }
 
+/**
+ * Compute row y of the stretched image, from the row of the original image
+ * at srcPtr and the one above it.
+ */
+template<typename ColorMask>
+static inline void stretch200To240Line(uint8 *dstPtr, const uint8 *srcPtr, uint32 srcPitch, int width, int y) {
+#if ASPECT_MODE == kSuperFastAndUglyAspectMode
+	if (srcPtr != dstPtr)
+		memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
+#else
+	// Bilinear filter
+	switch (y % 6) {
+	case 0:
+	case 5:
+		if (srcPtr != dstPtr)
+			memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
+		break;
+	case 1:
+		interpolate5Line<ColorMask, 1>((uint16 *)dstPtr, (const uint16 *)(srcPtr - srcPitch), (const uint16 *)srcPtr, width);
+		break;
+	case 2:
+		interpolate5Line<ColorMask, 2>((uint16 *)dstPtr, (const uint16 *)(srcPtr - srcPitch), (const uint16 *)srcPtr, width);
+		break;
+	case 3:
+		interpolate5Line<ColorMask, 2>((uint16 *)dstPtr, (const uint16 *)srcPtr, (const uint16 *)(srcPtr - srcPitch), width);
+		break;
+	case 4:
+		interpolate5Line<ColorMask, 1>((uint16 *)dstPtr, (const uint16 *)srcPtr, (const uint16 *)(srcPtr - srcPitch), width);
+		break;
+	}
+#endif
+}
+
 /**
  * Stretch a 16bpp image vertically by factor 1.2. Used to correct the
  * aspect-ratio in games using 320x200 pixel graphics with non-qudratic
@@ -216,35 +249,24 @@ int stretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, i
 #if ASPECT_MODE == kSuperFastAndUglyAspectMode
 		if (srcPtr == dstPtr)
 			break;
-		memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
-#else
-		// Bilinear filter
-		switch (y % 6) {
-		case 0:
-		case 5:
-			if (srcPtr != dstPtr)
-				memcpy(dstPtr, srcPtr, sizeof(uint16) * width);
-			break;
-		case 1:
-			interpolate5Line<ColorMask, 1>((uint16 *)dstPtr, (const uint16 *)(srcPtr - pitch), (const uint16 *)srcPtr, width);
-			break;
-		case 2:
-			interpolate5Line<ColorMask, 2>((uint16 *)dstPtr, (const uint16 *)(srcPtr - pitch), (const uint16 *)srcPtr, width);
-			break;
-		case 3:
-			interpolate5Line<ColorMask, 2>((uint16 *)dstPtr, (const uint16 *)srcPtr, (const uint16 *)(srcPtr - pitch), width);
-			break;
-		case 4:
-			interpolate5Line<ColorMask, 1>((uint16 *)dstPtr, (const uint16 *)srcPtr, (const uint16 *)(srcPtr - pitch), width);
-			break;
-		}
 #endif
+		stretch200To240Line<ColorMask>(dstPtr, srcPtr, pitch, width, y);
 		dstPtr -= pitch;
 	}
 
 	return 1 + maxDstY - srcY;
 }
 
+template<typename ColorMask>
+void stretch200To240Rows(uint8 *dst, uint32 dstPitch, const uint8 *src, uint32 srcPitch, int width, int firstY, int lastY, int srcY) {
+	uint8 *dstPtr = dst + firstY * dstPitch;
+
+	for (int y = firstY; y <= lastY; y++) {
+		stretch200To240Line<ColorMask>(dstPtr, src + (aspect2Real(y) - srcY) * srcPitch, srcPitch, width, y);
+		dstPtr += dstPitch;
+	}
+}
+
 int stretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, int srcY, int origSrcY) {
 	extern int gBitFormat;
 	if (gBitFormat == 565)
@@ -253,6 +275,14 @@ int stretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, i
 		return stretch200To240<Graphics::ColorMasks<555> >(buf, pitch, width, height, srcX, srcY, origSrcY);
 }
 
+void stretch200To240Rows(uint8 *dst, uint32 dstPitch, const uint8 *src, uint32 srcPitch, int width, int firstY, int lastY, int srcY) {
+	extern int gBitFormat;
+	if (gBitFormat == 565)
+		stretch200To240Rows<Graphics::ColorMasks<565> >(dst, dstPitch, src, srcPitch, width, firstY, lastY, srcY);
+	else // gBitFormat == 555
+		stretch200To240Rows<Graphics::ColorMasks<555> >(dst, dstPitch, src, srcPitch, width, firstY, lastY, srcY);
+}
+
 
 template<typename ColorMask>
 void Normal1xAspectTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
@@ -55,6 +55,31 @@ int stretch200To240(uint8 *buf,
                     int srcY,
                     int origSrcY);
 
+/**
+ * Stretch some rows of an image like stretch200To240() does, but from a
+ * separate buffer, so that several parts of an image can be stretched at
+ * the same time.
+ *
+ * @param dst		the destination, at row 0
+ * @param dstPitch	pitch of the destination
+ * @param src		the original image, at row srcY
+ * @param srcPitch	pitch of the original image
+ * @param width		width of the rows
+ * @param firstY	first row of the destination to compute
+ * @param lastY		last row of the destination to compute
+ * @param srcY		the row of the original image at src. The rows from
+ *					aspect2Real(firstY) - 1 up to aspect2Real(lastY) have
+ *					to be available.
+ */
+void stretch200To240Rows(uint8 *dst,
+                         uint32 dstPitch,
+                         const uint8 *src,
+                         uint32 srcPitch,
+                         int width,
+                         int firstY,
+                         int lastY,
+                         int srcY);
+
 
 /**
  * This filter (up)scales the source image vertically by a factor of 6/5.
@@ -0,0 +1,221 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/scaler/intern.h"
+#include "common/cpudetect.h"
+
+// The assembly versions of the HQ scalers compute their own patterns
+#ifndef USE_NASM
+
+#if defined(SCUMMVM_AVX2)
+#include <immintrin.h>
+#elif defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#endif
+
+extern "C" uint32 *RGBtoYUV;
+
+#pragma mark --- Plain C patterns ---
+
+static void computePatternsC(const uint16 *p, uint32 nextlineSrc, int count, uint8 *patterns) {
+	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
+
+	w1 = *(p - 1 - nextlineSrc);
+	w4 = *(p - 1);
+	w7 = *(p - 1 + nextlineSrc);
+
+	w2 = *(p - nextlineSrc);
+	w5 = *(p);
+	w8 = *(p + nextlineSrc);
+
+	for (int i = 0; i < count; i++) {
+		p++;
+
+		w3 = *(p - nextlineSrc);
+		w6 = *(p);
+		w9 = *(p + nextlineSrc);
+
+		int pattern = 0;
+		const int yuv5 = RGBtoYUV[w5];
+		if (w5 != w1 && diffYUV(yuv5, RGBtoYUV[w1])) pattern |= 0x0001;
+		if (w5 != w2 && diffYUV(yuv5, RGBtoYUV[w2])) pattern |= 0x0002;
+		if (w5 != w3 && diffYUV(yuv5, RGBtoYUV[w3])) pattern |= 0x0004;
+		if (w5 != w4 && diffYUV(yuv5, RGBtoYUV[w4])) pattern |= 0x0008;
+		if (w5 != w6 && diffYUV(yuv5, RGBtoYUV[w6])) pattern |= 0x0010;
+		if (w5 != w7 && diffYUV(yuv5, RGBtoYUV[w7])) pattern |= 0x0020;
+		if (w5 != w8 && diffYUV(yuv5, RGBtoYUV[w8])) pattern |= 0x0040;
+		if (w5 != w9 && diffYUV(yuv5, RGBtoYUV[w9])) pattern |= 0x0080;
+		patterns[i] = pattern;
+
+		w1 = w2;
+		w4 = w5;
+		w7 = w8;
+
+		w2 = w3;
+		w5 = w6;
+		w8 = w9;
+	}
+}
+
+#if defined(SCUMMVM_SSE2)
+
+/*
+ * The vector versions look up the YUV values of the three rows around the
+ * run once, and then compare each pixel with its neighbours four or eight
+ * at a time. The Y, U and V components are bytes, so diffYUV() is the same
+ * as checking whether the absolute difference of any component exceeds its
+ * threshold, which can be done with saturated byte arithmetic. Comparing
+ * equal pixels always yields no difference, so the shortcut for them in the
+ * C version is not needed.
+ */
+
+enum {
+	// Room for the pixels left and right of the run, and for rounding up
+	// the run to whole vectors
+	kYUVRowSize = kHQPatternChunk + 2 + 8
+};
+
+// The thresholds of diffYUV(), one byte per component
+static const int32 kYUVThresholds = 0x00300706;
+
+/** Returns all bits set in the lanes where the neighbours differ from the centers */
+static inline __m128i diffYUVSSE2(__m128i center, __m128i neighbour, __m128i thresholds) {
+	const __m128i absDiff = _mm_or_si128(_mm_subs_epu8(center, neighbour), _mm_subs_epu8(neighbour, center));
+	const __m128i excess = _mm_subs_epu8(absDiff, thresholds);
+	return _mm_andnot_si128(_mm_cmpeq_epi32(excess, _mm_setzero_si128()), _mm_set1_epi32(-1));
+}
+
+static void computePatternsSSE2(const uint16 *p, uint32 nextlineSrc, int count, uint8 *patterns) {
+	uint32 yuv[3][kYUVRowSize];
+	const int rounded = (count + 3) & ~3;
+
+	for (int row = 0; row < 3; row++) {
+		const uint16 *src = p + (row - 1) * (int)nextlineSrc;
+		for (int i = -1; i <= count; i++)
+			yuv[row][i + 1] = RGBtoYUV[src[i]];
+		for (int i = count + 1; i <= rounded; i++)
+			yuv[row][i + 1] = 0;
+	}
+
+	const __m128i thresholds = _mm_set1_epi32(kYUVThresholds);
+
+	for (int i = 0; i < rounded; i += 4) {
+		const __m128i center = _mm_loadu_si128((const __m128i *)&yuv[1][i + 1]);
+
+		__m128i pattern = _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[0][i + 0]), thresholds), _mm_set1_epi32(0x01));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[0][i + 1]), thresholds), _mm_set1_epi32(0x02)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[0][i + 2]), thresholds), _mm_set1_epi32(0x04)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[1][i + 0]), thresholds), _mm_set1_epi32(0x08)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[1][i + 2]), thresholds), _mm_set1_epi32(0x10)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[2][i + 0]), thresholds), _mm_set1_epi32(0x20)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[2][i + 1]), thresholds), _mm_set1_epi32(0x40)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffYUVSSE2(center, _mm_loadu_si128((const __m128i *)&yuv[2][i + 2]), thresholds), _mm_set1_epi32(0x80)));
+
+		// The patterns fit into a byte each
+		pattern = _mm_packs_epi32(pattern, pattern);
+		pattern = _mm_packus_epi16(pattern, pattern);
+		const uint32 bytes = _mm_cvtsi128_si32(pattern);
+		for (int j = 0; j < 4 && i + j < count; j++)
+			patterns[i + j] = (bytes >> (j * 8)) & 0xFF;
+	}
+}
+
+#endif
+
+#if defined(SCUMMVM_AVX2)
+
+SCUMMVM_TARGET_AVX2
+static inline __m256i diffYUVAVX2(__m256i center, __m256i neighbour, __m256i thresholds) {
+	const __m256i absDiff = _mm256_or_si256(_mm256_subs_epu8(center, neighbour), _mm256_subs_epu8(neighbour, center));
+	const __m256i excess = _mm256_subs_epu8(absDiff, thresholds);
+	return _mm256_andnot_si256(_mm256_cmpeq_epi32(excess, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+}
+
+SCUMMVM_TARGET_AVX2
+static void computePatternsAVX2(const uint16 *p, uint32 nextlineSrc, int count, uint8 *patterns) {
+	uint32 yuv[3][kYUVRowSize];
+	const int rounded = (count + 7) & ~7;
+
+	// Look up the YUV values eight at a time, for the pixels from the one
+	// left of the run up to the one right of it
+	for (int row = 0; row < 3; row++) {
+		const uint16 *src = p + (row - 1) * (int)nextlineSrc - 1;
+		int i = 0;
+		for (; i + 8 <= count + 2; i += 8) {
+			const __m256i colors = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+			_mm256_storeu_si256((__m256i *)&yuv[row][i], _mm256_i32gather_epi32((const int *)RGBtoYUV, colors, 4));
+		}
+		for (; i < count + 2; i++)
+			yuv[row][i] = RGBtoYUV[src[i]];
+		for (; i < rounded + 2; i++)
+			yuv[row][i] = 0;
+	}
+
+	const __m256i thresholds = _mm256_set1_epi32(kYUVThresholds);
+
+	for (int i = 0; i < rounded; i += 8) {
+		const __m256i center = _mm256_loadu_si256((const __m256i *)&yuv[1][i + 1]);
+
+		__m256i pattern = _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[0][i + 0]), thresholds), _mm256_set1_epi32(0x01));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[0][i + 1]), thresholds), _mm256_set1_epi32(0x02)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[0][i + 2]), thresholds), _mm256_set1_epi32(0x04)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[1][i + 0]), thresholds), _mm256_set1_epi32(0x08)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[1][i + 2]), thresholds), _mm256_set1_epi32(0x10)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[2][i + 0]), thresholds), _mm256_set1_epi32(0x20)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[2][i + 1]), thresholds), _mm256_set1_epi32(0x40)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffYUVAVX2(center, _mm256_loadu_si256((const __m256i *)&yuv[2][i + 2]), thresholds), _mm256_set1_epi32(0x80)));
+
+		// The patterns fit into a byte each
+		__m128i bytes = _mm_packs_epi32(_mm256_castsi256_si128(pattern), _mm256_extracti128_si256(pattern, 1));
+		bytes = _mm_packus_epi16(bytes, bytes);
+		if (i + 8 <= count) {
+			_mm_storel_epi64((__m128i *)(patterns + i), bytes);
+		} else {
+			uint8 tail[16];
+			_mm_storeu_si128((__m128i *)tail, bytes);
+			for (int j = 0; i + j < count; j++)
+				patterns[i + j] = tail[j];
+		}
+	}
+}
+
+#endif
+
+HQPatternProc hqComputePatterns = computePatternsC;
+
+void InitHQPatterns() {
+	hqComputePatterns = computePatternsC;
+
+#if defined(SCUMMVM_AVX2)
+	if (Common::hasCpuFeature(Common::kCpuFeatureAVX2)) {
+		hqComputePatterns = computePatternsAVX2;
+		return;
+	}
+#endif
+
+#if defined(SCUMMVM_SSE2)
+	if (Common::hasCpuFeature(Common::kCpuFeatureSSE2))
+		hqComputePatterns = computePatternsSSE2;
+#endif
+}
+
+#endif
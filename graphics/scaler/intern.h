@@ -218,4 +218,26 @@ static inline bool diffYUV(int yuv1, int yuv2) {
 */
 }
 
+/**
+ * Computes the HQ scaler patterns of a run of pixels. Bit n of a pattern is
+ * set if the pixel differs, according to diffYUV(), from its n-th neighbour,
+ * counting the 3x3 neighbourhood from the top left and skipping the center.
+ *
+ * @param p				the first pixel of the run
+ * @param nextlineSrc	the source pitch, in pixels
+ * @param count			the number of pixels, at most kHQPatternChunk
+ * @param patterns		receives one pattern per pixel
+ */
+typedef void (*HQPatternProc)(const uint16 *p, uint32 nextlineSrc, int count, uint8 *patterns);
+
+enum {
+	kHQPatternChunk = 256
+};
+
+/** The fastest pattern implementation for this CPU, set up by InitLUT(). */
+extern HQPatternProc hqComputePatterns;
+
+/** Selects hqComputePatterns for the CPU features currently enabled. */
+void InitHQPatterns();
+
 #endif
@@ -19,7 +19,7 @@
  */
 
 /*
- * This file contains a C and MMX implementation of the Scale2x effect.
+ * This file contains a C and SSE2 implementation of the Scale3x effect.
  *
  * You can find an high level description of the effect at :
  *
@@ -36,6 +36,10 @@
 
 #include "graphics/scaler/scale3x.h"
 
+#if defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#endif
+
 /***************************************************************************/
 /* Scale3x C implementation */
 
@@ -220,3 +224,134 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+#if defined(SCUMMVM_SSE2)
+
+/***************************************************************************/
+/* Scale3x SSE2 implementation */
+
+/*
+ * The SSE2 implementation evaluates the same conditions as the C one for
+ * eight pixels at a time, as masks, and then interleaves the three pixels
+ * computed for each source pixel into the destination row.
+ */
+
+static inline __m128i scale3x_16_sse2_select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i scale3x_16_sse2_ne(__m128i a, __m128i b) {
+	return _mm_andnot_si128(_mm_cmpeq_epi16(a, b), _mm_set1_epi16(-1));
+}
+
+/*
+ * Store the pixels of a, b and c interleaved as a0 b0 c0 a1 b1 c1 ...
+ */
+static inline void scale3x_16_sse2_store(scale3x_uint16* dst, __m128i a, __m128i b, __m128i c) {
+	static const scale3x_uint16 lanes[3][3][8] = {
+		{ { 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0 }, { 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF }, { 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0 } },
+		{ { 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF }, { 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0 }, { 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0 } },
+		{ { 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0 }, { 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0 }, { 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF } }
+	};
+
+	__m128i rep[3][3];
+	const __m128i src[3] = { a, b, c };
+	for (int i = 0; i < 3; ++i) {
+		const __m128i v = src[i];
+		const __m128i lo = _mm_unpacklo_epi16(v, v);
+		const __m128i hi = _mm_unpackhi_epi16(v, v);
+
+		// Every pixel three times, v0 v0 v0 v1 v1 v1 v2 v2 ...
+		rep[i][0] = _mm_unpacklo_epi64(_mm_shufflelo_epi16(v, _MM_SHUFFLE(1, 0, 0, 0)), _mm_srli_si128(lo, 4));
+		rep[i][1] = _mm_unpacklo_epi64(_mm_shufflelo_epi16(_mm_srli_si128(v, 4), _MM_SHUFFLE(1, 1, 1, 0)), _mm_shufflelo_epi16(_mm_srli_si128(v, 8), _MM_SHUFFLE(1, 0, 0, 0)));
+		rep[i][2] = _mm_unpacklo_epi64(_mm_srli_si128(hi, 4), _mm_shufflelo_epi16(_mm_srli_si128(v, 12), _MM_SHUFFLE(1, 1, 1, 0)));
+	}
+
+	for (int j = 0; j < 3; ++j) {
+		__m128i out = _mm_and_si128(rep[0][j], _mm_loadu_si128((const __m128i *)lanes[0][j]));
+		out = _mm_or_si128(out, _mm_and_si128(rep[1][j], _mm_loadu_si128((const __m128i *)lanes[1][j])));
+		out = _mm_or_si128(out, _mm_and_si128(rep[2][j], _mm_loadu_si128((const __m128i *)lanes[2][j])));
+		_mm_storeu_si128((__m128i *)(dst + 8 * j), out);
+	}
+}
+
+static inline void scale3x_16_sse2_border(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i al = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i ar = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i bl = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i br = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i c = _mm_loadu_si128((const __m128i *)src2);
+
+		const __m128i cond = _mm_and_si128(scale3x_16_sse2_ne(a, c), scale3x_16_sse2_ne(bl, br));
+		const __m128i leftIsA = _mm_cmpeq_epi16(bl, a);
+		const __m128i rightIsA = _mm_cmpeq_epi16(br, a);
+
+		const __m128i d0 = scale3x_16_sse2_select(_mm_and_si128(cond, leftIsA), bl, b);
+		const __m128i d1 = scale3x_16_sse2_select(_mm_and_si128(cond,
+			_mm_or_si128(_mm_and_si128(leftIsA, scale3x_16_sse2_ne(b, ar)), _mm_and_si128(rightIsA, scale3x_16_sse2_ne(b, al)))), a, b);
+		const __m128i d2 = scale3x_16_sse2_select(_mm_and_si128(cond, rightIsA), br, b);
+		scale3x_16_sse2_store(dst, d0, d1, d2);
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_border(dst, src0, src1, src2, count);
+}
+
+static inline void scale3x_16_sse2_center(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)src0);
+		const __m128i al = _mm_loadu_si128((const __m128i *)(src0 - 1));
+		const __m128i ar = _mm_loadu_si128((const __m128i *)(src0 + 1));
+		const __m128i b = _mm_loadu_si128((const __m128i *)src1);
+		const __m128i bl = _mm_loadu_si128((const __m128i *)(src1 - 1));
+		const __m128i br = _mm_loadu_si128((const __m128i *)(src1 + 1));
+		const __m128i c = _mm_loadu_si128((const __m128i *)src2);
+		const __m128i cl = _mm_loadu_si128((const __m128i *)(src2 - 1));
+		const __m128i cr = _mm_loadu_si128((const __m128i *)(src2 + 1));
+
+		const __m128i cond = _mm_and_si128(scale3x_16_sse2_ne(a, c), scale3x_16_sse2_ne(bl, br));
+
+		const __m128i d0 = scale3x_16_sse2_select(_mm_and_si128(cond,
+			_mm_or_si128(_mm_and_si128(_mm_cmpeq_epi16(bl, a), scale3x_16_sse2_ne(b, cl)), _mm_and_si128(_mm_cmpeq_epi16(bl, c), scale3x_16_sse2_ne(b, al)))), bl, b);
+		const __m128i d2 = scale3x_16_sse2_select(_mm_and_si128(cond,
+			_mm_or_si128(_mm_and_si128(_mm_cmpeq_epi16(br, a), scale3x_16_sse2_ne(b, cr)), _mm_and_si128(_mm_cmpeq_epi16(br, c), scale3x_16_sse2_ne(b, ar)))), br, b);
+		scale3x_16_sse2_store(dst, d0, b, d2);
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_center(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def() but is implemented with
+ * SSE2 instructions, which the caller has to check are available.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * It must be at least 2.
+ * @param dst0 First destination row, triple length in pixels.
+ * @param dst1 Second destination row, triple length in pixels.
+ * @param dst2 Third destination row, triple length in pixels.
+ */
+void scale3x_16_sse2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	scale3x_16_sse2_border(dst0, src0, src1, src2, count);
+	scale3x_16_sse2_center(dst1, src0, src1, src2, count);
+	scale3x_16_sse2_border(dst2, src2, src1, src0, count);
+}
+
+#endif
@@ -83,9 +83,17 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/cpudetect.h"
+
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#if defined(SCUMMVM_SSE2)
+#include <emmintrin.h>
+#elif defined(SCUMMVM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -158,8 +166,6 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 }
 
 YUVToRGBManager::YUVToRGBManager() {
-	_lookup = 0;
-
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
 	int16 *Cb_g_tab = &_colorTab[2 * 256];
@@ -180,18 +186,362 @@ YUVToRGBManager::YUVToRGBManager() {
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
-	delete _lookup;
+	for (uint i = 0; i < _lookups.size(); i++)
+		delete _lookups[i];
 }
 
 const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
-	if (_lookup && _lookup->getFormat() == format && _lookup->getScale() == scale)
-		return _lookup;
+	Common::StackLock lock(_lookupMutex);
+
+	YUVToRGBLookup *lookup = 0;
+	for (uint i = 0; i < _lookups.size() && !lookup; i++)
+		if (_lookups[i]->getFormat() == format && _lookups[i]->getScale() == scale)
+			lookup = _lookups[i];
+
+	if (!lookup) {
+		lookup = new YUVToRGBLookup(format, scale);
+		_lookups.push_back(lookup);
+	}
+
+	return lookup;
+}
+
+#pragma mark --- Vector converters ---
+
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_NEON)
+
+/*
+ * The vector converters produce exactly the same pixels as the lookup
+ * tables, eight chroma samples at a time.
+ *
+ * The chroma contributions of the color tables are truncated products of
+ * the chroma with constant factors. They are computed here in fixed point
+ * on the magnitude of the chroma, with the sign applied afterwards, using
+ * factors for which all 129 magnitudes give the same results as the
+ * tables. The contributions are added to the luminance, the sums clipped
+ * the same way the lookup tables are padded, scaled for kScaleITU and
+ * packed into pixels like PixelFormat::RGBToColor() does.
+ */
+
+// ((|c| << 1) * factor) >> 16 == (int16)(|k| * |c|) for |c| in [0, 128]
+static const int kCrRFactor = 45901; // 0.419 / 0.299
+static const int kCrGFactor = 23386; // 0.299 / 0.419
+static const int kCbGFactor = 11283; // 0.114 / 0.331
+static const int kCbBFactor = 58110; // 0.587 / 0.331
+
+// ((t << 2) * kITUFactor) >> 16 == t * 255 / 219 for t in [0, 219]
+static const int kITUFactor = 19078;
+
+/*
+ * For kScaleITU, the luminance and the chroma contributions are kept
+ * shifted as needed for kITUFactor, with the luminance offset by 16.
+ */
+static const int kITUShift = 2;
+
+/** How the channels are packed into a pixel */
+struct PixelPacking {
+	int rLoss, gLoss, bLoss;
+	int rShift, gShift, bShift;
+	uint32 alpha;
+
+	PixelPacking(const Graphics::PixelFormat &format) :
+			rLoss(format.rLoss), gLoss(format.gLoss), bLoss(format.bLoss),
+			rShift(format.rShift), gShift(format.gShift), bShift(format.bShift),
+			alpha((0xFF >> format.aLoss) << format.aShift) {
+	}
+};
+
+/** Convert the pixels the vector code leaves over at the end of the rows, with the lookup tables. */
+template<typename PixelInt, bool halfChroma>
+static void convertRest(PixelInt *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int start, int width, const int16 *colorTab, const uint32 *rgbToPix) {
+	const int16 *Cr_r_tab = colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+
+	for (int row = 0; row < (halfChroma ? 2 : 1); row++) {
+		for (int x = start; x < width; x++) {
+			const int c = halfChroma ? (x >> 1) : x;
+			const int y = ySrc[x];
+			dst[x] = rgbToPix[y + Cr_r_tab[vSrc[c]]] |
+			         rgbToPix[y + Cr_g_tab[vSrc[c]] + Cb_g_tab[uSrc[c]]] |
+			         rgbToPix[y + Cb_b_tab[uSrc[c]]];
+		}
+
+		dst = (PixelInt *)((byte *)dst + dstPitch);
+		ySrc += yPitch;
+	}
+}
+
+#if defined(SCUMMVM_SSE2)
+
+/** Multiply signed chroma by a factor, truncating towards zero like the color tables */
+static inline __m128i mulChromaSSE2(__m128i magnitude, __m128i sign, int factor) {
+	const __m128i product = _mm_mulhi_epu16(magnitude, _mm_set1_epi16((int16)factor));
+	return _mm_sub_epi16(_mm_xor_si128(product, sign), sign);
+}
+
+template<bool itu>
+static inline __m128i clipChannelSSE2(__m128i x) {
+	if (!itu)
+		return _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(255));
 
-	delete _lookup;
-	_lookup = new YUVToRGBLookup(format, scale);
-	return _lookup;
+	x = _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(219 << kITUShift));
+	return _mm_mulhi_epu16(x, _mm_set1_epi16(kITUFactor));
 }
 
+/** The shift counts and alpha of a pixel format, in registers */
+struct PackingSSE2 {
+	__m128i rLoss, gLoss, bLoss;
+	__m128i rShift, gShift, bShift;
+	__m128i alpha16, alpha32;
+
+	PackingSSE2(const PixelPacking &packing) :
+			rLoss(_mm_cvtsi32_si128(packing.rLoss)), gLoss(_mm_cvtsi32_si128(packing.gLoss)), bLoss(_mm_cvtsi32_si128(packing.bLoss)),
+			rShift(_mm_cvtsi32_si128(packing.rShift)), gShift(_mm_cvtsi32_si128(packing.gShift)), bShift(_mm_cvtsi32_si128(packing.bShift)),
+			alpha16(_mm_set1_epi16((int16)packing.alpha)), alpha32(_mm_set1_epi32((int32)packing.alpha)) {
+	}
+};
+
+/** Convert eight pixels, given their luminance and chroma contributions */
+template<typename PixelInt, bool itu>
+static inline void convertPixelsSSE2(PixelInt *dst, __m128i y, __m128i offR, __m128i offG, __m128i offB, const PackingSSE2 &packing) {
+	if (itu)
+		y = _mm_slli_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), kITUShift);
+
+	const __m128i r = _mm_srl_epi16(clipChannelSSE2<itu>(_mm_add_epi16(y, offR)), packing.rLoss);
+	const __m128i g = _mm_srl_epi16(clipChannelSSE2<itu>(_mm_add_epi16(y, offG)), packing.gLoss);
+	const __m128i b = _mm_srl_epi16(clipChannelSSE2<itu>(_mm_add_epi16(y, offB)), packing.bLoss);
+
+	if (sizeof(PixelInt) == 2) {
+		__m128i pixels = _mm_or_si128(packing.alpha16, _mm_sll_epi16(r, packing.rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(g, packing.gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(b, packing.bShift));
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	} else {
+		const __m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_or_si128(packing.alpha32, _mm_sll_epi32(_mm_unpacklo_epi16(r, zero), packing.rShift));
+		__m128i hi = _mm_or_si128(packing.alpha32, _mm_sll_epi32(_mm_unpackhi_epi16(r, zero), packing.rShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), packing.gShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), packing.gShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), packing.bShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), packing.bShift));
+		_mm_storeu_si128((__m128i *)dst, lo);
+		_mm_storeu_si128((__m128i *)dst + 1, hi);
+	}
+}
+
+/**
+ * Convert one row of a YUV444 image, or with halfChroma two rows of a
+ * YUV420 image, eight chroma samples at a time.
+ */
+template<typename PixelInt, bool halfChroma, bool itu>
+static void convertRowsSSE2(PixelInt *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const PixelPacking &packing, const int16 *colorTab, const uint32 *rgbToPix) {
+	const PackingSSE2 vPacking(packing);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const int step = halfChroma ? 16 : 8;
+	PixelInt *dst2 = (PixelInt *)((byte *)dst + dstPitch);
+	int x = 0;
+
+	for (; x + step <= width; x += step) {
+		const int c = halfChroma ? (x >> 1) : x;
+		const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + c)), zero), bias);
+		const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + c)), zero), bias);
+		const __m128i crSign = _mm_srai_epi16(cr, 15);
+		const __m128i cbSign = _mm_srai_epi16(cb, 15);
+		const __m128i crMagnitude = _mm_slli_epi16(_mm_max_epi16(cr, _mm_sub_epi16(zero, cr)), 1);
+		const __m128i cbMagnitude = _mm_slli_epi16(_mm_max_epi16(cb, _mm_sub_epi16(zero, cb)), 1);
+
+		__m128i offR = mulChromaSSE2(crMagnitude, crSign, kCrRFactor);
+		__m128i offG = _mm_sub_epi16(zero, _mm_add_epi16(mulChromaSSE2(crMagnitude, crSign, kCrGFactor), mulChromaSSE2(cbMagnitude, cbSign, kCbGFactor)));
+		__m128i offB = mulChromaSSE2(cbMagnitude, cbSign, kCbBFactor);
+		if (itu) {
+			offR = _mm_slli_epi16(offR, kITUShift);
+			offG = _mm_slli_epi16(offG, kITUShift);
+			offB = _mm_slli_epi16(offB, kITUShift);
+		}
+
+		if (halfChroma) {
+			const __m128i offRLo = _mm_unpacklo_epi16(offR, offR), offRHi = _mm_unpackhi_epi16(offR, offR);
+			const __m128i offGLo = _mm_unpacklo_epi16(offG, offG), offGHi = _mm_unpackhi_epi16(offG, offG);
+			const __m128i offBLo = _mm_unpacklo_epi16(offB, offB), offBHi = _mm_unpackhi_epi16(offB, offB);
+
+			const __m128i y1 = _mm_loadu_si128((const __m128i *)(ySrc + x));
+			const __m128i y2 = _mm_loadu_si128((const __m128i *)(ySrc + yPitch + x));
+			convertPixelsSSE2<PixelInt, itu>(dst + x, _mm_unpacklo_epi8(y1, zero), offRLo, offGLo, offBLo, vPacking);
+			convertPixelsSSE2<PixelInt, itu>(dst + x + 8, _mm_unpackhi_epi8(y1, zero), offRHi, offGHi, offBHi, vPacking);
+			convertPixelsSSE2<PixelInt, itu>(dst2 + x, _mm_unpacklo_epi8(y2, zero), offRLo, offGLo, offBLo, vPacking);
+			convertPixelsSSE2<PixelInt, itu>(dst2 + x + 8, _mm_unpackhi_epi8(y2, zero), offRHi, offGHi, offBHi, vPacking);
+		} else {
+			const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), zero);
+			convertPixelsSSE2<PixelInt, itu>(dst + x, y, offR, offG, offB, vPacking);
+		}
+	}
+
+	convertRest<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, colorTab, rgbToPix);
+}
+
+#define convertRowsVector convertRowsSSE2
+
+#elif defined(SCUMMVM_NEON)
+
+/** Multiply signed chroma by a factor, truncating towards zero like the color tables */
+static inline int16x8_t mulChromaNEON(uint16x8_t magnitude, int16x8_t sign, int factor) {
+	const uint16x4_t f = vdup_n_u16(factor);
+	const int16x8_t product = vreinterpretq_s16_u16(vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(magnitude), f), 16),
+	                                                             vshrn_n_u32(vmull_u16(vget_high_u16(magnitude), f), 16)));
+	return vsubq_s16(veorq_s16(product, sign), sign);
+}
+
+template<bool itu>
+static inline uint16x8_t clipChannelNEON(int16x8_t x) {
+	if (!itu)
+		return vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(255)));
+
+	const uint16x8_t t = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(219 << kITUShift)));
+	const uint16x4_t factor = vdup_n_u16(kITUFactor);
+	return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(t), factor), 16),
+	                    vshrn_n_u32(vmull_u16(vget_high_u16(t), factor), 16));
+}
+
+/** Convert eight pixels, given their luminance and chroma contributions */
+template<typename PixelInt, bool itu>
+static inline void convertPixelsNEON(PixelInt *dst, uint8x8_t yBytes, int16x8_t offR, int16x8_t offG, int16x8_t offB, const PixelPacking &packing) {
+	int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(yBytes));
+	if (itu)
+		y = vshlq_n_s16(vsubq_s16(y, vdupq_n_s16(16)), kITUShift);
+
+	// Shifting by a negative amount shifts right
+	const uint16x8_t r = vshlq_u16(clipChannelNEON<itu>(vaddq_s16(y, offR)), vdupq_n_s16(-packing.rLoss));
+	const uint16x8_t g = vshlq_u16(clipChannelNEON<itu>(vaddq_s16(y, offG)), vdupq_n_s16(-packing.gLoss));
+	const uint16x8_t b = vshlq_u16(clipChannelNEON<itu>(vaddq_s16(y, offB)), vdupq_n_s16(-packing.bLoss));
+
+	if (sizeof(PixelInt) == 2) {
+		uint16x8_t pixels = vorrq_u16(vdupq_n_u16((uint16)packing.alpha), vshlq_u16(r, vdupq_n_s16(packing.rShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(g, vdupq_n_s16(packing.gShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(b, vdupq_n_s16(packing.bShift)));
+		vst1q_u16((uint16 *)dst, pixels);
+	} else {
+		const uint32x4_t alpha = vdupq_n_u32(packing.alpha);
+		uint32x4_t lo = vorrq_u32(alpha, vshlq_u32(vmovl_u16(vget_low_u16(r)), vdupq_n_s32(packing.rShift)));
+		uint32x4_t hi = vorrq_u32(alpha, vshlq_u32(vmovl_u16(vget_high_u16(r)), vdupq_n_s32(packing.rShift)));
+		lo = vorrq_u32(lo, vshlq_u32(vmovl_u16(vget_low_u16(g)), vdupq_n_s32(packing.gShift)));
+		hi = vorrq_u32(hi, vshlq_u32(vmovl_u16(vget_high_u16(g)), vdupq_n_s32(packing.gShift)));
+		lo = vorrq_u32(lo, vshlq_u32(vmovl_u16(vget_low_u16(b)), vdupq_n_s32(packing.bShift)));
+		hi = vorrq_u32(hi, vshlq_u32(vmovl_u16(vget_high_u16(b)), vdupq_n_s32(packing.bShift)));
+		vst1q_u32((uint32 *)dst, lo);
+		vst1q_u32((uint32 *)dst + 4, hi);
+	}
+}
+
+/**
+ * Convert one row of a YUV444 image, or with halfChroma two rows of a
+ * YUV420 image, eight chroma samples at a time.
+ */
+template<typename PixelInt, bool halfChroma, bool itu>
+static void convertRowsNEON(PixelInt *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const PixelPacking &packing, const int16 *colorTab, const uint32 *rgbToPix) {
+	const int step = halfChroma ? 16 : 8;
+	PixelInt *dst2 = (PixelInt *)((byte *)dst + dstPitch);
+	int x = 0;
+
+	for (; x + step <= width; x += step) {
+		const int c = halfChroma ? (x >> 1) : x;
+		const int16x8_t cr = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(vSrc + c), vdup_n_u8(128)));
+		const int16x8_t cb = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(uSrc + c), vdup_n_u8(128)));
+		const int16x8_t crSign = vshrq_n_s16(cr, 15);
+		const int16x8_t cbSign = vshrq_n_s16(cb, 15);
+		const uint16x8_t crMagnitude = vshlq_n_u16(vreinterpretq_u16_s16(vabsq_s16(cr)), 1);
+		const uint16x8_t cbMagnitude = vshlq_n_u16(vreinterpretq_u16_s16(vabsq_s16(cb)), 1);
+
+		int16x8_t offR = mulChromaNEON(crMagnitude, crSign, kCrRFactor);
+		int16x8_t offG = vnegq_s16(vaddq_s16(mulChromaNEON(crMagnitude, crSign, kCrGFactor), mulChromaNEON(cbMagnitude, cbSign, kCbGFactor)));
+		int16x8_t offB = mulChromaNEON(cbMagnitude, cbSign, kCbBFactor);
+		if (itu) {
+			offR = vshlq_n_s16(offR, kITUShift);
+			offG = vshlq_n_s16(offG, kITUShift);
+			offB = vshlq_n_s16(offB, kITUShift);
+		}
+
+		if (halfChroma) {
+			const int16x8x2_t r = vzipq_s16(offR, offR);
+			const int16x8x2_t g = vzipq_s16(offG, offG);
+			const int16x8x2_t b = vzipq_s16(offB, offB);
+
+			const uint8x16_t y1 = vld1q_u8(ySrc + x);
+			const uint8x16_t y2 = vld1q_u8(ySrc + yPitch + x);
+			convertPixelsNEON<PixelInt, itu>(dst + x, vget_low_u8(y1), r.val[0], g.val[0], b.val[0], packing);
+			convertPixelsNEON<PixelInt, itu>(dst + x + 8, vget_high_u8(y1), r.val[1], g.val[1], b.val[1], packing);
+			convertPixelsNEON<PixelInt, itu>(dst2 + x, vget_low_u8(y2), r.val[0], g.val[0], b.val[0], packing);
+			convertPixelsNEON<PixelInt, itu>(dst2 + x + 8, vget_high_u8(y2), r.val[1], g.val[1], b.val[1], packing);
+		} else {
+			convertPixelsNEON<PixelInt, itu>(dst + x, vld1_u8(ySrc + x), offR, offG, offB, packing);
+		}
+	}
+
+	convertRest<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, colorTab, rgbToPix);
+}
+
+#define convertRowsVector convertRowsNEON
+
+#endif
+
+template<typename PixelInt, bool halfChroma, bool itu>
+static void convertYUVToRGBVector(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const PixelPacking packing(lookup->getFormat());
+	const uint32 *rgbToPix = lookup->getRGBToPix();
+	const int rowsPerChroma = halfChroma ? 2 : 1;
+
+	for (int h = 0; h < yHeight; h += rowsPerChroma) {
+		convertRowsVector<PixelInt, halfChroma, itu>((PixelInt *)dstPtr, dstPitch, ySrc, yPitch, uSrc, vSrc, yWidth, packing, colorTab, rgbToPix);
+
+		dstPtr += rowsPerChroma * dstPitch;
+		ySrc += rowsPerChroma * yPitch;
+		uSrc += uvPitch;
+		vSrc += uvPitch;
+	}
+}
+
+#undef convertRowsVector
+
+/**
+ * Convert a YUV444 or, with halfChroma, a YUV420 image with the vector
+ * code, if the CPU supports it.
+ * @return false if the lookup tables have to be used instead
+ */
+template<bool halfChroma>
+static bool convertYUVToRGBVector(Graphics::Surface *dst, const YUVToRGBLookup *lookup, const int16 *colorTab, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+#if defined(SCUMMVM_SSE2)
+	if (!Common::hasCpuFeature(Common::kCpuFeatureSSE2))
+		return false;
+#else
+	if (!Common::hasCpuFeature(Common::kCpuFeatureNEON))
+		return false;
+#endif
+
+	byte *dstPtr = (byte *)dst->getPixels();
+	const bool itu = lookup->getScale() == YUVToRGBManager::kScaleITU;
+
+	if (dst->format.bytesPerPixel == 2) {
+		if (itu)
+			convertYUVToRGBVector<uint16, halfChroma, true>(dstPtr, dst->pitch, lookup, colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		else
+			convertYUVToRGBVector<uint16, halfChroma, false>(dstPtr, dst->pitch, lookup, colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	} else {
+		if (itu)
+			convertYUVToRGBVector<uint32, halfChroma, true>(dstPtr, dst->pitch, lookup, colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+		else
+			convertYUVToRGBVector<uint32, halfChroma, false>(dstPtr, dst->pitch, lookup, colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	}
+
+	return true;
+}
+
+#endif
+
+#pragma mark -
+#pragma mark --- Lookup table converters ---
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -235,6 +585,11 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_NEON)
+	if (convertYUVToRGBVector<false>(dst, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch))
+		return;
+#endif
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV444ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
@@ -291,6 +646,11 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
+#if defined(SCUMMVM_SSE2) || defined(SCUMMVM_NEON)
+	if (convertYUVToRGBVector<true>(dst, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch))
+		return;
+#endif
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV420ToRGB<uint16>((byte *)dst->getPixels(), dst->pitch, lookup, _colorTab, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
@@ -83,6 +83,9 @@ struct WidgetDrawData {
 
 	bool _buffer;
 
+	/** Whether the DrawData cache may keep this item */
+	bool _cacheable;
+
 
 	/**
 	 * Calculates the background threshold offset of a given DrawData item.
@@ -92,6 +95,13 @@ struct WidgetDrawData {
 	 * value will be added when restoring the background of the widget.
 	 */
 	void calcBackgroundOffset();
+
+	/**
+	 * Decides whether the item can be cached. Its DrawSteps must only
+	 * draw inside of the widget and its background offset, and must not
+	 * depend on the colors left behind by whatever was drawn before.
+	 */
+	void calcCacheable();
 };
 
 class ThemeItem {
@@ -154,6 +164,79 @@ protected:
 	bool _alpha;
 };
 
+/**
+ * Keeps the pixels of recently rendered DrawData items, together with the
+ * background they were rendered onto. Gradients, rounded corners and
+ * shadows are expensive to render, but dialogs draw the same items at the
+ * same places over and over, e.g. every time they are opened.
+ *
+ * Items are looked up by their DrawData, size, dynamic data and whether
+ * shadows are drawn. As the renderer blends with the background, an item
+ * is only copied from the cache if the background is the same as when it
+ * was cached.
+ */
+class DrawDataCache {
+public:
+	DrawDataCache();
+	~DrawDataCache();
+
+	struct Entry;
+
+	/**
+	 * Copies an item onto the surface, if it is in the cache.
+	 * @return false if the item has to be rendered
+	 */
+	bool draw(Graphics::Surface *surface, const WidgetDrawData *data, const Common::Rect &area,
+	          const Common::Rect &rect, uint32 dynamicData, bool shadows);
+
+	/**
+	 * Adds an item which is about to be rendered, keeping the background
+	 * of its rect. finish() has to be called once it has been rendered.
+	 * @return the new entry, or NULL if the item is too large to be cached
+	 */
+	Entry *add(Graphics::Surface *surface, const WidgetDrawData *data, const Common::Rect &area,
+	           const Common::Rect &rect, uint32 dynamicData, bool shadows);
+
+	/** Keeps the pixels of an item added with add(). */
+	void finish(Entry *entry, const Graphics::Surface *surface, const Common::Rect &rect);
+
+	/** Removes all items. */
+	void clear();
+
+	bool isEnabled() const { return _enabled; }
+	void setEnabled(bool enabled);
+
+	ThemeEngine::DrawCacheStats &getStats() { return _stats; }
+
+	struct Entry {
+		const WidgetDrawData *data;
+		int16 width, height;
+		uint32 dynamicData;
+		bool shadows;
+		bool oddX;  ///< gradients are dithered on odd and even columns
+		uint32 lastUsed;
+		Common::Array<byte> background;
+		Common::Array<byte> pixels;
+	};
+
+private:
+	enum {
+		kMaxEntries = 64,
+		kMaxBytes = 8 * 1024 * 1024
+	};
+
+	Common::Array<Entry *> _entries;
+	uint32 _useCounter;
+	bool _enabled;
+	ThemeEngine::DrawCacheStats _stats;
+
+	static bool matches(const Entry *entry, const WidgetDrawData *data, const Common::Rect &area, uint32 dynamicData, bool shadows);
+	static bool compareRect(const Common::Array<byte> &pixels, const Graphics::Surface *surface, const Common::Rect &rect);
+	static void copyFromRect(Common::Array<byte> &pixels, const Graphics::Surface *surface, const Common::Rect &rect);
+	static void copyToRect(const Common::Array<byte> &pixels, Graphics::Surface *surface, const Common::Rect &rect);
+	void removeOldest();
+};
+
 
 
 /**********************************************************
@@ -232,11 +315,8 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
-	}
+	if (draw)
+		_engine->drawDrawData(_data, _area, extendedRect, _dynamicData);
 
 	_engine->addDirtyRect(extendedRect);
 }
@@ -269,6 +349,134 @@ void ThemeItemBitmap::drawSelf(bool draw, bool restore) {
 
 
 
+/**********************************************************
+ * DrawData cache
+ *********************************************************/
+DrawDataCache::DrawDataCache() : _useCounter(0), _enabled(true) {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+DrawDataCache::~DrawDataCache() {
+	clear();
+}
+
+bool DrawDataCache::draw(Graphics::Surface *surface, const WidgetDrawData *data, const Common::Rect &area,
+                         const Common::Rect &rect, uint32 dynamicData, bool shadows) {
+	for (uint i = 0; i < _entries.size(); ++i) {
+		Entry *entry = _entries[i];
+		if (matches(entry, data, area, dynamicData, shadows) && compareRect(entry->background, surface, rect)) {
+			copyToRect(entry->pixels, surface, rect);
+			entry->lastUsed = ++_useCounter;
+			_stats.hits++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+DrawDataCache::Entry *DrawDataCache::add(Graphics::Surface *surface, const WidgetDrawData *data, const Common::Rect &area,
+                                         const Common::Rect &rect, uint32 dynamicData, bool shadows) {
+	const uint32 size = 2 * rect.width() * rect.height() * surface->format.bytesPerPixel;
+	if (size > kMaxBytes / 2)
+		return 0;
+
+	while (!_entries.empty() && (_entries.size() >= kMaxEntries || _stats.bytes + size > kMaxBytes))
+		removeOldest();
+
+	Entry *entry = new Entry;
+	entry->data = data;
+	entry->width = area.width();
+	entry->height = area.height();
+	entry->dynamicData = dynamicData;
+	entry->shadows = shadows;
+	entry->oddX = (area.left & 1) != 0;
+	entry->lastUsed = ++_useCounter;
+	copyFromRect(entry->background, surface, rect);
+
+	_entries.push_back(entry);
+	_stats.bytes += size;
+	_stats.misses++;
+	return entry;
+}
+
+void DrawDataCache::finish(Entry *entry, const Graphics::Surface *surface, const Common::Rect &rect) {
+	copyFromRect(entry->pixels, surface, rect);
+}
+
+void DrawDataCache::clear() {
+	for (uint i = 0; i < _entries.size(); ++i)
+		delete _entries[i];
+	_entries.clear();
+	_stats.bytes = 0;
+}
+
+void DrawDataCache::setEnabled(bool enabled) {
+	if (!enabled)
+		clear();
+	_enabled = enabled;
+}
+
+bool DrawDataCache::matches(const Entry *entry, const WidgetDrawData *data, const Common::Rect &area, uint32 dynamicData, bool shadows) {
+	return entry->data == data && entry->width == area.width() && entry->height == area.height()
+	    && entry->dynamicData == dynamicData && entry->shadows == shadows && entry->oddX == ((area.left & 1) != 0);
+}
+
+bool DrawDataCache::compareRect(const Common::Array<byte> &pixels, const Graphics::Surface *surface, const Common::Rect &rect) {
+	const uint rowSize = rect.width() * surface->format.bytesPerPixel;
+	const byte *src = &pixels[0];
+	const byte *dst = (const byte *)surface->getBasePtr(rect.left, rect.top);
+
+	for (int y = 0; y < rect.height(); ++y) {
+		if (memcmp(src, dst, rowSize))
+			return false;
+		src += rowSize;
+		dst += surface->pitch;
+	}
+
+	return true;
+}
+
+void DrawDataCache::copyFromRect(Common::Array<byte> &pixels, const Graphics::Surface *surface, const Common::Rect &rect) {
+	const uint rowSize = rect.width() * surface->format.bytesPerPixel;
+	pixels.resize(rowSize * rect.height());
+	byte *dst = &pixels[0];
+	const byte *src = (const byte *)surface->getBasePtr(rect.left, rect.top);
+
+	for (int y = 0; y < rect.height(); ++y) {
+		memcpy(dst, src, rowSize);
+		dst += rowSize;
+		src += surface->pitch;
+	}
+}
+
+void DrawDataCache::copyToRect(const Common::Array<byte> &pixels, Graphics::Surface *surface, const Common::Rect &rect) {
+	const uint rowSize = rect.width() * surface->format.bytesPerPixel;
+	const byte *src = &pixels[0];
+	byte *dst = (byte *)surface->getBasePtr(rect.left, rect.top);
+
+	for (int y = 0; y < rect.height(); ++y) {
+		memcpy(dst, src, rowSize);
+		src += rowSize;
+		dst += surface->pitch;
+	}
+}
+
+void DrawDataCache::removeOldest() {
+	uint oldest = 0;
+	for (uint i = 1; i < _entries.size(); ++i) {
+		if (_entries[i]->lastUsed < _entries[oldest]->lastUsed)
+			oldest = i;
+	}
+
+	// The pixels take as much memory as the background
+	_stats.bytes -= 2 * _entries[oldest]->background.size();
+	delete _entries[oldest];
+	_entries.remove_at(oldest);
+}
+
+
+
 /**********************************************************
  * ThemeEngine class
  *********************************************************/
@@ -281,6 +489,7 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system = g_system;
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
+	_drawCache = new DrawDataCache();
 
 	_useCursor = false;
 
@@ -321,6 +530,7 @@ ThemeEngine::~ThemeEngine() {
 	_backBuffer.free();
 
 	unloadTheme();
+	delete _drawCache;
 
 	// Release all graphics surfaces
 	for (ImagesMap::iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
@@ -523,6 +733,9 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
 
+	// The cached items were rendered by the old renderer
+	_drawCache->clear();
+
 	// Since we reinitialized our screen surfaces we know nothing has been
 	// drawn so far. Sometimes we still end up with dirty screen bits in the
 	// list. Clearing it avoids invalid overlay writes when the backend
@@ -544,6 +757,84 @@ void WidgetDrawData::calcBackgroundOffset() {
 	_backgroundOffset = maxShadow;
 }
 
+void WidgetDrawData::calcCacheable() {
+	_cacheable = false;
+
+	for (Common::List<Graphics::DrawStep>::const_iterator step = _steps.begin();
+	        step != _steps.end(); ++step) {
+		// Filling the surface draws outside of the widget
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_FILLSURFACE)
+			return;
+
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_VOID ||
+		        step->drawingCall == &Graphics::VectorRenderer::drawCallback_BITMAP)
+			continue;
+
+		// Shadows of steps with a fixed size are not included in the
+		// background offset
+		if (!(step->autoWidth && step->autoHeight) && step->shadow)
+			return;
+
+		// Colors which aren't set are taken over from the previous step
+		if (!step->fgColor.set)
+			return;
+		if (step->fillMode == Graphics::VectorRenderer::kFillBackground && !step->bgColor.set)
+			return;
+		if (step->fillMode == Graphics::VectorRenderer::kFillGradient && !(step->gradColor1.set && step->gradColor2.set))
+			return;
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_BEVELSQ && !step->bevelColor.set)
+			return;
+	}
+
+	_cacheable = true;
+}
+
+void ThemeEngine::drawDrawData(const WidgetDrawData *data, const Common::Rect &area, const Common::Rect &extendedRect, uint32 dynamicData) {
+	Graphics::Surface *surface = _vectorRenderer->getSurface();
+	const bool shadows = _vectorRenderer->areShadowsEnabled();
+	DrawDataCache::Entry *entry = 0;
+
+	// Shadows can reach one pixel further than the background offset
+	Common::Rect rect(extendedRect);
+	rect.grow(1);
+
+	// The renderer leaves out shadows of shapes touching the edges of the
+	// surface, so items there are drawn differently than elsewhere
+	Common::Rect bounds(rect);
+	bounds.grow(1);
+
+	if (_drawCache->isEnabled() && data->_cacheable && Common::Rect(surface->w, surface->h).contains(bounds)) {
+		if (_drawCache->draw(surface, data, area, rect, dynamicData, shadows))
+			return;
+
+		entry = _drawCache->add(surface, data, area, rect, dynamicData, shadows);
+	}
+
+	Common::List<Graphics::DrawStep>::const_iterator step;
+	for (step = data->_steps.begin(); step != data->_steps.end(); ++step)
+		_vectorRenderer->drawStep(area, *step, dynamicData);
+
+	if (entry)
+		_drawCache->finish(entry, surface, rect);
+}
+
+void ThemeEngine::setDrawCacheEnabled(bool enabled) {
+	_drawCache->setEnabled(enabled);
+}
+
+bool ThemeEngine::isDrawCacheEnabled() const {
+	return _drawCache->isEnabled();
+}
+
+ThemeEngine::DrawCacheStats ThemeEngine::getDrawCacheStats() const {
+	return _drawCache->getStats();
+}
+
+void ThemeEngine::resetDrawCacheStats() {
+	DrawCacheStats &stats = _drawCache->getStats();
+	stats.hits = stats.misses = 0;
+}
+
 void ThemeEngine::restoreBackground(Common::Rect r) {
 	r.clip(_screen.w, _screen.h);
 	_vectorRenderer->blitSurface(&_backBuffer, r);
@@ -673,6 +964,7 @@ bool ThemeEngine::addDrawData(const Common::String &data, bool cached) {
 
 	_widgets[id] = new WidgetDrawData;
 	_widgets[id]->_buffer = kDrawDataDefaults[id].buffer;
+	_widgets[id]->_cacheable = false;
 	_widgets[id]->_textDataId = kTextDataNone;
 
 	return true;
@@ -704,6 +996,7 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 			warning("Missing data asset: '%s'", kDrawDataDefaults[i].name);
 		} else {
 			_widgets[i]->calcBackgroundOffset();
+			_widgets[i]->calcCacheable();
 		}
 	}
 }
@@ -712,6 +1005,8 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	_drawCache->clear();
+
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
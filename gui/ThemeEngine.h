@@ -51,6 +51,7 @@ struct WidgetDrawData;
 struct TextDrawData;
 struct TextColorData;
 class Dialog;
+class DrawDataCache;
 class GuiObject;
 class ThemeEval;
 class ThemeItem;
@@ -380,6 +381,31 @@ public:
 	//@}
 
 
+	/** @name DRAWDATA CACHE METHODS */
+	//@{
+
+	/** Usage statistics of the DrawData cache */
+	struct DrawCacheStats {
+		uint32 hits;    ///< items copied from the cache
+		uint32 misses;  ///< items rendered and added to the cache
+		uint32 bytes;   ///< memory used for the cached items
+	};
+
+	/**
+	 * Enables or disables the cache of rendered DrawData items. While it
+	 * is enabled, drawing an item again at the same size onto the same
+	 * background copies its pixels instead of rendering its DrawSteps.
+	 * Disabling it frees the cached items.
+	 */
+	void setDrawCacheEnabled(bool enabled);
+	bool isDrawCacheEnabled() const;
+
+	DrawCacheStats getDrawCacheStats() const;
+	void resetDrawCacheStats();
+
+	//@}
+
+
 
 	/**
 	 * Actual implementation of a dirty rect handling.
@@ -523,6 +549,18 @@ public:
 	 */
 	void restoreBackground(Common::Rect r);
 
+	/**
+	 * Draws the DrawSteps of a DrawData item, or copies the item from the
+	 * cache if it has been drawn like this before.
+	 *
+	 * @param data          the item to draw
+	 * @param area          area of the widget
+	 * @param extendedRect  area including everything drawn outside of the
+	 *                      widget, as restored by restoreBackground()
+	 * @param dynamicData   dynamic data of the DrawSteps
+	 */
+	void drawDrawData(const WidgetDrawData *data, const Common::Rect &area, const Common::Rect &extendedRect, uint32 dynamicData);
+
 	const Common::String &getThemeName() const { return _themeName; }
 	const Common::String &getThemeId() const { return _themeId; }
 	int getGraphicsMode() const { return _graphicsMode; }
@@ -673,6 +711,9 @@ protected:
 	/** Queue with all the drawing that must be done to the screen */
 	Common::List<ThemeItem *> _screenQueue;
 
+	/** Recently rendered DrawData items */
+	DrawDataCache *_drawCache;
+
 	bool _initOk;  ///< Class and renderer properly initialized
 	bool _themeOk; ///< Theme data successfully loaded.
 	bool _enabled; ///< Whether the Theme is currently shown on the overlay
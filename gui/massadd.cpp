@@ -23,6 +23,7 @@
 #include "common/algorithm.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
+#include "common/md5cache.h"
 #include "common/system.h"
 #include "common/taskbar.h"
 #include "common/translation.h"
@@ -116,6 +117,13 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 		if (!path.empty())
 			_pathToTargets[path].push_back(iter->_key);
 	}
+
+	// Save the checksums computed during the scan only once at the end
+	Common::MD5Cache::instance().beginBatch();
+}
+
+MassAddDialog::~MassAddDialog() {
+	Common::MD5Cache::instance().endBatch();
 }
 
 struct GameTargetLess {
@@ -23,6 +23,8 @@
 #include "common/translation.h"
 #include "common/config-manager.h"
 
+#include "engines/saveindex.h"
+
 #include "gui/message.h"
 #include "gui/gui-manager.h"
 #include "gui/ThemeEval.h"
@@ -104,7 +106,30 @@ int SaveLoadChooserDialog::run(const Common::String &target, const MetaEngine *m
 	_saveDateSupport = _metaInfoSupport && _metaEngine->hasFeature(MetaEngine::kSavesSupportCreationDate);
 	_playTimeSupport = _metaInfoSupport && _metaEngine->hasFeature(MetaEngine::kSavesSupportPlayTime);
 
-	return runIntern();
+	const int result = runIntern();
+
+	// Store what was read from the savefiles for the next time
+	SaveStateIndex *index = SaveStateIndexMan.getIndex(target);
+	if (index)
+		index->flush();
+
+	return result;
+}
+
+SaveStateList SaveLoadChooserDialog::listSaves() const {
+	SaveStateIndex *index = SaveStateIndexMan.getIndex(_target);
+	if (index)
+		return index->listSaves(*_metaEngine, _target);
+
+	return _metaEngine->listSaves(_target.c_str());
+}
+
+SaveStateDescriptor SaveLoadChooserDialog::querySaveMetaInfos(int slot) const {
+	SaveStateIndex *index = SaveStateIndexMan.getIndex(_target);
+	if (index)
+		return index->querySaveMetaInfos(*_metaEngine, _target, slot, _thumbnailSupport);
+
+	return _metaEngine->querySaveMetaInfos(_target.c_str(), slot);
 }
 
 void SaveLoadChooserDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data) {
@@ -361,7 +386,7 @@ void SaveLoadChooserSimple::updateSelection(bool redraw) {
 	_playtime->setLabel(_("No playtime saved"));
 
 	if (selItem >= 0 && _metaInfoSupport) {
-		SaveStateDescriptor desc = _metaEngine->querySaveMetaInfos(_target.c_str(), _saveList[selItem].getSaveSlot());
+		SaveStateDescriptor desc = querySaveMetaInfos(_saveList[selItem].getSaveSlot());
 
 		isDeletable = desc.getDeletableFlag() && _delSupport;
 		isWriteProtected = desc.getWriteProtectedFlag();
@@ -462,7 +487,7 @@ void SaveLoadChooserSimple::close() {
 }
 
 void SaveLoadChooserSimple::updateSaveList() {
-	_saveList = _metaEngine->listSaves(_target.c_str());
+	_saveList = listSaves();
 
 	int curSlot = 0;
 	int saveSlot = 0;
@@ -621,7 +646,7 @@ void SaveLoadChooserGrid::handleMouseWheel(int x, int y, int direction) {
 void SaveLoadChooserGrid::open() {
 	SaveLoadChooserDialog::open();
 
-	_saveList = _metaEngine->listSaves(_target.c_str());
+	_saveList = listSaves();
 	_resultString.clear();
 
 	// Load information to restore the last page the user had open.
@@ -853,7 +878,7 @@ void SaveLoadChooserGrid::updateSaves() {
 	for (uint i = _curPage * _entriesPerPage, curNum = 0; i < _saveList.size() && curNum < _entriesPerPage; ++i, ++curNum) {
 		const uint saveSlot = _saveList[i].getSaveSlot();
 
-		SaveStateDescriptor desc = _metaEngine->querySaveMetaInfos(_target.c_str(), saveSlot);
+		SaveStateDescriptor desc = querySaveMetaInfos(saveSlot);
 		SlotButton &curButton = _buttons[curNum];
 		curButton.setVisible(true);
 		const Graphics::Surface *thumbnail = desc.getThumbnail();
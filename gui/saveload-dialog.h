@@ -69,6 +69,19 @@ public:
 protected:
 	virtual int runIntern() = 0;
 
+	/**
+	 * Lists the save states of the target, from the save state index if
+	 * there is one.
+	 */
+	SaveStateList listSaves() const;
+
+	/**
+	 * Queries a save state of the target, from the save state index if
+	 * there is one. The thumbnail is only read if the dialog shows
+	 * thumbnails.
+	 */
+	SaveStateDescriptor querySaveMetaInfos(int slot) const;
+
 	const bool				_saveMode;
 	const MetaEngine		*_metaEngine;
 	bool					_delSupport;
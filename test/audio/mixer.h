@@ -0,0 +1,98 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "common/config-manager.h"
+#include "test/system.h"
+
+/**
+ * Silence, which counts how often it is deleted, and optionally stops
+ * another sound when it is, like streams which own other sounds do.
+ */
+class StoppingStream : public Audio::AudioStream {
+public:
+	StoppingStream(int &deleted, Audio::Mixer *mixer = 0, Audio::SoundHandle stopHandle = Audio::SoundHandle())
+		: _deleted(deleted), _mixer(mixer), _stopHandle(stopHandle) {}
+
+	~StoppingStream() {
+		_deleted++;
+		if (_mixer)
+			_mixer->stopHandle(_stopHandle);
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		memset(buffer, 0, numSamples * sizeof(int16));
+		return numSamples;
+	}
+
+	bool isStereo() const { return false; }
+	int getRate() const { return 22050; }
+	bool endOfData() const { return false; }
+
+private:
+	int &_deleted;
+	Audio::Mixer *_mixer;
+	Audio::SoundHandle _stopHandle;
+};
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void setUp() {
+		// The mixer guards its state with mutexes
+		TestSystem::install();
+	}
+
+	void tearDown() {
+		TS_ASSERT_EQUALS(TestSystem::getLockCount(), 0);
+	}
+
+	void test_stop_from_stream_destructor() {
+		Audio::MixerImpl *mixerImpl = new Audio::MixerImpl(g_system, 44100);
+		mixerImpl->setReady(true);
+		Audio::Mixer *mixer = mixerImpl;
+
+		int deletedFirst = 0, deletedSecond = 0;
+		Audio::SoundHandle first, second;
+		mixer->playStream(Audio::Mixer::kSFXSoundType, &first, new StoppingStream(deletedFirst));
+		mixer->playStream(Audio::Mixer::kSFXSoundType, &second, new StoppingStream(deletedSecond, mixer, first));
+
+		// Deleting the second stream stops the first sound while the stop
+		// of the second one is being executed
+		mixer->stopHandle(second);
+		TS_ASSERT_EQUALS(deletedSecond, 1);
+		TS_ASSERT_EQUALS(deletedFirst, 1);
+		TS_ASSERT(!mixer->isSoundHandleActive(first));
+		TS_ASSERT(!mixer->isSoundHandleActive(second));
+
+		// Nothing is executed twice later on
+		int16 samples[2 * 256];
+		mixerImpl->mixCallback((byte *)samples, sizeof(samples));
+		delete mixerImpl;
+		TS_ASSERT_EQUALS(deletedSecond, 1);
+		TS_ASSERT_EQUALS(deletedFirst, 1);
+	}
+
+	void test_channel_limit_from_config() {
+		ConfMan.setInt("mixer_channels", 2, Common::ConfigManager::kTransientDomain);
+		Audio::MixerImpl *mixerImpl = new Audio::MixerImpl(g_system, 44100);
+		ConfMan.removeKey("mixer_channels", Common::ConfigManager::kTransientDomain);
+		mixerImpl->setReady(true);
+		Audio::Mixer *mixer = mixerImpl;
+
+		// Sounds beyond the limit are dropped right away
+		int deleted[3] = { 0, 0, 0 };
+		Audio::SoundHandle handles[3];
+		for (int i = 0; i < 3; ++i)
+			mixer->playStream(Audio::Mixer::kSFXSoundType, &handles[i], new StoppingStream(deleted[i]));
+
+		TS_ASSERT(mixer->isSoundHandleActive(handles[0]));
+		TS_ASSERT(mixer->isSoundHandleActive(handles[1]));
+		TS_ASSERT(!mixer->isSoundHandleActive(handles[2]));
+		TS_ASSERT_EQUALS(deleted[2], 1);
+
+		delete mixerImpl;
+		TS_ASSERT_EQUALS(deleted[0], 1);
+		TS_ASSERT_EQUALS(deleted[1], 1);
+	}
+};
@@ -0,0 +1,264 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+
+#include "common/cpudetect.h"
+#include "common/frac.h"
+#include "common/memstream.h"
+#include "common/endian.h"
+#include "common/util.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	static int16 *createNoise(const int samples, uint32 seed) {
+		int16 *data = new int16[samples];
+		for (int i = 0; i < samples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (int16)(seed >> 16);
+			// Throw in full scale samples to exercise clamping and overflow
+			if ((i % 37) == 0)
+				data[i] = (i & 1) ? 32767 : -32768;
+		}
+		return data;
+	}
+
+	static Audio::AudioStream *createStream(const int16 *data, const int samples, const int rate, const bool stereo) {
+		byte *raw = (byte *)malloc(samples * 2);
+		for (int i = 0; i < samples; ++i)
+			WRITE_LE_UINT16(raw + i * 2, data[i]);
+
+		Common::SeekableReadStream *stream = new Common::MemoryReadStream(raw, samples * 2, DisposeAfterUse::YES);
+		return Audio::makeRawStream(stream, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	/**
+	 * The linear interpolation as done by the original frame-by-frame
+	 * implementation of LinearRateConverter.
+	 */
+	static int referenceLinear(const int16 *in, const int inFrames, const bool stereo, const uint32 inRate, const uint32 outRate,
+	                           int16 *out, const int outFrames, const uint16 volL, const uint16 volR) {
+		const frac_t inc = (inRate << FRAC_BITS) / outRate;
+		frac_t pos = FRAC_ONE;
+		int16 last0 = 0, last1 = 0, cur0 = 0, cur1 = 0;
+		int read = 0;
+
+		for (int o = 0; o < outFrames; ++o) {
+			while ((frac_t)FRAC_ONE <= pos) {
+				if (read == inFrames)
+					return o;
+				last0 = cur0;
+				cur0 = in[read * (stereo ? 2 : 1)];
+				if (stereo) {
+					last1 = cur1;
+					cur1 = in[read * 2 + 1];
+				}
+				read++;
+				pos -= FRAC_ONE;
+			}
+
+			const int16 out0 = (int16)(last0 + (((cur0 - last0) * pos + FRAC_HALF) >> FRAC_BITS));
+			const int16 out1 = stereo ? (int16)(last1 + (((cur1 - last1) * pos + FRAC_HALF) >> FRAC_BITS)) : out0;
+			Audio::clampedAdd(out[o * 2 + 0], (out0 * (int)volL) / Audio::Mixer::kMaxMixerVolume);
+			Audio::clampedAdd(out[o * 2 + 1], (out1 * (int)volR) / Audio::Mixer::kMaxMixerVolume);
+			pos += inc;
+		}
+		return outFrames;
+	}
+
+	/**
+	 * Runs a converter over the whole stream in chunks of varying size,
+	 * mixing into a pre-filled output buffer.
+	 */
+	static int runConverter(const int16 *in, const int samples, const bool stereo, const bool reverse, const uint32 inRate, const uint32 outRate,
+	                        int16 *out, const int outFrames, const uint16 volL, const uint16 volR) {
+		Audio::AudioStream *stream = createStream(in, samples, inRate, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverse);
+
+		int done = 0, chunk = 1;
+		while (done < outFrames) {
+			const int len = MIN(chunk, outFrames - done);
+			const int res = converter->flow(*stream, out + done * 2, len, volL, volR);
+			done += res;
+			if (res < len)
+				break;
+			chunk = (chunk * 7 + 3) % 700;
+		}
+
+		delete converter;
+		delete stream;
+		return done;
+	}
+
+	void compareWithReference(const bool stereo, const uint32 inRate, const uint32 outRate, const uint16 volL, const uint16 volR) {
+		const int inFrames = 3000;
+		const int samples = inFrames * (stereo ? 2 : 1);
+		const int outFrames = (int)((uint64)inFrames * outRate / inRate) + 16;
+
+		int16 *in = createNoise(samples, inRate ^ outRate);
+		int16 *expected = createNoise(outFrames * 2, 42);
+		int16 *actual = createNoise(outFrames * 2, 42);
+
+		const int expectedFrames = referenceLinear(in, inFrames, stereo, inRate, outRate, expected, outFrames, volL, volR);
+		const int actualFrames = runConverter(in, samples, stereo, false, inRate, outRate, actual, outFrames, volL, volR);
+
+		TS_ASSERT_EQUALS(actualFrames, expectedFrames);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, outFrames * 2 * sizeof(int16)), 0);
+
+		delete[] in;
+		delete[] expected;
+		delete[] actual;
+	}
+
+	void compareWithPlainC(const bool stereo, const bool reverse, const uint32 inRate, const uint32 outRate) {
+		const int inFrames = 2000;
+		const int samples = inFrames * (stereo ? 2 : 1);
+		const int outFrames = (int)((uint64)inFrames * outRate / inRate) + 16;
+
+		int16 *in = createNoise(samples, inRate + outRate);
+		int16 *expected = createNoise(outFrames * 2, 7);
+		int16 *actual = createNoise(outFrames * 2, 7);
+
+		Common::setCpuFeatureMask(0);
+		const int expectedFrames = runConverter(in, samples, stereo, reverse, inRate, outRate, expected, outFrames, 256, 97);
+		Common::setCpuFeatureMask(0xFFFFFFFF);
+		const int actualFrames = runConverter(in, samples, stereo, reverse, inRate, outRate, actual, outFrames, 256, 97);
+
+		TS_ASSERT_EQUALS(actualFrames, expectedFrames);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, outFrames * 2 * sizeof(int16)), 0);
+
+		delete[] in;
+		delete[] expected;
+		delete[] actual;
+	}
+
+public:
+	void test_kernels_match_plain_c() {
+		Common::setCpuFeatureMask(0);
+		const Audio::RateKernels &plain = Audio::getRateKernels();
+		Common::setCpuFeatureMask(0xFFFFFFFF);
+		const Audio::RateKernels &best = Audio::getRateKernels();
+
+		const int frames = 203;
+		int16 *src = createNoise(frames * 2 + 2, 1);
+		int16 *expected = createNoise(frames * 2, 2);
+		int16 *actual = new int16[frames * 2];
+
+		const uint16 volumes[] = { 0, 1, 127, 255, 256 };
+		for (int l = 0; l < ARRAYSIZE(volumes); ++l) {
+			for (int r = 0; r < ARRAYSIZE(volumes); ++r) {
+				Audio::MixFramesProc procs[3][2] = {
+					{ plain.mixMono, best.mixMono },
+					{ plain.mixStereo, best.mixStereo },
+					{ plain.mixStereoReverse, best.mixStereoReverse }
+				};
+				for (int p = 0; p < 3; ++p) {
+					memcpy(actual, expected, frames * 2 * sizeof(int16));
+					int16 *reference = new int16[frames * 2];
+					memcpy(reference, expected, frames * 2 * sizeof(int16));
+
+					procs[p][0](reference, src, frames, volumes[l], volumes[r]);
+					procs[p][1](actual, src, frames, volumes[l], volumes[r]);
+					TS_ASSERT_EQUALS(memcmp(reference, actual, frames * 2 * sizeof(int16)), 0);
+
+					delete[] reference;
+				}
+			}
+		}
+
+		const frac_t incs[] = { FRAC_ONE / 4, (11025 << FRAC_BITS) / 44100, (22050 << FRAC_BITS) / 48000, FRAC_ONE - 1, (48000 << FRAC_BITS) / 44100 };
+		for (int i = 0; i < ARRAYSIZE(incs); ++i) {
+			const int n = MIN<int>(frames, (frames - 2) * FRAC_ONE / incs[i]);
+			int16 reference[frames * 2];
+
+			plain.interpolateMono(reference, src, 123, incs[i], n);
+			best.interpolateMono(actual, src, 123, incs[i], n);
+			TS_ASSERT_EQUALS(memcmp(reference, actual, n * sizeof(int16)), 0);
+
+			plain.interpolateStereo(reference, src, 123, incs[i], n);
+			best.interpolateStereo(actual, src, 123, incs[i], n);
+			TS_ASSERT_EQUALS(memcmp(reference, actual, n * 2 * sizeof(int16)), 0);
+		}
+
+		delete[] src;
+		delete[] expected;
+		delete[] actual;
+	}
+
+	void test_linear_matches_reference_mono() {
+		compareWithReference(false, 11025, 44100, 256, 256);
+		compareWithReference(false, 22050, 48000, 200, 31);
+		compareWithReference(false, 48000, 44100, 256, 256);
+	}
+
+	void test_linear_matches_reference_stereo() {
+		compareWithReference(true, 11025, 44100, 256, 256);
+		compareWithReference(true, 32000, 22050, 17, 256);
+		compareWithReference(true, 44100, 48000, 256, 128);
+	}
+
+	void test_converters_match_plain_c() {
+		const uint32 rates[][2] = { { 22050, 22050 }, { 44100, 22050 }, { 48000, 8000 }, { 11025, 44100 }, { 22050, 48000 }, { 48000, 44100 } };
+		for (int i = 0; i < ARRAYSIZE(rates); ++i) {
+			compareWithPlainC(false, false, rates[i][0], rates[i][1]);
+			compareWithPlainC(true, false, rates[i][0], rates[i][1]);
+			compareWithPlainC(true, true, rates[i][0], rates[i][1]);
+		}
+	}
+
+	void test_sinc_preserves_dc() {
+		const uint32 rates[][2] = { { 11025, 44100 }, { 22050, 48000 }, { 48000, 44100 }, { 48000, 8000 } };
+		for (int i = 0; i < ARRAYSIZE(rates); ++i) {
+			for (int stereo = 0; stereo < 2; ++stereo) {
+				const int inFrames = 4000;
+				const int samples = inFrames * (stereo ? 2 : 1);
+				int16 *in = new int16[samples];
+				for (int j = 0; j < samples; ++j)
+					in[j] = (j & 1) && stereo ? -12000 : 10000;
+
+				Audio::AudioStream *stream = createStream(in, samples, rates[i][0], stereo != 0);
+				Audio::RateConverter *converter = Audio::makeRateConverter(rates[i][0], rates[i][1], stereo != 0, false, Audio::kRateConverterSinc);
+
+				const int outFrames = (int)((uint64)inFrames * rates[i][1] / rates[i][0]);
+				int16 *out = new int16[outFrames * 2];
+				memset(out, 0, outFrames * 2 * sizeof(int16));
+				const int done = converter->flow(*stream, out, outFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+				// All but the filter delay should come out
+				TS_ASSERT_LESS_THAN(outFrames - 64 * (int)rates[i][1] / (int)rates[i][0] - 2, done);
+
+				// Skip the fade in from the initial silence
+				for (int j = 64; j < done; ++j) {
+					TS_ASSERT_EQUALS(out[j * 2], 10000);
+					TS_ASSERT_EQUALS(out[j * 2 + 1], stereo ? -12000 : 10000);
+				}
+
+				delete converter;
+				delete stream;
+				delete[] out;
+				delete[] in;
+			}
+		}
+	}
+
+	void test_sinc_same_rate_copies() {
+		int16 *in = createNoise(1000, 3);
+		int16 *out = new int16[1000 * 2];
+		memset(out, 0, 1000 * 2 * sizeof(int16));
+
+		Audio::AudioStream *stream = createStream(in, 1000, 22050, false);
+		Audio::RateConverter *converter = Audio::makeRateConverter(22050, 22050, false, false, Audio::kRateConverterSinc);
+		TS_ASSERT_EQUALS(converter->flow(*stream, out, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+		for (int i = 0; i < 1000; ++i)
+			TS_ASSERT_EQUALS(out[i * 2], in[i]);
+
+		delete converter;
+		delete stream;
+		delete[] out;
+		delete[] in;
+	}
+};
@@ -0,0 +1,130 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "common/str.h"
+#include "common/util.h"
+
+namespace {
+
+/**
+ * A short burst of noise, like the sound effects games fire off in bulk.
+ */
+class BurstStream : public Audio::AudioStream {
+public:
+	BurstStream(int rate, int frames) : _rate(rate), _remaining(frames), _seed(frames) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		const int samples = MIN(numSamples, _remaining);
+		for (int i = 0; i < samples; ++i) {
+			_seed = _seed * 1103515245 + 12345;
+			buffer[i] = (int16)(_seed >> 20);
+		}
+		_remaining -= samples;
+		return samples;
+	}
+
+	bool isStereo() const { return false; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return _remaining == 0; }
+
+private:
+	const int _rate;
+	int _remaining;
+	uint32 _seed;
+};
+
+enum {
+	kOutputRate = 44100,
+	kCallbackFrames = 1024,
+	kCallbacks = 200
+};
+
+/*
+ * Keep @p voices short sounds playing at all times, restarting each as
+ * soon as it ends, while polling and adjusting all of them once per
+ * mixer callback like an engine would once per frame.
+ */
+void runVoices(uint voices) {
+	Audio::MixerImpl *mixer = new Audio::MixerImpl(g_system, kOutputRate, 1024);
+	mixer->setReady(true);
+
+	Common::Array<Audio::SoundHandle> handles;
+	handles.resize(voices);
+
+	int16 buffer[kCallbackFrames * 2];
+	uint64 controlMicros = 0, mixMicros = 0;
+	uint32 started = 0, calls = 0;
+
+	for (uint round = 0; round < kCallbacks; ++round) {
+		uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < voices; ++i) {
+			if (!mixer->isSoundHandleActive(handles[i])) {
+				// Between 10 and 40 ms at 22050 Hz
+				Audio::AudioStream *stream = new BurstStream(22050, 220 + (started * 37) % 660);
+				mixer->playStream(Audio::Mixer::kSFXSoundType, &handles[i], stream, -1, 200, (int8)(i % 64 - 32),
+				                  DisposeAfterUse::YES, false, false);
+				++started;
+			} else {
+				mixer->setChannelVolume(handles[i], (byte)(100 + round % 100));
+				const uint32 elapsed = mixer->getSoundElapsedTime(handles[i]);
+				Benchmark::consume(&elapsed, sizeof(elapsed));
+			}
+		}
+		controlMicros += Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		mixer->mixCallback((byte *)buffer, sizeof(buffer));
+		mixMicros += Benchmark::getMicros() - start;
+		++calls;
+	}
+
+	Benchmark::consume(buffer, sizeof(buffer));
+	mixer->stopAll();
+	delete mixer;
+
+	Common::String label = Common::String::format("%4u voices, control (%u sounds)", voices, started);
+	Benchmark::report(label.c_str(), (double)calls * voices, "handle ops", controlMicros);
+	label = Common::String::format("%4u voices, mixing", voices);
+	Benchmark::report(label.c_str(), (double)calls * kCallbackFrames, "frames", mixMicros);
+}
+
+} // End of anonymous namespace
+
+/**
+ * Stresses the mixer with hundreds of short sounds: allocating channels,
+ * per-handle queries and mixing, at increasing numbers of simultaneous
+ * voices. The control cost per handle should not depend on the number
+ * of voices.
+ */
+BENCHMARK(audio_mixer) {
+	Benchmark::initSystem();
+
+	const uint voices[] = { 16, 64, 256, 1000 };
+	for (uint i = 0; i < ARRAYSIZE(voices); ++i)
+		runVoices(voices[i]);
+}
@@ -0,0 +1,142 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/rate_kernels.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+
+namespace {
+
+/**
+ * An endless stream of pseudo random samples, so that the benchmark
+ * measures the rate converters and not the decoders.
+ */
+class NoiseStream : public Audio::AudioStream {
+public:
+	NoiseStream(int rate, bool stereo) : _rate(rate), _stereo(stereo), _seed(1) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; ++i) {
+			_seed = _seed * 1103515245 + 12345;
+			buffer[i] = (int16)(_seed >> 16);
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	const int _rate;
+	const bool _stereo;
+	uint32 _seed;
+};
+
+enum {
+	kSeconds = 60,
+	kCallbackFrames = 2048
+};
+
+uint64 timeConverter(uint32 inRate, uint32 outRate, bool stereo, bool reverseStereo, Audio::RateConverterQuality quality, uint32 &calls) {
+	NoiseStream stream(inRate, stereo);
+	Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, quality);
+	int16 buffer[kCallbackFrames * 2];
+	memset(buffer, 0, sizeof(buffer));
+
+	const uint64 start = Benchmark::getMicros();
+	calls = 0;
+	for (uint32 done = 0; done < outRate * kSeconds; done += kCallbackFrames, ++calls)
+		converter->flow(stream, buffer, kCallbackFrames, 200, 150);
+	const uint64 micros = Benchmark::getMicros() - start;
+
+	Benchmark::consume(buffer, sizeof(buffer));
+	delete converter;
+	return micros;
+}
+
+void runConverter(uint32 inRate, uint32 outRate, bool stereo, bool reverseStereo) {
+	uint32 calls;
+	const uint64 micros = timeConverter(inRate, outRate, stereo, reverseStereo, Audio::kRateConverterLinear, calls);
+
+	Common::String label = Common::String::format("%5u -> %5u Hz %-6s %-8s %s", inRate, outRate, stereo ? "stereo" : "mono",
+	                                              reverseStereo ? "reversed" : "", Audio::getRateKernels().name);
+	Benchmark::report(label.c_str(), outRate * kSeconds, "frames", micros);
+}
+
+} // End of anonymous namespace
+
+/**
+ * Feeds a minute of audio at each typical game sample rate through the
+ * rate converters (copy, integer decimation and linear interpolation),
+ * once with the plain C kernels and once with the best kernels the CPU
+ * supports.
+ */
+BENCHMARK(audio_rate) {
+	const uint32 rates[][2] = {
+		{ 44100, 44100 }, { 44100, 22050 }, { 48000, 8000 },
+		{ 8000, 44100 }, { 11025, 44100 }, { 22050, 44100 }, { 32000, 44100 }, { 48000, 44100 }
+	};
+
+	for (uint i = 0; i < ARRAYSIZE(rates); ++i) {
+		for (int layout = 0; layout < 3; ++layout) {
+			const bool stereo = (layout != 0);
+			const bool reverseStereo = (layout == 2);
+
+			Common::setCpuFeatureMask(0);
+			runConverter(rates[i][0], rates[i][1], stereo, reverseStereo);
+			Common::setCpuFeatureMask(0xFFFFFFFF);
+			runConverter(rates[i][0], rates[i][1], stereo, reverseStereo);
+		}
+	}
+}
+
+/**
+ * Compares the cost of a mixer callback (2048 output frames) between the
+ * linear and the windowed-sinc rate converters.
+ */
+BENCHMARK(audio_rate_sinc) {
+	const uint32 rates[][2] = {
+		{ 8000, 44100 }, { 11025, 44100 }, { 22050, 44100 }, { 32000, 44100 }, { 48000, 44100 }, { 48000, 8000 }, { 44100, 22050 }
+	};
+
+	for (uint i = 0; i < ARRAYSIZE(rates); ++i) {
+		for (int stereo = 0; stereo < 2; ++stereo) {
+			for (int sinc = 0; sinc < 2; ++sinc) {
+				uint32 calls;
+				const uint64 micros = timeConverter(rates[i][0], rates[i][1], stereo != 0, false,
+				                                    sinc ? Audio::kRateConverterSinc : Audio::kRateConverterLinear, calls);
+
+				Common::String label = Common::String::format("%5u -> %5u Hz %-6s %-6s (%.1f us/call)", rates[i][0], rates[i][1],
+				                                              stereo ? "stereo" : "mono", sinc ? "sinc" : "linear", (double)micros / calls);
+				Benchmark::report(label.c_str(), calls, "calls", micros);
+			}
+		}
+	}
+}
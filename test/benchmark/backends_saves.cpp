@@ -0,0 +1,193 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+// The savefiles are written to a temporary directory
+#ifdef POSIX
+
+#include "backends/saves/default/default-saves.h"
+#include "common/array.h"
+#include "common/config-manager.h"
+#include "common/savefile.h"
+#include "common/str.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+enum {
+	kSaveSize = 4 * 1024 * 1024,
+	kSaves = 10
+};
+
+/** Game state which compresses about as well as a real one */
+void createGameState(Common::Array<byte> &data) {
+	data.resize(kSaveSize);
+
+	uint32 seed = 1;
+	for (uint i = 0; i < data.size(); ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (seed >> 28) ? (byte)(i / 64) : (byte)(seed >> 16);
+	}
+}
+
+/** Owns a savefile of its own, like the save state index */
+class OwnFileObserver : public Common::SaveFileObserver {
+public:
+	virtual void savefileOpened(const Common::String &name, int32 size, uint32 mtime, uint32 mtimeMicros) {}
+	virtual void savefilesListed(const Common::String &pattern, const Common::StringArray &names) {}
+	virtual void savefileChanged(const Common::String &name) {}
+	virtual bool isOwnSavefile(const Common::String &name) const { return name == "own.dat"; }
+};
+
+void writeSave(Common::SaveFileManager &saveFileMan, const Common::String &name, const Common::Array<byte> &data) {
+	Common::OutSaveFile *out = saveFileMan.openForSaving(name);
+	if (!out) {
+		printf("  Could not open '%s'\n", name.c_str());
+		return;
+	}
+
+	// Engines write their state in small pieces
+	for (uint i = 0; i < data.size(); i += 256)
+		out->write(&data[i], 256);
+
+	out->finalize();
+	if (out->err())
+		printf("  Could not write '%s'\n", name.c_str());
+	delete out;
+}
+
+bool isSaved(Common::SaveFileManager &saveFileMan, const Common::String &name, const Common::Array<byte> &data) {
+	Common::InSaveFile *in = saveFileMan.openForLoading(name);
+	if (!in)
+		return false;
+
+	Common::Array<byte> saved;
+	saved.resize(data.size());
+	const bool same = in->size() == (int32)data.size() && in->read(saved.begin(), saved.size()) == saved.size() && saved == data;
+	delete in;
+	return same;
+}
+
+} // End of anonymous namespace
+
+/**
+ * Writes savefiles of 4 MB, and reports how many of them per second the
+ * caller can hand over, once when they are compressed and written right
+ * away and once when this happens in the background, and how long it
+ * takes until all of them are done. Also checks that the savefiles can be
+ * read back, also when one is saved again before it was written, and that
+ * a failure in the background is reported, also after an observer wrote
+ * its own savefile.
+ */
+BENCHMARK(backends_saves) {
+	Benchmark::initSystem();
+
+	const Common::String dir = Benchmark::createTempDir("saves");
+	if (dir.empty()) {
+		printf("  Could not create a temporary directory\n");
+		return;
+	}
+
+	ConfMan.set("savepath", dir, Common::ConfigManager::kTransientDomain);
+
+	Common::Array<byte> data;
+	createGameState(data);
+
+	DefaultSaveFileManager *saveFileMan = new DefaultSaveFileManager();
+	bool same = true;
+
+	for (int background = 0; background < 2; ++background) {
+		saveFileMan->setBackgroundSavingEnabled(background != 0);
+
+		const uint64 start = Benchmark::getMicros();
+		for (int i = 0; i < kSaves; ++i)
+			writeSave(*saveFileMan, Common::String::format("save.%03d", i), data);
+		const uint64 handedOver = Benchmark::getMicros() - start;
+		saveFileMan->waitForSaves();
+		const uint64 done = Benchmark::getMicros() - start;
+
+		Benchmark::report(background ? "background, handed over" : "right away, handed over", kSaves, "saves", handedOver);
+		Benchmark::report(background ? "background, written" : "right away, written", kSaves, "saves", done);
+
+		if (saveFileMan->getError().getCode() != Common::kNoError)
+			printf("  %s\n", saveFileMan->getErrorDesc().c_str());
+
+		for (int i = 0; i < kSaves; ++i)
+			same = same && isSaved(*saveFileMan, Common::String::format("save.%03d", i), data);
+	}
+
+	if (!same)
+		printf("  The savefiles read back differ!\n");
+
+	// Saving again while the first save of the same name is still queued,
+	// like two quicksaves in a row, must not mix the two savefiles
+	Common::Array<byte> shorter;
+	createGameState(shorter);
+	shorter.resize(kSaveSize / 2);
+	writeSave(*saveFileMan, "save.000", data);
+	writeSave(*saveFileMan, "save.000", shorter);
+	saveFileMan->waitForSaves();
+	if (saveFileMan->getError().getCode() != Common::kNoError)
+		printf("  %s\n", saveFileMan->getErrorDesc().c_str());
+	if (!isSaved(*saveFileMan, "save.000", shorter))
+		printf("  The savefile saved twice in a row differs!\n");
+
+	// The savefile can't replace a directory, which is only noticed in the background
+	const Common::String blocked = dir + "/blocked.000";
+	mkdir(blocked.c_str(), 0700);
+	writeSave(*saveFileMan, "blocked.000", data);
+	// Listing the savefiles waits for the failed one and checks the savepath,
+	// which must not hide the failure
+	saveFileMan->listSavefiles("*");
+	saveFileMan->listSavefiles("*");
+	// Nor may an observer writing its own savefile
+	OwnFileObserver observer;
+	saveFileMan->addObserver(&observer);
+	writeSave(*saveFileMan, "own.dat", shorter);
+	saveFileMan->waitForSaves();
+	saveFileMan->removeObserver(&observer);
+	unlink((dir + "/own.dat").c_str());
+	if (saveFileMan->getError().getCode() != Common::kWritingFailed)
+		printf("  The failed save wasn't reported!\n");
+	saveFileMan->popErrorDesc();
+	if (saveFileMan->getError().getCode() != Common::kNoError)
+		printf("  The failed save is still reported!\n");
+	if (access((blocked + ".savetmp").c_str(), F_OK) == 0)
+		printf("  The temporary file was left behind!\n");
+	rmdir(blocked.c_str());
+
+	delete saveFileMan;
+
+	for (int i = 0; i < kSaves; ++i)
+		unlink(Common::String::format("%s/save.%03d", dir.c_str(), i).c_str());
+	rmdir(dir.c_str());
+
+	ConfMan.removeKey("savepath", Common::ConfigManager::kTransientDomain);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include "common/scummsys.h"
+#include "common/str.h"
+
+/**
+ * A tiny benchmark harness, for code which needs at most a minimal OSystem.
+ *
+ * Each benchmark is a function registered with the BENCHMARK macro. The
+ * runner executes all of them, or only those whose name starts with one
+ * of the prefixes given on the command line.
+ */
+namespace Benchmark {
+
+typedef void (*BenchmarkProc)();
+
+struct Registration {
+	Registration(const char *name, BenchmarkProc proc);
+
+	const char *_name;
+	BenchmarkProc _proc;
+	Registration *_next;
+};
+
+/**
+ * Returns a monotonic timestamp in microseconds.
+ */
+uint64 getMicros();
+
+/**
+ * Prints a single result line.
+ *
+ * @param label     what was measured
+ * @param work      amount of work done, in units of @p unit
+ * @param unit      name of the unit of work (e.g. "frames")
+ * @param micros    time it took
+ */
+void report(const char *label, double work, const char *unit, uint64 micros);
+
+/**
+ * Prevents the compiler from optimizing away a computed result.
+ */
+void consume(const void *data, uint32 size);
+
+/**
+ * Installs a minimal g_system, for benchmarks of code which uses mutexes
+ * or timers. It has no graphics, sound or event handling.
+ */
+void initSystem();
+
+/**
+ * Gives the minimal g_system an RGB565 overlay of the given size, for
+ * benchmarks of GUI code. What is copied to the overlay is kept, but not
+ * shown anywhere.
+ */
+void setOverlaySize(int width, int height);
+
+/**
+ * Returns the pixels of the overlay, for comparing the results of
+ * different code paths.
+ */
+const byte *getOverlayPixels();
+
+#ifdef POSIX
+/**
+ * Creates a new directory for temporary files, in TMPDIR or else in /tmp.
+ *
+ * @param name      part of the name of the directory
+ * @return the path of the directory, or an empty string on failure
+ */
+Common::String createTempDir(const char *name);
+#endif
+
+} // End of namespace Benchmark
+
+#define BENCHMARK(name) \
+	static void benchmark_##name(); \
+	static Benchmark::Registration benchmarkRegistration_##name(#name, benchmark_##name); \
+	static void benchmark_##name()
+
+#endif
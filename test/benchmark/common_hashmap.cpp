@@ -0,0 +1,128 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/flat-hashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+namespace {
+
+enum {
+	kRepeats = 20
+};
+
+/*
+ * Time inserting, looking up (hits and misses), iterating over and
+ * erasing the given keys, each kRepeats times on a fresh map.
+ */
+template<class Map, class Key>
+void runMap(const char *name, const Common::Array<Key> &keys, const Common::Array<Key> &missing) {
+	uint64 insertMicros = 0, hitMicros = 0, missMicros = 0, iterateMicros = 0, eraseMicros = 0;
+	uint32 sink = 0;
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat) {
+		Map map;
+
+		uint64 start = Benchmark::getMicros();
+		for (uint i = 0; i < keys.size(); ++i)
+			map[keys[i]] = i;
+		insertMicros += Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		for (uint i = 0; i < keys.size(); ++i)
+			sink += map.getVal(keys[i], 0);
+		hitMicros += Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		for (uint i = 0; i < missing.size(); ++i)
+			sink += map.contains(missing[i]);
+		missMicros += Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+			sink += i->_value;
+		iterateMicros += Benchmark::getMicros() - start;
+
+		start = Benchmark::getMicros();
+		for (uint i = 0; i < keys.size(); ++i)
+			map.erase(keys[i]);
+		eraseMicros += Benchmark::getMicros() - start;
+	}
+
+	Benchmark::consume(&sink, sizeof(sink));
+
+	const double ops = (double)keys.size() * kRepeats;
+	Benchmark::report(Common::String::format("%-24s insert", name).c_str(), ops, "ops", insertMicros);
+	Benchmark::report(Common::String::format("%-24s lookup (hit)", name).c_str(), ops, "ops", hitMicros);
+	Benchmark::report(Common::String::format("%-24s lookup (miss)", name).c_str(), (double)missing.size() * kRepeats, "ops", missMicros);
+	Benchmark::report(Common::String::format("%-24s iterate", name).c_str(), ops, "entries", iterateMicros);
+	Benchmark::report(Common::String::format("%-24s erase", name).c_str(), ops, "ops", eraseMicros);
+}
+
+void makeIntKeys(uint count, Common::Array<uint> &keys, Common::Array<uint> &missing) {
+	// Resource ids and the like are mostly small, clustered numbers
+	uint32 seed = 1;
+	for (uint i = 0; i < count; ++i) {
+		seed = seed * 1103515245 + 12345;
+		keys.push_back(i * 2 + ((seed >> 16) & 1) * 100000);
+		missing.push_back(i * 2 + 1);
+	}
+}
+
+void makeStringKeys(uint count, Common::Array<Common::String> &keys, Common::Array<Common::String> &missing) {
+	// File names, as in FSDirectory's caches
+	for (uint i = 0; i < count; ++i) {
+		keys.push_back(Common::String::format("RESOURCE.%03u", i));
+		missing.push_back(Common::String::format("PATCH.%03u", i));
+	}
+}
+
+} // End of anonymous namespace
+
+/**
+ * Compares Common::HashMap with Common::FlatHashMap, for integer and
+ * (case insensitive) string keys at a small and a large map size.
+ */
+BENCHMARK(common_hashmap) {
+	const uint sizes[] = { 64, 20000 };
+
+	for (uint s = 0; s < ARRAYSIZE(sizes); ++s) {
+		Common::Array<uint> intKeys, intMissing;
+		makeIntKeys(sizes[s], intKeys, intMissing);
+		Common::Array<Common::String> stringKeys, stringMissing;
+		makeStringKeys(sizes[s], stringKeys, stringMissing);
+
+		runMap<Common::HashMap<uint, uint> >(Common::String::format("HashMap<uint> %u", sizes[s]).c_str(), intKeys, intMissing);
+		runMap<Common::FlatHashMap<uint, uint> >(Common::String::format("FlatHashMap<uint> %u", sizes[s]).c_str(), intKeys, intMissing);
+
+		typedef Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> StringMap;
+		typedef Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+		runMap<StringMap>(Common::String::format("HashMap<String> %u", sizes[s]).c_str(), stringKeys, stringMissing);
+		runMap<FlatStringMap>(Common::String::format("FlatHashMap<String> %u", sizes[s]).c_str(), stringKeys, stringMissing);
+	}
+}
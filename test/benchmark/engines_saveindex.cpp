@@ -0,0 +1,323 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+// The savefiles are written to a temporary directory
+#ifdef POSIX
+
+#include "backends/saves/default/default-saves.h"
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/savefile.h"
+#include "common/str.h"
+#include "engines/metaengine.h"
+#include "engines/saveindex.h"
+#include "graphics/surface.h"
+#include "graphics/thumbnail.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+
+enum {
+	kSaves = 300,
+	kDataSize = 64 * 1024,
+	kOpens = 3
+};
+
+const char *const kTarget = "benchmark";
+
+struct SlotLess {
+	bool operator()(const SaveStateDescriptor &a, const SaveStateDescriptor &b) const {
+		return a.getSaveSlot() < b.getSaveSlot();
+	}
+};
+
+Common::String readDescription(Common::SeekableReadStream &in) {
+	Common::String description;
+	for (byte size = in.readByte(); size > 0; --size)
+		description += (char)in.readByte();
+	return description;
+}
+
+/**
+ * Reads savefiles like most engines do: a header with the description,
+ * date and play time, a thumbnail, and then the game data.
+ */
+class BenchmarkMetaEngine : public MetaEngine {
+public:
+	BenchmarkMetaEngine(Common::SaveFileManager *saveFileMan) : _saveFileMan(saveFileMan) {}
+
+	virtual const char *getName() const { return "Benchmark"; }
+	virtual const char *getOriginalCopyright() const { return ""; }
+	virtual GameList getSupportedGames() const { return GameList(); }
+	virtual GameDescriptor findGame(const char *gameid) const { return GameDescriptor(); }
+	virtual GameList detectGames(const Common::FSList &fslist) const { return GameList(); }
+	virtual Common::Error createInstance(OSystem *syst, Engine **engine) const { return Common::kUnsupportedGameidError; }
+	virtual int getMaximumSaveSlot() const { return 999; }
+
+	virtual SaveStateList listSaves(const char *target) const {
+		Common::StringArray files = _saveFileMan->listSavefiles(Common::String(target) + ".???");
+		SaveStateList saveList;
+
+		for (uint i = 0; i < files.size(); ++i) {
+			Common::InSaveFile *in = _saveFileMan->openForLoading(files[i]);
+			if (!in)
+				continue;
+
+			saveList.push_back(SaveStateDescriptor(atoi(files[i].c_str() + files[i].size() - 3), readDescription(*in)));
+			delete in;
+		}
+
+		Common::sort(saveList.begin(), saveList.end(), SlotLess());
+		return saveList;
+	}
+
+	virtual SaveStateDescriptor querySaveMetaInfos(const char *target, int slot) const {
+		Common::InSaveFile *in = _saveFileMan->openForLoading(Common::String::format("%s.%03d", target, slot));
+		if (!in)
+			return SaveStateDescriptor();
+
+		SaveStateDescriptor desc(slot, readDescription(*in));
+		const uint32 date = in->readUint32LE();
+		desc.setSaveDate(date >> 16, (date >> 8) & 0xFF, date & 0xFF);
+		desc.setPlayTime(in->readUint32LE());
+		desc.setThumbnail(Graphics::loadThumbnail(*in));
+
+		delete in;
+		return desc;
+	}
+
+private:
+	Common::SaveFileManager *_saveFileMan;
+};
+
+void writeSave(Common::SaveFileManager &saveFileMan, int slot, const Common::String &description) {
+	Common::OutSaveFile *out = saveFileMan.openForSaving(Common::String::format("%s.%03d", kTarget, slot));
+	out->writeByte(description.size());
+	out->writeString(description);
+	out->writeUint32LE((2013 << 16) | (1 + slot % 12) << 8 | (1 + slot % 28));
+	out->writeUint32LE(slot * 60000);
+
+	uint32 seed = slot + 1;
+	Graphics::Surface thumbnail;
+	thumbnail.create(160, 100, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+	for (int y = 0; y < thumbnail.h; ++y) {
+		uint16 *row = (uint16 *)thumbnail.getBasePtr(0, y);
+		for (int x = 0; x < thumbnail.w; ++x) {
+			seed = seed * 1103515245 + 12345;
+			row[x] = (x * 7 + y * 3 + slot) ^ (seed >> 28);
+		}
+	}
+	Graphics::saveThumbnail(*out, thumbnail);
+	thumbnail.free();
+
+	// Game data, which doesn't compress too well
+	for (int i = 0; i < kDataSize; ++i) {
+		seed = seed * 1103515245 + 12345;
+		out->writeByte((seed >> 24) & 0x3F);
+	}
+
+	out->finalize();
+	delete out;
+}
+
+bool isSameSaveState(const SaveStateDescriptor &a, const SaveStateDescriptor &b) {
+	if (a.getSaveSlot() != b.getSaveSlot() || a.getDescription() != b.getDescription()
+	    || a.getSaveDate() != b.getSaveDate() || a.getPlayTime() != b.getPlayTime())
+		return false;
+
+	const Graphics::Surface *ta = a.getThumbnail(), *tb = b.getThumbnail();
+	if (!ta || !tb)
+		return ta == tb;
+
+	if (ta->w != tb->w || ta->h != tb->h || ta->format != tb->format)
+		return false;
+
+	for (int y = 0; y < ta->h; ++y) {
+		if (memcmp(ta->getBasePtr(0, y), tb->getBasePtr(0, y), ta->w * ta->format.bytesPerPixel))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Does what the grid chooser does when it is opened and the user looks at
+ * all of its pages: list the save states, and query the ones on each page.
+ */
+uint64 browseSaves(const MetaEngine &metaEngine, bool useIndex, SaveStateList &states) {
+	SaveStateIndex *index = useIndex ? SaveStateIndexMan.getIndex(kTarget) : 0;
+	states.clear();
+
+	const uint64 start = Benchmark::getMicros();
+	const SaveStateList saveList = index ? index->listSaves(metaEngine, kTarget) : metaEngine.listSaves(kTarget);
+	for (uint i = 0; i < saveList.size(); ++i) {
+		const int slot = saveList[i].getSaveSlot();
+		states.push_back(index ? index->querySaveMetaInfos(metaEngine, kTarget, slot) : metaEngine.querySaveMetaInfos(kTarget, slot));
+	}
+	if (index)
+		index->flush();
+	const uint64 micros = Benchmark::getMicros() - start;
+
+	return micros;
+}
+
+bool isSameList(const SaveStateList &a, const SaveStateList &b) {
+	if (a.size() != b.size())
+		return false;
+
+	for (uint i = 0; i < a.size(); ++i) {
+		if (!isSameSaveState(a[i], b[i]))
+			return false;
+	}
+
+	return true;
+}
+
+} // End of anonymous namespace
+
+/**
+ * Writes a few hundred savefiles with thumbnails into a temporary directory
+ * and reports how often all of them can be listed and queried, like the
+ * grid chooser does, once by asking the engine and once through the save
+ * state index: while it is being built, when it is in memory, and when it
+ * is read from its file again. Also checks that the index notices changed
+ * savefiles.
+ */
+BENCHMARK(engines_saveindex) {
+	Benchmark::initSystem();
+
+	const Common::String dir = Benchmark::createTempDir("saveindex");
+	if (dir.empty()) {
+		printf("  Could not create a temporary directory\n");
+		return;
+	}
+
+	ConfMan.addGameDomain(kTarget);
+	ConfMan.setActiveDomain(kTarget);
+	ConfMan.set("savepath", dir, Common::ConfigManager::kTransientDomain);
+
+	DefaultSaveFileManager *saveFileMan = new DefaultSaveFileManager();
+	SaveStateIndexMan.attach(saveFileMan);
+	for (int slot = 0; slot < kSaves; ++slot)
+		writeSave(*saveFileMan, slot, Common::String::format("Save game number %d", slot));
+	saveFileMan->waitForSaves();
+
+	BenchmarkMetaEngine *metaEngine = new BenchmarkMetaEngine(saveFileMan);
+	SaveStateList expected, states;
+
+	uint64 micros = 0;
+	for (int i = 0; i < kOpens; ++i)
+		micros += browseSaves(*metaEngine, false, expected);
+	Benchmark::report("engine", kOpens * kSaves, "saves", micros);
+
+	micros = browseSaves(*metaEngine, true, states);
+	Benchmark::report("index, building", kSaves, "saves", micros);
+	bool same = isSameList(states, expected);
+
+	micros = 0;
+	for (int i = 0; i < kOpens; ++i) {
+		micros += browseSaves(*metaEngine, true, states);
+		same = same && isSameList(states, expected);
+	}
+	Benchmark::report("index, in memory", kOpens * kSaves, "saves", micros);
+
+	// A new savefile manager reads the index from its file, and checks it once
+	SaveStateIndexMan.detach();
+	delete metaEngine;
+	delete saveFileMan;
+	saveFileMan = new DefaultSaveFileManager();
+	SaveStateIndexMan.attach(saveFileMan);
+	metaEngine = new BenchmarkMetaEngine(saveFileMan);
+
+	micros = browseSaves(*metaEngine, true, states);
+	Benchmark::report("index, from file", kSaves, "saves", micros);
+	same = same && isSameList(states, expected);
+
+	micros = 0;
+	for (int i = 0; i < kOpens; ++i) {
+		micros += browseSaves(*metaEngine, true, states);
+		same = same && isSameList(states, expected);
+	}
+	Benchmark::report("index, from file, checked", kOpens * kSaves, "saves", micros);
+
+	// Changed savefiles are read again
+	writeSave(*saveFileMan, 7, "Overwritten");
+	saveFileMan->removeSavefile(Common::String::format("%s.%03d", kTarget, 8));
+	browseSaves(*metaEngine, false, expected);
+	browseSaves(*metaEngine, true, states);
+	same = same && isSameList(states, expected);
+
+	if (!same)
+		printf("  The index is out of date!\n");
+
+	// A savefile which is written without the index noticing, keeping its
+	// size, is told apart by its modification time
+	SaveStateIndexMan.detach();
+	delete metaEngine;
+	delete saveFileMan;
+	saveFileMan = new DefaultSaveFileManager();
+	writeSave(*saveFileMan, 10, "Save game number 01");
+	saveFileMan->waitForSaves();
+	SaveStateIndexMan.attach(saveFileMan);
+	metaEngine = new BenchmarkMetaEngine(saveFileMan);
+
+	browseSaves(*metaEngine, false, expected);
+	browseSaves(*metaEngine, true, states);
+	if (!isSameList(states, expected))
+		printf("  A savefile changed outside of the index was not noticed!\n");
+
+	// An index which changed isn't written once another savepath is current
+	writeSave(*saveFileMan, 9, "Overwritten");
+	saveFileMan->waitForSaves();
+	const Common::String otherDir = Benchmark::createTempDir("saveindex-other");
+	const Common::String otherIndex = Common::String::format("%s/%s", otherDir.c_str(), SaveStateIndex::getFileName(kTarget).c_str());
+	ConfMan.set("savepath", otherDir, Common::ConfigManager::kTransientDomain);
+
+	SaveStateIndexMan.detach();
+	delete metaEngine;
+	delete saveFileMan;
+
+	if (!otherDir.empty()) {
+		if (access(otherIndex.c_str(), F_OK) == 0)
+			printf("  The index was written to another savepath!\n");
+		unlink(otherIndex.c_str());
+		rmdir(otherDir.c_str());
+	}
+
+	for (int slot = 0; slot < kSaves; ++slot)
+		unlink(Common::String::format("%s/%s.%03d", dir.c_str(), kTarget, slot).c_str());
+	unlink(Common::String::format("%s/%s", dir.c_str(), SaveStateIndex::getFileName(kTarget).c_str()).c_str());
+	rmdir(dir.c_str());
+
+	ConfMan.setActiveDomain("");
+	ConfMan.removeGameDomain(kTarget);
+	ConfMan.removeKey("savepath", Common::ConfigManager::kTransientDomain);
+}
+
+#endif
@@ -0,0 +1,221 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/decoders/bmp.h"
+#include "graphics/pixelformat.h"
+#include "graphics/scaler.h"
+#include "graphics/surface.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+enum {
+	kFrames = 50
+};
+
+struct ScalerUse {
+	const char *name;
+	ScalerProc *proc;
+	int factor;
+};
+
+const ScalerUse s_scalers[] = {
+	{ "Normal1x", Normal1x, 1 },
+#ifdef USE_SCALERS
+	{ "Normal2x", Normal2x, 2 },
+	{ "Normal3x", Normal3x, 3 },
+	{ "AdvMame2x", AdvMame2x, 2 },
+	{ "AdvMame3x", AdvMame3x, 3 },
+	{ "TV2x", TV2x, 2 },
+	{ "DotMatrix", DotMatrix, 2 },
+	{ "2xSaI", _2xSaI, 2 },
+	{ "Super2xSaI", Super2xSaI, 2 },
+	{ "SuperEagle", SuperEagle, 2 },
+#ifdef USE_HQ_SCALERS
+	{ "HQ2x", HQ2x, 2 },
+	{ "HQ3x", HQ3x, 3 },
+#endif
+#endif
+};
+
+/** A 16bpp frame with a border of one pixel on each side, as the scalers expect */
+struct Frame {
+	Common::String name;
+	int width, height;
+	Common::Array<uint16> pixels;
+
+	int pitch() const { return width + 2; }
+	const uint16 *origin() const { return &pixels[pitch() + 1]; }
+};
+
+/**
+ * Creates a frame which looks roughly like game graphics to the scalers:
+ * runs of a few palette colors, with dithering and some noise.
+ */
+void createFrame(Frame &frame, int width, int height, uint32 &seed) {
+	static const uint16 palette[] = { 0x0000, 0xFFFF, 0x8410, 0x4208, 0xA145, 0x2589, 0x07E0, 0x781F, 0x6B4D, 0xF800 };
+
+	frame.name = Common::String::format("%dx%d", width, height);
+	frame.width = width;
+	frame.height = height;
+	frame.pixels.resize(frame.pitch() * (height + 2));
+
+	const int pitch = frame.pitch();
+	for (int y = 0; y < height + 2; ++y) {
+		for (int x = 0; x < pitch; ++x) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 r = seed >> 8;
+			uint16 &pixel = frame.pixels[y * pitch + x];
+			if (x > 0 && (r & 7) != 0)
+				pixel = frame.pixels[y * pitch + x - 1];
+			else if (y > 0 && (r & 8) != 0)
+				pixel = frame.pixels[(y - 1) * pitch + x];
+			else if ((r & 0x30) != 0)
+				pixel = palette[(r >> 6) % ARRAYSIZE(palette)];
+			else
+				pixel = (uint16)(r >> 6);
+		}
+	}
+}
+
+/** Loads a captured frame from a BMP file, converted to RGB565. */
+bool loadFrame(Frame &frame, const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(size);
+	const bool read = fread(data, 1, size, file) == (size_t)size;
+	fclose(file);
+
+	bool loaded = false;
+	Graphics::BitmapDecoder decoder;
+	Common::MemoryReadStream stream(data, size);
+	if (read && decoder.loadStream(stream)) {
+		Graphics::Surface *surface = decoder.getSurface()->convertTo(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0), decoder.getPalette());
+
+		frame.name = path;
+		frame.width = surface->w;
+		frame.height = surface->h;
+		frame.pixels.resize(frame.pitch() * (frame.height + 2));
+
+		// Repeat the edges into the border
+		const int pitch = frame.pitch();
+		for (int y = 0; y < frame.height + 2; ++y) {
+			const uint16 *src = (const uint16 *)surface->getBasePtr(0, CLIP(y - 1, 0, frame.height - 1));
+			for (int x = 0; x < pitch; ++x)
+				frame.pixels[y * pitch + x] = src[CLIP(x - 1, 0, frame.width - 1)];
+		}
+
+		surface->free();
+		delete surface;
+		loaded = true;
+	}
+
+	free(data);
+	return loaded;
+}
+
+} // End of anonymous namespace
+
+/**
+ * Runs every scaler over game sized frames, once with the plain C code and
+ * once with the vector code, and reports the number of frames scaled per
+ * second. Captured frames can be used in addition to the synthetic ones, by
+ * setting SCUMMVM_BENCHMARK_FRAMES to a list of BMP files.
+ */
+BENCHMARK(graphics_scalers) {
+	Common::Array<Frame> frames;
+	uint32 seed = 1;
+
+	frames.push_back(Frame());
+	createFrame(frames.back(), 320, 200, seed);
+	frames.push_back(Frame());
+	createFrame(frames.back(), 640, 480, seed);
+
+	const char *paths = getenv("SCUMMVM_BENCHMARK_FRAMES");
+	if (paths) {
+#ifdef WIN32
+		const char separator = ';';
+#else
+		const char separator = ':';
+#endif
+		Common::String list(paths);
+		while (!list.empty()) {
+			const char *end = strchr(list.c_str(), separator);
+			const Common::String path = end ? Common::String(list.c_str(), end) : list;
+			list = end ? Common::String(end + 1) : Common::String();
+			if (path.empty())
+				continue;
+
+			frames.push_back(Frame());
+			if (!loadFrame(frames.back(), path.c_str())) {
+				printf("  Could not load %s\n", path.c_str());
+				frames.pop_back();
+			}
+		}
+	}
+
+	for (uint f = 0; f < frames.size(); ++f) {
+		const Frame &frame = frames[f];
+		const uint32 srcPitch = frame.pitch() * sizeof(uint16);
+
+		for (uint i = 0; i < ARRAYSIZE(s_scalers); ++i) {
+			const ScalerUse &scaler = s_scalers[i];
+			const uint32 dstPitch = frame.width * scaler.factor * sizeof(uint16);
+			Common::Array<uint16> dst;
+			dst.resize(frame.width * scaler.factor * frame.height * scaler.factor);
+
+			for (int vector = 0; vector < 2; ++vector) {
+				Common::setCpuFeatureMask(vector ? 0xFFFFFFFF : 0);
+				InitScalers(565);
+
+				const uint64 start = Benchmark::getMicros();
+				for (int n = 0; n < kFrames; ++n)
+					scaler.proc((const uint8 *)frame.origin(), srcPitch, (uint8 *)&dst[0], dstPitch, frame.width, frame.height);
+				const uint64 micros = Benchmark::getMicros() - start;
+
+				Common::String label = Common::String::format("%-12s %-10s %s", frame.name.c_str(), scaler.name, vector ? "vector" : "C");
+				Benchmark::report(label.c_str(), kFrames, "frames", micros);
+				Benchmark::consume(&dst[0], dst.size() * sizeof(uint16));
+			}
+		}
+	}
+
+	Common::setCpuFeatureMask(0xFFFFFFFF);
+	InitScalers(565);
+	DestroyScalers();
+}
@@ -0,0 +1,108 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+namespace {
+
+enum {
+	kFrames = 100
+};
+
+void fillPlane(Common::Array<byte> &plane, uint size, uint32 &seed) {
+	plane.resize(size);
+	for (uint i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		plane[i] = seed >> 24;
+	}
+}
+
+} // End of anonymous namespace
+
+/**
+ * Converts video frames of typical sizes from YUV420 and YUV444 to 16bpp
+ * and 32bpp RGB, once with the lookup tables and once with the vector code,
+ * and reports the number of frames converted per second.
+ */
+BENCHMARK(graphics_yuv) {
+	Benchmark::initSystem();
+
+	const int sizes[][2] = { { 640, 480 }, { 1280, 720 } };
+	const Graphics::PixelFormat formats[] = {
+		Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+		Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+	};
+
+	uint32 seed = 1;
+	for (uint i = 0; i < ARRAYSIZE(sizes); ++i) {
+		const int width = sizes[i][0], height = sizes[i][1];
+
+		Common::Array<byte> y, u, v;
+		fillPlane(y, width * height, seed);
+		fillPlane(u, width * height, seed);
+		fillPlane(v, width * height, seed);
+
+		for (uint f = 0; f < ARRAYSIZE(formats); ++f) {
+			Graphics::Surface dst;
+			dst.create(width, height, formats[f]);
+
+			for (int halfChroma = 1; halfChroma >= 0; --halfChroma) {
+				const int uvPitch = halfChroma ? width / 2 : width;
+
+				for (int itu = 0; itu < 2; ++itu) {
+					const Graphics::YUVToRGBManager::LuminanceScale scale = itu ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+
+					for (int vector = 0; vector < 2; ++vector) {
+						Common::setCpuFeatureMask(vector ? 0xFFFFFFFF : 0);
+
+						const uint64 start = Benchmark::getMicros();
+						for (int frame = 0; frame < kFrames; ++frame) {
+							if (halfChroma)
+								YUVToRGBMan.convert420(&dst, scale, &y[0], &u[0], &v[0], width, height, width, uvPitch);
+							else
+								YUVToRGBMan.convert444(&dst, scale, &y[0], &u[0], &v[0], width, height, width, uvPitch);
+						}
+						const uint64 micros = Benchmark::getMicros() - start;
+
+						Common::String label = Common::String::format("%4dx%-4d %s %2dbpp %-4s %s", width, height, halfChroma ? "420" : "444",
+						                                              formats[f].bytesPerPixel * 8, itu ? "ITU" : "full", vector ? "vector" : "C");
+						Benchmark::report(label.c_str(), kFrames, "frames", micros);
+						Benchmark::consume(dst.getPixels(), dst.pitch * dst.h);
+					}
+				}
+			}
+
+			dst.free();
+		}
+	}
+
+	Common::setCpuFeatureMask(0xFFFFFFFF);
+}
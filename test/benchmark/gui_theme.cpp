@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+// The GUI needs a file system, which the benchmark system only has here
+#if defined(POSIX) || defined(WIN32)
+
+#include "common/array.h"
+#include "common/rect.h"
+#include "common/str.h"
+#include "gui/ThemeEngine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+enum {
+	kOpens = 20,
+	kScrolls = 100,
+	kGames = 200
+};
+
+struct OverlaySize {
+	int width, height;
+};
+
+const OverlaySize s_sizes[] = {
+	{ 320, 200 },
+	{ 1280, 960 }
+};
+
+/** Where the launcher puts its widgets, scaled up from 320x200 */
+struct LauncherLayout {
+	Common::Rect dialog;
+	Common::Rect title;
+	Common::Rect search;
+	Common::Rect list;
+	Common::Rect scrollbar;
+	Common::Array<Common::Rect> buttons;
+	int lineHeight;
+	int entriesPerPage;
+
+	LauncherLayout(const GUI::ThemeEngine &theme, int width, int height) {
+		const int sx = width / 320, sy = height / 200;
+
+		dialog = Common::Rect(0, 0, width, height);
+		title = Common::Rect(10 * sx, 4 * sy, width - 10 * sx, 16 * sy);
+		search = Common::Rect(10 * sx, 18 * sy, 210 * sx, 30 * sy);
+		list = Common::Rect(10 * sx, 34 * sy, 200 * sx, height - 10 * sy);
+		scrollbar = Common::Rect(list.right, list.top, 210 * sx, list.bottom);
+
+		for (int i = 0; i < 8; ++i)
+			buttons.push_back(Common::Rect(220 * sx, (34 + i * 19) * sy, width - 10 * sx, (50 + i * 19) * sy));
+
+		lineHeight = theme.getFontHeight() + 2;
+		entriesPerPage = (list.height() - 4) / lineHeight;
+	}
+};
+
+const char *const s_buttonLabels[] = {
+	"Start", "Load...", "Add Game...", "Edit Game...", "Remove Game", "Options...", "About...", "Quit"
+};
+
+/** Draws the game list and its scroll bar, like ListWidget and ScrollBarWidget do */
+void drawList(GUI::ThemeEngine &theme, const LauncherLayout &layout, int first) {
+	theme.drawWidgetBackground(layout.list, 0, GUI::ThemeEngine::kWidgetBackgroundBorder);
+
+	for (int i = 0; i < layout.entriesPerPage && first + i < kGames; ++i) {
+		const int y = layout.list.top + 2 + i * layout.lineHeight;
+		const Common::String name = Common::String::format("Game number %d (DOS/English)", first + i);
+		theme.drawText(Common::Rect(layout.list.left + 4, y, layout.list.right, y + layout.lineHeight - 2), name,
+		               GUI::ThemeEngine::kStateEnabled, Graphics::kTextAlignLeft,
+		               (first + i == 3) ? GUI::ThemeEngine::kTextInversionFocus : GUI::ThemeEngine::kTextInversionNone,
+		               0, true);
+	}
+
+	const int sliderHeight = MAX(layout.scrollbar.height() * layout.entriesPerPage / kGames, 8);
+	const int sliderY = (layout.scrollbar.height() - sliderHeight) * first / (kGames - layout.entriesPerPage);
+	theme.drawScrollbar(layout.scrollbar, sliderY, sliderHeight, GUI::ThemeEngine::kScrollbarStateNo);
+}
+
+/** Opens the launcher, like GuiManager::redraw() does */
+void openLauncher(GUI::ThemeEngine &theme, const LauncherLayout &layout) {
+	theme.clearAll();
+	theme.openDialog(true);
+	theme.finishBuffering();
+	theme.updateScreen(false);
+
+	theme.openDialog(true);
+	theme.drawDialogBackground(layout.dialog, GUI::ThemeEngine::kDialogBackgroundMain);
+	theme.drawText(layout.title, "ScummVM", GUI::ThemeEngine::kStateEnabled);
+	theme.drawWidgetBackground(layout.search, 0, GUI::ThemeEngine::kWidgetBackgroundEditText);
+	drawList(theme, layout, 0);
+	for (uint i = 0; i < layout.buttons.size(); ++i)
+		theme.drawButton(layout.buttons[i], s_buttonLabels[i], (i == 7) ? GUI::ThemeEngine::kStateDisabled : GUI::ThemeEngine::kStateEnabled);
+	theme.finishBuffering();
+	theme.updateScreen();
+}
+
+} // End of anonymous namespace
+
+/**
+ * Opens a launcher-like dialog and scrolls its game list, on a small and a
+ * large overlay, once without and once with the DrawData cache, and reports
+ * how many times per second this can be done.
+ *
+ * The built-in theme is used, unless SCUMMVM_BENCHMARK_THEME is set to the
+ * path of a theme directory or zip file, like gui/themes/scummmodern.zip.
+ * Its gradients, rounded corners and shadows are much more expensive to
+ * render.
+ */
+BENCHMARK(gui_theme) {
+	const char *themeId = getenv("SCUMMVM_BENCHMARK_THEME");
+	if (!themeId)
+		themeId = "builtin";
+
+	for (uint size = 0; size < ARRAYSIZE(s_sizes); ++size) {
+		const int width = s_sizes[size].width, height = s_sizes[size].height;
+		Benchmark::setOverlaySize(width, height);
+
+		GUI::ThemeEngine theme(themeId, GUI::ThemeEngine::_defaultRendererMode);
+		if (!theme.init()) {
+			printf("  Could not load the theme %s\n", themeId);
+			return;
+		}
+
+		const LauncherLayout layout(theme, width, height);
+		Common::Array<byte> uncached[2];
+
+		for (int cache = 0; cache < 2; ++cache) {
+			theme.setDrawCacheEnabled(cache != 0);
+			theme.resetDrawCacheStats();
+
+			uint64 start = Benchmark::getMicros();
+			for (int i = 0; i < kOpens; ++i)
+				openLauncher(theme, layout);
+			uint64 micros = Benchmark::getMicros() - start;
+
+			Common::String label = Common::String::format("%dx%d open, %s", width, height, cache ? "cached" : "not cached");
+			Benchmark::report(label.c_str(), kOpens, "dialogs", micros);
+
+			Common::Array<byte> opened(Benchmark::getOverlayPixels(), width * height * 2);
+
+			// Scroll down one line at a time, and back up again
+			const int lastFirst = kGames - layout.entriesPerPage;
+			start = Benchmark::getMicros();
+			for (int i = 0; i < kScrolls; ++i) {
+				const int first = (i / lastFirst) & 1 ? lastFirst - i % lastFirst : i % lastFirst;
+				drawList(theme, layout, first);
+				theme.updateScreen();
+			}
+			micros = Benchmark::getMicros() - start;
+
+			label = Common::String::format("%dx%d scroll, %s", width, height, cache ? "cached" : "not cached");
+			Benchmark::report(label.c_str(), kScrolls, "frames", micros);
+
+			Common::Array<byte> scrolled(Benchmark::getOverlayPixels(), width * height * 2);
+
+			if (!cache) {
+				uncached[0] = opened;
+				uncached[1] = scrolled;
+			} else {
+				const GUI::ThemeEngine::DrawCacheStats stats = theme.getDrawCacheStats();
+				printf("  %u items copied from the cache, %u rendered into it, %u KB used\n",
+				       stats.hits, stats.misses, stats.bytes / 1024);
+
+				if (opened != uncached[0] || scrolled != uncached[1])
+					printf("  The cached drawing differs!\n");
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,131 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The benchmark runner is a plain command line tool
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+#include "common/cpudetect.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(POSIX)
+#include <time.h>
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+// HACK to allow building with the SDL backend on MinGW, see cxxtest_mingw.h
+#ifdef main
+#undef main
+#endif
+
+namespace Benchmark {
+
+static Registration *s_benchmarks = 0;
+
+Registration::Registration(const char *name, BenchmarkProc proc) : _name(name), _proc(proc), _next(0) {
+	// Keep the registration order, which follows the link order
+	Registration **last = &s_benchmarks;
+	while (*last)
+		last = &(*last)->_next;
+	*last = this;
+}
+
+uint64 getMicros() {
+#if defined(WIN32)
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
+#elif defined(POSIX) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#elif defined(POSIX)
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+	return (uint64)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+void report(const char *label, double work, const char *unit, uint64 micros) {
+	const double seconds = micros / 1000000.0;
+	const double rate = (seconds > 0) ? work / seconds : 0;
+	printf("  %-48s %10.2f ms %14.1f %s/s\n", label, micros / 1000.0, rate, unit);
+	fflush(stdout);
+}
+
+static volatile uint32 s_sink = 0;
+
+void consume(const void *data, uint32 size) {
+	const byte *bytes = (const byte *)data;
+	uint32 sum = 0;
+	for (uint32 i = 0; i < size; i += 64)
+		sum += bytes[i];
+	s_sink += sum;
+}
+
+#ifdef POSIX
+Common::String createTempDir(const char *name) {
+	const char *tmpDir = getenv("TMPDIR");
+	if (!tmpDir || !*tmpDir)
+		tmpDir = "/tmp";
+
+	char *path = strdup(Common::String::format("%s/scummvm-%s-XXXXXX", tmpDir, name).c_str());
+	Common::String dir;
+	if (mkdtemp(path))
+		dir = path;
+	free(path);
+	return dir;
+}
+#endif
+
+} // End of namespace Benchmark
+
+int main(int argc, char *argv[]) {
+	printf("CPU features:%s%s%s\n",
+	       Common::hasCpuFeature(Common::kCpuFeatureSSE2) ? " SSE2" : "",
+	       Common::hasCpuFeature(Common::kCpuFeatureAVX2) ? " AVX2" : "",
+	       Common::hasCpuFeature(Common::kCpuFeatureNEON) ? " NEON" : "");
+
+	for (Benchmark::Registration *b = Benchmark::s_benchmarks; b; b = b->_next) {
+		bool selected = (argc <= 1);
+		for (int i = 1; i < argc && !selected; ++i)
+			selected = !strncmp(b->_name, argv[i], strlen(argv[i]));
+		if (!selected)
+			continue;
+
+		printf("%s:\n", b->_name);
+		fflush(stdout);
+		b->_proc();
+	}
+
+	return 0;
+}
@@ -0,0 +1,163 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+#if defined(POSIX)
+#include "backends/fs/posix/posix-fs-factory.h"
+#elif defined(WIN32)
+#include "backends/fs/windows/windows-fs-factory.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+static const OSystem::GraphicsMode s_noGraphicsModes[] = { { 0, 0, 0 } };
+
+/**
+ * A backend without any output, for benchmarks of code which needs an
+ * OSystem for timing and mutexes, or an overlay and a file system for the
+ * GUI. The benchmarks run on a single thread, so the mutexes do nothing.
+ */
+class BenchmarkSystem : public OSystem {
+public:
+	BenchmarkSystem() : _start(Benchmark::getMicros()), _overlayWidth(0), _overlayHeight(0) {
+		// The GUI looks for files, even when it doesn't need any
+#if defined(POSIX)
+		_fsFactory = new POSIXFilesystemFactory();
+#elif defined(WIN32)
+		_fsFactory = new WindowsFilesystemFactory();
+#endif
+	}
+
+	void setOverlaySize(int width, int height) {
+		_overlayWidth = width;
+		_overlayHeight = height;
+		_overlay.resize(width * height);
+		clearOverlay();
+	}
+
+	const byte *getOverlayPixels() const { return _overlay.empty() ? 0 : (const byte *)&_overlay[0]; }
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return s_noGraphicsModes; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return true; }
+	virtual int getGraphicsMode() const { return 0; }
+#ifdef USE_RGB_COLOR
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+#endif
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+
+	virtual void clearOverlay() {
+		if (!_overlay.empty())
+			memset(&_overlay[0], 0, _overlay.size() * sizeof(uint16));
+	}
+
+	virtual void grabOverlay(void *buf, int pitch) {
+		for (int y = 0; y < _overlayHeight; ++y)
+			memcpy((byte *)buf + y * pitch, &_overlay[y * _overlayWidth], _overlayWidth * sizeof(uint16));
+	}
+
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {
+		for (int row = 0; row < h; ++row)
+			memcpy(&_overlay[(y + row) * _overlayWidth + x], (const byte *)buf + row * pitch, w * sizeof(uint16));
+	}
+
+	virtual int16 getOverlayHeight() { return _overlayHeight; }
+	virtual int16 getOverlayWidth() { return _overlayWidth; }
+
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) {}
+
+	virtual uint32 getMillis(bool skipRecord = false) {
+		// Never return 0, which some code treats as "not started"
+		return (uint32)((Benchmark::getMicros() - _start) / 1000) + 1;
+	}
+
+	virtual void delayMillis(uint msecs) {}
+	virtual void getTimeAndDate(TimeDate &t) const {}
+
+	virtual MutexRef createMutex() { return 0; }
+	virtual void lockMutex(MutexRef mutex) {}
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+
+	virtual Audio::Mixer *getMixer() { return 0; }
+
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+
+	virtual void logMessage(LogMessageType::Type type, const char *message) {
+		fputs(message, (type == LogMessageType::kInfo || type == LogMessageType::kDebug) ? stdout : stderr);
+	}
+
+private:
+	const uint64 _start;
+
+	int _overlayWidth, _overlayHeight;
+	Common::Array<uint16> _overlay;
+};
+
+} // End of anonymous namespace
+
+namespace Benchmark {
+
+void initSystem() {
+	if (!g_system)
+		g_system = new BenchmarkSystem();
+}
+
+void setOverlaySize(int width, int height) {
+	initSystem();
+	static_cast<BenchmarkSystem *>(g_system)->setOverlaySize(width, height);
+}
+
+const byte *getOverlayPixels() {
+	initSystem();
+	return static_cast<BenchmarkSystem *>(g_system)->getOverlayPixels();
+}
+
+} // End of namespace Benchmark
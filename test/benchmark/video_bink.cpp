@@ -0,0 +1,118 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#ifdef USE_BINK
+
+#include "common/memstream.h"
+#include "common/str.h"
+#include "graphics/surface.h"
+#include "video/bink_decoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+/**
+ * Decodes all frames of a video as fast as possible, and returns a
+ * checksum of them, so the ways of decoding can be compared.
+ */
+uint32 decodeVideo(const byte *data, uint32 size, uint decodeAhead) {
+	Video::BinkDecoder decoder;
+	decoder.setDecodeAhead(decodeAhead);
+	if (!decoder.loadStream(new Common::MemoryReadStream(data, size, DisposeAfterUse::NO))) {
+		printf("  Not a Bink video\n");
+		return 0;
+	}
+
+	uint32 checksum = 0;
+	uint32 frames = 0;
+	const uint64 start = Benchmark::getMicros();
+	while (frames < decoder.getFrameCount()) {
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		if (!surface)
+			break;
+
+		for (int y = 0; y < surface->h; ++y) {
+			const byte *row = (const byte *)surface->getBasePtr(0, y);
+			for (int x = 0; x < surface->w * surface->format.bytesPerPixel; ++x)
+				checksum = checksum * 31 + row[x];
+		}
+		++frames;
+	}
+	const uint64 micros = Benchmark::getMicros() - start;
+
+	Common::String label = decodeAhead ? Common::String::format("%u frames ahead", decodeAhead) : "when needed";
+	Benchmark::report(label.c_str(), frames, "frames", micros);
+	return checksum;
+}
+
+} // End of anonymous namespace
+
+/**
+ * Decodes the Bink video named by the SCUMMVM_BENCHMARK_BINK environment
+ * variable without showing it, once decoding each frame when it is needed
+ * and once decoding ahead on another thread, and reports the frames
+ * decoded per second.
+ */
+BENCHMARK(video_bink) {
+	const char *path = getenv("SCUMMVM_BENCHMARK_BINK");
+	if (!path) {
+		printf("  Skipped, set SCUMMVM_BENCHMARK_BINK to the path of a Bink video\n");
+		return;
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		printf("  Could not open %s\n", path);
+		return;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(size);
+	const bool read = fread(data, 1, size, file) == (size_t)size;
+	fclose(file);
+
+	if (read) {
+		Benchmark::initSystem();
+
+		const uint32 expected = decodeVideo(data, size, 0);
+		const uint ahead[] = { 1, 4, 16 };
+		for (uint i = 0; i < ARRAYSIZE(ahead); ++i) {
+			if (decodeVideo(data, size, ahead[i]) != expected)
+				printf("  The frames decoded ahead differ!\n");
+		}
+	} else {
+		printf("  Could not read %s\n", path);
+	}
+
+	free(data);
+}
+
+#endif
@@ -0,0 +1,159 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+
+#include "common/rational.h"
+#include "common/str.h"
+#include "graphics/surface.h"
+#include "video/video_decoder.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+namespace {
+
+enum {
+	kWidth = 640,
+	kHeight = 480,
+	kFrames = 150,
+	kStallInterval = 10, ///< every this many frames, reading the next one stalls
+	kStallMicros = 30000,
+	kEngineMicros = 4000  ///< the time the engine spends on each frame
+};
+
+/**
+ * A video whose frames take a while to decode, and which now and then
+ * stalls when reading, like a video read from a slow disc.
+ */
+class SlowDecoder : public Video::VideoDecoder {
+public:
+	bool loadStream(Common::SeekableReadStream *stream) {
+		close();
+		_track = new SlowVideoTrack();
+		addTrack(_track);
+		return true;
+	}
+
+	void close() {
+		Video::VideoDecoder::close();
+		_track = 0;
+	}
+
+protected:
+	void readNextPacket() {
+		if ((_track->getCurFrame() + 1) % kStallInterval == 0)
+			usleep(kStallMicros);
+	}
+
+private:
+	class SlowVideoTrack : public FixedRateVideoTrack {
+	public:
+		SlowVideoTrack() : _curFrame(-1) {
+			_surface.create(kWidth, kHeight, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		}
+
+		~SlowVideoTrack() {
+			_surface.free();
+		}
+
+		uint16 getWidth() const { return kWidth; }
+		uint16 getHeight() const { return kHeight; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return kFrames; }
+
+		const Graphics::Surface *decodeNextFrame() {
+			_curFrame++;
+
+			// Some work per pixel, like a codec
+			uint32 seed = _curFrame;
+			for (int y = 0; y < kHeight; ++y) {
+				uint16 *row = (uint16 *)_surface.getBasePtr(0, y);
+				for (int x = 0; x < kWidth; ++x) {
+					for (int i = 0; i < 8; ++i)
+						seed = seed * 1103515245 + 12345;
+					row[x] = (uint16)(seed >> 16);
+				}
+			}
+
+			return &_surface;
+		}
+
+	protected:
+		Common::Rational getFrameRate() const { return 30; }
+
+	private:
+		int _curFrame;
+		Graphics::Surface _surface;
+	};
+
+	SlowVideoTrack *_track;
+};
+
+uint32 playVideo(uint decodeAhead) {
+	SlowDecoder decoder;
+	decoder.setDecodeAhead(decodeAhead);
+	decoder.loadStream(0);
+
+	uint32 checksum = 0;
+	uint frames = 0;
+	const uint64 start = Benchmark::getMicros();
+	while (!decoder.endOfVideo()) {
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		if (!surface)
+			break;
+
+		for (int y = 0; y < surface->h; y += 16)
+			checksum = checksum * 31 + *(const uint16 *)surface->getBasePtr(y, y);
+		++frames;
+
+		usleep(kEngineMicros);
+	}
+	const uint64 micros = Benchmark::getMicros() - start;
+
+	Common::String label = decodeAhead ? Common::String::format("%2u frames ahead", decodeAhead) : "when needed";
+	Benchmark::report(label.c_str(), frames, "frames", micros);
+	return checksum;
+}
+
+} // End of anonymous namespace
+
+/**
+ * Plays a video with slow frames and read stalls as fast as the decoder
+ * allows, while the engine spends some time on each frame, decoding
+ * frames when needed and ahead of time. Reports the frames shown per
+ * second.
+ */
+BENCHMARK(video_decode_ahead) {
+	Benchmark::initSystem();
+
+	const uint32 expected = playVideo(0);
+	const uint ahead[] = { 1, 4, 16 };
+	for (uint i = 0; i < ARRAYSIZE(ahead); ++i) {
+		if (playVideo(ahead[i]) != expected)
+			printf("  The frames decoded ahead differ!\n");
+	}
+}
@@ -0,0 +1,154 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "test/benchmark/benchmark.h"
+#include "base/plugins.h"
+
+// The engine code is only linked in when the engine is built in
+#if PLUGIN_ENABLED_STATIC(WINTERMUTE)
+
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+#include "engines/wintermute/graphics/transparent_surface.h"
+
+#include <math.h>
+
+namespace {
+
+enum {
+	kScreenWidth = 800,
+	kScreenHeight = 600,
+	kFrames = 200
+};
+
+/** One sprite drawn per frame, at a few positions */
+struct SpriteUse {
+	const char *name;
+	int width, height;
+	int copies;
+	int flipping;
+	uint32 color;
+	Wintermute::TSpriteBlendMode blendMode;
+};
+
+/**
+ * Roughly what a Wintermute scene draws: a few large characters and
+ * props with soft edges, UI elements, tinted and faded sprites, lights
+ * and shadows.
+ */
+const SpriteUse s_sprites[] = {
+	{ "character",     180, 400, 3, Wintermute::TransparentSurface::FLIP_NONE, 0xFFFFFFFF, Wintermute::BLEND_NORMAL },
+	{ "character (flipped)", 180, 400, 2, Wintermute::TransparentSurface::FLIP_H, 0xFFFFFFFF, Wintermute::BLEND_NORMAL },
+	{ "prop (faded)",  250, 150, 2, Wintermute::TransparentSurface::FLIP_NONE, 0x80FFFFFF, Wintermute::BLEND_NORMAL },
+	{ "icon (tinted)",  50,  50, 20, Wintermute::TransparentSurface::FLIP_NONE, 0xFFC0A080, Wintermute::BLEND_NORMAL },
+	{ "light",         300, 300, 2, Wintermute::TransparentSurface::FLIP_NONE, 0xFFFFFFFF, Wintermute::BLEND_ADDITIVE },
+	{ "light (tinted)", 200, 200, 2, Wintermute::TransparentSurface::FLIP_V, 0xC0FF8040, Wintermute::BLEND_ADDITIVE },
+	{ "shadow",        250, 80,  3, Wintermute::TransparentSurface::FLIP_NONE, 0xFFFFFFFF, Wintermute::BLEND_SUBTRACTIVE },
+	{ "shadow (tinted)", 250, 80, 2, Wintermute::TransparentSurface::FLIP_HV, 0xFF606060, Wintermute::BLEND_SUBTRACTIVE }
+};
+
+/**
+ * Creates a sprite with an opaque body, soft edges and fully transparent
+ * surroundings, like anti-aliased artwork.
+ */
+void createSprite(Wintermute::TransparentSurface &surface, int width, int height, uint32 &seed) {
+	surface.create(width, height, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+	const int cx = width / 2, cy = height / 2;
+	for (int y = 0; y < height; ++y) {
+		uint32 *row = (uint32 *)surface.getBasePtr(0, y);
+		for (int x = 0; x < width; ++x) {
+			// Distance from the center, 256 at the edge of an inscribed ellipse
+			const int dx = (x - cx) * 256 / cx, dy = (y - cy) * 256 / cy;
+			const int d = (int)sqrt((double)(dx * dx + dy * dy));
+			const int alpha = CLIP((256 - d) * 8, 0, 255);
+
+			seed = seed * 1103515245 + 12345;
+			row[x] = (seed & 0xFFFFFF00) | alpha;
+		}
+	}
+}
+
+} // End of anonymous namespace
+
+/**
+ * Draws a scene of sprites in all blend modes onto an 800x600 screen, once
+ * with the plain C code and once with the vector code, and reports the
+ * number of sprite pixels drawn per second.
+ */
+BENCHMARK(wintermute_blit) {
+	Graphics::Surface screen;
+	screen.create(kScreenWidth, kScreenHeight, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+
+	uint32 seed = 1;
+	Wintermute::TransparentSurface sprites[ARRAYSIZE(s_sprites)];
+	for (uint i = 0; i < ARRAYSIZE(s_sprites); ++i)
+		createSprite(sprites[i], s_sprites[i].width, s_sprites[i].height, seed);
+
+	uint64 totalMicros[2] = { 0, 0 };
+	double totalPixels = 0;
+
+	for (uint i = 0; i < ARRAYSIZE(s_sprites); ++i) {
+		const SpriteUse &use = s_sprites[i];
+		double pixels = 0;
+
+		for (int vector = 0; vector < 2; ++vector) {
+			Common::setCpuFeatureMask(vector ? 0xFFFFFFFF : 0);
+
+			// Also leave partly visible sprites at the screen edges
+			uint32 pos = 1;
+			pixels = 0;
+			const uint64 start = Benchmark::getMicros();
+			for (int frame = 0; frame < kFrames; ++frame) {
+				for (int copy = 0; copy < use.copies; ++copy) {
+					pos = pos * 1103515245 + 12345;
+					const int x = (int)((pos >> 8) % (kScreenWidth + use.width / 2)) - use.width / 4;
+					const int y = (int)((pos >> 20) % (kScreenHeight + use.height / 2)) - use.height / 4;
+
+					const Common::Rect drawn = sprites[i].blit(screen, x, y, use.flipping, nullptr, use.color, -1, -1, use.blendMode);
+					pixels += drawn.width() * drawn.height();
+				}
+			}
+			const uint64 micros = Benchmark::getMicros() - start;
+
+			Common::String label = Common::String::format("%-20s %s", use.name, vector ? "vector" : "C");
+			Benchmark::report(label.c_str(), pixels / 1000000.0, "Mpixels", micros);
+			totalMicros[vector] += micros;
+		}
+
+		totalPixels += pixels;
+	}
+
+	Common::setCpuFeatureMask(0xFFFFFFFF);
+	Benchmark::report("scene                C", totalPixels / 1000000.0, "Mpixels", totalMicros[0]);
+	Benchmark::report("scene                vector", totalPixels / 1000000.0, "Mpixels", totalMicros[1]);
+
+	Benchmark::consume(screen.getPixels(), screen.pitch * screen.h);
+	for (uint i = 0; i < ARRAYSIZE(s_sprites); ++i)
+		sprites[i].free();
+	screen.free();
+}
+
+#endif
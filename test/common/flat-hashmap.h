@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		FlatStringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+		TS_ASSERT(!container2.contains("foo"));
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("QUUX"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(container.find(1));
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		container.erase(2);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		// We take a const ref now to ensure that the map
+		// is not modified by getVal.
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef[1], -1);
+		TS_ASSERT_EQUALS(container.size(), 2u);
+	}
+
+	void test_copy() {
+		FlatStringMap map1, container2;
+		map1["foo"] = "bar";
+		map1["baz"] = "qux";
+		map1.erase("baz");
+		container2 = map1;
+		map1["foo"] = "changed";
+		TS_ASSERT_EQUALS(container2["foo"], "bar");
+		TS_ASSERT(!container2.contains("baz"));
+		TS_ASSERT_EQUALS(container2.size(), 1u);
+
+		FlatStringMap container3(container2);
+		TS_ASSERT_EQUALS(container3["FOO"], "bar");
+	}
+
+	void test_erase_while_iterating() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 1000; ++i)
+			container[i * 16] = i;
+
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			if (i->_value & 1)
+				container.erase(i);
+		}
+
+		TS_ASSERT_EQUALS(container.size(), 500u);
+		int found = 0;
+		for (Common::FlatHashMap<int, int>::const_iterator j = container.begin(); j != container.end(); ++j) {
+			TS_ASSERT_EQUALS(j->_key, j->_value * 16);
+			TS_ASSERT(!(j->_value & 1));
+			found++;
+		}
+		TS_ASSERT_EQUALS(found, 500);
+	}
+
+	void test_matches_hashmap() {
+		// Run the same random operations on both implementations, with
+		// a small key range so that erased slots get reused a lot
+		Common::FlatHashMap<uint, uint> flat;
+		Common::HashMap<uint, uint> reference;
+		uint32 seed = 1;
+
+		for (int op = 0; op < 20000; ++op) {
+			seed = seed * 1103515245 + 12345;
+			const uint key = (seed >> 8) % 600;
+			switch ((seed >> 24) % 4) {
+			case 0:
+			case 1:
+				flat[key] = op;
+				reference[key] = op;
+				break;
+			case 2:
+				flat.erase(key);
+				reference.erase(key);
+				break;
+			default:
+				TS_ASSERT_EQUALS(flat.contains(key), reference.contains(key));
+				break;
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Common::HashMap<uint, uint>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, 0xFFFFFFFF), i->_value);
+	}
+};
@@ -0,0 +1,147 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atomic.h"
+#include "common/thread.h"
+
+class ThreadTestSuite : public CxxTest::TestSuite
+{
+	struct Counter {
+		Counter() : calls(0) {
+			for (int i = 0; i < 1000; ++i)
+				seen[i] = 0;
+		}
+
+		void count(uint index) {
+			Common::atomicAdd(calls, 1);
+			seen[index]++;
+		}
+
+		volatile int32 calls;
+		int seen[1000];
+	};
+
+	class Adder : public Common::Thread {
+	public:
+		Adder(int *values, int count) : _values(values), _count(count), _sum(0) {}
+		int getSum() const { return _sum; }
+
+	protected:
+		void run() {
+			for (int i = 0; i < _count; ++i)
+				_sum += _values[i];
+		}
+
+	private:
+		int *_values;
+		int _count;
+		int _sum;
+	};
+
+	/** Hands numbers through a queue of a few slots, like a decoder running ahead */
+	class Producer : public Common::Thread {
+	public:
+		Producer(Common::Semaphore *free, Common::Semaphore *ready, int *slots, int numSlots, int count)
+			: _free(free), _ready(ready), _slots(slots), _numSlots(numSlots), _count(count) {}
+
+	protected:
+		void run() {
+			for (int i = 0; i < _count; ++i) {
+				_free->wait();
+				_slots[i % _numSlots] = i;
+				_ready->post();
+			}
+		}
+
+	private:
+		Common::Semaphore *_free, *_ready;
+		int *_slots;
+		int _numSlots, _count;
+	};
+
+	public:
+	void test_run_in_parallel() {
+		for (uint threads = 1; threads <= 4; ++threads) {
+			Counter counter;
+			Common::runInParallel(1000, Common::Functor1Mem<uint, void, Counter>(&counter, &Counter::count), threads);
+
+			TS_ASSERT_EQUALS(counter.calls, 1000);
+			for (int i = 0; i < 1000; ++i)
+				TS_ASSERT_EQUALS(counter.seen[i], 1);
+		}
+
+		// Nothing to do at all
+		Counter counter;
+		Common::runInParallel(0, Common::Functor1Mem<uint, void, Counter>(&counter, &Counter::count), 4);
+		TS_ASSERT_EQUALS(counter.calls, 0);
+	}
+
+	void test_thread_pool() {
+		for (uint threads = 1; threads <= 4; ++threads) {
+			Common::ThreadPool pool(threads);
+			TS_ASSERT(pool.getNumThreads() >= 1 && pool.getNumThreads() <= threads);
+
+			// The same threads take on one task after the other
+			for (uint count = 0; count <= 1000; count += 200) {
+				Counter counter;
+				pool.run(count, Common::Functor1Mem<uint, void, Counter>(&counter, &Counter::count));
+
+				TS_ASSERT_EQUALS(counter.calls, (int32)count);
+				for (uint i = 0; i < 1000; ++i)
+					TS_ASSERT_EQUALS(counter.seen[i], i < count ? 1 : 0);
+			}
+		}
+	}
+
+	void test_thread() {
+		int values[100];
+		for (int i = 0; i < 100; ++i)
+			values[i] = i;
+
+		Adder adder(values, 100);
+		TS_ASSERT(!adder.isStarted());
+
+		if (adder.start()) {
+			TS_ASSERT(adder.isStarted());
+			adder.join();
+			TS_ASSERT_EQUALS(adder.getSum(), 4950);
+		}
+
+		TS_ASSERT(!adder.isStarted());
+		// Joining a thread which is not running does nothing
+		adder.join();
+	}
+
+	void test_semaphore() {
+		Common::Semaphore semaphore(2);
+		TS_ASSERT(semaphore.tryWait());
+		semaphore.wait();
+		TS_ASSERT(!semaphore.tryWait());
+
+		semaphore.post();
+		semaphore.post();
+		semaphore.wait();
+		TS_ASSERT(semaphore.tryWait());
+		TS_ASSERT(!semaphore.tryWait());
+	}
+
+	void test_semaphore_queue() {
+		Common::Semaphore free(3), ready(0);
+		int slots[3];
+		Producer producer(&free, &ready, slots, 3, 1000);
+
+		// Without threads there is nothing to hand over
+		if (!producer.start())
+			return;
+
+		bool inOrder = true;
+		for (int i = 0; i < 1000; ++i) {
+			ready.wait();
+			inOrder = inOrder && slots[i % 3] == i;
+			free.post();
+		}
+
+		producer.join();
+		TS_ASSERT(inOrder);
+		TS_ASSERT(!ready.tryWait());
+	}
+};
@@ -0,0 +1,87 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <cxxtest/TestSuite.h>
+
+#include "engines/sci/graphics/frameout_changes.h"
+#include "common/rect.h"
+
+class FrameoutChangesTestSuite : public CxxTest::TestSuite
+{
+	Sci::FrameoutDrawRecord createView(uint32 remapGeneration) {
+		Sci::FrameoutDrawRecord record = Sci::FrameoutDrawRecord();
+		record.plane = Sci::make_reg(1, 2);
+		record.object = Sci::make_reg(1, 3);
+		record.type = Sci::kFrameoutDrawView;
+		record.resourceId = 100;
+		record.x = 40;
+		record.y = 50;
+		record.remapGeneration = remapGeneration;
+		record.celRect = Common::Rect(40, 50, 72, 82);
+		record.rect = record.celRect;
+		return record;
+	}
+
+	/** Draws a frame with a picture and a view, and returns whether the view's area is dirty afterwards */
+	bool drawFrame(Sci::FrameoutChangeTracker &changes, Graphics::DirtyRegion &dirtyRegion, uint32 remapGeneration) {
+		Sci::FrameoutDrawRecord picture = Sci::FrameoutDrawRecord();
+		picture.plane = Sci::make_reg(1, 2);
+		picture.type = Sci::kFrameoutDrawPicture;
+		picture.resourceId = 200;
+		picture.rect = Common::Rect(0, 0, 320, 200);
+
+		dirtyRegion.clear();
+		changes.addRecord(picture);
+		changes.addRecord(createView(remapGeneration));
+		changes.findChanges(dirtyRegion);
+
+		Common::Rect rects[4];
+		const uint count = dirtyRegion.getRects(rects, ARRAYSIZE(rects));
+		for (uint i = 0; i < count; ++i) {
+			if (rects[i].contains(createView(remapGeneration).rect))
+				return true;
+		}
+		return false;
+	}
+
+	public:
+	void test_unchanged_frame() {
+		Sci::FrameoutChangeTracker changes;
+		Graphics::DirtyRegion dirtyRegion;
+		dirtyRegion.setSize(320, 200);
+
+		TS_ASSERT(drawFrame(changes, dirtyRegion, 0));
+		TS_ASSERT(!drawFrame(changes, dirtyRegion, 0));
+		TS_ASSERT(dirtyRegion.isEmpty());
+	}
+
+	void test_remap_change() {
+		Sci::FrameoutChangeTracker changes;
+		Graphics::DirtyRegion dirtyRegion;
+		dirtyRegion.setSize(320, 200);
+
+		drawFrame(changes, dirtyRegion, 0);
+		// Only the remapped colors differ, e.g. when a room fades to black
+		TS_ASSERT(drawFrame(changes, dirtyRegion, 1));
+		TS_ASSERT(!drawFrame(changes, dirtyRegion, 1));
+	}
+};
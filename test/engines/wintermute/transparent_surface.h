@@ -0,0 +1,104 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/wintermute/graphics/transparent_surface.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite
+{
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Fills a surface with random colors. Most alpha values are the edge
+	 * cases of the blenders: fully transparent, fully opaque and the ones
+	 * next to them or to the middle.
+	 */
+	void fill(Graphics::Surface &surface) {
+		static const byte alphas[] = { 0, 1, 127, 128, 129, 254, 255 };
+
+		for (int y = 0; y < surface.h; ++y) {
+			uint32 *row = (uint32 *)surface.getBasePtr(0, y);
+			for (int x = 0; x < surface.w; ++x) {
+				const uint32 r = nextRandom();
+				const byte alpha = (r & 3) ? alphas[(r >> 2) % ARRAYSIZE(alphas)] : (byte)(r >> 2);
+				row[x] = (nextRandom() << 8) | alpha;
+			}
+		}
+	}
+
+	/**
+	 * Blits a sprite with the vector code disabled and enabled, and
+	 * compares the results, including the pixels around the sprite.
+	 */
+	void compare(int width, int flipping, uint32 color, Wintermute::TSpriteBlendMode blendMode) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		const int height = 3;
+
+		Wintermute::TransparentSurface sprite;
+		sprite.create(width, height, format);
+		fill(sprite);
+
+		Graphics::Surface background;
+		background.create(width + 2, height + 2, format);
+		fill(background);
+
+		Graphics::Surface target[2];
+		for (int vector = 0; vector < 2; ++vector) {
+			Common::setCpuFeatureMask(vector ? 0xFFFFFFFF : 0);
+
+			target[vector].copyFrom(background);
+			sprite.blit(target[vector], 1, 1, flipping, nullptr, color, -1, -1, blendMode);
+		}
+
+		for (int y = 0; y < background.h; ++y) {
+			const uint32 *scalar = (const uint32 *)target[0].getBasePtr(0, y);
+			const uint32 *vector = (const uint32 *)target[1].getBasePtr(0, y);
+			for (int x = 0; x < background.w; ++x) {
+				if (scalar[x] != vector[x]) {
+					TS_FAIL(Common::String::format("Blend mode %d, width %d, flipping %d, color %08x differs at %d,%d: %08x instead of %08x",
+						blendMode, width, flipping, color, x, y, vector[x], scalar[x]).c_str());
+					y = background.h;
+					break;
+				}
+			}
+		}
+
+		for (int vector = 0; vector < 2; ++vector)
+			target[vector].free();
+		background.free();
+		sprite.free();
+	}
+
+	public:
+	void test_vector_blit() {
+		static const Wintermute::TSpriteBlendMode blendModes[] = {
+			Wintermute::BLEND_NORMAL, Wintermute::BLEND_ADDITIVE, Wintermute::BLEND_SUBTRACTIVE
+		};
+		static const int flippings[] = {
+			Wintermute::TransparentSurface::FLIP_NONE, Wintermute::TransparentSurface::FLIP_H,
+			Wintermute::TransparentSurface::FLIP_V, Wintermute::TransparentSurface::FLIP_HV
+		};
+		// Without and with tinting and fading, and their edge cases
+		static const uint32 colors[] = { 0xFFFFFFFF, 0x80FFFFFF, 0x01FFFFFF, 0xFFC0A080, 0xFF000000, 0xFE7F8001 };
+		// Shorter than a vector, whole vectors, and whole vectors with a rest
+		static const int widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33 };
+
+		_seed = 1;
+		for (uint b = 0; b < ARRAYSIZE(blendModes); ++b) {
+			for (uint f = 0; f < ARRAYSIZE(flippings); ++f) {
+				for (uint c = 0; c < ARRAYSIZE(colors); ++c) {
+					for (uint w = 0; w < ARRAYSIZE(widths); ++w)
+						compare(widths[w], flippings[f], colors[c], blendModes[b]);
+				}
+			}
+		}
+
+		Common::setCpuFeatureMask(0xFFFFFFFF);
+	}
+};
@@ -0,0 +1,145 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyregion.h"
+#include "common/array.h"
+#include "common/rect.h"
+#include "common/util.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kWidth = 100,
+		kHeight = 60
+	};
+
+	/** Checks that the rects don't overlap, and cover exactly the tiles touched by the added rects */
+	void checkRects(const Common::Rect *rects, uint count, const Common::Array<Common::Rect> &added, bool exact) {
+		byte covered[kHeight][kWidth];
+		memset(covered, 0, sizeof(covered));
+
+		for (uint i = 0; i < count; ++i) {
+			TS_ASSERT(!rects[i].isEmpty());
+			TS_ASSERT(rects[i].left >= 0 && rects[i].top >= 0);
+			TS_ASSERT(rects[i].right <= kWidth && rects[i].bottom <= kHeight);
+			for (int y = rects[i].top; y < rects[i].bottom; ++y) {
+				for (int x = rects[i].left; x < rects[i].right; ++x) {
+					TS_ASSERT_EQUALS(covered[y][x], 0);
+					covered[y][x] = 1;
+				}
+			}
+		}
+
+		byte expected[kHeight][kWidth];
+		memset(expected, 0, sizeof(expected));
+		for (uint i = 0; i < added.size(); ++i) {
+			Common::Rect r = added[i];
+			r.clip(Common::Rect(0, 0, kWidth, kHeight));
+			for (int y = r.top; y < r.bottom; ++y)
+				for (int x = r.left; x < r.right; ++x)
+					expected[y][x] = 1;
+		}
+
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				// Every dirty pixel has to be covered
+				if (expected[y][x])
+					TS_ASSERT_EQUALS(covered[y][x], 1);
+
+				// Exact regions only cover the tiles of dirty pixels
+				if (exact && covered[y][x]) {
+					bool tileDirty = false;
+					for (int ty = y & ~7; ty < MIN<int>(kHeight, (y & ~7) + 8); ++ty)
+						for (int tx = x & ~7; tx < MIN<int>(kWidth, (x & ~7) + 8); ++tx)
+							tileDirty = tileDirty || expected[ty][tx];
+					TS_ASSERT(tileDirty);
+				}
+			}
+		}
+	}
+
+	public:
+	void test_empty_and_full() {
+		Graphics::DirtyRegion region;
+		region.setSize(kWidth, kHeight);
+		TS_ASSERT(region.isEmpty());
+
+		Common::Rect rects[4];
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 0u);
+
+		// Clipped away completely
+		region.add(Common::Rect(kWidth, 0, kWidth + 10, 10));
+		TS_ASSERT(region.isEmpty());
+
+		region.addAll();
+		TS_ASSERT(!region.isEmpty());
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 1u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, kWidth, kHeight));
+
+		region.clear();
+		TS_ASSERT(region.isEmpty());
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 0u);
+	}
+
+	void test_merge() {
+		Graphics::DirtyRegion region;
+		region.setSize(kWidth, kHeight);
+
+		// Overlapping and adjacent rects in the same tiles become one
+		region.add(Common::Rect(1, 1, 5, 5));
+		region.add(Common::Rect(3, 3, 7, 7));
+		region.add(Common::Rect(8, 0, 16, 8));
+
+		Common::Rect rects[4];
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 1u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 16, 8));
+
+		// Tiles are clipped at the edges
+		region.clear();
+		region.add(Common::Rect(95, 55, 120, 70));
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 1u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(88, 48, kWidth, kHeight));
+
+		// An L shape needs two rects
+		region.clear();
+		region.add(Common::Rect(0, 0, 16, 8));
+		region.add(Common::Rect(0, 8, 8, 16));
+		TS_ASSERT_EQUALS(region.getRects(rects, 4), 2u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 16, 8));
+		TS_ASSERT_EQUALS(rects[1], Common::Rect(0, 8, 8, 16));
+	}
+
+	void test_random() {
+		Graphics::DirtyRegion region;
+		region.setSize(kWidth, kHeight);
+
+		uint32 seed = 1;
+		for (int round = 0; round < 50; ++round) {
+			Common::Array<Common::Rect> added;
+			region.clear();
+
+			const int count = round % 20 + 1;
+			for (int i = 0; i < count; ++i) {
+				seed = seed * 1103515245 + 12345;
+				const int x = (seed >> 8) % (kWidth + 10) - 5;
+				const int y = (seed >> 16) % (kHeight + 10) - 5;
+				seed = seed * 1103515245 + 12345;
+				const int w = (seed >> 8) % 30 + 1;
+				const int h = (seed >> 16) % 20 + 1;
+
+				added.push_back(Common::Rect(x, y, x + w, y + h));
+				region.add(added.back());
+			}
+
+			Common::Rect rects[64];
+			const uint numRects = region.getRects(rects, 64);
+			checkRects(rects, numRects, added, true);
+
+			// Not enough room, fewer but larger rects
+			for (uint maxRects = 1; maxRects < 4; ++maxRects) {
+				const uint numFewer = region.getRects(rects, maxRects);
+				TS_ASSERT(numFewer <= maxRects);
+				checkRects(rects, numFewer, added, false);
+			}
+		}
+	}
+};
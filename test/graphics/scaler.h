@@ -0,0 +1,121 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+#include "common/cpudetect.h"
+#include "common/str.h"
+#include "common/util.h"
+
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+	struct ScalerUse {
+		const char *name;
+		ScalerProc *proc;
+		int factor;
+	};
+
+	uint32 _seed;
+
+	uint32 nextRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 8;
+	}
+
+	/**
+	 * Fills a source with a border of one pixel, with runs of a few colors
+	 * like game graphics, mixed with similar and random colors, so that all
+	 * rules of the scalers are used.
+	 */
+	void fillSource(uint16 *src, int pitch, int height) {
+		static const uint16 colors[] = { 0x0000, 0xFFFF, 0x1234, 0x1235, 0x7BEF, 0xF800, 0x07E0, 0x001F };
+
+		for (int y = 0; y < height + 2; ++y) {
+			for (int x = 0; x < pitch; ++x) {
+				const uint32 r = nextRandom();
+				if (x > 0 && (r & 3) != 0)
+					src[y * pitch + x] = src[y * pitch + x - 1];
+				else if (y > 0 && (r & 4) != 0)
+					src[y * pitch + x] = src[(y - 1) * pitch + x];
+				else if ((r & 0x18) != 0)
+					src[y * pitch + x] = colors[(r >> 5) % ARRAYSIZE(colors)];
+				else
+					src[y * pitch + x] = (uint16)(r >> 5);
+			}
+		}
+	}
+
+	/**
+	 * Runs a scaler with the vector code disabled, with SSE2 only and with
+	 * all features enabled, and compares the results.
+	 */
+	void compare(const ScalerUse &scaler, uint32 bitFormat, int width, int height) {
+		static const uint32 masks[] = { 0, Common::kCpuFeatureSSE2, 0xFFFFFFFF };
+
+		const int srcPitch = width + 2;
+		const int dstPitch = width * scaler.factor + 8;
+		const int dstSize = dstPitch * height * scaler.factor;
+
+		uint16 *src = new uint16[srcPitch * (height + 2)];
+		fillSource(src, srcPitch, height);
+
+		uint16 *dst[ARRAYSIZE(masks)];
+		for (uint m = 0; m < ARRAYSIZE(masks); ++m) {
+			Common::setCpuFeatureMask(masks[m]);
+			InitScalers(bitFormat);
+
+			dst[m] = new uint16[dstSize];
+			memset(dst[m], 0xAB, dstSize * sizeof(uint16));
+			scaler.proc((const uint8 *)(src + srcPitch + 1), srcPitch * sizeof(uint16),
+			            (uint8 *)dst[m], dstPitch * sizeof(uint16), width, height);
+		}
+
+		for (uint m = 1; m < ARRAYSIZE(masks); ++m) {
+			int mismatch = -1;
+			for (int i = 0; i < dstSize && mismatch < 0; ++i) {
+				if (dst[0][i] != dst[m][i])
+					mismatch = i;
+			}
+			if (mismatch >= 0) {
+				TS_FAIL(Common::String::format("%s (%d, features %x) %dx%d differs at %d,%d: %04x instead of %04x",
+					scaler.name, bitFormat, masks[m], width, height, mismatch % dstPitch, mismatch / dstPitch,
+					dst[m][mismatch], dst[0][mismatch]).c_str());
+			}
+		}
+
+		for (uint m = 0; m < ARRAYSIZE(masks); ++m)
+			delete[] dst[m];
+		delete[] src;
+	}
+
+	public:
+	void test_vector_scalers() {
+		static const ScalerUse scalers[] = {
+			{ "Normal1x", Normal1x, 1 },
+#ifdef USE_SCALERS
+			{ "Normal2x", Normal2x, 2 },
+			{ "Normal3x", Normal3x, 3 },
+			{ "AdvMame2x", AdvMame2x, 2 },
+			{ "AdvMame3x", AdvMame3x, 3 },
+			{ "TV2x", TV2x, 2 },
+			{ "DotMatrix", DotMatrix, 2 },
+#ifdef USE_HQ_SCALERS
+			{ "HQ2x", HQ2x, 2 },
+			{ "HQ3x", HQ3x, 3 },
+#endif
+#endif
+		};
+		// Both shorter and longer than the vectors and the HQ pattern chunks
+		static const int widths[] = { 2, 7, 8, 9, 23, 64, 257, 320 };
+
+		_seed = 1;
+		for (int format = 0; format < 2; ++format) {
+			for (uint i = 0; i < ARRAYSIZE(scalers); ++i) {
+				for (uint w = 0; w < ARRAYSIZE(widths); ++w)
+					compare(scalers[i], format ? 555 : 565, widths[w], 6);
+			}
+		}
+
+		Common::setCpuFeatureMask(0xFFFFFFFF);
+		InitScalers(565);
+		DestroyScalers();
+	}
+};
@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/yuv_to_rgb.h"
+#include "graphics/surface.h"
+#include "common/array.h"
+#include "common/cpudetect.h"
+#include "test/system.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+	/** Fills the planes with noise, and a few runs of extreme values to exercise the clipping */
+	void fillPlane(Common::Array<byte> &plane, uint size, uint32 &seed) {
+		plane.resize(size);
+		for (uint i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			plane[i] = seed >> 24;
+			if ((seed & 0x700) == 0)
+				plane[i] = (seed & 0x800) ? 255 : 0;
+		}
+	}
+
+	/** Converts with the plain C code and with the vector code, and checks the output is identical */
+	void checkConversion(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, bool halfChroma, int width, int height) {
+		uint32 seed = width * 1000 + height;
+		const int uvWidth = halfChroma ? width / 2 : width;
+		const int uvHeight = halfChroma ? height / 2 : height;
+
+		Common::Array<byte> y, u, v;
+		fillPlane(y, width * height, seed);
+		fillPlane(u, uvWidth * uvHeight, seed);
+		fillPlane(v, uvWidth * uvHeight, seed);
+		checkConversion(format, scale, halfChroma, width, height, y, u, v);
+	}
+
+	void checkConversion(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, bool halfChroma, int width, int height,
+	                     const Common::Array<byte> &y, const Common::Array<byte> &u, const Common::Array<byte> &v) {
+		const int uvWidth = halfChroma ? width / 2 : width;
+
+		Graphics::Surface expected, actual;
+		expected.create(width, height, format);
+		actual.create(width, height, format);
+
+		for (int vector = 0; vector < 2; ++vector) {
+			Common::setCpuFeatureMask(vector ? 0xFFFFFFFF : 0);
+			Graphics::Surface &dst = vector ? actual : expected;
+			if (halfChroma)
+				YUVToRGBMan.convert420(&dst, scale, &y[0], &u[0], &v[0], width, height, width, uvWidth);
+			else
+				YUVToRGBMan.convert444(&dst, scale, &y[0], &u[0], &v[0], width, height, width, uvWidth);
+		}
+		Common::setCpuFeatureMask(0xFFFFFFFF);
+
+		for (int row = 0; row < height; ++row)
+			TS_ASSERT_SAME_DATA(expected.getBasePtr(0, row), actual.getBasePtr(0, row), width * format.bytesPerPixel);
+
+		expected.free();
+		actual.free();
+	}
+
+	void checkFormat(const Graphics::PixelFormat &format) {
+		static const int sizes[][2] = { { 2, 2 }, { 14, 6 }, { 64, 8 }, { 118, 10 }, { 600, 4 } };
+
+		for (uint i = 0; i < ARRAYSIZE(sizes); ++i) {
+			for (int itu = 0; itu < 2; ++itu) {
+				const Graphics::YUVToRGBManager::LuminanceScale scale = itu ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+				checkConversion(format, scale, false, sizes[i][0], sizes[i][1]);
+				checkConversion(format, scale, true, sizes[i][0], sizes[i][1]);
+			}
+		}
+	}
+
+	public:
+	void setUp() {
+		// The manager guards its lookup tables with a mutex
+		TestSystem::install();
+	}
+
+	void tearDown() {
+		TS_ASSERT_EQUALS(TestSystem::getLockCount(), 0);
+	}
+
+	void test_16bpp() {
+		checkFormat(Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		checkFormat(Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0));
+		checkFormat(Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
+		checkFormat(Graphics::PixelFormat(2, 5, 6, 5, 0, 0, 5, 11, 0));
+		checkFormat(Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0));
+	}
+
+	void test_all_chroma() {
+		// Every combination of chroma values, with the luminance at both ends and in the middle
+		Common::Array<byte> y, u, v;
+		y.resize(256 * 256);
+		u.resize(256 * 256);
+		v.resize(256 * 256);
+		for (uint i = 0; i < 256 * 256; ++i) {
+			u[i] = i & 0xFF;
+			v[i] = i >> 8;
+		}
+
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		for (int luminance = 0; luminance < 3; ++luminance) {
+			memset(&y[0], luminance * 127, y.size());
+			checkConversion(format, Graphics::YUVToRGBManager::kScaleFull, false, 256, 256, y, u, v);
+			checkConversion(format, Graphics::YUVToRGBManager::kScaleITU, false, 256, 256, y, u, v);
+		}
+	}
+
+	void test_32bpp() {
+		checkFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		checkFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24));
+		checkFormat(Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+		checkFormat(Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0));
+	}
+};
@@ -1,12 +1,24 @@
 ######################################################################
 # Unit/regression tests, based on CxxTest.
-# Use the 'test' target to run them.
+# Use the 'test' target to run them, and 'benchmark' for the benchmarks.
 # Edit TESTS and TESTLIBS to add more tests.
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h
+TEST_LIBS    := graphics/libgraphics.a audio/libaudio.a common/libcommon.a
+
+# Engine code with tests of its own, when it is built in
+ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
+TESTS        += $(srcdir)/test/engines/wintermute/*.h
+TEST_LIBS    := engines/wintermute/libwintermute.a $(TEST_LIBS)
+endif
+ifeq ($(ENABLE_SCI), STATIC_PLUGIN)
+ifdef ENABLE_SCI32
+TESTS        += $(srcdir)/test/engines/sci/*.h
+TEST_LIBS    := engines/sci/libsci.a $(TEST_LIBS)
+endif
+endif
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -34,9 +46,23 @@ test/runner.cpp: $(TESTS)
 	@mkdir -p test
 	$(srcdir)/test/cxxtest/cxxtestgen.py $(TEST_FLAGS) -o $@ $+
 
+#
+# Benchmarks, using a minimal harness of their own.
+# Use the 'benchmark' target to run them, optionally passing a list of
+# benchmark name prefixes via BENCHMARK_ARGS.
+#
+BENCHMARKS   := $(wildcard $(srcdir)/test/benchmark/*.cpp)
+BENCHMARK_LIBS := gui/libgui.a backends/libbackends.a engines/libengines.a video/libvideo.a $(TEST_LIBS)
+
+benchmark: test/benchmark/runner
+	./test/benchmark/runner $(BENCHMARK_ARGS)
+test/benchmark/runner: $(BENCHMARKS) $(BENCHMARK_LIBS)
+	@mkdir -p test/benchmark
+	$(QUIET_LINK)$(CXX) $(TEST_CXXFLAGS) $(CPPFLAGS) -O2 -o $@ $+ $(TEST_LDFLAGS)
+
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner
+	-$(RM) test/runner.cpp test/runner test/benchmark/runner
 
-.PHONY: test clean-test
+.PHONY: test clean-test benchmark
@@ -0,0 +1,86 @@
+#ifndef TEST_SYSTEM_H
+#define TEST_SYSTEM_H
+
+#include "common/system.h"
+#include "graphics/pixelformat.h"
+
+/**
+ * A backend without any output, for tests of code which needs an OSystem
+ * for its mutexes. The tests run on a single thread, so the mutexes only
+ * count how often they are locked, which lets the tests check that every
+ * lock is released again.
+ */
+class TestSystem : public OSystem {
+public:
+	/** Installs the test system as g_system, unless there already is one. */
+	static void install() {
+		if (!g_system)
+			g_system = new TestSystem();
+	}
+
+	/** The number of locks not released yet, over all mutexes. */
+	static int getLockCount() { return _lockCount; }
+
+	virtual const GraphicsMode *getSupportedGraphicsModes() const {
+		static const GraphicsMode noGraphicsModes[] = { { 0, 0, 0 } };
+		return noGraphicsModes;
+	}
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return true; }
+	virtual int getGraphicsMode() const { return 0; }
+#ifdef USE_RGB_COLOR
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+#endif
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) {}
+
+	virtual uint32 getMillis(bool skipRecord = false) { return 1; }
+	virtual void delayMillis(uint msecs) {}
+	virtual void getTimeAndDate(TimeDate &t) const {}
+
+	virtual MutexRef createMutex() { return (MutexRef)new int(0); }
+	virtual void lockMutex(MutexRef mutex) {
+		++*(int *)mutex;
+		++_lockCount;
+	}
+	virtual void unlockMutex(MutexRef mutex) {
+		--*(int *)mutex;
+		--_lockCount;
+	}
+	virtual void deleteMutex(MutexRef mutex) { delete (int *)mutex; }
+
+	virtual Audio::Mixer *getMixer() { return 0; }
+
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+
+private:
+	static int _lockCount;
+};
+
+int TestSystem::_lockCount = 0;
+
+#endif
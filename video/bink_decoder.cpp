@@ -39,6 +39,8 @@
 #include "common/rdft.h"
 #include "common/dct.h"
 #include "common/system.h"
+#include "common/atomic.h"
+#include "common/func.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
@@ -63,6 +65,14 @@ namespace Video {
 
 BinkDecoder::BinkDecoder() {
 	_bink = 0;
+
+	_decodeThread = 0;
+	_slots = 0;
+	_slotCount = 0;
+	_writeSlot = _readSlot = 0;
+	_holdingSlot = false;
+	_freeSlots = _readySlots = 0;
+	_stopDecoding = 0;
 }
 
 BinkDecoder::~BinkDecoder() {
@@ -143,10 +153,15 @@ bool BinkDecoder::loadStream(Common::SeekableReadStream *stream) {
 
 	_frames[frameCount - 1].size = _bink->size() - _frames[frameCount - 1].offset;
 
+	startDecodeThread();
+
 	return true;
 }
 
 void BinkDecoder::close() {
+	// The decode thread uses everything else, so it goes first
+	stopDecodeThread();
+
 	VideoDecoder::close();
 
 	delete _bink;
@@ -162,7 +177,25 @@ void BinkDecoder::readNextPacket() {
 	if (videoTrack->endOfTrack())
 		return;
 
-	VideoFrame &frame = _frames[videoTrack->getCurFrame() + 1];
+	if (!_decodeThread) {
+		decodeFrame(videoTrack->getCurFrame() + 1, videoTrack->getSurface());
+		videoTrack->showFrame(&videoTrack->getSurface());
+		return;
+	}
+
+	_readySlots->wait();
+
+	// The frame shown so far isn't needed anymore
+	if (_holdingSlot)
+		_freeSlots->post();
+
+	videoTrack->showFrame(&_slots[_readSlot]);
+	_readSlot = (_readSlot + 1) % _slotCount;
+	_holdingSlot = true;
+}
+
+void BinkDecoder::decodeFrame(uint32 frameNr, Graphics::Surface &dst) {
+	VideoFrame &frame = _frames[frameNr];
 
 	if (!_bink->seek(frame.offset))
 		error("Bad bink seek");
@@ -208,12 +241,80 @@ void BinkDecoder::readNextPacket() {
 	frame.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
 			videoPacketStart, videoPacketEnd), true);
 
-	videoTrack->decodePacket(frame);
+	BinkVideoTrack *videoTrack = (BinkVideoTrack *)getTrack(0);
+	videoTrack->decodePacket(frame, dst);
 
 	delete frame.bits;
 	frame.bits = 0;
 }
 
+void BinkDecoder::startDecodeThread() {
+	if (!getDecodeAhead())
+		return;
+
+	BinkVideoTrack *videoTrack = (BinkVideoTrack *)getTrack(0);
+
+	// One more slot than frames decoded ahead, for the frame being shown
+	_slotCount = getDecodeAhead() + 1;
+	_slots = new Graphics::Surface[_slotCount];
+	for (uint i = 0; i < _slotCount; i++)
+		videoTrack->createSurface(_slots[i]);
+
+	_writeSlot = _readSlot = 0;
+	_holdingSlot = false;
+	_freeSlots = new Common::Semaphore(_slotCount);
+	_readySlots = new Common::Semaphore(0);
+	_stopDecoding = 0;
+
+	// Make sure the converter isn't first created on two threads at once
+	Graphics::YUVToRGBManager::instance();
+	videoTrack->setParallelConversion(true);
+
+	_decodeThread = new DecodeThread(this);
+	if (!_decodeThread->start()) {
+		// Fall back to decoding each frame when it is needed
+		delete _decodeThread;
+		_decodeThread = 0;
+		stopDecodeThread();
+		videoTrack->setParallelConversion(false);
+	}
+}
+
+void BinkDecoder::stopDecodeThread() {
+	if (_decodeThread) {
+		Common::atomicStore(_stopDecoding, 1);
+		// Wake the thread up if it is waiting for a free slot
+		_freeSlots->post();
+		_decodeThread->join();
+
+		delete _decodeThread;
+		_decodeThread = 0;
+	}
+
+	delete _freeSlots;
+	delete _readySlots;
+	_freeSlots = _readySlots = 0;
+
+	for (uint i = 0; i < _slotCount; i++)
+		_slots[i].free();
+	delete[] _slots;
+	_slots = 0;
+	_slotCount = 0;
+}
+
+void BinkDecoder::decodeAhead() {
+	for (uint32 frameNr = 0; frameNr < _frames.size(); frameNr++) {
+		_freeSlots->wait();
+		if (Common::atomicLoad(_stopDecoding))
+			return;
+
+		decodeFrame(frameNr, _slots[_writeSlot]);
+		_writeSlot = (_writeSlot + 1) % _slotCount;
+
+		_readySlots->post();
+	}
+}
+
 BinkDecoder::VideoFrame::VideoFrame() : bits(0) {
 }
 
@@ -238,6 +339,10 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const G
 		_frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id) {
 	_curFrame = -1;
 
+	_convertPool = 0;
+	_convertDst = 0;
+	_convertBands = 0;
+
 	for (int i = 0; i < 16; i++)
 		_huffman[i] = 0;
 
@@ -277,6 +382,7 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const G
 	// surface.
 	_surface.h = height;
 	_surface.w = width;
+	_shownSurface = &_surface;
 
 	// Give the planes a bit extra space
 	width  = _surface.w + 32;
@@ -306,6 +412,8 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const G
 }
 
 BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
+	delete _convertPool;
+
 	for (int i = 0; i < 4; i++) {
 		delete[] _curPlanes[i]; _curPlanes[i] = 0;
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
@@ -321,7 +429,33 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 	_surface.free();
 }
 
-void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
+void BinkDecoder::BinkVideoTrack::createSurface(Graphics::Surface &surface) const {
+	// Over-allocated like our own surface
+	surface.create(_surfaceWidth, _surfaceHeight, _surface.format);
+	surface.w = _surface.w;
+	surface.h = _surface.h;
+}
+
+void BinkDecoder::BinkVideoTrack::setParallelConversion(bool parallel) {
+	delete _convertPool;
+	_convertPool = 0;
+
+	if (parallel) {
+		// Bands of at least 32 rows, so handing them to other threads pays off
+		_convertPool = new Common::ThreadPool(CLIP<uint>(_surfaceHeight / 32, 1, Common::getNumCores()));
+		if (_convertPool->getNumThreads() == 1) {
+			delete _convertPool;
+			_convertPool = 0;
+		}
+	}
+}
+
+void BinkDecoder::BinkVideoTrack::showFrame(const Graphics::Surface *surface) {
+	_shownSurface = surface;
+	_curFrame++;
+}
+
+void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame, Graphics::Surface &dst) {
 	assert(frame.bits);
 
 	if (_hasAlpha) {
@@ -348,14 +482,33 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	// The width used here is the surface-width, and not the video-width
 	// to allow for odd-sized videos.
 	assert(_curPlanes[0] && _curPlanes[1] && _curPlanes[2]);
-	YUVToRGBMan.convert420(&_surface, Graphics::YUVToRGBManager::kScaleITU, _curPlanes[0], _curPlanes[1], _curPlanes[2],
-			_surfaceWidth, _surfaceHeight, _surfaceWidth, _surfaceWidth >> 1);
+	_convertDst = &dst;
+	_convertBands = _convertPool ? _convertPool->getNumThreads() : 1;
+
+	if (_convertBands > 1)
+		_convertPool->run(_convertBands, Common::Functor1Mem<uint, void, BinkVideoTrack>(this, &BinkVideoTrack::convertBand));
+	else
+		convertBand(0);
 
 	// And swap the planes with the reference planes
 	for (int i = 0; i < 4; i++)
 		SWAP(_curPlanes[i], _oldPlanes[i]);
+}
 
-	_curFrame++;
+void BinkDecoder::BinkVideoTrack::convertBand(uint band) {
+	// Bands start on even rows, as two rows share their chroma
+	const int top = (_surfaceHeight * band / _convertBands) & ~1;
+	const int bottom = (_surfaceHeight * (band + 1) / _convertBands) & ~1;
+	if (top == bottom)
+		return;
+
+	Graphics::Surface dst;
+	dst.init(_surfaceWidth, bottom - top, _convertDst->pitch, _convertDst->getBasePtr(0, top), _convertDst->format);
+
+	const int uvOffset = (top >> 1) * (_surfaceWidth >> 1);
+	YUVToRGBMan.convert420(&dst, Graphics::YUVToRGBManager::kScaleITU, _curPlanes[0] + top * _surfaceWidth,
+			_curPlanes[1] + uvOffset, _curPlanes[2] + uvOffset,
+			_surfaceWidth, bottom - top, _surfaceWidth, _surfaceWidth >> 1);
 }
 
 void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
@@ -33,6 +33,7 @@
 
 #include "common/array.h"
 #include "common/rational.h"
+#include "common/thread.h"
 
 #include "video/video_decoder.h"
 
@@ -75,6 +76,12 @@ public:
 protected:
 	void readNextPacket();
 
+	/**
+	 * Bink decodes ahead on its own, straight into the frames shown, and
+	 * starts doing so when a video is loaded.
+	 */
+	bool supportsDecodeAhead() const { return false; }
+
 private:
 	static const int kAudioChannelsMax  = 2;
 	static const int kAudioBlockSizeMax = (kAudioChannelsMax << 11);
@@ -147,10 +154,20 @@ private:
 		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
-		const Graphics::Surface *decodeNextFrame() { return &_surface; }
+		const Graphics::Surface *decodeNextFrame() { return _shownSurface; }
+
+		/** Create a surface which frames can be decoded into. */
+		void createSurface(Graphics::Surface &surface) const;
+		/** The surface frames are decoded into when they are not decoded ahead. */
+		Graphics::Surface &getSurface() { return _surface; }
 
-		/** Decode a video packet. */
-		void decodePacket(VideoFrame &frame);
+		/** Split the color conversion of each frame over all cores. */
+		void setParallelConversion(bool parallel);
+
+		/** Decode a video packet into a surface. */
+		void decodePacket(VideoFrame &frame, Graphics::Surface &dst);
+		/** Make a decoded surface the current frame. */
+		void showFrame(const Graphics::Surface *surface);
 
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
@@ -233,9 +250,14 @@ private:
 		int _frameCount;
 
 		Graphics::Surface _surface;
+		const Graphics::Surface *_shownSurface; ///< The current frame
 		int _surfaceWidth; ///< The actual surface width
 		int _surfaceHeight; ///< The actual surface height
 
+		Common::ThreadPool *_convertPool; ///< The threads converting the bands, if there are several
+		Graphics::Surface *_convertDst; ///< The surface being converted to
+		uint _convertBands;             ///< The number of bands being converted
+
 		uint32 _id; ///< The BIK FourCC.
 
 		bool _hasAlpha;   ///< Do video frames have alpha?
@@ -263,6 +285,9 @@ private:
 		/** Initialize the Huffman decoders. */
 		void initHuffman();
 
+		/** Convert a band of rows of the last decoded frame to RGB. */
+		void convertBand(uint band);
+
 		/** Decode a plane. */
 		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
 
@@ -345,12 +370,48 @@ private:
 		static void floatToInt16Interleave(int16 *dst, const float **src, uint32 length, uint8 channels);
 	};
 
+	/** Decodes the frames ahead of time. */
+	class DecodeThread : public Common::Thread {
+	public:
+		DecodeThread(BinkDecoder *decoder) : _decoder(decoder) {}
+
+	protected:
+		void run() { _decoder->decodeAhead(); }
+
+	private:
+		BinkDecoder *_decoder;
+	};
+
 	Common::SeekableReadStream *_bink;
 
 	Common::Array<AudioInfo> _audioTracks; ///< All audio tracks.
 	Common::Array<VideoFrame> _frames;      ///< All video frames.
 
+	/**
+	 * While decoding ahead, the decoded frames go into a ring of surfaces.
+	 * The decode thread fills the free slots, and readNextPacket() shows
+	 * the ready ones in order. The slot of the frame being shown is only
+	 * given back when the next frame is shown.
+	 */
+	DecodeThread *_decodeThread;
+	Graphics::Surface *_slots;
+	uint _slotCount;
+	uint _writeSlot, _readSlot;
+	bool _holdingSlot;
+	Common::Semaphore *_freeSlots, *_readySlots;
+	volatile int32 _stopDecoding;
+
 	void initAudioTrack(AudioInfo &audio);
+
+	/** Read the packets of a frame, decoding its audio and its video into a surface. */
+	void decodeFrame(uint32 frameNr, Graphics::Surface &dst);
+
+	/** Start decoding ahead, if enabled. */
+	void startDecodeThread();
+	/** Stop decoding ahead, and free the frames decoded so far. */
+	void stopDecodeThread();
+	/** The loop of the decode thread. */
+	void decodeAhead();
 };
 
 } // End of namespace Video
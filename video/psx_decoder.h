@@ -74,6 +74,8 @@ public:
 protected:
 	void readNextPacket();
 	bool useAudioSync() const;
+	// The tracks are only added while reading the packets
+	bool supportsDecodeAhead() const { return false; }
 
 private:
 	class PSXVideoTrack : public VideoTrack {
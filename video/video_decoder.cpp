@@ -26,13 +26,77 @@
 #include "audio/mixer.h" // for kMaxChannelVolume
 
 #include "common/rational.h"
+#include "common/atomic.h"
 #include "common/file.h"
 #include "common/system.h"
+#include "common/thread.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+/** A frame decoded ahead, with the state of its track after decoding it */
+struct DecodeAheadFrame {
+	Graphics::Surface surface;
+	bool hasSurface;
+
+	byte palette[256 * 3];
+	bool dirtyPalette;
+
+	int curFrame;
+	bool endOfTrack;
+	uint32 nextFrameStartTime;
+
+	DecodeAheadFrame() : hasSurface(false), dirtyPalette(false), curFrame(-1), endOfTrack(false), nextFrameStartTime(0) {}
+	~DecodeAheadFrame() { surface.free(); }
+};
+
+/**
+ * The frames decoded ahead go into a ring of slots. The decode thread
+ * fills the free slots, and decodeNextFrame() returns the ready ones in
+ * order. The slot of the frame returned last is only given back with the
+ * next frame, as the caller may still use its surface until then.
+ */
+struct VideoDecoder::DecodeAheadState {
+	DecodeAheadState(VideoTrack *t, uint frames) :
+			track(t), slots(new DecodeAheadFrame[frames + 1]), slotCount(frames + 1),
+			freeSlots(frames + 1), readySlots(0), writeSlot(0), readSlot(0),
+			holdingSlot(false), stop(0), thread(0) {
+	}
+
+	~DecodeAheadState() {
+		delete[] slots;
+	}
+
+	VideoTrack *track;
+
+	DecodeAheadFrame *slots;
+	uint slotCount;
+	Common::Semaphore freeSlots, readySlots;
+	uint writeSlot, readSlot;
+	bool holdingSlot;
+	volatile int32 stop;
+
+	DecodeAheadThread *thread;
+
+	/** The state of the track as of the frame returned last */
+	int curFrame;
+	bool endOfTrack;
+	uint32 nextFrameStartTime;
+};
+
+class VideoDecoder::DecodeAheadThread : public Common::Thread {
+public:
+	DecodeAheadThread(VideoDecoder *decoder) : _decoder(decoder) {}
+
+protected:
+	void run() { _decoder->runDecodeAhead(); }
+
+private:
+	VideoDecoder *_decoder;
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -46,6 +110,8 @@ VideoDecoder::VideoDecoder() {
 	_endTime = 0;
 	_endTimeSet = false;
 	_nextVideoTrack = 0;
+	_decodeAheadFrames = 0;
+	_decodeAhead = 0;
 
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
@@ -54,7 +120,17 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	// Subclasses close the video before they go away, so this only frees
+	// the state
+	stopDecodeAhead();
+}
+
 void VideoDecoder::close() {
+	// The decode thread uses the tracks and whatever the subclass reads
+	// them from, so it goes first
+	stopDecodeAhead();
+
 	if (isPlaying())
 		stop();
 
@@ -170,6 +246,12 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 
+	if (!_decodeAhead && _decodeAheadFrames)
+		startDecodeAhead();
+
+	if (_decodeAhead)
+		return decodeNextFrameAhead();
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -195,6 +277,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// The tracks are ahead of the frame shown, and only go forwards
+	if (_decodeAhead)
+		return !reverse;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -219,7 +305,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+			frame += getTrackCurFrame((VideoTrack *)*it) + 1;
 
 	return frame;
 }
@@ -256,13 +342,17 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (endOfVideo() || _needsUpdate || !_nextVideoTrack)
+	const VideoTrack *nextVideoTrack = _nextVideoTrack;
+	if (_decodeAhead)
+		nextVideoTrack = _decodeAhead->endOfTrack ? 0 : _decodeAhead->track;
+
+	if (endOfVideo() || _needsUpdate || !nextVideoTrack)
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getTrackNextFrameStartTime(nextVideoTrack);
 
-	if (_nextVideoTrack->isReversed()) {
+	if (nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
 		if (nextFrameStartTime >= currentTime)
 			return 0;
@@ -279,7 +369,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if (!isTrackAtEnd(*it) && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || getTrackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return false;
 
 	return true;
@@ -300,6 +390,9 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	// Frames decoded ahead are of the old position
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -334,6 +427,9 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	// Frames decoded ahead are of the old position
+	stopDecodeAhead();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -795,7 +891,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !isTrackAtEnd(*it) && (!isPlaying() || !_endTimeSet || getTrackNextFrameStartTime((VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return true;
 
 	return false;
@@ -809,4 +905,141 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+void VideoDecoder::startDecodeAhead() {
+	if (!supportsDecodeAhead() || !_nextVideoTrack || _nextVideoTrack->isReversed())
+		return;
+
+	// Only a single video track can be followed by its frames alone
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && *it != _nextVideoTrack)
+			return;
+
+	_decodeAhead = new DecodeAheadState(_nextVideoTrack, _decodeAheadFrames);
+	_decodeAhead->curFrame = _nextVideoTrack->getCurFrame();
+	_decodeAhead->endOfTrack = _nextVideoTrack->endOfTrack();
+	_decodeAhead->nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+
+	_decodeAhead->thread = new DecodeAheadThread(this);
+	if (!_decodeAhead->thread->start()) {
+		// Without threads, don't try again
+		delete _decodeAhead->thread;
+		delete _decodeAhead;
+		_decodeAhead = 0;
+		_decodeAheadFrames = 0;
+	}
+}
+
+void VideoDecoder::stopDecodeAhead() {
+	if (!_decodeAhead)
+		return;
+
+	Common::atomicStore(_decodeAhead->stop, 1);
+	// Wake the thread up if it is waiting for a free slot
+	_decodeAhead->freeSlots.post();
+	_decodeAhead->thread->join();
+
+	delete _decodeAhead->thread;
+	delete _decodeAhead;
+	_decodeAhead = 0;
+}
+
+void VideoDecoder::runDecodeAhead() {
+	DecodeAheadState &state = *_decodeAhead;
+
+	// The same as decodeNextFrame() does, until the track ends
+	while (_nextVideoTrack) {
+		state.freeSlots.wait();
+		if (Common::atomicLoad(state.stop))
+			return;
+
+		DecodeAheadFrame &slot = state.slots[state.writeSlot];
+
+		readNextPacket();
+
+		VideoTrack *track = _nextVideoTrack;
+		const Graphics::Surface *frame = track->decodeNextFrame();
+
+		slot.hasSurface = frame != 0;
+		if (frame) {
+			if (slot.surface.w != frame->w || slot.surface.h != frame->h || slot.surface.format != frame->format) {
+				slot.surface.free();
+				slot.surface.create(frame->w, frame->h, frame->format);
+			}
+
+			for (int y = 0; y < frame->h; y++)
+				memcpy(slot.surface.getBasePtr(0, y), frame->getBasePtr(0, y), frame->w * frame->format.bytesPerPixel);
+		}
+
+		slot.dirtyPalette = track->hasDirtyPalette();
+		if (slot.dirtyPalette)
+			memcpy(slot.palette, track->getPalette(), sizeof(slot.palette));
+
+		findNextVideoTrack();
+
+		slot.curFrame = track->getCurFrame();
+		slot.endOfTrack = track->endOfTrack();
+		slot.nextFrameStartTime = track->getNextFrameStartTime();
+
+		state.writeSlot = (state.writeSlot + 1) % state.slotCount;
+		state.readySlots.post();
+	}
+}
+
+const Graphics::Surface *VideoDecoder::decodeNextFrameAhead() {
+	DecodeAheadState &state = *_decodeAhead;
+
+	if (state.endOfTrack) {
+		// The decode thread is done, so continue the way decodeNextFrame()
+		// would without a next video track
+		stopDecodeAhead();
+		readNextPacket();
+		return 0;
+	}
+
+	state.readySlots.wait();
+
+	// The frame returned last isn't needed anymore
+	if (state.holdingSlot)
+		state.freeSlots.post();
+
+	const DecodeAheadFrame &slot = state.slots[state.readSlot];
+	state.readSlot = (state.readSlot + 1) % state.slotCount;
+	state.holdingSlot = true;
+
+	state.curFrame = slot.curFrame;
+	state.endOfTrack = slot.endOfTrack;
+	state.nextFrameStartTime = slot.nextFrameStartTime;
+
+	// The slot goes back to the decode thread with the next frame, so the
+	// palette is kept elsewhere
+	if (slot.dirtyPalette) {
+		memcpy(_decodeAheadPalette, slot.palette, sizeof(_decodeAheadPalette));
+		_palette = _decodeAheadPalette;
+		_dirtyPalette = true;
+	}
+
+	return slot.hasSurface ? &slot.surface : 0;
+}
+
+bool VideoDecoder::isTrackAtEnd(const Track *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->endOfTrack;
+
+	return track->endOfTrack();
+}
+
+int VideoDecoder::getTrackCurFrame(const VideoTrack *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->curFrame;
+
+	return track->getCurFrame();
+}
+
+uint32 VideoDecoder::getTrackNextFrameStartTime(const VideoTrack *track) const {
+	if (_decodeAhead && track == _decodeAhead->track)
+		return _decodeAhead->nextFrameStartTime;
+
+	return track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
@@ -52,7 +52,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -344,6 +344,23 @@ public:
 	 */
 	virtual const Graphics::Surface *decodeNextFrame();
 
+	/**
+	 * Set how many frames may be decoded ahead of time on a separate
+	 * thread, so slow frames and reading from disk don't hold up playback.
+	 * 0, the default, decodes each frame when decodeNextFrame() is called.
+	 *
+	 * Decoding ahead starts with the next frame decoded after loading,
+	 * seeking or rewinding, and only for videos with a single video track
+	 * played forwards. Without thread support, or if the decoder does not
+	 * support it, frames are decoded when needed as before.
+	 */
+	void setDecodeAhead(uint frames) { _decodeAheadFrames = frames; }
+
+	/**
+	 * Get the number of frames which may be decoded ahead of time.
+	 */
+	uint getDecodeAhead() const { return _decodeAheadFrames; }
+
 	/**
 	 * Set the default high color format for videos that convert from YUV.
 	 *
@@ -774,6 +791,17 @@ protected:
 	 */
 	virtual bool useAudioSync() const { return true; }
 
+	/**
+	 * Whether the frames may be decoded ahead of time on a separate thread,
+	 * when setDecodeAhead() asks for it.
+	 *
+	 * readNextPacket() and the decodeNextFrame() of the video track then run
+	 * on that thread, so they must not change anything used by the other
+	 * functions of the decoder, besides the tracks. A subclass returns false
+	 * if it can't guarantee that, or if it decodes ahead on its own.
+	 */
+	virtual bool supportsDecodeAhead() const { return true; }
+
 	/**
 	 * Get the given track based on its index.
 	 *
@@ -853,6 +881,25 @@ private:
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
+	// Decoding ahead, see setDecodeAhead()
+	struct DecodeAheadState;
+	class DecodeAheadThread;
+	uint _decodeAheadFrames;
+	DecodeAheadState *_decodeAhead;
+	/** The palette of the frame decoded ahead which was returned last */
+	byte _decodeAheadPalette[256 * 3];
+
+	void startDecodeAhead();
+	void stopDecodeAhead();
+	void runDecodeAhead();
+	const Graphics::Surface *decodeNextFrameAhead();
+
+	// The state of the video tracks as of the frame last returned, which
+	// is ahead when decoding ahead
+	bool isTrackAtEnd(const Track *track) const;
+	int getTrackCurFrame(const VideoTrack *track) const;
+	uint32 getTrackNextFrameStartTime(const VideoTrack *track) const;
+
 	// Internal helper functions
 	void stopAudio();
 	void startAudio();